@@ -15,20 +15,13 @@
 #include <simdstr/slim_teddy.h>
 
 void Benchmark_FatTeddy() {
-        __declspec(align(16)) char haystack[] = "sdfj kjdf foo! anyways... this is how it works, so it is okay.";
+        char haystack[] = "sdfj kjdf foo! anyways... this is how it works, so it is okay.";
         char* patterns[] = {"foo", "bar", "bat"};
 
-        Pattern pats[3];
-        for (uint8_t i = 0; i < 3; ++i)
-        {
-                pats[i].begin = patterns[i];
-                pats[i].size = strlen(patterns[i]);
-        }
-
         FatTeddy teddy;
-        FatTeddy_init(&teddy, pats, 3);
+        fat_teddy_init(&teddy, patterns, 3);
 
-        Match match = FatTeddy_find(&teddy, haystack, strlen (haystack));
+        Match match = fat_teddy_find(&teddy, haystack, strlen (haystack));
         if (match.pattern_id >= 0) {
                 printf ("Match found at position %li for pattern %i\n", (long)(match.begin - &haystack[0]), match.pattern_id);
         } else {
@@ -37,7 +30,7 @@ void Benchmark_FatTeddy() {
 }
 
 void Benchmark_SlimTeddy() {
-        __declspec(align(16)) char haystack[] = "sdfj kjdf foo! anyways... this is how it works, so it is okay.";
+        char haystack[] = "sdfj kjdf foo! anyways... this is how it works, so it is okay.";
         char* patterns[] = {"foo", "bar", "bat"};
 
         Pattern pats[3];
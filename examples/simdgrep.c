@@ -0,0 +1,820 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+/*
+ * simdgrep: fixed string grep (like grep -F) built on simd_string.
+ *
+ *  simdgrep [OPTION...] PATTERN [FILE...]
+ *  simdgrep [OPTION...] -e PATTERN... [FILE...]
+ *  simdgrep [OPTION...] -f PATTERN_FILE [FILE...]
+ *
+ * Inputs are memory mapped and searched for all patterns at once (Teddy, up to 64 patterns per matcher). Files are
+ *  searched in parallel, output is written in the order of the files on the command line.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <simdstr/corpus.h>
+#include <simdstr/line_index.h>
+#include <simdstr/mapped_corpus.h>
+#include <simdstr/search.h>
+#include <simdstr/searcher.h>
+#include <simdstr/thread_pool.h>
+
+// patterns per Teddy matcher
+#define GROUP_SIZE 64
+// output of a file is written early once it exceeds this size and all preceding files are done
+#define FLUSH_SIZE (64u << 10)
+
+typedef struct {
+        int icase;
+        // SEARCH_* flags of -w and -x
+        uint32_t flags;
+        int count;
+        int files_with_matches;
+        int only_matching;
+        int line_number;
+        int with_filename;
+        int recursive;
+        unsigned num_threads;
+} Options;
+
+typedef struct {
+        char* data;
+        size_t size;
+        size_t capacity;
+} Output;
+
+typedef struct {
+        Output out;
+        char* error;
+        int matched;
+        int done;
+} FileState;
+
+typedef struct {
+        Pattern* patterns;
+        size_t num_patterns;
+        size_t capacity;
+
+        Searcher* searchers;
+        SlimTeddy* teddies;
+        size_t num_searchers;
+        // there is an empty pattern: it matches every line (with -w / -x only some, see h_empty_match)
+        int match_all;
+} PatternSet;
+
+typedef struct {
+        const Options* options;
+        const PatternSet* set;
+        char** paths;
+        size_t num_paths;
+        // content of the standard input if "-" is searched
+        char* stdin_data;
+        size_t stdin_size;
+
+        FileState* files;
+        pthread_mutex_t mutex;
+        size_t next_file;
+        // num_searchers cached matches per worker (see h_find)
+        Match* caches;
+} Grep;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_usage (FILE* stream)
+{
+        fprintf (stream, "Usage: simdgrep [OPTION...] PATTERN [FILE...]\n"
+                         "       simdgrep [OPTION...] -e PATTERN... [FILE...]\n"
+                         "       simdgrep [OPTION...] -f PATTERN_FILE [FILE...]\n"
+                         "Search for fixed strings in each FILE (standard input if none or \"-\").\n\n"
+                         "  -e PATTERN  search for PATTERN (may be repeated)\n"
+                         "  -f FILE     read patterns from FILE, one per line\n"
+                         "  -i          ignore ASCII case\n"
+                         "  -w          match only whole words\n"
+                         "  -x          match only whole lines\n"
+                         "  -c          print the number of matching lines per file\n"
+                         "  -l          print only the names of files with matches\n"
+                         "  -o          print only the matched parts of the lines\n"
+                         "  -n          prefix lines with their line number\n"
+                         "  -H / -h     always / never prefix lines with the file name\n"
+                         "  -r          search directories recursively\n"
+                         "  -j N        use N threads (default: number of CPUs)\n");
+}
+
+static int
+h_append (Output* out, const char* data, size_t size)
+{
+        if (out->size + size > out->capacity)
+        {
+                size_t capacity = out->capacity == 0 ? 4096 : out->capacity;
+                while (capacity < out->size + size)
+                {
+                        capacity *= 2;
+                }
+                char* buffer = realloc (out->data, capacity);
+                if (buffer == NULL)
+                {
+                        return -1;
+                }
+                out->data = buffer;
+                out->capacity = capacity;
+        }
+        memcpy (out->data + out->size, data, size);
+        out->size += size;
+        return 0;
+}
+
+static void
+h_append_prefix (Output* out, const Options* options, const char* path, size_t line_no)
+{
+        char number[32];
+        if (options->with_filename)
+        {
+                h_append (out, path, strlen (path));
+                h_append (out, ":", 1);
+        }
+        if (options->line_number)
+        {
+                int size = snprintf (number, sizeof (number), "%zu:", line_no);
+                h_append (out, number, (size_t) size);
+        }
+}
+
+static int
+h_add_pattern (PatternSet* set, char* begin, size_t size)
+{
+        if (set->num_patterns == set->capacity)
+        {
+                size_t capacity = set->capacity == 0 ? 16 : 2 * set->capacity;
+                Pattern* patterns = realloc (set->patterns, capacity * sizeof (Pattern));
+                if (patterns == NULL)
+                {
+                        return -1;
+                }
+                set->patterns = patterns;
+                set->capacity = capacity;
+        }
+        set->patterns[set->num_patterns].begin = begin;
+        set->patterns[set->num_patterns].size = size;
+        set->num_patterns++;
+        set->match_all |= size == 0;
+        return 0;
+}
+
+static char*
+h_read_stream (FILE* stream, size_t* size)
+{
+        size_t capacity = 1 << 16;
+        char* data = malloc (capacity);
+        *size = 0;
+        while (data != NULL)
+        {
+                size_t n = fread (data + *size, 1, capacity - *size, stream);
+                *size += n;
+                if (n == 0)
+                {
+                        break;
+                }
+                if (*size == capacity)
+                {
+                        capacity *= 2;
+                        char* grown = realloc (data, capacity);
+                        if (grown == NULL)
+                        {
+                                free (data);
+                                return NULL;
+                        }
+                        data = grown;
+                }
+        }
+        return data;
+}
+
+/*
+ * Add one pattern per line of the file at path. The file content is kept in *content.
+ */
+static int
+h_read_pattern_file (PatternSet* set, const char* path, char** content)
+{
+        FILE* file = strcmp (path, "-") == 0 ? stdin : fopen (path, "rb");
+        if (file == NULL)
+        {
+                return -1;
+        }
+        size_t size;
+        *content = h_read_stream (file, &size);
+        if (file != stdin)
+        {
+                fclose (file);
+        }
+        if (*content == NULL)
+        {
+                return -1;
+        }
+        size_t begin = 0;
+        while (begin < size)
+        {
+                char* newline = memchr (*content + begin, '\n', size - begin);
+                size_t end = newline != NULL ? (size_t) (newline - *content) : size;
+                if (h_add_pattern (set, *content + begin, end - begin) != 0)
+                {
+                        return -1;
+                }
+                begin = end + 1;
+        }
+        return 0;
+}
+
+static int
+h_compare_size (const void* a, const void* b)
+{
+        const Pattern* x = a;
+        const Pattern* y = b;
+        return x->size == y->size ? 0 : (x->size > y->size ? -1 : 1);
+}
+
+/*
+ * One matcher per GROUP_SIZE non-empty patterns: a needle search for a single pattern, Slim Teddy otherwise. Empty
+ *  patterns are covered by match_all (Slim Teddy needs at least one mask byte per pattern). Patterns are sorted by
+ *  decreasing size: matchers report the lowest pattern id among the patterns matching at a position, i.e. the longest
+ *  one (as grep -o).
+ */
+static int
+h_compile (PatternSet* set, int icase, uint32_t flags)
+{
+        size_t num_patterns = 0;
+        for (size_t i = 0; i < set->num_patterns; ++i)
+        {
+                if (set->patterns[i].size > 0)
+                {
+                        set->patterns[num_patterns++] = set->patterns[i];
+                }
+        }
+        set->num_patterns = num_patterns;
+        if (num_patterns > 0)
+        {
+                qsort (set->patterns, num_patterns, sizeof (Pattern), h_compare_size);
+        }
+        set->num_searchers = (set->num_patterns + GROUP_SIZE - 1) / GROUP_SIZE;
+        set->searchers = malloc (set->num_searchers * sizeof (Searcher));
+        set->teddies = malloc (set->num_searchers * sizeof (SlimTeddy));
+        if (set->num_searchers > 0 && (set->searchers == NULL || set->teddies == NULL))
+        {
+                return -1;
+        }
+        for (size_t g = 0; g < set->num_searchers; ++g)
+        {
+                Pattern* patterns = set->patterns + g * GROUP_SIZE;
+                size_t n = set->num_patterns - g * GROUP_SIZE < GROUP_SIZE ? set->num_patterns - g * GROUP_SIZE : GROUP_SIZE;
+                if (n == 1)
+                {
+                        if (icase)
+                        {
+                                Searcher_init_needle_icase (&set->searchers[g], patterns[0].begin, patterns[0].size);
+                        }
+                        else
+                        {
+                                Searcher_init_needle (&set->searchers[g], patterns[0].begin, patterns[0].size);
+                        }
+                        Searcher_set_flags (&set->searchers[g], flags);
+                        continue;
+                }
+                size_t min_size = SIZE_MAX;
+                for (size_t i = 0; i < n; ++i)
+                {
+                        min_size = patterns[i].size < min_size ? patterns[i].size : min_size;
+                }
+                uint8_t num_masks = (uint8_t) (min_size < 3 ? min_size : 3);
+                if (icase)
+                {
+                        SlimTeddy_init_icase (&set->teddies[g], patterns, (uint8_t) n, num_masks);
+                }
+                else
+                {
+                        SlimTeddy_init (&set->teddies[g], patterns, (uint8_t) n, num_masks);
+                }
+                Searcher_init_slim_teddy (&set->searchers[g], &set->teddies[g]);
+                Searcher_set_flags (&set->searchers[g], flags);
+        }
+        return 0;
+}
+
+static int
+h_word_byte (char c)
+{
+        return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+}
+
+/*
+ * The empty pattern matches line[0, size) under the SEARCH_* flags: somewhere between two non-word bytes (or line
+ *  edges) with -w, only an empty line with -x.
+ */
+static int
+h_empty_match (const char* line, size_t size, uint32_t flags)
+{
+        for (size_t pos = 0; pos <= size; ++pos)
+        {
+                if ((flags & SEARCH_LINE_START) && pos > 0)
+                {
+                        break;
+                }
+                if ((flags & SEARCH_LINE_END) && pos < size)
+                {
+                        continue;
+                }
+                if (!(flags & SEARCH_WORD) || ((pos == 0 || !h_word_byte (line[pos - 1])) &&
+                                               (pos == size || !h_word_byte (line[pos]))))
+                {
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * Leftmost (longest on ties) match of all matchers starting at or after data + pos. cache holds the next match of
+ *  every matcher (pattern_id -2: no further match).
+ */
+static Match
+h_find (const PatternSet* set, Match* cache, char* data, size_t size, size_t pos)
+{
+        Match best = Match_empty ();
+        for (size_t g = 0; g < set->num_searchers; ++g)
+        {
+                if (cache[g].pattern_id == -2)
+                {
+                        continue;
+                }
+                if (cache[g].pattern_id < 0 || cache[g].begin < data + pos)
+                {
+                        cache[g] = Searcher_find_from (&set->searchers[g], data, size, pos);
+                        if (cache[g].pattern_id < 0)
+                        {
+                                cache[g].pattern_id = -2;
+                                continue;
+                        }
+                }
+                if (best.pattern_id < 0 || cache[g].begin < best.begin ||
+                    (cache[g].begin == best.begin && cache[g].end > best.end))
+                {
+                        best = cache[g];
+                }
+        }
+        return best;
+}
+
+static void
+h_flush (Grep* grep, size_t file_id)
+{
+        pthread_mutex_lock (&grep->mutex);
+        if (grep->next_file == file_id)
+        {
+                fwrite (grep->files[file_id].out.data, 1, grep->files[file_id].out.size, stdout);
+                grep->files[file_id].out.size = 0;
+        }
+        pthread_mutex_unlock (&grep->mutex);
+}
+
+/*
+ * Search data[0, size) and append the output for it to the output of file_id.
+ */
+static void
+h_grep_buffer (Grep* grep, size_t file_id, Match* cache, char* data, size_t size)
+{
+        const Options* options = grep->options;
+        const char* path = grep->paths[file_id];
+        FileState* file = &grep->files[file_id];
+        Output* out = &file->out;
+
+        for (size_t g = 0; g < grep->set->num_searchers; ++g)
+        {
+                cache[g] = Match_empty ();
+        }
+
+        size_t count = 0;
+        // matching lines are visited in ascending order: line numbers are counted incrementally
+        LineCursor cursor;
+        LineCursor_init (&cursor, data, size, NULL);
+        size_t line_no = 1;
+        size_t pos = 0;
+        while (pos < size)
+        {
+                size_t line_start;
+                Match match = Match_empty ();
+                if (grep->set->match_all)
+                {
+                        // with -w / -x, skip lines matched neither by the empty pattern nor by another one
+                        line_start = pos;
+                        while (options->flags != 0 && line_start < size)
+                        {
+                                const char* newline = memchr (data + line_start, '\n', size - line_start);
+                                size_t line_end = newline != NULL ? (size_t) (newline - data) : size;
+                                if (h_empty_match (data + line_start, line_end - line_start, options->flags))
+                                {
+                                        break;
+                                }
+                                match = h_find (grep->set, cache, data, size, line_start);
+                                if (match.pattern_id >= 0 && match.begin < data + line_end)
+                                {
+                                        break;
+                                }
+                                line_start = line_end + 1;
+                        }
+                        if (line_start >= size)
+                        {
+                                break;
+                        }
+                }
+                else
+                {
+                        match = h_find (grep->set, cache, data, size, pos);
+                        if (match.pattern_id < 0)
+                        {
+                                break;
+                        }
+                        size_t begin = (size_t) (match.begin - data);
+                        const char* newline = begin > pos ? simd_memrchr (data + pos, begin - pos, '\n') : NULL;
+                        line_start = newline != NULL ? (size_t) (newline - data) + 1 : pos;
+                }
+                const char* newline = memchr (data + line_start, '\n', size - line_start);
+                size_t line_end = newline != NULL ? (size_t) (newline - data) : size;
+                if (options->line_number)
+                {
+                        line_no = LineCursor_line (&cursor, line_start);
+                }
+                count++;
+                if (options->files_with_matches)
+                {
+                        break;
+                }
+
+                if (options->count)
+                {
+                        // only the number of lines is reported
+                }
+                else if (options->only_matching)
+                {
+                        if (grep->set->match_all)
+                        {
+                                // the line matched the empty pattern: print the matches of the other patterns
+                                match = h_find (grep->set, cache, data, size, line_start);
+                        }
+                        while (match.pattern_id >= 0 && match.begin < data + line_end)
+                        {
+                                if (match.end > match.begin)
+                                {
+                                        h_append_prefix (out, options, path, line_no);
+                                        h_append (out, match.begin, (size_t) (match.end - match.begin));
+                                        h_append (out, "\n", 1);
+                                }
+                                size_t next = (size_t) (match.end - data);
+                                next = next > (size_t) (match.begin - data) ? next : (size_t) (match.begin - data) + 1;
+                                match = next < size ? h_find (grep->set, cache, data, size, next) : Match_empty ();
+                        }
+                }
+                else
+                {
+                        h_append_prefix (out, options, path, line_no);
+                        h_append (out, data + line_start, line_end - line_start);
+                        h_append (out, "\n", 1);
+                }
+                if (out->size >= FLUSH_SIZE)
+                {
+                        h_flush (grep, file_id);
+                }
+                pos = line_end + 1;
+        }
+
+        file->matched = count > 0;
+        if (options->files_with_matches)
+        {
+                if (count > 0)
+                {
+                        h_append (out, path, strlen (path));
+                        h_append (out, "\n", 1);
+                }
+        }
+        else if (options->count)
+        {
+                char number[32];
+                int length = snprintf (number, sizeof (number), "%zu\n", count);
+                if (options->with_filename)
+                {
+                        h_append (out, path, strlen (path));
+                        h_append (out, ":", 1);
+                }
+                h_append (out, number, (size_t) length);
+        }
+}
+
+static void
+h_grep_task (void* context, size_t file_id, unsigned worker_id)
+{
+        Grep* grep = context;
+        FileState* file = &grep->files[file_id];
+        const char* path = grep->paths[file_id];
+        Match* cache = grep->caches + (size_t) worker_id * grep->set->num_searchers;
+
+        if (strcmp (path, "-") == 0)
+        {
+                h_grep_buffer (grep, file_id, cache, grep->stdin_data, grep->stdin_size);
+        }
+        else
+        {
+                MappedCorpus corpus;
+                struct stat st;
+                if (stat (path, &st) == 0 && S_ISDIR (st.st_mode))
+                {
+                        file->error = strdup ("Is a directory");
+                }
+                else if (MappedCorpus_open (&corpus, path, MAPPED_CORPUS_SEQUENTIAL) != 0)
+                {
+                        file->error = strdup (strerror (errno));
+                }
+                else
+                {
+                        h_grep_buffer (grep, file_id, cache, corpus.data, corpus.size);
+                        MappedCorpus_close (&corpus);
+                }
+        }
+
+        // write the output of all finished files in command line order
+        pthread_mutex_lock (&grep->mutex);
+        file->done = 1;
+        while (grep->next_file < grep->num_paths && grep->files[grep->next_file].done)
+        {
+                FileState* next = &grep->files[grep->next_file];
+                fwrite (next->out.data, 1, next->out.size, stdout);
+                if (next->error != NULL)
+                {
+                        fflush (stdout);
+                        fprintf (stderr, "simdgrep: %s: %s\n", grep->paths[grep->next_file], next->error);
+                }
+                free (next->out.data);
+                next->out.data = NULL;
+                grep->next_file++;
+        }
+        pthread_mutex_unlock (&grep->mutex);
+}
+
+/*
+ * Value of an option taking an argument: the rest of the current argument or the next argument.
+ */
+static char*
+h_option_value (int argc, char* argv[], int* i, const char* rest)
+{
+        if (*rest != '\0')
+        {
+                return (char*) rest;
+        }
+        if (*i + 1 < argc)
+        {
+                return argv[++*i];
+        }
+        fprintf (stderr, "simdgrep: option requires an argument\n");
+        h_usage (stderr);
+        exit (2);
+}
+
+// ____________________________________________________________________________
+
+int
+main (int argc, char* argv[])
+{
+        Options options = {0, 0, 0, 0, 0, 0, -1, 0, 0};
+        PatternSet set;
+        memset (&set, 0, sizeof (set));
+        char** pattern_files = malloc ((size_t) argc * sizeof (char*));
+        size_t num_pattern_files = 0;
+        char** paths = malloc ((size_t) argc * sizeof (char*));
+        size_t num_paths = 0;
+        int have_patterns = 0;
+        if (pattern_files == NULL || paths == NULL)
+        {
+                return 2;
+        }
+
+        int only_paths = 0;
+        for (int i = 1; i < argc; ++i)
+        {
+                char* arg = argv[i];
+                if (only_paths || arg[0] != '-' || arg[1] == '\0')
+                {
+                        paths[num_paths++] = arg;
+                        continue;
+                }
+                if (strcmp (arg, "--") == 0)
+                {
+                        only_paths = 1;
+                        continue;
+                }
+                if (strcmp (arg, "--help") == 0)
+                {
+                        h_usage (stdout);
+                        return 0;
+                }
+                // options taking a value consume the rest of the argument
+                int consumed = 0;
+                for (const char* flag = arg + 1; *flag != '\0' && !consumed; ++flag)
+                {
+                        switch (*flag)
+                        {
+                                case 'i':
+                                        options.icase = 1;
+                                        break;
+                                case 'w':
+                                        options.flags |= SEARCH_WORD;
+                                        break;
+                                case 'x':
+                                        options.flags |= SEARCH_LINE_START | SEARCH_LINE_END;
+                                        break;
+                                case 'c':
+                                        options.count = 1;
+                                        break;
+                                case 'l':
+                                        options.files_with_matches = 1;
+                                        break;
+                                case 'o':
+                                        options.only_matching = 1;
+                                        break;
+                                case 'n':
+                                        options.line_number = 1;
+                                        break;
+                                case 'H':
+                                        options.with_filename = 1;
+                                        break;
+                                case 'h':
+                                        options.with_filename = 0;
+                                        break;
+                                case 'r':
+                                        options.recursive = 1;
+                                        break;
+                                case 'j':
+                                        options.num_threads = (unsigned) strtoul (h_option_value (argc, argv, &i, flag + 1), NULL, 10);
+                                        consumed = 1;
+                                        break;
+                                case 'e': {
+                                        char* pattern = h_option_value (argc, argv, &i, flag + 1);
+                                        h_add_pattern (&set, pattern, strlen (pattern));
+                                        have_patterns = 1;
+                                        consumed = 1;
+                                        break;
+                                }
+                                case 'f':
+                                        pattern_files[num_pattern_files++] = h_option_value (argc, argv, &i, flag + 1);
+                                        have_patterns = 1;
+                                        consumed = 1;
+                                        break;
+                                default:
+                                        fprintf (stderr, "simdgrep: invalid option -- '%c'\n", *flag);
+                                        h_usage (stderr);
+                                        return 2;
+                        }
+                }
+        }
+        if (!have_patterns)
+        {
+                if (num_paths == 0)
+                {
+                        h_usage (stderr);
+                        return 2;
+                }
+                char* pattern = paths[0];
+                h_add_pattern (&set, pattern, strlen (pattern));
+                memmove (paths, paths + 1, --num_paths * sizeof (char*));
+        }
+        for (size_t i = 0; i < num_pattern_files; ++i)
+        {
+                // the patterns point into the file content, it is kept until the end
+                char* content = NULL;
+                if (h_read_pattern_file (&set, pattern_files[i], &content) != 0)
+                {
+                        fprintf (stderr, "simdgrep: %s: %s\n", pattern_files[i], strerror (errno));
+                        return 2;
+                }
+        }
+        if (set.num_patterns == 0)
+        {
+                // an empty pattern file matches nothing
+                return 1;
+        }
+        if (h_compile (&set, options.icase, options.flags) != 0)
+        {
+                fprintf (stderr, "simdgrep: %s\n", strerror (ENOMEM));
+                return 2;
+        }
+
+        // expand directories
+        if (num_paths == 0)
+        {
+                paths[num_paths++] = options.recursive ? "." : "-";
+        }
+        char** files = NULL;
+        size_t num_files = 0;
+        size_t capacity = 0;
+        for (size_t i = 0; i < num_paths; ++i)
+        {
+                struct stat st;
+                char** listed = NULL;
+                size_t num_listed = 0;
+                int is_listing = options.recursive && stat (paths[i], &st) == 0 && S_ISDIR (st.st_mode) &&
+                                 corpus_list_files (paths[i], &listed, &num_listed) == 0;
+                if (!is_listing)
+                {
+                        listed = &paths[i];
+                        num_listed = 1;
+                }
+                if (num_files + num_listed > capacity)
+                {
+                        capacity = 2 * (num_files + num_listed);
+                        char** grown = realloc (files, capacity * sizeof (char*));
+                        if (grown == NULL)
+                        {
+                                fprintf (stderr, "simdgrep: %s\n", strerror (ENOMEM));
+                                free (files);
+                                if (is_listing)
+                                {
+                                        corpus_free_file_list (listed, num_listed);
+                                }
+                                return 2;
+                        }
+                        files = grown;
+                }
+                memcpy (files + num_files, listed, num_listed * sizeof (char*));
+                num_files += num_listed;
+                // the listed paths are owned by files now
+                if (is_listing)
+                {
+                        free (listed);
+                }
+        }
+        if (options.with_filename < 0)
+        {
+                options.with_filename = num_files > 1 || options.recursive;
+        }
+
+        Grep grep;
+        grep.options = &options;
+        grep.set = &set;
+        grep.paths = files;
+        grep.num_paths = num_files;
+        grep.stdin_data = NULL;
+        grep.stdin_size = 0;
+        grep.next_file = 0;
+        grep.files = calloc (num_files, sizeof (FileState));
+        if (grep.files == NULL)
+        {
+                fprintf (stderr, "simdgrep: %s\n", strerror (ENOMEM));
+                return 2;
+        }
+        pthread_mutex_init (&grep.mutex, NULL);
+        for (size_t i = 0; i < num_files; ++i)
+        {
+                if (strcmp (files[i], "-") == 0 && grep.stdin_data == NULL)
+                {
+                        grep.stdin_data = h_read_stream (stdin, &grep.stdin_size);
+                }
+        }
+
+        ThreadPool pool;
+        if (ThreadPool_init (&pool, options.num_threads, NULL, NULL) != 0)
+        {
+                fprintf (stderr, "simdgrep: %s\n", strerror (ENOMEM));
+                return 2;
+        }
+        grep.caches = malloc ((size_t) pool.num_threads * set.num_searchers * sizeof (Match));
+        if (grep.caches == NULL && set.num_searchers > 0)
+        {
+                fprintf (stderr, "simdgrep: %s\n", strerror (ENOMEM));
+                return 2;
+        }
+        ThreadPool_run (&pool, num_files, h_grep_task, &grep);
+        ThreadPool_destroy (&pool);
+        free (grep.caches);
+        fflush (stdout);
+
+        int matched = 0;
+        int failed = 0;
+        for (size_t i = 0; i < num_files; ++i)
+        {
+                matched |= grep.files[i].matched;
+                failed |= grep.files[i].error != NULL;
+                free (grep.files[i].error);
+        }
+        return failed ? 2 : (matched ? 0 : 1);
+}
@@ -0,0 +1,104 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_COLUMN_H
+#define SIMD_STRING_COLUMN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/types.h>
+
+// --- StringColumn ---------------------------------------------------------------------------------------------------
+/**
+ * StringColumn
+ *  Column of num_rows strings in the offsets + data layout (Arrow string arrays): row i is
+ *  data[offsets[i], offsets[i + 1]). offsets holds num_rows + 1 non decreasing entries.
+ *
+ *  Predicates produce a selection bitmap (bit i % 8 of byte i / 8 is set for selected rows, as Arrow validity
+ *  bitmaps) or a selection vector (ascending row ids).
+ */
+typedef struct {
+        const char* data;
+        const int32_t* offsets;
+        size_t num_rows;
+} StringColumn;
+
+void StringColumn_init (StringColumn* self, const char* data, const int32_t* offsets, size_t num_rows);
+
+/**
+ * Row holding byte data[pos] (offsets[0] <= pos < offsets[num_rows]), found by a branchless binary search among the
+ *  rows [first_row, num_rows).
+ */
+size_t StringColumn_row_of (const StringColumn* self, size_t first_row, size_t pos);
+
+/**
+ * LIKE '%pattern%': select the rows containing a match of searcher (any pattern). The data buffer is scanned once,
+ *  matches are mapped to their rows by StringColumn_row_of and matches crossing a row end are dropped. After a hit,
+ *  the scan resumes at the next row. The SEARCH_* flags of searcher see the data of all rows
+ *  (data[offsets[0], offsets[num_rows])) as one buffer, not the single rows.
+ *
+ *  bitmap holds (num_rows + 7) / 8 bytes and is overwritten. Returns the number of selected rows.
+ */
+size_t StringColumn_contains (const StringColumn* self, const Searcher* searcher, uint8_t* bitmap);
+
+/**
+ * StringColumn_contains writing the selected row ids to rows (capacity num_rows). Returns the number of rows.
+ */
+size_t StringColumn_contains_rows (const StringColumn* self, const Searcher* searcher, uint32_t* rows);
+// ___ StringColumn ___________________________________________________________________________________________________
+
+typedef enum {
+        STRING_PREDICATE_STARTS_WITH,
+        STRING_PREDICATE_ENDS_WITH,
+        STRING_PREDICATE_EQUALS,
+        STRING_PREDICATE_CONTAINS,
+} StringPredicateKind;
+
+// --- StringPredicate ------------------------------------------------------------------------------------------------
+/**
+ * StringPredicate
+ *  Compiled starts_with / ends_with / equals / contains predicate over string columns and arrays of (begin, size)
+ *  strings. Rows are evaluated in groups of 8, each group producing one bitmap byte. starts_with, ends_with and
+ *  equals compare the compared bytes of several rows per vector, masked to the needle size: 4 rows of 8 bytes
+ *  (needles up to 8 bytes) or 2 rows of 16 bytes (up to 16 bytes). Longer needles compare their first 32 bytes with
+ *  one vector compare per row and the rest with memcmp. contains uses a Searcher (simd_strstr, StringColumn_contains
+ *  for columns).
+ *
+ *  icase folds ASCII letters of rows and needle. Row loads read up to 32 bytes from the compared position but never
+ *  cross a page boundary behind the row. needle MUST outlive the StringPredicate.
+ */
+typedef struct {
+        StringPredicateKind kind;
+        const char* needle;
+        size_t needle_size;
+        int icase;
+
+        // first min (needle_size, 32) bytes of the needle (lower case if icase) and the mask of these bytes
+        uint8_t block[32];
+        uint32_t mask;
+        Searcher searcher;
+} StringPredicate;
+
+void StringPredicate_init (StringPredicate* self, StringPredicateKind kind, const char* needle, size_t needle_size,
+                           int icase);
+
+/**
+ * Evaluate the predicate for all rows of column. bitmap holds (num_rows + 7) / 8 bytes and is overwritten (see
+ *  StringColumn). Returns the number of selected rows.
+ */
+size_t StringPredicate_column (const StringPredicate* self, const StringColumn* column, uint8_t* bitmap);
+
+/**
+ * Evaluate the predicate for strings[0, num_strings). bitmap holds (num_strings + 7) / 8 bytes and is overwritten.
+ *  Returns the number of selected strings.
+ */
+size_t StringPredicate_strings (const StringPredicate* self, const Pattern* strings, size_t num_strings, uint8_t* bitmap);
+// ___ StringPredicate ________________________________________________________________________________________________
+
+#endif//SIMD_STRING_COLUMN_H
@@ -0,0 +1,75 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_CORPUS_H
+#define SIMD_STRING_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/stream.h>
+#include <simdstr/thread_pool.h>
+
+// default number of start positions of one piece of a large file
+#define CORPUS_PIECE_SIZE (8u << 20)
+// files up to this size are read into a per worker buffer instead of being mapped
+#define CORPUS_READ_SIZE (64u << 10)
+
+// --- CorpusFileResult -----------------------------------------------------------------------------------------------
+/**
+ * CorpusFileResult
+ *  All matches of one file ordered by their start (offsets into the file, see SearchStream for the semantics of
+ *  overlapping matches). error is 0 or the errno of the failed open/read, matches are not reported then.
+ */
+typedef struct {
+        const char* path;
+        size_t file_id;
+        uint64_t size;
+        int error;
+
+        const StreamMatch* matches;
+        size_t num_matches;
+} CorpusFileResult;
+
+/**
+ * Called once per file in the order of the file list. result is only valid during the call. Return non-zero to stop
+ *  the search.
+ */
+typedef int (*CorpusCallback) (const CorpusFileResult* result, void* user_data);
+// ___ CorpusFileResult _______________________________________________________________________________________________
+
+/*
+ * Multi-file search: every file is split into pieces of piece_size start positions (0 uses CORPUS_PIECE_SIZE). Small
+ *  files are a single piece, so whole small files and pieces of large files are scheduled alike on the work stealing
+ *  pool. Results are reported per file in file list order as soon as all pieces of the file and all preceding files are
+ *  done; callbacks are serialized.
+ */
+
+/**
+ * Search the files paths[0, num_paths). Returns 0 on success (also if stopped by the callback), -1 if memory could not
+ *  be allocated.
+ */
+int corpus_search_files (ThreadPool* pool, const Searcher* searcher, const char* const* paths, size_t num_paths,
+                         size_t piece_size, CorpusCallback callback, void* user_data);
+
+/**
+ * Search all regular files below root (symbolic links are not followed) in lexicographic path order. Returns 0 on
+ *  success, -1 if root could not be listed or memory could not be allocated.
+ */
+int corpus_search_directory (ThreadPool* pool, const Searcher* searcher, const char* root, size_t piece_size,
+                             CorpusCallback callback, void* user_data);
+
+/**
+ * Collect the paths of all regular files below root in lexicographic order (directory entries sorted by name). *paths
+ *  must be released with corpus_free_file_list. Returns 0 on success, -1 on failure.
+ */
+int corpus_list_files (const char* root, char*** paths, size_t* num_paths);
+
+void corpus_free_file_list (char** paths, size_t num_paths);
+
+#endif//SIMD_STRING_CORPUS_H
@@ -0,0 +1,80 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_DNA_H
+#define SIMD_STRING_DNA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// zero words behind the packed bases of a DnaText (read by the search kernel)
+#define DNA_PADDING_WORDS 4
+
+/**
+ * Pack the nucleotides str[0, size) to 2 bits per base: base i is stored in bits 2 * (i % 32) of words[i / 32]
+ *  (A = 0, C = 1, T = 2, G = 3, upper or lower case). words holds (size + 31) / 32 words, the bits behind the last
+ *  base are zero. Bytes other than ACGT (N, IUPAC codes, line breaks) are packed as the base sharing their bits 1 and
+ *  2 and counted: returns the number of such bytes. Packs 32 bases per AVX2 iteration.
+ */
+size_t dna_pack (const char* str, size_t size, uint64_t* words);
+
+// --- DnaPattern -----------------------------------------------------------------------------------------------------
+/**
+ * DnaPattern
+ *  Packed search pattern (primer). Bases behind the first 32 are verified after the kernel matched the first 32.
+ */
+typedef struct {
+        uint64_t* words;
+        size_t size;
+        // number of non ACGT bytes of the pattern
+        size_t num_invalid;
+} DnaPattern;
+
+/**
+ * Pack pattern[0, size). Returns 0 on success, -1 if memory could not be allocated.
+ */
+int DnaPattern_init (DnaPattern* self, const char* pattern, size_t size);
+
+void DnaPattern_destroy (DnaPattern* self);
+// ___ DnaPattern _____________________________________________________________________________________________________
+
+// --- DnaText --------------------------------------------------------------------------------------------------------
+/**
+ * DnaText
+ *  Nucleotide text packed to 2 bits per base, a quarter of the memory traffic of searching the ASCII text.
+ *  Searches compare the pattern with the text shifted by 0 ... 31 bases: every AVX2 step tests the 128 positions
+ *  starting in 4 text words, counting mismatching bases per position (Hamming distance) when mismatches are
+ *  allowed.
+ *
+ *  Positions are base indices. Non ACGT bytes are not distinguished from the base they are packed as (see
+ *  dna_pack), num_invalid counts them so that callers can fall back to a byte search.
+ */
+typedef struct {
+        uint64_t* words;
+        size_t size;
+        size_t num_invalid;
+} DnaText;
+
+/**
+ * Pack str[0, size). Returns 0 on success, -1 if memory could not be allocated.
+ */
+int DnaText_init (DnaText* self, const char* str, size_t size);
+
+/**
+ * First position >= from at which pattern occurs with at most max_mismatches mismatching bases, -1 if there is none.
+ */
+int64_t DnaText_find_from (const DnaText* self, const DnaPattern* pattern, size_t max_mismatches, size_t from);
+
+/**
+ * Number of positions at which pattern occurs with at most max_mismatches mismatching bases (overlapping).
+ */
+size_t DnaText_count (const DnaText* self, const DnaPattern* pattern, size_t max_mismatches);
+
+void DnaText_destroy (DnaText* self);
+// ___ DnaText ________________________________________________________________________________________________________
+
+#endif//SIMD_STRING_DNA_H
@@ -29,7 +29,10 @@ typedef struct {
        __m256i v_hi;
 } FatPatternMask;
 
-void pattern_mask_init(FatPatternMask* pattern_mask, FatBucket* buckets, char** patterns);
+/**
+ * Add the byte at offset of all patterns to the bucket masks, in upper and lower case if icase.
+ */
+void pattern_mask_init(FatPatternMask* pattern_mask, FatBucket* buckets, char** patterns, uint8_t offset, uint8_t icase);
 
 void pattern_mask_add_fat(FatPatternMask* mask, char byte, uint8_t bucket_id);
 
@@ -40,19 +43,42 @@ typedef struct {
 
        char** patterns;
        uint8_t num_patterns;
+       // patterns are fingerprinted by their byte at offset
+       uint8_t offset;
 
        FatBucket buckets[16];
+
+       // ASCII case insensitive matching
+       uint8_t icase;
+
+       // predicted probability that a scanned position yields a candidate (see teddy_false_positive_rate)
+       double false_positive_rate;
 } FatTeddy;
 
-void fat_teddy_init(FatTeddy* teddy, char** patterns, uint8_t num_patterns);
+/**
+ * Initialize FatTeddy. The fingerprinted byte (offset) with the lowest predicted false positive rate is chosen and
+ *  patterns are assigned to buckets by shared fingerprint nibbles under the default byte frequency
+ *  model (see teddy_assign_buckets).
+ */
+void fat_teddy_init (FatTeddy* teddy, char** patterns, uint8_t num_patterns);
+
+/**
+ * Same as fat_teddy_init but assigns buckets under the byte frequency model byte_freq (256 probabilities).
+ */
+void fat_teddy_init_freq (FatTeddy* teddy, char** patterns, uint8_t num_patterns, const double* byte_freq);
+
+/**
+ * Same as fat_teddy_init but matches ASCII case insensitively.
+ */
+void fat_teddy_init_icase (FatTeddy* teddy, char** patterns, uint8_t num_patterns);
 
 Match fat_teddy_find(FatTeddy* teddy, char* str, size_t str_size);
 
-Match fat_teddy_find_next(FatTeddy* teddy, char* str, size_t str_size);
+Match fat_teddy_find_next(FatTeddy* teddy, char* begin, char* str, size_t str_size);
 
-Match fat_teddy_verify(FatTeddy* teddy, __m256i* candidate, char* str, size_t str_size);
+Match fat_teddy_verify(FatTeddy* teddy, __m256i* candidate, char* begin, char* str, size_t str_size);
 
-Match fat_teddy_verify64(FatTeddy* teddy, uint64_t lane, char* str, size_t str_size);
+Match fat_teddy_verify64(FatTeddy* teddy, uint64_t lane, char* begin, char* str, size_t str_size);
 
 __m256i mm256_lookup_1(__m256i* chunk, FatPatternMask* pattern_mask);
 
@@ -0,0 +1,53 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_HAMMING_H
+#define SIMD_STRING_HAMMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the pigeonhole prefilter is used if the needle splits into k + 1 exact segments of at least this size
+#define HAMMING_MIN_SEGMENT_SIZE 4
+#define HAMMING_MAX_SEGMENTS 64
+
+/*
+ * Approximate search with at most k mismatches: an occurrence of needle is a window str[pos, pos + needle_len) that
+ *  differs from needle in at most k bytes (substitutions only).
+ */
+
+/**
+ * Number of positions i < size with a[i] != b[i].
+ */
+size_t hamming_distance (const char* a, const char* b, size_t size);
+
+/**
+ * Leftmost occurrence of needle with at most k mismatches. Pigeonhole prefilter if the needle splits into k + 1
+ *  segments of at least HAMMING_MIN_SEGMENT_SIZE bytes (one of them occurs exactly in every occurrence), the SIMD
+ *  mismatch counting kernels otherwise.
+ */
+const char* simd_hamming_search (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k);
+
+/**
+ * Mismatch counting kernel using AVX2: the mismatch counts of 32 start positions are accumulated from the compare
+ *  masks of every needle offset. A block is abandoned as soon as all 32 counts exceed k.
+ */
+const char* simd_hamming_search_avx_32 (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k);
+
+/**
+ * Same as simd_hamming_search_avx_32 for 64 start positions using AVX512BW.
+ */
+const char* simd_hamming_search_avx_64 (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k);
+
+/**
+ * Pigeonhole prefilter: needle is split into k + 1 segments, their exact occurrences (simd_generic_search_avx_32) are
+ *  merged by candidate start and verified. k + 1 MUST be <= HAMMING_MAX_SEGMENTS and <= needle_len.
+ */
+const char* simd_hamming_search_pigeonhole (const char* str, size_t str_len, const char* needle, size_t needle_len,
+                                            size_t k);
+
+#endif//SIMD_STRING_HAMMING_H
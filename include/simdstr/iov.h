@@ -0,0 +1,67 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_IOV_H
+#define SIMD_STRING_IOV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+struct iovec {
+        void* iov_base;
+        size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+
+#include <simdstr/slim_teddy.h>
+#include <simdstr/stream.h>
+
+/*
+ * Scatter/gather search: the haystack is the concatenation of the segments iov[0, iovcnt). Segments are scanned in
+ *  place, matches crossing segment boundaries are found in a small stitched window at the seams (see SearchStream).
+ *  Match offsets refer to the concatenation, use iov_locate to map them back to a segment.
+ */
+
+/**
+ * Leftmost match of searcher. Returns 1 and fills match if there is one, 0 otherwise, -1 as Searcher_find_all_iov.
+ */
+int Searcher_find_iov (const Searcher* searcher, const struct iovec* iov, int iovcnt, StreamMatch* match);
+
+/**
+ * Report all matches of searcher in order of their start. Returns 1 if the scan was stopped by the callback, 0 if it
+ *  was not, -1 if the seam window could not be allocated (errno is set; only for windows larger than 1 KiB, which live
+ *  on the stack otherwise). Nothing is reported then.
+ */
+int Searcher_find_all_iov (const Searcher* searcher, const struct iovec* iov, int iovcnt, StreamCallback callback,
+                           void* user_data);
+
+/**
+ * Leftmost occurrence of needle. Returns 1 and fills match if there is one, 0 otherwise, -1 as Searcher_find_all_iov.
+ */
+int simd_strstr_iov (const struct iovec* iov, int iovcnt, const char* needle, size_t needle_size, StreamMatch* match);
+
+/**
+ * Leftmost match of teddy. Returns 1 and fills match if there is one, 0 otherwise, -1 as Searcher_find_all_iov.
+ */
+int SlimTeddy_find_iov (SlimTeddy* teddy, const struct iovec* iov, int iovcnt, StreamMatch* match);
+
+/**
+ * Describe the size bytes starting at head of the ring buffer ring[0, capacity) as (up to) two segments.
+ *  Returns the number of segments written to iov.
+ */
+int iov_from_ring (struct iovec* iov, char* ring, size_t capacity, size_t head, size_t size);
+
+/**
+ * Map offset of the concatenation to the segment containing it. Returns the segment index (iovcnt if offset is out of
+ *  range) and writes the offset within the segment to segment_offset.
+ */
+int iov_locate (const struct iovec* iov, int iovcnt, uint64_t offset, size_t* segment_offset);
+
+#endif//SIMD_STRING_IOV_H
@@ -0,0 +1,85 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_KEYWORD_DICT_H
+#define SIMD_STRING_KEYWORD_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/types.h>
+
+// longest keyword (one 32 byte vector)
+#define KEYWORD_DICT_MAX_SIZE 32
+
+// --- KeywordSlot ----------------------------------------------------------------------------------------------------
+/**
+ * KeywordSlot
+ *  Slot of a perfect hash table: the keyword zero padded to 32 bytes and its id (-1: empty slot). One slot per
+ *  cache line.
+ */
+typedef struct {
+        uint8_t key[KEYWORD_DICT_MAX_SIZE];
+        int32_t keyword_id;
+        uint8_t padding[28];
+} KeywordSlot;
+// ___ KeywordSlot ____________________________________________________________________________________________________
+
+// --- KeywordTable ---------------------------------------------------------------------------------------------------
+/**
+ * KeywordTable
+ *  Perfect hash table of the keywords of one size (CHD: hash and displace). A key hashing to h lands in bucket
+ *  ((h >> 32) * num_buckets) >> 32, whose displacement selects the slot among slots[slots, slots + num_slots).
+ */
+typedef struct {
+        uint64_t seed;
+        uint32_t displacements;
+        uint32_t num_buckets;
+        uint32_t slots;
+        uint32_t num_slots;
+} KeywordTable;
+// ___ KeywordTable ___________________________________________________________________________________________________
+
+// --- KeywordDict ----------------------------------------------------------------------------------------------------
+/**
+ * KeywordDict
+ *  Exact membership of tokens in a fixed set of keywords (stop words, reserved identifiers, ...) of up to 32 bytes.
+ *  Keywords are bucketed by size, each size has its own perfect hash table. A token is loaded into one AVX2 vector
+ *  (zero padded), hashed and confirmed by one vector compare with the only slot it can occupy, so a lookup touches
+ *  one slot cache line. Equal keywords resolve to the lowest keyword id.
+ *
+ *  Token loads read up to 32 bytes from the token begin but never cross a page boundary behind the token.
+ */
+typedef struct {
+        KeywordTable tables[KEYWORD_DICT_MAX_SIZE + 1];
+        uint16_t* displacements;
+        KeywordSlot* slots;
+        size_t num_keywords;
+} KeywordDict;
+
+/**
+ * Compile keywords[0, num_keywords) (copied, keyword ids are the indices). Returns 0 on success, -1 if a keyword is
+ *  longer than KEYWORD_DICT_MAX_SIZE, there are more than INT32_MAX keywords or memory could not be allocated.
+ */
+int KeywordDict_init (KeywordDict* self, const Pattern* keywords, size_t num_keywords);
+
+/**
+ * Id of the keyword equal to str[0, str_size), -1 if there is none.
+ */
+int32_t KeywordDict_find (const KeywordDict* self, const char* str, size_t str_size);
+
+/**
+ * KeywordDict_find for tokens[0, num_tokens), the keyword ids are stored in keyword_ids. Tokens are processed in
+ *  groups of 8: all 8 are hashed and their slots prefetched before the first one is compared, so the cache misses of
+ *  a group overlap.
+ */
+void KeywordDict_find_all (const KeywordDict* self, const Pattern* tokens, size_t num_tokens, int32_t* keyword_ids);
+
+void KeywordDict_destroy (KeywordDict* self);
+// ___ KeywordDict ____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_KEYWORD_DICT_H
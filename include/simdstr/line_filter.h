@@ -0,0 +1,63 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_LINE_FILTER_H
+#define SIMD_STRING_LINE_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+
+// --- LineRange ------------------------------------------------------------------------------------------------------
+/**
+ * LineRange
+ *  Line [begin, end) as offsets into the filtered buffer, end is the offset of the newline (or the buffer size).
+ */
+typedef struct {
+        uint64_t begin;
+        uint64_t end;
+} LineRange;
+// ___ LineRange ______________________________________________________________________________________________________
+
+// --- LineFilter -----------------------------------------------------------------------------------------------------
+/**
+ * LineFilter
+ *  Iterates over the lines of a buffer that contain a match of a Searcher. After a match, the rest of its line is not
+ *  searched: the filter jumps to the next newline (simd_strchr) and resumes the search at the following line.
+ *
+ *  Usage:
+ *    LineFilter_init (&filter, &searcher, str, str_size);
+ *    while ((n = LineFilter_next (&filter, lines, capacity)) > 0) ...
+ */
+typedef struct {
+        const Searcher* searcher;
+        char* str;
+        size_t str_size;
+
+        // start of the first line not filtered yet
+        size_t pos;
+} LineFilter;
+
+/**
+ * str MUST outlive the filter.
+ */
+void LineFilter_init (LineFilter* self, const Searcher* searcher, char* str, size_t str_size);
+
+/**
+ * Write the next (up to capacity) matching lines to lines. Returns the number of lines written, 0 once all lines are
+ *  filtered.
+ */
+size_t LineFilter_next (LineFilter* self, LineRange* lines, size_t capacity);
+
+/**
+ * Number of lines of str[0, str_size) containing a match.
+ */
+size_t line_filter_count (const Searcher* searcher, char* str, size_t str_size);
+// ___ LineFilter _____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_LINE_FILTER_H
@@ -0,0 +1,87 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_LINE_INDEX_H
+#define SIMD_STRING_LINE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// distance in bytes between two checkpoints of a LineIndex
+#define LINE_INDEX_SAMPLE_SIZE 4096
+
+// --- LineIndex ------------------------------------------------------------------------------------------------------
+/**
+ * LineIndex
+ *  Sampled line index of a buffer: checkpoints[k] is the number of newlines before offset k * LINE_INDEX_SAMPLE_SIZE.
+ *  The exact line of an offset is resolved by counting the newlines (simd_count_char) between the preceding
+ *  checkpoint and the offset, i.e. at most LINE_INDEX_SAMPLE_SIZE bytes. Lines and columns are 1-based.
+ */
+typedef struct {
+        const char* data;
+        size_t size;
+
+        uint64_t* checkpoints;
+        size_t num_checkpoints;
+        // number of lines (a last line without trailing newline counts as well)
+        uint64_t num_lines;
+} LineIndex;
+
+/**
+ * Build the index of data[0, size) in one pass. data MUST outlive the index. Returns 0 on success, -1 if memory could
+ *  not be allocated.
+ */
+int LineIndex_init (LineIndex* self, const char* data, size_t size);
+
+/**
+ * Line of the byte at offset (offset == size is the position after the last byte).
+ */
+uint64_t LineIndex_line (const LineIndex* self, size_t offset);
+
+/**
+ * Line and column of the byte at offset.
+ */
+void LineIndex_position (const LineIndex* self, size_t offset, uint64_t* line, uint64_t* column);
+
+/**
+ * Bounds [*begin, *end) of the line containing offset, *end is the offset of its newline (or size).
+ */
+void LineIndex_line_bounds (const LineIndex* self, size_t offset, size_t* begin, size_t* end);
+
+/**
+ * Offset of the first byte of line (size if line > num_lines).
+ */
+size_t LineIndex_line_start (const LineIndex* self, uint64_t line);
+
+void LineIndex_destroy (LineIndex* self);
+// ___ LineIndex ______________________________________________________________________________________________________
+
+// --- LineCursor -----------------------------------------------------------------------------------------------------
+/**
+ * LineCursor
+ *  Incremental line numbers for ascending offsets (e.g. the matches of a find-all): each lookup only counts the
+ *  newlines since the previous one, so a scan over all matches costs one pass over the buffer. Offsets smaller than
+ *  the previous one fall back to the index (if any) or a recount from the start.
+ */
+typedef struct {
+        const char* data;
+        size_t size;
+        const LineIndex* index;
+
+        size_t offset;
+        uint64_t line;
+} LineCursor;
+
+/**
+ * index may be NULL.
+ */
+void LineCursor_init (LineCursor* self, const char* data, size_t size, const LineIndex* index);
+
+uint64_t LineCursor_line (LineCursor* self, size_t offset);
+// ___ LineCursor _____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_LINE_INDEX_H
@@ -0,0 +1,123 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_MAPPED_CORPUS_H
+#define SIMD_STRING_MAPPED_CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/thread_pool.h>
+#include <simdstr/types.h>
+
+#define NUMA_MAX_NODES 64
+#define NUMA_MAX_CPUS 1024
+
+// fault in all pages before the mapping is returned (after the madvise hints, so huge pages can back them)
+#define MAPPED_CORPUS_POPULATE 0x1
+// madvise (MADV_HUGEPAGE): back the mapping with transparent huge pages where the kernel supports it
+#define MAPPED_CORPUS_HUGEPAGE 0x2
+// madvise (MADV_SEQUENTIAL): aggressive read ahead, early reclaim of scanned pages
+#define MAPPED_CORPUS_SEQUENTIAL 0x4
+// copy the file into anonymous memory instead of mapping the page cache (THP always applies to anonymous memory)
+#define MAPPED_CORPUS_COPY 0x8
+#define MAPPED_CORPUS_DEFAULT (MAPPED_CORPUS_POPULATE | MAPPED_CORPUS_HUGEPAGE | MAPPED_CORPUS_SEQUENTIAL)
+
+// default distance (in bytes) between the scanned position and the software prefetched position
+#define CORPUS_PREFETCH_DISTANCE (1u << 14)
+
+// --- NumaTopology ---------------------------------------------------------------------------------------------------
+/**
+ * NumaTopology
+ *  NUMA nodes and the CPUs attached to them. cpus[i] is a bitmap of the CPUs of node node_ids[i].
+ */
+typedef struct {
+        unsigned num_nodes;
+        int node_ids[NUMA_MAX_NODES];
+        unsigned num_cpus[NUMA_MAX_NODES];
+        uint64_t cpus[NUMA_MAX_NODES][NUMA_MAX_CPUS / 64];
+} NumaTopology;
+
+/**
+ * Read the topology from sysfs_root (NULL: /sys/devices/system/node, i.e. the node<id>/cpulist files). Without NUMA
+ *  information a single node 0 holding all online CPUs is assumed.
+ */
+void NumaTopology_discover (NumaTopology* self, const char* sysfs_root);
+
+/**
+ * Index of node_id in self->node_ids or -1.
+ */
+int NumaTopology_node_index (const NumaTopology* self, int node_id);
+
+/**
+ * Index of the node holding cpu or -1.
+ */
+int NumaTopology_cpu_node (const NumaTopology* self, unsigned cpu);
+
+/**
+ * Store the NUMA node id of the pages holding addresses[0, n) in nodes (-1 if unknown, e.g. page not resident or no
+ *  NUMA support). Returns 0 if the kernel could be queried, -1 otherwise.
+ */
+int numa_page_nodes (void* const* addresses, size_t n, int* nodes);
+// ___ NumaTopology ___________________________________________________________________________________________________
+
+// --- MappedCorpus ---------------------------------------------------------------------------------------------------
+/**
+ * MappedCorpus
+ *  Read only memory mapped file. huge_pages is set if madvise (MADV_HUGEPAGE) was accepted for the mapping.
+ */
+typedef struct {
+        char* data;
+        size_t size;
+        void* mapping;
+        size_t mapping_size;
+        int flags;
+        int huge_pages;
+} MappedCorpus;
+
+/**
+ * Map the file at path using MAPPED_CORPUS_* flags. Returns 0 on success, -1 on failure (errno is set).
+ */
+int MappedCorpus_open (MappedCorpus* self, const char* path, int flags);
+
+void MappedCorpus_close (MappedCorpus* self);
+// ___ MappedCorpus ___________________________________________________________________________________________________
+
+// --- CorpusScanner --------------------------------------------------------------------------------------------------
+/**
+ * CorpusScanner
+ *  Thread pool whose workers are pinned to NUMA nodes. Buffers are split into chunks (like parallel_find_all) and each
+ *  chunk is scanned preferably by a worker of the node holding its pages; workers of other nodes only take over once
+ *  their own node has no chunks left. The calling thread (worker 0) is not pinned and serves the node it runs on.
+ */
+typedef struct {
+        NumaTopology topology;
+        ThreadPool pool;
+        unsigned num_workers;
+        int* worker_nodes;
+} CorpusScanner;
+
+/**
+ * Start num_threads workers (0: one per CPU of topology) distributed round robin over the nodes of topology.
+ *  num_workers receives the number of workers actually started (fewer if a thread could not be created). Returns 0 on
+ *  success, -1 on failure.
+ */
+int CorpusScanner_init (CorpusScanner* self, const NumaTopology* topology, unsigned num_threads);
+
+/**
+ * All matches in str[0, str_size) ordered by their start (see parallel_find_all). chunk_size == 0 uses
+ *  PARALLEL_SEARCH_CHUNK_SIZE. If prefetch_distance > 0, the bytes prefetch_distance ahead of the scanned position are
+ *  prefetched in software. Returns the number of matches or SIZE_MAX if memory could not be allocated.
+ */
+size_t CorpusScanner_find_all (CorpusScanner* self, const Searcher* searcher, char* str, size_t str_size,
+                               size_t chunk_size, size_t prefetch_distance, Match** matches);
+
+void CorpusScanner_destroy (CorpusScanner* self);
+// ___ CorpusScanner __________________________________________________________________________________________________
+
+#endif//SIMD_STRING_MAPPED_CORPUS_H
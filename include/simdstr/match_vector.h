@@ -0,0 +1,54 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_MATCH_VECTOR_H
+#define SIMD_STRING_MATCH_VECTOR_H
+
+#include <stddef.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/types.h>
+
+// --- MatchVector ----------------------------------------------------------------------------------------------------
+/**
+ * MatchVector
+ *  Growable array of matches. failed is set if memory could not be allocated, further pushes are ignored.
+ */
+typedef struct {
+        Match* matches;
+        size_t size;
+        size_t capacity;
+        int failed;
+} MatchVector;
+
+void MatchVector_init (MatchVector* self);
+
+void MatchVector_push (MatchVector* self, Match match);
+
+void MatchVector_free (MatchVector* self);
+
+/**
+ * Push all matches of searcher starting in str[0, num_starts). str[0, str_size) with str_size >= num_starts is used to
+ *  verify matches.
+ */
+void MatchVector_find_all (MatchVector* self, const Searcher* searcher, char* str, size_t str_size, size_t num_starts);
+
+/**
+ * MatchVector_find_all for the window str[0, str_size) of a larger buffer, before and after are the bytes around it
+ *  (see Searcher_find_window).
+ */
+void MatchVector_find_all_window (MatchVector* self, const Searcher* searcher, char* str, size_t str_size,
+                                  size_t num_starts, int before, int after);
+
+/**
+ * Concatenate vectors[0, num_vectors) into a newly allocated array and free the vectors. Returns the number of matches
+ *  or SIZE_MAX if any allocation failed (*matches is NULL then).
+ */
+size_t MatchVector_merge (MatchVector* vectors, size_t num_vectors, Match** matches);
+// ___ MatchVector ____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_MATCH_VECTOR_H
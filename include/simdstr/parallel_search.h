@@ -0,0 +1,40 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_PARALLEL_SEARCH_H
+#define SIMD_STRING_PARALLEL_SEARCH_H
+
+#include <stddef.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/thread_pool.h>
+#include <simdstr/types.h>
+
+// default number of start positions scanned by one task
+#define PARALLEL_SEARCH_CHUNK_SIZE (1u << 20)
+
+/*
+ * Parallel search of large buffers: str is split into chunks of chunk_size start positions (0 uses
+ *  PARALLEL_SEARCH_CHUNK_SIZE). Each chunk is scanned including the following max_pattern_size - 1 bytes, so matches
+ *  crossing chunk boundaries are found by the chunk they start in. Chunks are scanned by the workers of pool.
+ */
+
+/**
+ * Leftmost match in str[0, str_size). Once a match is found, chunks right of the leftmost chunk with a match are
+ *  cancelled.
+ */
+Match parallel_find (ThreadPool* pool, const Searcher* searcher, char* str, size_t str_size, size_t chunk_size);
+
+/**
+ * All matches in str[0, str_size) ordered by their start (see SearchStream for the semantics of overlapping matches).
+ *  *matches is allocated with malloc and must be freed by the caller. Returns the number of matches or SIZE_MAX if
+ *  memory could not be allocated.
+ */
+size_t parallel_find_all (ThreadPool* pool, const Searcher* searcher, char* str, size_t str_size, size_t chunk_size,
+                          Match** matches);
+
+#endif//SIMD_STRING_PARALLEL_SEARCH_H
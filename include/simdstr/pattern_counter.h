@@ -0,0 +1,63 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_PATTERN_COUNTER_H
+#define SIMD_STRING_PATTERN_COUNTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/slim_teddy.h>
+#include <simdstr/thread_pool.h>
+#include <simdstr/types.h>
+
+// patterns per Slim Teddy
+#define PATTERN_COUNTER_GROUP_SIZE 64
+// default number of start positions counted by one task
+#define PATTERN_COUNTER_CHUNK_SIZE (1u << 20)
+
+// --- PatternCounter -------------------------------------------------------------------------------------------------
+/**
+ * PatternCounter
+ *  Occurrence histogram of any number of patterns. Patterns are sorted by size and split into groups of
+ *  PATTERN_COUNTER_GROUP_SIZE, each compiled into a Slim Teddy counting directly from verification (see
+ *  SlimTeddy_count), so no Match is ever produced. Chunks are counted by all groups while they are in cache.
+ */
+typedef struct {
+        // patterns in group order, pattern_ids maps them to the ids passed to PatternCounter_init
+        Pattern* patterns;
+        size_t* pattern_ids;
+        size_t num_patterns;
+        size_t max_pattern_size;
+
+        SlimTeddy* teddies;
+        size_t num_teddies;
+} PatternCounter;
+
+/**
+ * Compile patterns[0, num_patterns) (not copied, MUST outlive the counter). icase counts ASCII case insensitively.
+ *  Returns 0 on success, -1 if a pattern is empty or memory could not be allocated.
+ */
+int PatternCounter_init (PatternCounter* self, const Pattern* patterns, size_t num_patterns, int icase);
+
+/**
+ * Add the occurrences starting in str[0, num_starts) to counts[pattern_id] (see SlimTeddy_count for the semantics).
+ */
+void PatternCounter_count (const PatternCounter* self, char* str, size_t str_size, size_t num_starts, uint64_t* counts);
+
+/**
+ * Same as PatternCounter_count over str[0, str_size) using the workers of pool: str is split into chunks of chunk_size
+ *  start positions (0 uses PATTERN_COUNTER_CHUNK_SIZE), every worker accumulates into its own counter array and the
+ *  arrays are merged into counts at the end. Returns 0 on success, -1 if memory could not be allocated.
+ */
+int PatternCounter_parallel_count (const PatternCounter* self, ThreadPool* pool, char* str, size_t str_size,
+                                   size_t chunk_size, uint64_t* counts);
+
+void PatternCounter_destroy (PatternCounter* self);
+// ___ PatternCounter _________________________________________________________________________________________________
+
+#endif//SIMD_STRING_PATTERN_COUNTER_H
@@ -0,0 +1,47 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_PATTERN_SYNTAX_H
+#define SIMD_STRING_PATTERN_SYNTAX_H
+
+#include <stdint.h>
+
+/*
+ * Escape and class syntax shared by ShiftOr, Regex and Signature. Byte sets are bitmaps of 32 bytes (bit byte % 8 of
+ *  set[byte / 8]). Escapes after '\': "d" ([0-9]), "w" ([A-Za-z0-9_]), "s" (whitespace) and their negations "D", "W",
+ *  "S", "xHH" (the byte 0xHH), "n", "t", "r", "0" as in C, any other byte stands for itself.
+ */
+
+/**
+ * Add the bytes [first, last] to set.
+ */
+void pattern_set_add (uint8_t* set, unsigned first, unsigned last);
+
+/**
+ * Add the other case of every ASCII letter of set.
+ */
+void pattern_set_fold (uint8_t* set);
+
+/**
+ * Value of the hex digit c, -1 if c is none.
+ */
+int pattern_hex_digit (char c);
+
+/**
+ * Escape sequence at *cur (after the '\', the pattern ends at end): a shorthand class is added to set (returns 1), a
+ *  single byte is stored in byte (returns 0). Returns -1 on a syntax error. *cur is advanced past the sequence.
+ */
+int pattern_parse_escape (const char** cur, const char* end, uint8_t* set, uint8_t* byte);
+
+/**
+ * Class at *cur (after the '[', up to and including the closing ']') with ranges, escapes and a leading '^' negating
+ *  it. set receives the members. icase adds the other case of every letter before negating ("[^a]" excludes 'A' as
+ *  well). Returns 0 on success, -1 on a syntax error.
+ */
+int pattern_parse_class (const char** cur, const char* end, uint8_t* set, int icase);
+
+#endif//SIMD_STRING_PATTERN_SYNTAX_H
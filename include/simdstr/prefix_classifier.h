@@ -0,0 +1,75 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_PREFIX_CLASSIFIER_H
+#define SIMD_STRING_PREFIX_CLASSIFIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/types.h>
+
+// --- PrefixNode -----------------------------------------------------------------------------------------------------
+/**
+ * PrefixNode
+ *  Node of the compressed trie: the label (labels[label, label + label_size)) is matched before the node is
+ *  reached, pattern_id is the pattern ending there (-1 if none). The edges to the children are the bytes
+ *  edges[edges, edges + num_edges) in ascending order, children holds the child node at the same index.
+ */
+typedef struct {
+        uint32_t label;
+        uint32_t label_size;
+        uint32_t edges;
+        uint32_t num_edges;
+        int32_t pattern_id;
+} PrefixNode;
+// ___ PrefixNode _____________________________________________________________________________________________________
+
+// --- PrefixClassifier -----------------------------------------------------------------------------------------------
+/**
+ * PrefixClassifier
+ *  Anchored matcher answering "which pattern is the longest prefix of the input". The patterns are compiled into a
+ *  compressed trie (single child chains are merged into labels compared with memcmp). The first byte after the root
+ *  label is resolved through a 256 entry table, the other branch nodes compare the input byte with 32 edge bytes per
+ *  AVX2 compare. Equal patterns resolve to the lowest pattern id.
+ */
+typedef struct {
+        PrefixNode* nodes;
+        size_t num_nodes;
+        char* labels;
+        size_t labels_size;
+        // edge lists padded to 32 bytes
+        uint8_t* edges;
+        uint32_t* children;
+        size_t num_edges;
+        // child of the root per byte (-1: none)
+        int32_t root_children[256];
+        size_t num_patterns;
+} PrefixClassifier;
+
+/**
+ * Compile patterns[0, num_patterns) (copied, pattern ids are the indices). Returns 0 on success, -1 if memory could
+ *  not be allocated or there are more than INT32_MAX patterns.
+ */
+int PrefixClassifier_init (PrefixClassifier* self, const Pattern* patterns, size_t num_patterns);
+
+/**
+ * Id of the longest pattern that is a prefix of str[0, str_size), -1 if there is none. The size of that pattern is
+ *  stored in prefix_size unless it is NULL.
+ */
+int32_t PrefixClassifier_find (const PrefixClassifier* self, const char* str, size_t str_size, size_t* prefix_size);
+
+/**
+ * PrefixClassifier_find for strings[0, num_strings), the pattern ids are stored in pattern_ids.
+ */
+void PrefixClassifier_classify (const PrefixClassifier* self, const Pattern* strings, size_t num_strings,
+                                int32_t* pattern_ids);
+
+void PrefixClassifier_destroy (PrefixClassifier* self);
+// ___ PrefixClassifier _______________________________________________________________________________________________
+
+#endif//SIMD_STRING_PREFIX_CLASSIFIER_H
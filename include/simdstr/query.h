@@ -0,0 +1,117 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_QUERY_H
+#define SIMD_STRING_QUERY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/slim_teddy.h>
+#include <simdstr/types.h>
+
+#define QUERY_MAX_TERMS 64
+#define QUERY_MAX_NODES 256
+
+typedef enum {
+        QUERY_TERM,
+        QUERY_AND,
+        QUERY_OR,
+        QUERY_NOT,
+} QueryNodeKind;
+
+// node of the expression tree: term index for QUERY_TERM, children for AND/OR, left child for NOT
+typedef struct {
+        QueryNodeKind kind;
+        uint8_t term;
+        int16_t left;
+        int16_t right;
+} QueryNode;
+
+// --- QueryResult ----------------------------------------------------------------------------------------------------
+/**
+ * QueryResult
+ *  match: the document satisfies the query. hits: bitset of the terms found before the result was decided.
+ *  scanned: number of document bytes searched until the result was decided.
+ */
+typedef struct {
+        int match;
+        uint64_t hits;
+        size_t scanned;
+} QueryResult;
+// ___ QueryResult ____________________________________________________________________________________________________
+
+// --- Query ----------------------------------------------------------------------------------------------------------
+/**
+ * Query
+ *  Boolean expression over the containment of terms (e.g. "A and B but not C"). All terms are compiled into one
+ *  matcher (needle search for a single term, Slim Teddy otherwise), so a document is scanned once. Every new term hit
+ *  updates a bitset and the expression is evaluated three-valued (terms not hit yet are unknown); the scan stops as
+ *  soon as the result no longer depends on the rest of the document.
+ *
+ *  Build the expression with Query_term/and/or/not or Query_parse, then call Query_compile. A compiled Query MUST NOT
+ *  be moved (its Searcher refers to its Teddy).
+ */
+typedef struct {
+        QueryNode nodes[QUERY_MAX_NODES];
+        int16_t num_nodes;
+        int16_t root;
+
+        Pattern terms[QUERY_MAX_TERMS];
+        uint8_t num_terms;
+        // unescaped terms of Query_parse
+        char* text;
+        size_t text_size;
+
+        // icase of Query_compile
+        int icase;
+        Searcher searcher;
+        SlimTeddy teddy;
+} Query;
+
+void Query_init (Query* self);
+
+/**
+ * Node for containment of term[0, term_size) (not copied, MUST outlive the Query). Equal terms share one term index.
+ *  Returns the node index or -1 (empty term, too many terms or nodes).
+ */
+int Query_term (Query* self, const char* term, size_t term_size);
+
+int Query_and (Query* self, int left, int right);
+
+int Query_or (Query* self, int left, int right);
+
+int Query_not (Query* self, int child);
+
+/**
+ * Parse expression into nodes and return the root node or -1 on a syntax error. Syntax: terms are words or double
+ *  quoted strings (\" and \\ escapes), '!' negates, '&' or juxtaposition is AND, '|' is OR (lowest precedence),
+ *  parentheses group. Example: error & (timeout | "connection refused") & !debug
+ */
+int Query_parse (Query* self, const char* expression);
+
+/**
+ * Compile the terms for the expression rooted at root. Returns 0 on success, -1 if the query has no terms or root is
+ *  invalid.
+ */
+int Query_compile (Query* self, int root, int icase);
+
+QueryResult Query_eval (const Query* self, char* doc, size_t doc_size);
+
+int Query_match (const Query* self, char* doc, size_t doc_size);
+
+/**
+ * Evaluate the query for docs[0, num_docs) and set results[i] to 1 for matching documents. Returns the number of
+ *  matching documents.
+ */
+size_t Query_filter (const Query* self, const Pattern* docs, size_t num_docs, uint8_t* results);
+
+void Query_destroy (Query* self);
+// ___ Query __________________________________________________________________________________________________________
+
+#endif//SIMD_STRING_QUERY_H
@@ -0,0 +1,117 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_REGEX_H
+#define SIMD_STRING_REGEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/slim_teddy.h>
+#include <simdstr/types.h>
+
+// byte classes of a pattern (after expanding {n,m}); position 0 is the automaton start
+#define REGEX_MAX_POSITIONS 256
+#define REGEX_MAX_NODES 1024
+// required literal set handed to the prefilter
+#define REGEX_MAX_LITERALS 8
+#define REGEX_MAX_LITERAL_SIZE 32
+// lazy DFA states cached before the cache is flushed (about 1 KiB each)
+#define REGEX_DEFAULT_CACHE_STATES 512
+
+// --- RegexState -----------------------------------------------------------------------------------------------------
+/**
+ * RegexState
+ *  Cached DFA state: a set of automaton positions and its transitions (-1: not computed yet). Unanchored states
+ *  restart the automaton at every byte. Reverse states belong to the reversed automaton, which reads a line backwards
+ *  to find the leftmost match start.
+ */
+typedef struct {
+        uint64_t set[REGEX_MAX_POSITIONS / 64];
+        uint8_t unanchored;
+        uint8_t reverse;
+        uint8_t accepting;
+        int32_t next[256];
+} RegexState;
+// ___ RegexState _____________________________________________________________________________________________________
+
+// --- Regex ----------------------------------------------------------------------------------------------------------
+/**
+ * Regex
+ *  Regular expression matcher for patterns with required literals (e.g. "ERROR .* timeout=\d+"). Compilation
+ *  extracts a set of literals every match contains ("timeout=") and compiles it into a Searcher (simd_strstr or Slim
+ *  Teddy). Only the lines containing a literal hit are verified by a lazily built DFA: a DFA state is computed on its
+ *  first use and cached, the cache is flushed when it holds cache_states states. Patterns without required literals
+ *  verify every line.
+ *
+ *  Matches never span lines: "." and negated classes do not match '\n'. The leftmost-longest match is reported: the
+ *  reversed automaton scans a candidate line backwards for the leftmost match start, the forward automaton extends
+ *  the match from there. Both passes are linear in the line size.
+ *
+ *  Syntax: bytes match themselves, except "." (any byte but '\n'), "[a-z_]" / "[^,]" (classes with ranges and
+ *  negation), "\d" / "\w" / "\s" and their negations "\D" / "\W" / "\S", "\xHH", "\n", "\t", "\r", "\0", "\"
+ *  escaping any other byte, "(" ")" (groups), "|" (alternation) and the quantifiers "*", "+", "?", "{n}", "{n,}",
+ *  "{n,m}". A leading "^" and a trailing "$" anchor the match to the line start/end.
+ *
+ *  Matching updates the DFA cache: a Regex MUST NOT be shared between threads. A compiled Regex MUST NOT be moved
+ *  (its Searcher refers to its Teddy).
+ */
+typedef struct {
+        // Glushkov automaton: follow[p] are the positions following position p, byte_positions[c] the positions
+        //  accepting byte c, last the accepting positions (including 0 for patterns matching the empty string)
+        uint64_t follow[REGEX_MAX_POSITIONS][REGEX_MAX_POSITIONS / 64];
+        uint64_t byte_positions[256][REGEX_MAX_POSITIONS / 64];
+        uint64_t last[REGEX_MAX_POSITIONS / 64];
+        // reversed automaton: reverse_follow[q] are the positions p with q in follow[p] (reverse_follow[0]: the last
+        //  positions), first the positions starting a match (the accepting ones, including 0 if the pattern matches
+        //  the empty string)
+        uint64_t reverse_follow[REGEX_MAX_POSITIONS][REGEX_MAX_POSITIONS / 64];
+        uint64_t first[REGEX_MAX_POSITIONS / 64];
+        uint16_t num_positions;
+        int anchored_start;
+        int anchored_end;
+
+        // required literals (lower case if icase), 0 if there are none
+        char literals[REGEX_MAX_LITERALS][REGEX_MAX_LITERAL_SIZE];
+        Pattern literal_patterns[REGEX_MAX_LITERALS];
+        uint8_t num_literals;
+        Searcher searcher;
+        SlimTeddy teddy;
+
+        // DFA cache: states[0] is the dead state, states[1] the anchored and states[2] the unanchored start, states[3]
+        //  and states[4] the same for the reversed automaton
+        RegexState* states;
+        size_t num_states;
+        size_t cache_states;
+        // open addressing hash table of state indices (-1: empty)
+        int32_t* table;
+        size_t table_size;
+        size_t num_flushes;
+} Regex;
+
+/**
+ * Compile pattern (see the syntax above). icase matches ASCII letters case insensitively. cache_states bounds the
+ *  DFA cache (0: REGEX_DEFAULT_CACHE_STATES, at least 8). Returns 0 on success, -1 on a syntax error or if a limit is
+ *  exceeded.
+ */
+int Regex_compile (Regex* self, const char* pattern, int icase, size_t cache_states);
+
+/**
+ * Leftmost-longest match in str[0, str_size). Returns Match_empty () if there is none (pattern_id is 0 otherwise).
+ */
+Match Regex_find (Regex* self, char* str, size_t str_size);
+
+/**
+ * Leftmost-longest match in str[0, str_size) that begins at or after from. The bytes before from are visible to "^".
+ */
+Match Regex_find_from (Regex* self, char* str, size_t str_size, size_t from);
+
+void Regex_destroy (Regex* self);
+// ___ Regex __________________________________________________________________________________________________________
+
+#endif//SIMD_STRING_REGEX_H
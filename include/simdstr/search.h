@@ -31,6 +31,18 @@ simd_strchr (const char *str, size_t str_len, int c);
 const char *
 simd_strichr (const char *str, size_t str_len, int c);
 
+/**
+ * AVX2 based number of occurrences of c in str[0, str_len) (popcount over compare masks, 128 bytes per iteration).
+ */
+size_t
+simd_count_char (const char *str, size_t str_len, int c);
+
+/**
+ * AVX2 based memrchr: last occurrence of c in str[0, str_len).
+ */
+const char *
+simd_memrchr (const char *str, size_t str_len, int c);
+
 /**
  * SIMD based strstr implementation using available SIMD instruction sets with fallback to clib's strstr if no SIMD instructions are available.
  */
@@ -44,4 +56,10 @@ simd_strstr (const char *str, size_t str_len, const char *substr, size_t substr_
 const char *
 simd_stristr (const char *str, size_t str_len, const char *substr, size_t substr_len);
 
+/**
+ * ASCII case insensitive memcmp.
+ */
+int
+icase_memcmp (const char *str1, const char *str2, size_t size);
+
 #endif  // SIMDSTR_H_
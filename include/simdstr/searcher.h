@@ -0,0 +1,109 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_SEARCHER_H
+#define SIMD_STRING_SEARCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/fat_teddy.h>
+#include <simdstr/slim_teddy.h>
+#include <simdstr/types.h>
+
+// match flags (see Searcher_set_flags)
+// the match is preceded and followed by a non-word byte ([A-Za-z0-9_] are word bytes) or the buffer edge
+#define SEARCH_WORD (1u << 0)
+// the match begins at the buffer start or after a '\n'
+#define SEARCH_LINE_START (1u << 1)
+// the match ends at the buffer end or before a '\n'
+#define SEARCH_LINE_END (1u << 2)
+// the match begins at the buffer start
+#define SEARCH_BUFFER_START (1u << 3)
+// the match ends at the buffer end
+#define SEARCH_BUFFER_END (1u << 4)
+
+// before/after byte of Searcher_find_window: the window edge is the buffer edge
+#define SEARCH_EDGE (-1)
+
+// --- Searcher -------------------------------------------------------------------------------------------------------
+typedef enum {
+        SEARCHER_NEEDLE,
+        SEARCHER_SLIM_TEDDY,
+        SEARCHER_FAT_TEDDY,
+} SearcherKind;
+
+/**
+ * Searcher
+ *  Common interface of the compiled single-needle (simd_strstr) and multi-pattern (SlimTeddy, FatTeddy) matchers.
+ *  Unlike the matchers themselves, Searcher_find accepts haystacks of any size.
+ */
+typedef struct {
+        SearcherKind kind;
+
+        Pattern needle;
+        SlimTeddy* slim_teddy;
+        FatTeddy* fat_teddy;
+
+        size_t min_pattern_size;
+        size_t max_pattern_size;
+
+        // ASCII case insensitive matching (taken from the Teddy matcher)
+        int icase;
+
+        // SEARCH_* match flags
+        uint32_t flags;
+} Searcher;
+
+void Searcher_init_needle (Searcher* self, const char* needle, size_t needle_size);
+
+/**
+ * Case insensitive needle search (simd_stristr).
+ */
+void Searcher_init_needle_icase (Searcher* self, const char* needle, size_t needle_size);
+
+/**
+ * teddy MUST outlive the Searcher.
+ */
+void Searcher_init_slim_teddy (Searcher* self, SlimTeddy* teddy);
+
+/**
+ * teddy MUST outlive the Searcher.
+ */
+void Searcher_init_fat_teddy (Searcher* self, FatTeddy* teddy);
+
+/**
+ * Only report matches satisfying the SEARCH_* flags (0 reports all matches). The buffer is the haystack passed to
+ *  Searcher_find/Searcher_find_from. Scanners that split a buffer into windows (SearchStream, parallel_search, ...)
+ *  pass the bytes around each window to Searcher_find_window, so the flags see the whole buffer.
+ */
+void Searcher_set_flags (Searcher* self, uint32_t flags);
+
+uint16_t Searcher_num_patterns (const Searcher* self);
+
+size_t Searcher_pattern_size (const Searcher* self, uint16_t pattern_id);
+
+/**
+ * Leftmost match that lies completely within str[0, str_size). Returns Match_empty () if there is none.
+ */
+Match Searcher_find (const Searcher* self, char* str, size_t str_size);
+
+/**
+ * Leftmost match in str[0, str_size) that begins at or after from. Unlike Searcher_find (self, str + from, ...), the
+ *  bytes before from are visible to the SEARCH_* flags: use it to resume a scan behind a previous match.
+ */
+Match Searcher_find_from (const Searcher* self, char* str, size_t str_size, size_t from);
+
+/**
+ * Searcher_find_from for the window str[0, str_size) of a larger buffer: before and after are the buffer bytes in
+ *  front of str[0] and behind str[str_size - 1] (as unsigned char), or SEARCH_EDGE where the window edge is the buffer
+ *  edge. Matches lie within the window, the SEARCH_* flags see the bytes around it.
+ */
+Match Searcher_find_window (const Searcher* self, char* str, size_t str_size, size_t from, int before, int after);
+// ___ Searcher _______________________________________________________________________________________________________
+
+#endif//SIMD_STRING_SEARCHER_H
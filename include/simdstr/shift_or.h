@@ -0,0 +1,76 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_SHIFT_OR_H
+#define SIMD_STRING_SHIFT_OR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/types.h>
+
+#define SHIFT_OR_MAX_PATTERN_SIZE 64
+// one 64 bit lane per pattern: two 256 bit or one 512 bit register
+#define SHIFT_OR_MAX_PATTERNS 8
+
+// --- ShiftOr --------------------------------------------------------------------------------------------------------
+/**
+ * ShiftOr
+ *  Bit-parallel (Shift-Or) matcher for up to SHIFT_OR_MAX_PATTERNS fixed-size patterns of up to
+ *  SHIFT_OR_MAX_PATTERN_SIZE positions, each position being a byte class. Every pattern runs in its own 64 bit lane of
+ *  a vector state: per text byte the state is shifted by one and or-ed with the class masks of the byte for all lanes.
+ *
+ *  While no lane has a partial match, the scan skips 32 bytes at a time using a nibble lookup (as mm_lookup_1) of the
+ *  bytes that can start a pattern.
+ *
+ *  Pattern syntax: bytes match themselves, except "." (any byte), "[a-z_]" / "[^,]" (classes with ranges and
+ *  negation), "\d" ([0-9]), "\w" ([A-Za-z0-9_]), "\s" (whitespace) and their negations "\D" / "\W" / "\S", "\xHH",
+ *  "\n", "\t", "\r", "\0" and "\" escaping any other byte. "{n}" repeats the preceding position to n positions in
+ *  total, e.g. "[0-9]{3}-[0-9]{4}".
+ */
+typedef struct {
+        // masks[byte][pattern_id]: bit i is cleared if byte matches position i of the pattern
+        uint64_t masks[256][SHIFT_OR_MAX_PATTERNS];
+        // bit (size - 1) of every pattern (0 for unused lanes)
+        uint64_t match_bits[SHIFT_OR_MAX_PATTERNS];
+        // bits [size - 1, 64) of every pattern: lanes without partial matches are all ones besides these bits
+        uint64_t ignore_bits[SHIFT_OR_MAX_PATTERNS];
+        uint8_t sizes[SHIFT_OR_MAX_PATTERNS];
+        uint8_t num_patterns;
+        uint8_t max_pattern_size;
+
+        // bitmap of the bytes matching the first position of any pattern, as nibble lookup tables: bit (hi & 7) of
+        // start_lo[lo] (hi < 8) or start_hi[lo] (hi >= 8) is set for the byte hi << 4 | lo
+        uint8_t start_lo[16];
+        uint8_t start_hi[16];
+} ShiftOr;
+
+/**
+ * Compile patterns[0, num_patterns) (see the syntax above). icase adds the other ASCII case of every letter to its
+ *  position, classes are folded before they are negated ("[^a]" matches neither 'a' nor 'A'). Returns 0 on success,
+ *  -1 on a syntax error or if a limit is exceeded.
+ */
+int ShiftOr_init (ShiftOr* self, const char* const* patterns, uint8_t num_patterns, int icase);
+
+/**
+ * Leftmost match in str[0, str_size) (the lowest pattern id among matches starting at the same position). Uses the
+ *  512 bit kernel if avx512 () and the 256 bit kernel otherwise.
+ */
+Match ShiftOr_find (const ShiftOr* self, char* str, size_t str_size);
+
+/**
+ * ShiftOr_find with the state in two 256 bit registers (one if num_patterns <= 4).
+ */
+Match ShiftOr_find_avx_32 (const ShiftOr* self, char* str, size_t str_size);
+
+/**
+ * ShiftOr_find with the state in one 512 bit register.
+ */
+Match ShiftOr_find_avx_64 (const ShiftOr* self, char* str, size_t str_size);
+// ___ ShiftOr ________________________________________________________________________________________________________
+
+#endif//SIMD_STRING_SHIFT_OR_H
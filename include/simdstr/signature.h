@@ -0,0 +1,107 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_SIGNATURE_H
+#define SIMD_STRING_SIGNATURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/types.h>
+
+// maximal number of byte positions of a signature (gaps not counted)
+#define SIGNATURE_MAX_SIZE 256
+#define SIGNATURE_MAX_SEGMENTS 16
+// maximal number of byte classes that cannot be expressed as value/care mask
+#define SIGNATURE_MAX_CLASSES 16
+// maximal size of a match including the gaps
+#define SIGNATURE_MAX_SPAN 4096
+// gap of '*' in the text syntax: {0,SIGNATURE_STAR_GAP}
+#define SIGNATURE_STAR_GAP 256
+
+// --- SignatureSegment -----------------------------------------------------------------------------------------------
+/**
+ * SignatureSegment
+ *  Run of byte positions [begin, begin + size) without gaps, preceded by a gap of [gap_min, gap_max] arbitrary bytes
+ *  (0 for the first segment). min_offset/max_offset bound the start of the segment relative to the match start.
+ */
+typedef struct {
+        uint16_t begin;
+        uint16_t size;
+        uint16_t gap_min;
+        uint16_t gap_max;
+        uint16_t min_offset;
+        uint16_t max_offset;
+        // some position has a byte class that is checked exactly after the masked compare
+        uint8_t has_classes;
+} SignatureSegment;
+// ___ SignatureSegment _______________________________________________________________________________________________
+
+// --- Signature ------------------------------------------------------------------------------------------------------
+/**
+ * Signature
+ *  Byte pattern with single byte wildcards, byte classes and bounded gaps, e.g. the hex signature
+ *  "4D 5A ?? ?? 50 45" or the text pattern "user=*;id=". Every position is matched by a masked compare
+ *  ((byte & mask) == value, 32 positions per AVX2 compare); classes that are no value/mask pair (e.g. [a-z]) are
+ *  checked exactly afterwards. Gaps split the signature into segments whose possible placements are tracked as a set
+ *  of reachable offsets, so every placement of the gaps is considered.
+ *
+ *  Candidates are filtered by two anchors: the two rarest (byte frequency model) exact bytes of a segment are
+ *  compared for 32 placements of the segment at once, like the two byte filter of simd_strstr but at arbitrary
+ *  positions of the signature. The anchors come from the segment whose exact bytes are least likely to match together
+ *  (e.g. "4D 5A" in "?? ?? [2] 4D 5A"). From an anchor hit, the segments in front of the anchored one are verified
+ *  backwards and the ones behind it forwards. A segment with a single exact byte uses one anchor, a signature without
+ *  exact bytes is verified at every position.
+ */
+typedef struct {
+        uint8_t value[SIGNATURE_MAX_SIZE];
+        uint8_t mask[SIGNATURE_MAX_SIZE];
+        // 0 or 1 + index into classes for positions not expressible by value/mask
+        uint8_t class_id[SIGNATURE_MAX_SIZE];
+        uint8_t classes[SIGNATURE_MAX_CLASSES][32];
+        uint8_t num_classes;
+        uint16_t size;
+
+        SignatureSegment segments[SIGNATURE_MAX_SEGMENTS];
+        uint8_t num_segments;
+
+        size_t min_match_size;
+        size_t max_match_size;
+
+        // segment holding the filter bytes and their positions relative to its begin, -1 if unused
+        uint8_t anchor_segment;
+        int16_t anchor0;
+        int16_t anchor1;
+} Signature;
+
+/**
+ * Parse a hex signature. Tokens (whitespace between tokens is optional):
+ *  - "4D": the byte 0x4D
+ *  - "??": any byte, "4?" / "?D": only the given nibble must match
+ *  - "[n]" / "[n-m]": gap of exactly n / of n to m arbitrary bytes
+ *  Returns 0 on success, -1 on a syntax error or if a limit is exceeded.
+ */
+int Signature_parse_hex (Signature* self, const char* hex);
+
+/**
+ * Parse a text pattern. Bytes match themselves, except:
+ *  - "?": any byte
+ *  - "[abc]", "[a-z0-9]", "[^\n]": byte class (ranges, '^' negates)
+ *  - "*": gap of 0 to SIGNATURE_STAR_GAP arbitrary bytes, "{n}" / "{n,m}": gap of exactly n / of n to m bytes
+ *  - "\d" ([0-9]), "\w" ([A-Za-z0-9_]), "\s" (whitespace) and their negations "\D", "\W", "\S" (also in classes)
+ *  - "\": escapes the next byte, "\xHH" is the byte 0xHH, "\n", "\r", "\t" and "\0" as in C
+ *  Returns 0 on success, -1 on a syntax error or if a limit is exceeded.
+ */
+int Signature_parse (Signature* self, const char* pattern);
+
+/**
+ * Leftmost match in str[0, str_size). Of the matches starting there, the one ending first is reported (pattern_id 0).
+ */
+Match Signature_find (const Signature* self, char* str, size_t str_size);
+// ___ Signature ______________________________________________________________________________________________________
+
+#endif//SIMD_STRING_SIGNATURE_H
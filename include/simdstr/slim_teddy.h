@@ -29,6 +29,10 @@ typedef struct {
  */
 typedef struct {
         uint8_t id;
+        // fingerprinted byte of each pattern is offset + id
+        uint8_t offset;
+        // add the fingerprint bytes in upper and lower case
+        uint8_t icase;
         uint8_t lo[32];
         uint8_t hi[32];
 
@@ -54,25 +58,69 @@ typedef struct {
         Pattern* patterns;
         uint8_t num_patterns;
         uint8_t num_masks;
+        // patterns are fingerprinted by their bytes [offset, offset + num_masks)
+        uint8_t offset;
+
+        // ASCII case insensitive matching
+        uint8_t icase;
+
+        // predicted probability that a scanned position yields a candidate (see teddy_false_positive_rate)
+        double false_positive_rate;
 } SlimTeddy;
 
+/**
+ * Initialize SlimTeddy for up to 64 patterns. The fingerprint window (offset) with the lowest predicted false positive
+ *  rate is chosen and patterns are assigned to buckets by shared fingerprint nibbles under the default byte frequency
+ *  model (see teddy_assign_buckets).
+ */
 void SlimTeddy_init (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks);
 
+/**
+ * Same as SlimTeddy_init but assigns buckets under the byte frequency model byte_freq (256 probabilities).
+ */
+void SlimTeddy_init_freq (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, const double* byte_freq);
+
+/**
+ * Same as SlimTeddy_init but matches ASCII case insensitively: the masks accept both cases of each fingerprint byte
+ *  and candidates are verified case insensitively.
+ */
+void SlimTeddy_init_icase (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks);
+
 Match SlimTeddy_find (SlimTeddy* self, char* str, size_t str_size);
 
+/**
+ * Remove pattern_id from its bucket and rebuild the masks: the pattern is no longer matched and a bucket left empty no
+ *  longer produces candidates.
+ */
+void SlimTeddy_retire (SlimTeddy* self, uint8_t pattern_id);
+
+/**
+ * First occurrence of every pattern in str[0, str_size) in a single scan: firsts[pattern_id] receives the leftmost
+ *  match of pattern_id (or Match_empty). Found patterns are retired from a local copy of the matcher as the scan
+ *  proceeds and the scan stops once all patterns are found. Returns the number of patterns found.
+ */
+uint8_t SlimTeddy_find_each (const SlimTeddy* self, char* str, size_t str_size, Match* firsts);
+
+/**
+ * Count the occurrences of every pattern starting in str[0, num_starts) (and ending within str[0, str_size)):
+ *  counts[pattern_id] is incremented directly during verification, no Match is produced. Overlapping occurrences are
+ *  counted, as are occurrences of different patterns at the same position.
+ */
+void SlimTeddy_count (const SlimTeddy* self, char* str, size_t str_size, size_t num_starts, uint64_t* counts);
+
 Match SlimTeddy_find_1(SlimTeddy* self, char* str, size_t str_size);
 Match SlimTeddy_find_2(SlimTeddy* self, char* str, size_t str_size);
 Match SlimTeddy_find_3(SlimTeddy* self, char* str, size_t str_size);
 Match SlimTeddy_find_4(SlimTeddy* self, char* str, size_t str_size);
 
-Match SlimTeddy_find_one_1 (SlimTeddy* self, char* cur, size_t cur_size);
-Match SlimTeddy_find_one_2 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0);
-Match SlimTeddy_find_one_3 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1);
-Match SlimTeddy_find_one_4 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1, __m128i* prev2);
+Match SlimTeddy_find_one_1 (SlimTeddy* self, char* str, char* cur, size_t cur_size);
+Match SlimTeddy_find_one_2 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0);
+Match SlimTeddy_find_one_3 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1);
+Match SlimTeddy_find_one_4 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1, __m128i* prev2);
 
-Match SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* cur, size_t cur_size);
+Match SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* str, char* cur, size_t cur_size);
 
-Match SlimTeddy_verify64 (SlimTeddy* self, uint64_t lane, char* cur, size_t cur_size);
+Match SlimTeddy_verify64 (SlimTeddy* self, uint64_t lane, char* str, char* cur, size_t cur_size);
 
 void mm_lookup_1 (__m128i* chunk, SlimPatternMask* mask, __m128i* res0);
 
@@ -0,0 +1,97 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_STREAM_H
+#define SIMD_STRING_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+
+// --- StreamMatch ----------------------------------------------------------------------------------------------------
+/**
+ * StreamMatch
+ *  Match position as offsets into the stream (all bytes fed since SearchStream_begin).
+ */
+typedef struct {
+        int16_t pattern_id;
+
+        uint64_t begin;
+        uint64_t end;
+} StreamMatch;
+
+/**
+ * Called for every match in order of the match start. Return non-zero to stop the scan.
+ */
+typedef int (*StreamCallback) (const StreamMatch* match, void* user_data);
+// ___ StreamMatch ____________________________________________________________________________________________________
+
+// --- SearchStream ---------------------------------------------------------------------------------------------------
+/**
+ * SearchStream
+ *  Chunked scanner reporting all matches of a Searcher in a stream of arbitrary sized chunks. Matches straddling chunk
+ *  boundaries are found by keeping the last (max_pattern_size - 1) bytes of the stream: their start positions are
+ *  resolved once the next chunk arrives, by scanning a window stitched from the kept bytes and the head of the next
+ *  chunk. Memory is bounded by 2 * max_pattern_size; chunks are never copied otherwise. With SEARCH_* flags, one more
+ *  byte is kept so that the byte behind a match is known, the flags see the whole stream.
+ *
+ *  Usage:
+ *    SearchStream_begin (&stream, &searcher, callback, user_data);
+ *    while (...) SearchStream_feed (&stream, chunk, chunk_size);
+ *    SearchStream_end (&stream);
+ */
+typedef struct {
+        const Searcher* searcher;
+        StreamCallback callback;
+        void* user_data;
+
+        // bytes whose start positions have not been searched yet, pending[0] is at stream offset `offset`
+        char* pending;
+        size_t pending_size;
+        uint64_t offset;
+        // stream byte in front of pending[0], SEARCH_EDGE at the stream start
+        int before;
+
+        // stitched window of pending bytes and the head of the next chunk
+        char* window;
+
+        // pending and window were allocated by SearchStream_begin
+        int owns_buffers;
+        int stopped;
+} SearchStream;
+
+/**
+ * Returns 0 on success, -1 if the internal buffers could not be allocated.
+ */
+int SearchStream_begin (SearchStream* self, const Searcher* searcher, StreamCallback callback, void* user_data);
+
+/**
+ * Size of the buffer required by SearchStream_begin_buffer for searcher.
+ */
+size_t SearchStream_buffer_size (const Searcher* searcher);
+
+/**
+ * Same as SearchStream_begin but uses the caller provided buffer of at least SearchStream_buffer_size (searcher) bytes
+ *  instead of allocating. buffer MUST outlive the stream.
+ */
+void SearchStream_begin_buffer (SearchStream* self, const Searcher* searcher, StreamCallback callback, void* user_data,
+                                char* buffer);
+
+/**
+ * Scan the next chunk of the stream. Returns 1 if the scan was stopped by the callback, 0 otherwise.
+ */
+int SearchStream_feed (SearchStream* self, const char* chunk, size_t chunk_size);
+
+/**
+ * Report the remaining matches and release the internal buffers. Returns 1 if the scan was stopped by the callback,
+ *  0 otherwise.
+ */
+int SearchStream_end (SearchStream* self);
+// ___ SearchStream ___________________________________________________________________________________________________
+
+#endif//SIMD_STRING_STREAM_H
@@ -0,0 +1,82 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_TEDDY_BUCKETS_H
+#define SIMD_STRING_TEDDY_BUCKETS_H
+
+#include <stdint.h>
+
+#include <simdstr/types.h>
+
+// largest fingerprint offset considered when compiling Teddy matchers
+#define TEDDY_MAX_OFFSET 16
+
+// --- TeddyFingerprint -----------------------------------------------------------------------------------------------
+/**
+ * TeddyFingerprint
+ *  Sets of low and high nibbles (one bit per nibble value) per mask. A Teddy bucket fires on a byte if both of its
+ *  nibbles are contained in the sets of the corresponding mask.
+ */
+typedef struct {
+        uint16_t lo[4];
+        uint16_t hi[4];
+} TeddyFingerprint;
+
+void TeddyFingerprint_init (TeddyFingerprint* self);
+
+/**
+ * Add the bytes [offset, offset + num_masks) of pattern to the fingerprint.
+ */
+void TeddyFingerprint_add (TeddyFingerprint* self, const Pattern* pattern, uint8_t offset, uint8_t num_masks);
+
+/**
+ * Probability that the fingerprint fires on a random position of a text with byte distribution byte_freq.
+ */
+double TeddyFingerprint_probability (const TeddyFingerprint* self, uint8_t num_masks, const double* byte_freq);
+// ___ TeddyFingerprint _______________________________________________________________________________________________
+
+/**
+ * Assign num_patterns patterns to num_buckets buckets holding at most bucket_capacity patterns each.
+ *  Patterns are grouped by shared fingerprint nibbles (greedy assignment followed by a local search) such that the
+ *  expected number of candidate bits per scanned byte is minimized under the byte frequency model byte_freq
+ *  (byte_freq_default is used if byte_freq is NULL).
+ *  - patterns are fingerprinted by their bytes [offset, offset + num_masks)
+ *  - bucket_ids[pattern_id] receives the bucket of pattern_id
+ *  - num_patterns MUST be <= num_buckets * bucket_capacity
+ *
+ * Returns the predicted false positive rate (see teddy_false_positive_rate).
+ */
+double teddy_assign_buckets (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset,
+                             uint8_t num_buckets, uint8_t bucket_capacity, const double* byte_freq, uint8_t* bucket_ids);
+
+/**
+ * Predicted probability that a random position of a text with byte distribution byte_freq yields at least one
+ *  candidate bit for the given bucket assignment (byte_freq_default is used if byte_freq is NULL).
+ */
+double teddy_false_positive_rate (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset,
+                                  uint8_t num_buckets, const uint8_t* bucket_ids, const double* byte_freq);
+
+/**
+ * Number of pattern pairs whose fingerprint bytes [offset, offset + num_masks) are identical. Such patterns cannot be
+ *  told apart by the filter and are always verified together.
+ */
+uint32_t teddy_fingerprint_collisions (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset);
+
+/**
+ * Choose the fingerprint window for a Teddy matcher and assign buckets for it (see teddy_assign_buckets).
+ *  Offsets up to TEDDY_MAX_OFFSET that fit into the shortest pattern are considered. The window with the fewest
+ *  fingerprint collisions is chosen (patterns sharing a common prefix are fingerprinted behind the prefix), ties are
+ *  broken by the lowest predicted false positive rate.
+ *  - offset receives the chosen offset
+ *  - bucket_ids[pattern_id] receives the bucket of pattern_id
+ *
+ * Returns the predicted false positive rate for the chosen window.
+ */
+double teddy_choose_offset (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t num_buckets,
+                            uint8_t bucket_capacity, const double* byte_freq, uint8_t* offset, uint8_t* bucket_ids);
+
+#endif//SIMD_STRING_TEDDY_BUCKETS_H
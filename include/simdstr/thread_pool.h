@@ -0,0 +1,74 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_THREAD_POOL_H
+#define SIMD_STRING_THREAD_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Executed for every task id of a ThreadPool_run call. worker_id is in [0, num_threads).
+ */
+typedef void (*ThreadPoolTask) (void* context, size_t task_id, unsigned worker_id);
+
+/**
+ * Executed once by every worker thread (including the calling thread as worker 0) when the pool is started, e.g. to
+ *  pin the worker to a CPU.
+ */
+typedef void (*ThreadPoolWorkerInit) (void* context, unsigned worker_id);
+
+// --- WorkQueue ------------------------------------------------------------------------------------------------------
+/**
+ * WorkQueue
+ *  Range of task ids [begin, end) owned by one worker, packed into a single word (begin << 32 | end) so that the owner
+ *  (popping from the front) and thieves (splitting off the back half) synchronize with a single CAS.
+ */
+typedef struct {
+        uint64_t range;
+        char padding[56];
+} WorkQueue;
+// ___ WorkQueue ______________________________________________________________________________________________________
+
+// --- ThreadPool -----------------------------------------------------------------------------------------------------
+/**
+ * ThreadPool
+ *  Persistent worker threads executing batches of independent tasks. Each run distributes the task ids in contiguous
+ *  ranges over the workers; idle workers steal the back half of the largest remaining range of another worker.
+ */
+typedef struct {
+        unsigned num_threads;
+        pthread_t* threads;
+        WorkQueue* queues;
+
+        pthread_mutex_t mutex;
+        pthread_cond_t start;
+        pthread_cond_t done;
+        uint64_t generation;
+        unsigned active;
+        int shutdown;
+
+        ThreadPoolTask task;
+        void* context;
+} ThreadPool;
+
+/**
+ * Start num_threads - 1 worker threads (the thread calling ThreadPool_run is worker 0). num_threads == 0 uses the number
+ *  of online CPUs. worker_init may be NULL. Returns 0 on success, -1 on failure.
+ */
+int ThreadPool_init (ThreadPool* self, unsigned num_threads, ThreadPoolWorkerInit worker_init, void* init_context);
+
+/**
+ * Execute task for all task ids in [0, num_tasks) and return once all tasks are done.
+ */
+void ThreadPool_run (ThreadPool* self, size_t num_tasks, ThreadPoolTask task, void* context);
+
+void ThreadPool_destroy (ThreadPool* self);
+// ___ ThreadPool _____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_THREAD_POOL_H
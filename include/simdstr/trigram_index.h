@@ -0,0 +1,102 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_TRIGRAM_INDEX_H
+#define SIMD_STRING_TRIGRAM_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/thread_pool.h>
+#include <simdstr/types.h>
+
+// default number of start positions per indexed block
+#define TRIGRAM_INDEX_BLOCK_SIZE (1u << 16)
+// trigrams starting up to this many bytes behind a block are indexed for the block as well: all trigrams of a
+//  pattern prefix of TRIGRAM_INDEX_OVERLAP + 2 bytes are indexed for the block the pattern starts in
+#define TRIGRAM_INDEX_OVERLAP 256
+#define TRIGRAM_INDEX_MAGIC "SSTRIGR1"
+
+// --- TrigramIndexHeader ---------------------------------------------------------------------------------------------
+/**
+ * TrigramIndexHeader
+ *  Start of the index file, followed by trigrams (uint32_t[num_trigrams], padded to 8 bytes), offsets
+ *  (uint64_t[num_trigrams + 1]) and postings (uint32_t[num_postings]). The file is used in place when mapped.
+ */
+typedef struct {
+        char magic[8];
+        uint64_t corpus_size;
+        uint64_t block_size;
+        uint64_t overlap;
+        uint64_t num_blocks;
+        uint64_t num_trigrams;
+        uint64_t num_postings;
+        uint64_t reserved;
+} TrigramIndexHeader;
+// ___ TrigramIndexHeader _____________________________________________________________________________________________
+
+// --- TrigramIndex ---------------------------------------------------------------------------------------------------
+/**
+ * TrigramIndex
+ *  Trigram index of a static corpus split into blocks of block_size start positions. trigrams are the distinct
+ *  trigrams of the corpus (byte 0 | byte 1 << 8 | byte 2 << 16) in ascending order, the blocks containing
+ *  trigrams[i] are postings[offsets[i], offsets[i + 1]) in ascending order.
+ *
+ *  Queries intersect the posting lists of the trigrams of each pattern and only scan the candidate blocks. The index
+ *  is case sensitive; patterns shorter than 3 bytes make every block a candidate.
+ */
+typedef struct {
+        TrigramIndexHeader header;
+        const uint32_t* trigrams;
+        const uint64_t* offsets;
+        const uint32_t* postings;
+
+        // header and arrays in the file layout: malloc'd (built) or mapped (opened)
+        void* memory;
+        size_t memory_size;
+        int mapped;
+} TrigramIndex;
+
+/**
+ * Index str[0, str_size) in blocks of block_size (0: TRIGRAM_INDEX_BLOCK_SIZE) start positions. The blocks are
+ *  indexed by the workers of pool (NULL: by the calling thread). Returns 0 on success, -1 if memory could not be
+ *  allocated.
+ */
+int TrigramIndex_build (TrigramIndex* self, ThreadPool* pool, const char* str, size_t str_size, size_t block_size);
+
+/**
+ * Write the index to path. Returns 0 on success, -1 on failure (errno is set).
+ */
+int TrigramIndex_save (const TrigramIndex* self, const char* path);
+
+/**
+ * Map the index file at path. Returns 0 on success, -1 on failure or if the file is no valid index. The header,
+ *  offsets and postings are checked once here, so queries on an opened index never leave its arrays.
+ */
+int TrigramIndex_open (TrigramIndex* self, const char* path);
+
+/**
+ * Blocks that may contain pattern[0, pattern_size) in ascending order. blocks must hold header.num_blocks entries.
+ *  Returns the number of blocks.
+ */
+size_t TrigramIndex_candidates (const TrigramIndex* self, const char* pattern, size_t pattern_size, uint32_t* blocks);
+
+/**
+ * All matches of searcher in str[0, str_size) (the indexed corpus) ordered by their start (see SearchStream for the
+ *  semantics of overlapping matches). Only the candidate blocks of patterns[0, num_patterns) (the patterns searcher
+ *  was compiled from) are scanned, by the workers of pool (NULL: by the calling thread). *matches is allocated with
+ *  malloc and must be freed by the caller. Returns the number of matches or SIZE_MAX if memory could not be allocated
+ *  or str_size is not the indexed size.
+ */
+size_t TrigramIndex_find_all (const TrigramIndex* self, ThreadPool* pool, const Pattern* patterns, size_t num_patterns,
+                              const Searcher* searcher, char* str, size_t str_size, Match** matches);
+
+void TrigramIndex_destroy (TrigramIndex* self);
+// ___ TrigramIndex ___________________________________________________________________________________________________
+
+#endif//SIMD_STRING_TRIGRAM_INDEX_H
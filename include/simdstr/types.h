@@ -22,7 +22,7 @@ typedef struct {
         char* end;
 } Match;
 
-extern inline Match Match_empty()
+static inline Match Match_empty()
 {
         Match match;
         match.pattern_id = -1;
@@ -0,0 +1,103 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef SIMD_STRING_URING_READER_H
+#define SIMD_STRING_URING_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simdstr/searcher.h>
+#include <simdstr/stream.h>
+
+#define URING_READER_NUM_BUFFERS 8
+#define URING_READER_BUFFER_SIZE (1u << 20)
+
+// open files with O_DIRECT (bypassing the page cache) where the file system supports it
+#define URING_READER_DIRECT 0x1
+
+/**
+ * Called for every chunk of a file in file order. chunk is only valid during the call. Return non-zero to stop reading.
+ */
+typedef int (*UringChunkCallback) (const char* chunk, size_t chunk_size, uint64_t offset, void* user_data);
+
+// state of one buffer of the pool
+typedef struct {
+        uint64_t offset;
+        size_t size;
+        size_t filled;
+        // buffer position the read in flight starts at (filled rounded down to the O_DIRECT alignment)
+        size_t read_begin;
+        int done;
+        int error;
+} UringSlot;
+
+// --- UringReader ----------------------------------------------------------------------------------------------------
+/**
+ * UringReader
+ *  Asynchronous file reader keeping num_buffers reads in flight with io_uring. Buffers form a fixed pool (registered
+ *  with the kernel if possible) and are resubmitted as soon as their chunk was consumed, so I/O overlaps with the
+ *  processing of completed chunks and no memory is allocated per read. Completions arriving out of order are delivered
+ *  in file order. Without io_uring support (or without IORING_OP_READ), files are read synchronously with pread.
+ */
+typedef struct {
+        int ring_fd;
+        unsigned entries;
+        int flags;
+
+        // submission queue
+        void* sq_ring;
+        size_t sq_ring_size;
+        unsigned* sq_head;
+        unsigned* sq_tail;
+        unsigned* sq_mask;
+        unsigned* sq_array;
+        void* sqes;
+        size_t sqes_size;
+
+        // completion queue, shares the mapping of the submission queue if cq_ring == sq_ring
+        void* cq_ring;
+        size_t cq_ring_size;
+        unsigned* cq_head;
+        unsigned* cq_tail;
+        unsigned* cq_mask;
+        void* cqes;
+
+        char* buffers;
+        size_t buffer_size;
+        unsigned num_buffers;
+        UringSlot* slots;
+        unsigned in_flight;
+        // buffers are registered: reads use IORING_OP_READ_FIXED
+        int registered;
+} UringReader;
+
+/**
+ * num_buffers == 0 uses URING_READER_NUM_BUFFERS, buffer_size == 0 uses URING_READER_BUFFER_SIZE (rounded up to 4 KiB
+ *  for O_DIRECT). Returns 0 on success, -1 if the buffers could not be allocated. A failed io_uring setup is not an
+ *  error, the reader uses pread then (ring_fd == -1).
+ */
+int UringReader_init (UringReader* self, unsigned num_buffers, size_t buffer_size, int flags);
+
+/**
+ * Read the file at path and pass its content to callback chunk by chunk. Returns 0 when the file was read completely, 1
+ *  if stopped by the callback, -1 on failure (errno is set).
+ */
+int UringReader_read_file (UringReader* self, const char* path, UringChunkCallback callback, void* user_data);
+
+/**
+ * Report all matches of searcher in the file at path through a SearchStream fed with the chunks read. Returns the same
+ *  as UringReader_read_file (-1 with errno EIO if a chunk does not continue the previous one, e.g. the file was
+ *  truncated while reading).
+ */
+int UringReader_search_file (UringReader* self, const char* path, const Searcher* searcher, StreamCallback callback,
+                             void* user_data);
+
+void UringReader_destroy (UringReader* self);
+// ___ UringReader ____________________________________________________________________________________________________
+
+#endif//SIMD_STRING_URING_READER_H
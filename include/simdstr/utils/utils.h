@@ -16,19 +16,19 @@
 #include <windows.h>
 #endif
 
-extern inline bool
+static inline bool
 avx512 ()
 {
         return false;
 }
 
-extern inline bool
+static inline bool
 avx2 ()
 {
         return true;
 }
 
-extern inline uint32_t
+static inline uint32_t
 ctz_32 (uint32_t value)
 {
 #ifdef _MSC_VER
@@ -38,7 +38,7 @@ ctz_32 (uint32_t value)
 #endif
 }
 
-extern inline uint64_t
+static inline uint64_t
 ctz_64 (uint64_t value)
 {
 #ifdef _MSC_VER
@@ -48,4 +48,40 @@ ctz_64 (uint64_t value)
 #endif
 }
 
+static inline uint32_t
+clz_32 (uint32_t value)
+{
+#ifdef _MSC_VER
+        return _lzcnt_u32(value);
+#else
+        return (uint32_t)__builtin_clz (value);
+#endif
+}
+
+static inline uint32_t
+popcount_32 (uint32_t value)
+{
+#ifdef _MSC_VER
+        return (uint32_t)__popcnt(value);
+#else
+        return (uint32_t)__builtin_popcount (value);
+#endif
+}
+
+static inline uint64_t
+popcount_64 (uint64_t value)
+{
+#ifdef _MSC_VER
+        return (uint64_t)__popcnt64(value);
+#else
+        return (uint64_t)__builtin_popcountll (value);
+#endif
+}
+
+/**
+ * Fill freq[0..255] with a default byte frequency model (probabilities summing up to 1) approximating ASCII text and
+ *  log data. Used to estimate candidate rates of the SIMD filters.
+ */
+void byte_freq_default (double* freq);
+
 #endif//SIMD_STRING_UTILS_H
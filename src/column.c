@@ -0,0 +1,382 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <simdstr/column.h>
+#include <simdstr/search.h>
+#include <simdstr/utils/utils.h>
+
+#define PAGE_SIZE 4096
+
+// called for every selected row in ascending order
+typedef void (*RowSink) (void* context, size_t row);
+
+typedef struct {
+        uint8_t* bitmap;
+        uint32_t* rows;
+        size_t num_selected;
+} Selection;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_select_bit (void* context, size_t row)
+{
+        Selection* selection = context;
+        selection->bitmap[row / 8] |= (uint8_t) (1u << (row % 8));
+        selection->num_selected++;
+}
+
+static void
+h_select_row (void* context, size_t row)
+{
+        Selection* selection = context;
+        selection->rows[selection->num_selected++] = (uint32_t) row;
+}
+
+static void
+h_contains (const StringColumn* self, const Searcher* searcher, RowSink sink, void* context)
+{
+        if (self->num_rows == 0)
+        {
+                return;
+        }
+        // scan the data of all rows as one buffer
+        char* str = (char*) self->data + self->offsets[0];
+        size_t str_size = (size_t) (self->offsets[self->num_rows] - self->offsets[0]);
+        size_t row = 0;
+        size_t pos = 0;
+        while (pos < str_size)
+        {
+                Match match = Searcher_find_from (searcher, str, str_size, pos);
+                if (match.pattern_id < 0)
+                {
+                        return;
+                }
+                size_t begin = (size_t) (match.begin - self->data);
+                row = StringColumn_row_of (self, row, begin);
+                size_t row_end = (size_t) (self->offsets[row + 1] - self->offsets[0]);
+                if (match.end - str <= (ptrdiff_t) row_end)
+                {
+                        sink (context, row);
+                }
+                else if (Searcher_find_window (searcher, str, row_end, (size_t) (match.begin - str), SEARCH_EDGE,
+                                               (unsigned char) str[row_end])
+                                 .pattern_id >= 0)
+                {
+                        // crosses into the next row: another match starting in this row may end inside it
+                        sink (context, row);
+                }
+                pos = row_end;
+        }
+}
+
+/*
+ * ASCII upper case letters of bytes to lower case.
+ */
+static inline __m256i
+h_fold_32 (__m256i bytes)
+{
+        __m256i upper = _mm256_and_si256 (_mm256_cmpgt_epi8 (bytes, _mm256_set1_epi8 ('A' - 1)),
+                                          _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('Z' + 1), bytes));
+        return _mm256_or_si256 (bytes, _mm256_and_si256 (upper, _mm256_set1_epi8 (0x20)));
+}
+
+static inline __m128i
+h_fold_16 (__m128i bytes)
+{
+        __m128i upper = _mm_and_si128 (_mm_cmpgt_epi8 (bytes, _mm_set1_epi8 ('A' - 1)),
+                                       _mm_cmpgt_epi8 (_mm_set1_epi8 ('Z' + 1), bytes));
+        return _mm_or_si128 (bytes, _mm_and_si128 (upper, _mm_set1_epi8 (0x20)));
+}
+
+/*
+ * str[0, needle_size) (readable) equals the needle.
+ */
+static inline int
+h_needle_at (const StringPredicate* self, const char* str)
+{
+        uint32_t equal;
+        size_t block_size = self->needle_size < 32 ? self->needle_size : 32;
+        if (self->needle_size <= 16)
+        {
+                __m128i bytes;
+                if (((uintptr_t) str & (PAGE_SIZE - 1)) <= PAGE_SIZE - 16)
+                {
+                        bytes = _mm_loadu_si128 ((const __m128i*) str);
+                }
+                else
+                {
+                        // the 16 bytes would cross into the next page: copy the compared bytes
+                        char copy[16] = {0};
+                        memcpy (copy, str, block_size);
+                        bytes = _mm_loadu_si128 ((const __m128i*) copy);
+                }
+                bytes = self->icase ? h_fold_16 (bytes) : bytes;
+                equal = (uint32_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes, _mm_loadu_si128 ((const __m128i*) self->block)));
+        }
+        else
+        {
+                __m256i bytes;
+                if (((uintptr_t) str & (PAGE_SIZE - 1)) <= PAGE_SIZE - 32)
+                {
+                        bytes = _mm256_loadu_si256 ((const __m256i*) str);
+                }
+                else
+                {
+                        char copy[32] = {0};
+                        memcpy (copy, str, block_size);
+                        bytes = _mm256_loadu_si256 ((const __m256i*) copy);
+                }
+                bytes = self->icase ? h_fold_32 (bytes) : bytes;
+                equal = (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (bytes, _mm256_loadu_si256 ((const __m256i*) self->block)));
+        }
+        if ((equal & self->mask) != self->mask)
+        {
+                return 0;
+        }
+        if (self->needle_size <= 32)
+        {
+                return 1;
+        }
+        return self->icase ? icase_memcmp (str + 32, self->needle + 32, self->needle_size - 32) == 0
+                           : memcmp (str + 32, self->needle + 32, self->needle_size - 32) == 0;
+}
+
+/*
+ * Bytes [0, 8) at str, of which [0, size) are compared (size <= 8), without crossing into the next page.
+ */
+static inline uint64_t
+h_load_8 (const char* str, size_t size)
+{
+        uint64_t bytes = 0;
+        memcpy (&bytes, str, ((uintptr_t) str & (PAGE_SIZE - 1)) <= PAGE_SIZE - 8 ? 8 : size);
+        return bytes;
+}
+
+static inline __m128i
+h_load_16 (const char* str, size_t size)
+{
+        if (((uintptr_t) str & (PAGE_SIZE - 1)) <= PAGE_SIZE - 16)
+        {
+                return _mm_loadu_si128 ((const __m128i*) str);
+        }
+        char copy[16] = {0};
+        memcpy (copy, str, size);
+        return _mm_loadu_si128 ((const __m128i*) copy);
+}
+
+/*
+ * Compare the needle (needle_size <= 16) with strs[idx] for the rows idx of candidates (bits of a group of 8 rows).
+ *  Several rows share one vector compare: 4 rows of 8 bytes for needles up to 8 bytes, 2 rows of 16 bytes otherwise.
+ */
+static inline uint32_t
+h_eval_short (const StringPredicate* self, const char* const* strs, uint32_t candidates)
+{
+        uint32_t bits = 0;
+        if (self->needle_size <= 8)
+        {
+                uint64_t needle;
+                memcpy (&needle, self->block, 8);
+                uint64_t keep = self->needle_size == 8 ? UINT64_MAX : ((uint64_t) 1 << (8 * self->needle_size)) - 1;
+                uint64_t rows[8];
+                for (unsigned idx = 0; idx < 8; ++idx)
+                {
+                        rows[idx] = (candidates >> idx) & 1 ? h_load_8 (strs[idx], self->needle_size) : 0;
+                }
+                for (unsigned idx = 0; idx < 8; idx += 4)
+                {
+                        __m256i bytes = _mm256_setr_epi64x ((long long) rows[idx], (long long) rows[idx + 1],
+                                                            (long long) rows[idx + 2], (long long) rows[idx + 3]);
+                        bytes = self->icase ? h_fold_32 (bytes) : bytes;
+                        __m256i diff = _mm256_and_si256 (_mm256_xor_si256 (bytes, _mm256_set1_epi64x ((long long) needle)),
+                                                         _mm256_set1_epi64x ((long long) keep));
+                        __m256i equal = _mm256_cmpeq_epi64 (diff, _mm256_setzero_si256 ());
+                        bits |= (uint32_t) _mm256_movemask_pd (_mm256_castsi256_pd (equal)) << idx;
+                }
+                return bits & candidates;
+        }
+        uint8_t keep_bytes[16] = {0};
+        memset (keep_bytes, 0xff, self->needle_size);
+        const __m256i needle = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) self->block));
+        const __m256i keep = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) keep_bytes));
+        for (unsigned idx = 0; idx < 8; idx += 2)
+        {
+                __m128i lo = (candidates >> idx) & 1 ? h_load_16 (strs[idx], self->needle_size) : _mm_setzero_si128 ();
+                __m128i hi = (candidates >> (idx + 1)) & 1 ? h_load_16 (strs[idx + 1], self->needle_size)
+                                                            : _mm_setzero_si128 ();
+                __m256i bytes = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+                bytes = self->icase ? h_fold_32 (bytes) : bytes;
+                __m256i diff = _mm256_and_si256 (_mm256_xor_si256 (bytes, needle), keep);
+                // a row is equal if both of its 64 bit halves are
+                uint32_t equal = (uint32_t) _mm256_movemask_pd (
+                        _mm256_castsi256_pd (_mm256_cmpeq_epi64 (diff, _mm256_setzero_si256 ())));
+                bits |= (uint32_t) ((equal & 3) == 3) << idx | (uint32_t) ((equal >> 2) == 3) << (idx + 1);
+        }
+        return bits & candidates;
+}
+
+/*
+ * Evaluate the predicate for rows[0, num_rows) of sizes[0, num_rows) (a group of up to 8 rows): bit idx is set if row
+ *  idx is selected.
+ */
+static inline uint32_t
+h_eval_rows (const StringPredicate* self, const char* const* rows, const size_t* sizes, size_t num_rows)
+{
+        if (self->kind == STRING_PREDICATE_CONTAINS)
+        {
+                uint32_t bits = 0;
+                for (size_t idx = 0; idx < num_rows; ++idx)
+                {
+                        int found = self->needle_size == 0 ||
+                                    Searcher_find (&self->searcher, (char*) rows[idx], sizes[idx]).pattern_id >= 0;
+                        bits |= (uint32_t) found << idx;
+                }
+                return bits;
+        }
+        const char* strs[8] = {NULL};
+        uint32_t candidates = 0;
+        for (size_t idx = 0; idx < num_rows; ++idx)
+        {
+                int fits = self->kind == STRING_PREDICATE_EQUALS ? sizes[idx] == self->needle_size
+                                                                 : sizes[idx] >= self->needle_size;
+                candidates |= (uint32_t) fits << idx;
+                strs[idx] = self->kind == STRING_PREDICATE_ENDS_WITH && fits ? rows[idx] + sizes[idx] - self->needle_size
+                                                                            : rows[idx];
+        }
+        if (self->needle_size <= 16)
+        {
+                return h_eval_short (self, strs, candidates);
+        }
+        uint32_t bits = 0;
+        for (size_t idx = 0; idx < num_rows; ++idx)
+        {
+                bits |= (uint32_t) ((candidates >> idx) & 1 && h_needle_at (self, strs[idx])) << idx;
+        }
+        return bits;
+}
+
+// ____________________________________________________________________________
+
+void
+StringColumn_init (StringColumn* self, const char* data, const int32_t* offsets, size_t num_rows)
+{
+        self->data = data;
+        self->offsets = offsets;
+        self->num_rows = num_rows;
+}
+
+size_t
+StringColumn_row_of (const StringColumn* self, size_t first_row, size_t pos)
+{
+        // last row in [first_row, num_rows) starting at or before pos (empty rows before it start at pos as well)
+        const int32_t* base = self->offsets + first_row;
+        size_t size = self->num_rows - first_row;
+        while (size > 1)
+        {
+                size_t half = size / 2;
+                base = (size_t) base[half] <= pos ? base + half : base;
+                size -= half;
+        }
+        return (size_t) (base - self->offsets);
+}
+
+size_t
+StringColumn_contains (const StringColumn* self, const Searcher* searcher, uint8_t* bitmap)
+{
+        Selection selection;
+        selection.bitmap = bitmap;
+        selection.num_selected = 0;
+        memset (bitmap, 0, (self->num_rows + 7) / 8);
+        h_contains (self, searcher, h_select_bit, &selection);
+        return selection.num_selected;
+}
+
+size_t
+StringColumn_contains_rows (const StringColumn* self, const Searcher* searcher, uint32_t* rows)
+{
+        Selection selection;
+        selection.rows = rows;
+        selection.num_selected = 0;
+        h_contains (self, searcher, h_select_row, &selection);
+        return selection.num_selected;
+}
+
+void
+StringPredicate_init (StringPredicate* self, StringPredicateKind kind, const char* needle, size_t needle_size, int icase)
+{
+        self->kind = kind;
+        self->needle = needle;
+        self->needle_size = needle_size;
+        self->icase = icase;
+        size_t block_size = needle_size < 32 ? needle_size : 32;
+        memset (self->block, 0, sizeof (self->block));
+        for (size_t idx = 0; idx < block_size; ++idx)
+        {
+                char c = needle[idx];
+                self->block[idx] = (uint8_t) (icase && c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+        }
+        self->mask = block_size == 32 ? UINT32_MAX : (1u << block_size) - 1;
+        if (icase)
+        {
+                Searcher_init_needle_icase (&self->searcher, needle, needle_size);
+        }
+        else
+        {
+                Searcher_init_needle (&self->searcher, needle, needle_size);
+        }
+}
+
+size_t
+StringPredicate_column (const StringPredicate* self, const StringColumn* column, uint8_t* bitmap)
+{
+        if (self->kind == STRING_PREDICATE_CONTAINS && self->needle_size > 0)
+        {
+                return StringColumn_contains (column, &self->searcher, bitmap);
+        }
+        size_t num_selected = 0;
+        for (size_t base = 0; base < column->num_rows; base += 8)
+        {
+                size_t num_rows = column->num_rows - base < 8 ? column->num_rows - base : 8;
+                const int32_t* offsets = column->offsets + base;
+                const char* rows[8];
+                size_t sizes[8];
+                for (size_t idx = 0; idx < num_rows; ++idx)
+                {
+                        rows[idx] = column->data + offsets[idx];
+                        sizes[idx] = (size_t) (offsets[idx + 1] - offsets[idx]);
+                }
+                uint32_t bits = h_eval_rows (self, rows, sizes, num_rows);
+                bitmap[base / 8] = (uint8_t) bits;
+                num_selected += popcount_32 (bits);
+        }
+        return num_selected;
+}
+
+size_t
+StringPredicate_strings (const StringPredicate* self, const Pattern* strings, size_t num_strings, uint8_t* bitmap)
+{
+        size_t num_selected = 0;
+        for (size_t base = 0; base < num_strings; base += 8)
+        {
+                size_t num_rows = num_strings - base < 8 ? num_strings - base : 8;
+                const char* rows[8];
+                size_t sizes[8];
+                for (size_t idx = 0; idx < num_rows; ++idx)
+                {
+                        rows[idx] = strings[base + idx].begin;
+                        sizes[idx] = strings[base + idx].size;
+                }
+                uint32_t bits = h_eval_rows (self, rows, sizes, num_rows);
+                bitmap[base / 8] = (uint8_t) bits;
+                num_selected += popcount_32 (bits);
+        }
+        return num_selected;
+}
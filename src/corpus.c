@@ -0,0 +1,513 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <simdstr/corpus.h>
+
+typedef struct {
+        StreamMatch* matches;
+        size_t size;
+        size_t capacity;
+        int failed;
+} StreamMatchVector;
+
+typedef struct {
+        const char* path;
+        uint64_t size;
+        size_t num_pieces;
+        // pieces not done yet, file is reported once it drops to 0
+        size_t remaining;
+        int error;
+        int done;
+} CorpusFile;
+
+typedef struct {
+        size_t file_id;
+        uint64_t begin;
+        uint64_t end;
+        StreamMatchVector matches;
+} CorpusPiece;
+
+typedef struct {
+        const Searcher* searcher;
+        CorpusCallback callback;
+        void* user_data;
+
+        CorpusFile* files;
+        size_t num_files;
+        CorpusPiece* pieces;
+
+        // one read buffer of CORPUS_READ_SIZE bytes per worker
+        char* buffers;
+
+        pthread_mutex_t mutex;
+        size_t next_file;
+        size_t next_piece;
+        int stopped;
+        int failed;
+} CorpusSearch;
+
+typedef struct {
+        char** paths;
+        size_t size;
+        size_t capacity;
+} PathList;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_push (StreamMatchVector* vector, StreamMatch match)
+{
+        if (vector->failed)
+        {
+                return;
+        }
+        if (vector->size == vector->capacity)
+        {
+                size_t capacity = vector->capacity == 0 ? 16 : 2 * vector->capacity;
+                StreamMatch* matches = realloc (vector->matches, capacity * sizeof (StreamMatch));
+                if (matches == NULL)
+                {
+                        vector->failed = 1;
+                        return;
+                }
+                vector->matches = matches;
+                vector->capacity = capacity;
+        }
+        vector->matches[vector->size++] = match;
+}
+
+/*
+ * Push all matches starting in str[0, num_starts) with offset added to their positions. before and after are the file
+ *  bytes around str[0, size) (see Searcher_find_window).
+ */
+static void
+h_find_all (const Searcher* searcher, char* str, size_t size, size_t num_starts, uint64_t offset, int before, int after,
+            StreamMatchVector* vector)
+{
+        size_t pos = 0;
+        while (pos < num_starts && !vector->failed)
+        {
+                Match match = Searcher_find_window (searcher, str, size, pos, before, after);
+                if (match.pattern_id < 0 || (size_t) (match.begin - str) >= num_starts)
+                {
+                        return;
+                }
+                StreamMatch stream_match;
+                stream_match.pattern_id = match.pattern_id;
+                stream_match.begin = offset + (uint64_t) (match.begin - str);
+                stream_match.end = offset + (uint64_t) (match.end - str);
+                h_push (vector, stream_match);
+                pos = (size_t) (match.begin - str) + 1;
+        }
+}
+
+/*
+ * Read size bytes at offset of fd into buffer. Returns the number of bytes read (short at the end of the file) or -1.
+ */
+static ssize_t
+h_read (int fd, char* buffer, size_t size, uint64_t offset)
+{
+        size_t done = 0;
+        while (done < size)
+        {
+                ssize_t n = pread (fd, buffer + done, size - done, (off_t) (offset + done));
+                if (n < 0 && errno == EINTR)
+                {
+                        continue;
+                }
+                if (n < 0)
+                {
+                        return -1;
+                }
+                if (n == 0)
+                {
+                        break;
+                }
+                done += (size_t) n;
+        }
+        return (ssize_t) done;
+}
+
+static int
+h_scan_piece (CorpusSearch* search, CorpusPiece* piece, unsigned worker_id)
+{
+        CorpusFile* file = &search->files[piece->file_id];
+        size_t overlap = search->searcher->max_pattern_size > 0 ? search->searcher->max_pattern_size - 1 : 0;
+        uint64_t scan_end = piece->end + overlap < file->size ? piece->end + overlap : file->size;
+        size_t scan_size = (size_t) (scan_end - piece->begin);
+        size_t num_starts = (size_t) (piece->end - piece->begin);
+        if (num_starts == 0)
+        {
+                return 0;
+        }
+        // the bytes around the scanned range are read as well, the SEARCH_* flags see the whole file
+        size_t lead = piece->begin > 0;
+        uint64_t read_begin = piece->begin - lead;
+        uint64_t read_end = scan_end < file->size ? scan_end + 1 : scan_end;
+        size_t read_size = (size_t) (read_end - read_begin);
+
+        int fd = open (file->path, O_RDONLY);
+        if (fd < 0)
+        {
+                return errno;
+        }
+        int error = 0;
+        if (read_size <= CORPUS_READ_SIZE)
+        {
+                char* buffer = search->buffers + (size_t) worker_id * CORPUS_READ_SIZE;
+                ssize_t n = h_read (fd, buffer, read_size, read_begin);
+                if (n < 0)
+                {
+                        error = errno;
+                }
+                else if ((size_t) n > lead)
+                {
+                        // the file may have shrunk since it was listed
+                        size_t size = (size_t) n - lead;
+                        int before = lead ? (unsigned char) buffer[0] : SEARCH_EDGE;
+                        int after = size > scan_size ? (unsigned char) buffer[lead + scan_size] : SEARCH_EDGE;
+                        size = size < scan_size ? size : scan_size;
+                        h_find_all (search->searcher, buffer + lead, size, num_starts < size ? num_starts : size,
+                                    piece->begin, before, after, &piece->matches);
+                }
+        }
+        else
+        {
+                long page_size = sysconf (_SC_PAGESIZE);
+                uint64_t map_begin = read_begin & ~(uint64_t) (page_size - 1);
+                size_t map_size = (size_t) (read_end - map_begin);
+                char* mapping = mmap (NULL, map_size, PROT_READ, MAP_PRIVATE, fd, (off_t) map_begin);
+                if (mapping == MAP_FAILED)
+                {
+                        error = errno;
+                }
+                else
+                {
+                        madvise (mapping, map_size, MADV_SEQUENTIAL);
+                        char* str = mapping + (piece->begin - map_begin);
+                        int before = lead ? (unsigned char) str[-1] : SEARCH_EDGE;
+                        int after = read_end > scan_end ? (unsigned char) str[scan_size] : SEARCH_EDGE;
+                        h_find_all (search->searcher, str, scan_size, num_starts, piece->begin, before, after,
+                                    &piece->matches);
+                        munmap (mapping, map_size);
+                }
+        }
+        close (fd);
+        return error;
+}
+
+/*
+ * Report the finished files in file list order, starting at next_file. Must be called with the mutex held.
+ */
+static void
+h_report (CorpusSearch* search)
+{
+        while (search->next_file < search->num_files && search->files[search->next_file].done && !search->stopped)
+        {
+                CorpusFile* file = &search->files[search->next_file];
+                CorpusPiece* pieces = &search->pieces[search->next_piece];
+
+                CorpusFileResult result;
+                result.path = file->path;
+                result.file_id = search->next_file;
+                result.size = file->size;
+                result.error = file->error;
+                result.matches = NULL;
+                result.num_matches = 0;
+
+                StreamMatch* joined = NULL;
+                if (file->error == 0)
+                {
+                        size_t num_matches = 0;
+                        for (size_t i = 0; i < file->num_pieces; ++i)
+                        {
+                                num_matches += pieces[i].matches.size;
+                                search->failed |= pieces[i].matches.failed;
+                        }
+                        if (file->num_pieces == 1)
+                        {
+                                result.matches = pieces[0].matches.matches;
+                        }
+                        else if (num_matches > 0)
+                        {
+                                joined = malloc (num_matches * sizeof (StreamMatch));
+                                search->failed |= joined == NULL;
+                                size_t pos = 0;
+                                for (size_t i = 0; joined != NULL && i < file->num_pieces; ++i)
+                                {
+                                        memcpy (joined + pos, pieces[i].matches.matches,
+                                                pieces[i].matches.size * sizeof (StreamMatch));
+                                        pos += pieces[i].matches.size;
+                                }
+                                result.matches = joined;
+                        }
+                        result.num_matches = num_matches;
+                }
+
+                if (search->failed || search->callback (&result, search->user_data) != 0)
+                {
+                        __atomic_store_n (&search->stopped, 1, __ATOMIC_RELEASE);
+                }
+                free (joined);
+                for (size_t i = 0; i < file->num_pieces; ++i)
+                {
+                        free (pieces[i].matches.matches);
+                        pieces[i].matches.matches = NULL;
+                }
+                search->next_piece += file->num_pieces;
+                search->next_file++;
+        }
+}
+
+static void
+h_piece_task (void* context, size_t piece_id, unsigned worker_id)
+{
+        CorpusSearch* search = context;
+        CorpusPiece* piece = &search->pieces[piece_id];
+        CorpusFile* file = &search->files[piece->file_id];
+
+        if (!__atomic_load_n (&search->stopped, __ATOMIC_ACQUIRE) && __atomic_load_n (&file->error, __ATOMIC_RELAXED) == 0)
+        {
+                int error = h_scan_piece (search, piece, worker_id);
+                if (error != 0)
+                {
+                        int expected = 0;
+                        __atomic_compare_exchange_n (&file->error, &expected, error, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+                }
+        }
+
+        if (__atomic_sub_fetch (&file->remaining, 1, __ATOMIC_ACQ_REL) == 0)
+        {
+                pthread_mutex_lock (&search->mutex);
+                file->done = 1;
+                h_report (search);
+                pthread_mutex_unlock (&search->mutex);
+        }
+}
+
+static int
+h_compare_names (const void* a, const void* b)
+{
+        return strcmp (*(char* const*) a, *(char* const*) b);
+}
+
+static int
+h_add_path (PathList* list, char* path)
+{
+        if (list->size == list->capacity)
+        {
+                size_t capacity = list->capacity == 0 ? 64 : 2 * list->capacity;
+                char** paths = realloc (list->paths, capacity * sizeof (char*));
+                if (paths == NULL)
+                {
+                        free (path);
+                        return -1;
+                }
+                list->paths = paths;
+                list->capacity = capacity;
+        }
+        list->paths[list->size++] = path;
+        return 0;
+}
+
+static int
+h_list_directory (const char* root, PathList* list)
+{
+        DIR* dir = opendir (root);
+        if (dir == NULL)
+        {
+                return -1;
+        }
+        PathList names = {NULL, 0, 0};
+        int result = 0;
+        struct dirent* entry;
+        while (result == 0 && (entry = readdir (dir)) != NULL)
+        {
+                if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+                {
+                        continue;
+                }
+                char* name = strdup (entry->d_name);
+                result = name == NULL ? -1 : h_add_path (&names, name);
+        }
+        closedir (dir);
+        if (names.size > 0)
+        {
+                qsort (names.paths, names.size, sizeof (char*), h_compare_names);
+        }
+
+        size_t root_size = strlen (root);
+        for (size_t i = 0; i < names.size; ++i)
+        {
+                size_t size = root_size + 1 + strlen (names.paths[i]) + 1;
+                char* path = result == 0 ? malloc (size) : NULL;
+                if (path != NULL)
+                {
+                        snprintf (path, size, "%s/%s", root, names.paths[i]);
+                        struct stat st;
+                        int found = lstat (path, &st) == 0;
+                        if (found && S_ISDIR (st.st_mode))
+                        {
+                                // unreadable sub directories are skipped
+                                h_list_directory (path, list);
+                                free (path);
+                        }
+                        else if (found && S_ISREG (st.st_mode))
+                        {
+                                result = h_add_path (list, path);
+                        }
+                        else
+                        {
+                                free (path);
+                        }
+                }
+                else
+                {
+                        result = -1;
+                }
+                free (names.paths[i]);
+        }
+        free (names.paths);
+        return result;
+}
+
+// ____________________________________________________________________________
+
+int
+corpus_search_files (ThreadPool* pool, const Searcher* searcher, const char* const* paths, size_t num_paths,
+                     size_t piece_size, CorpusCallback callback, void* user_data)
+{
+        if (num_paths == 0)
+        {
+                return 0;
+        }
+        if (piece_size == 0)
+        {
+                piece_size = CORPUS_PIECE_SIZE;
+        }
+        CorpusSearch search;
+        search.searcher = searcher;
+        search.callback = callback;
+        search.user_data = user_data;
+        search.num_files = num_paths;
+        search.next_file = 0;
+        search.next_piece = 0;
+        search.stopped = 0;
+        search.failed = 0;
+        search.files = malloc (num_paths * sizeof (CorpusFile));
+        search.buffers = malloc ((size_t) pool->num_threads * CORPUS_READ_SIZE);
+        search.pieces = NULL;
+        if (search.files == NULL || search.buffers == NULL)
+        {
+                free (search.files);
+                free (search.buffers);
+                return -1;
+        }
+
+        size_t num_pieces = 0;
+        for (size_t i = 0; i < num_paths; ++i)
+        {
+                CorpusFile* file = &search.files[i];
+                struct stat st;
+                file->path = paths[i];
+                file->error = stat (paths[i], &st) == 0 ? 0 : errno;
+                file->size = file->error == 0 ? (uint64_t) st.st_size : 0;
+                file->num_pieces = file->size > 0 ? (size_t) ((file->size + piece_size - 1) / piece_size) : 1;
+                file->remaining = file->num_pieces;
+                file->done = 0;
+                num_pieces += file->num_pieces;
+        }
+        search.pieces = malloc (num_pieces * sizeof (CorpusPiece));
+        if (search.pieces == NULL)
+        {
+                free (search.files);
+                free (search.buffers);
+                return -1;
+        }
+        size_t piece_id = 0;
+        for (size_t i = 0; i < num_paths; ++i)
+        {
+                for (size_t j = 0; j < search.files[i].num_pieces; ++j)
+                {
+                        CorpusPiece* piece = &search.pieces[piece_id++];
+                        uint64_t begin = (uint64_t) j * piece_size;
+                        piece->file_id = i;
+                        piece->begin = begin < search.files[i].size ? begin : search.files[i].size;
+                        piece->end = begin + piece_size < search.files[i].size ? begin + piece_size : search.files[i].size;
+                        piece->matches.matches = NULL;
+                        piece->matches.size = 0;
+                        piece->matches.capacity = 0;
+                        piece->matches.failed = 0;
+                }
+        }
+        pthread_mutex_init (&search.mutex, NULL);
+
+        ThreadPool_run (pool, num_pieces, h_piece_task, &search);
+
+        // pieces of files not reported because the search was stopped
+        for (size_t i = search.next_piece; i < num_pieces; ++i)
+        {
+                free (search.pieces[i].matches.matches);
+        }
+        pthread_mutex_destroy (&search.mutex);
+        free (search.pieces);
+        free (search.files);
+        free (search.buffers);
+        return search.failed ? -1 : 0;
+}
+
+int
+corpus_search_directory (ThreadPool* pool, const Searcher* searcher, const char* root, size_t piece_size,
+                         CorpusCallback callback, void* user_data)
+{
+        char** paths;
+        size_t num_paths;
+        if (corpus_list_files (root, &paths, &num_paths) != 0)
+        {
+                return -1;
+        }
+        int result = corpus_search_files (pool, searcher, (const char* const*) paths, num_paths, piece_size, callback,
+                                          user_data);
+        corpus_free_file_list (paths, num_paths);
+        return result;
+}
+
+int
+corpus_list_files (const char* root, char*** paths, size_t* num_paths)
+{
+        PathList list = {NULL, 0, 0};
+        if (h_list_directory (root, &list) != 0)
+        {
+                corpus_free_file_list (list.paths, list.size);
+                *paths = NULL;
+                *num_paths = 0;
+                return -1;
+        }
+        *paths = list.paths;
+        *num_paths = list.size;
+        return 0;
+}
+
+void
+corpus_free_file_list (char** paths, size_t num_paths)
+{
+        for (size_t i = 0; i < num_paths; ++i)
+        {
+                free (paths[i]);
+        }
+        free (paths);
+}
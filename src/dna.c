@@ -0,0 +1,256 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/dna.h>
+#include <simdstr/utils/utils.h>
+
+// low bit of every 2 bit base
+#define DNA_LOW_BITS 0x5555555555555555ull
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * 32 bytes to their 2 bit codes ((byte >> 1) & 3), adds the number of non ACGT bytes to num_invalid.
+ */
+static inline uint64_t
+h_pack_32 (__m256i bytes, size_t* num_invalid)
+{
+        __m256i lower = _mm256_or_si256 (bytes, _mm256_set1_epi8 (0x20));
+        __m256i valid = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (lower, _mm256_set1_epi8 ('a')),
+                                                          _mm256_cmpeq_epi8 (lower, _mm256_set1_epi8 ('c'))),
+                                         _mm256_or_si256 (_mm256_cmpeq_epi8 (lower, _mm256_set1_epi8 ('g')),
+                                                          _mm256_cmpeq_epi8 (lower, _mm256_set1_epi8 ('t'))));
+        *num_invalid += 32 - popcount_32 ((uint32_t) _mm256_movemask_epi8 (valid));
+
+        __m256i codes = _mm256_and_si256 (_mm256_srli_epi16 (bytes, 1), _mm256_set1_epi8 (3));
+        // 2 codes per 16 bit lane, then 4 codes (one byte) per 32 bit lane
+        __m256i pairs = _mm256_maddubs_epi16 (codes, _mm256_set1_epi16 (0x0401));
+        __m256i quads = _mm256_madd_epi16 (pairs, _mm256_set1_epi32 (0x00100001));
+        __m256i packed = _mm256_shuffle_epi8 (quads, _mm256_setr_epi8 (0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                       -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1,
+                                                                       -1, -1, -1, -1, -1, -1, -1));
+        return (uint64_t) (uint32_t) _mm256_extract_epi32 (packed, 0) |
+               (uint64_t) (uint32_t) _mm256_extract_epi32 (packed, 4) << 32;
+}
+
+/*
+ * Popcount of every 64 bit lane (nibble lookup).
+ */
+static inline __m256i
+h_popcount_64 (__m256i value)
+{
+        const __m256i lookup = _mm256_setr_epi8 (0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+                                                 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i nibble = _mm256_set1_epi8 (0x0f);
+        __m256i lo = _mm256_shuffle_epi8 (lookup, _mm256_and_si256 (value, nibble));
+        __m256i hi = _mm256_shuffle_epi8 (lookup, _mm256_and_si256 (_mm256_srli_epi16 (value, 4), nibble));
+        return _mm256_sad_epu8 (_mm256_add_epi8 (lo, hi), _mm256_setzero_si256 ());
+}
+
+static inline uint64_t
+h_base_mask (size_t num_bases)
+{
+        return num_bases >= 32 ? UINT64_MAX : (1ull << (2 * num_bases)) - 1;
+}
+
+/*
+ * Bases [pos, pos + 32) of words.
+ */
+static inline uint64_t
+h_window (const uint64_t* words, size_t pos)
+{
+        size_t shift = 2 * (pos % 32);
+        const uint64_t* word = words + pos / 32;
+        return shift == 0 ? word[0] : word[0] >> shift | word[1] << (64 - shift);
+}
+
+/*
+ * All bases of pattern match the text at pos with at most max_mismatches mismatches.
+ */
+static int
+h_verify (const DnaText* self, const DnaPattern* pattern, size_t pos, size_t max_mismatches)
+{
+        size_t mismatches = 0;
+        for (size_t base = 0; base < pattern->size; base += 32)
+        {
+                uint64_t diff = (h_window (self->words, pos + base) ^ pattern->words[base / 32]) &
+                                h_base_mask (pattern->size - base);
+                mismatches += popcount_64 ((diff | diff >> 1) & DNA_LOW_BITS);
+                if (mismatches > max_mismatches)
+                {
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+/*
+ * Count the positions in [from, last] at which pattern occurs (0 < pattern->size, max_mismatches < pattern->size).
+ *  If first is not NULL, stops at the first one and stores it in first.
+ */
+static size_t
+h_scan (const DnaText* self, const DnaPattern* pattern, size_t max_mismatches, size_t from, size_t last,
+        int64_t* first)
+{
+        size_t count = 0;
+        const __m256i mask = _mm256_set1_epi64x ((long long) h_base_mask (pattern->size));
+        const __m256i needle = _mm256_set1_epi64x ((long long) pattern->words[0]);
+        const __m256i low_bits = _mm256_set1_epi64x ((long long) DNA_LOW_BITS);
+        const __m256i limit = _mm256_set1_epi64x ((long long) max_mismatches + 1);
+
+        for (size_t word = from / 32;; word += 4)
+        {
+                // lane l holds the text from base 32 * (word + l), next the 32 bases behind it
+                __m256i text = _mm256_loadu_si256 ((const __m256i*) (self->words + word));
+                __m256i next = _mm256_loadu_si256 ((const __m256i*) (self->words + word + 1));
+                uint8_t hits[32];
+                uint32_t any = 0;
+                for (int shift = 0; shift < 32; ++shift)
+                {
+                        // shifting by 64 bits (shift 0) yields zero
+                        __m256i window = _mm256_or_si256 (_mm256_srl_epi64 (text, _mm_cvtsi32_si128 (2 * shift)),
+                                                          _mm256_sll_epi64 (next, _mm_cvtsi32_si128 (64 - 2 * shift)));
+                        __m256i diff = _mm256_and_si256 (_mm256_xor_si256 (window, needle), mask);
+                        __m256i hit;
+                        if (max_mismatches == 0)
+                        {
+                                hit = _mm256_cmpeq_epi64 (diff, _mm256_setzero_si256 ());
+                        }
+                        else
+                        {
+                                diff = _mm256_and_si256 (_mm256_or_si256 (diff, _mm256_srli_epi64 (diff, 1)), low_bits);
+                                hit = _mm256_cmpgt_epi64 (limit, h_popcount_64 (diff));
+                        }
+                        hits[shift] = (uint8_t) _mm256_movemask_pd (_mm256_castsi256_pd (hit));
+                        any |= hits[shift];
+                }
+                // positions in ascending order: lane major, shift minor
+                for (uint32_t lane = 0; any != 0 && lane < 4; ++lane)
+                {
+                        for (size_t shift = 0; shift < 32; ++shift)
+                        {
+                                size_t pos = 32 * (word + lane) + shift;
+                                if (pos > last)
+                                {
+                                        return count;
+                                }
+                                if ((hits[shift] >> lane & 1) && pos >= from &&
+                                    (pattern->size <= 32 || h_verify (self, pattern, pos, max_mismatches)))
+                                {
+                                        count++;
+                                        if (first != NULL)
+                                        {
+                                                *first = (int64_t) pos;
+                                                return count;
+                                        }
+                                }
+                        }
+                }
+                if (32 * (word + 4) > last)
+                {
+                        return count;
+                }
+        }
+}
+
+// ____________________________________________________________________________
+
+size_t
+dna_pack (const char* str, size_t size, uint64_t* words)
+{
+        size_t num_invalid = 0;
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32)
+        {
+                words[pos / 32] = h_pack_32 (_mm256_loadu_si256 ((const __m256i*) (str + pos)), &num_invalid);
+        }
+        if (pos < size)
+        {
+                // pad with 'A' (code 0)
+                char tail[32];
+                memset (tail, 'A', sizeof (tail));
+                memcpy (tail, str + pos, size - pos);
+                words[pos / 32] = h_pack_32 (_mm256_loadu_si256 ((const __m256i*) tail), &num_invalid);
+        }
+        return num_invalid;
+}
+
+int
+DnaPattern_init (DnaPattern* self, const char* pattern, size_t size)
+{
+        self->size = size;
+        self->num_invalid = 0;
+        self->words = calloc ((size + 31) / 32 + 1, sizeof (uint64_t));
+        if (self->words == NULL)
+        {
+                return -1;
+        }
+        self->num_invalid = dna_pack (pattern, size, self->words);
+        return 0;
+}
+
+void
+DnaPattern_destroy (DnaPattern* self)
+{
+        free (self->words);
+        self->words = NULL;
+}
+
+int
+DnaText_init (DnaText* self, const char* str, size_t size)
+{
+        self->size = size;
+        self->num_invalid = 0;
+        self->words = calloc ((size + 31) / 32 + DNA_PADDING_WORDS, sizeof (uint64_t));
+        if (self->words == NULL)
+        {
+                return -1;
+        }
+        self->num_invalid = dna_pack (str, size, self->words);
+        return 0;
+}
+
+int64_t
+DnaText_find_from (const DnaText* self, const DnaPattern* pattern, size_t max_mismatches, size_t from)
+{
+        if (pattern->size > self->size || from > self->size - pattern->size)
+        {
+                return -1;
+        }
+        if (pattern->size == 0 || max_mismatches >= pattern->size)
+        {
+                return (int64_t) from;
+        }
+        int64_t first = -1;
+        h_scan (self, pattern, max_mismatches, from, self->size - pattern->size, &first);
+        return first;
+}
+
+size_t
+DnaText_count (const DnaText* self, const DnaPattern* pattern, size_t max_mismatches)
+{
+        if (pattern->size > self->size)
+        {
+                return 0;
+        }
+        if (pattern->size == 0 || max_mismatches >= pattern->size)
+        {
+                return self->size - pattern->size + 1;
+        }
+        return h_scan (self, pattern, max_mismatches, 0, self->size - pattern->size, NULL);
+}
+
+void
+DnaText_destroy (DnaText* self)
+{
+        free (self->words);
+        self->words = NULL;
+}
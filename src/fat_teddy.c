@@ -5,7 +5,11 @@
 * This file is part of simd_string.
 */
 
+#include <ctype.h>
+
 #include <simdstr/fat_teddy.h>
+#include <simdstr/search.h>
+#include <simdstr/teddy_buckets.h>
 
 void
 pattern_mask_add_fat (FatPatternMask *mask, char byte, uint8_t bucket_id)
@@ -32,7 +36,7 @@ pattern_mask_finish (FatPatternMask *mask)
 }
 
 void
-pattern_mask_init (FatPatternMask *pattern_mask, FatBucket *buckets, char **patterns)
+pattern_mask_init (FatPatternMask *pattern_mask, FatBucket *buckets, char **patterns, uint8_t offset, uint8_t icase)
 {
        memset (pattern_mask->lo, 0, 32);
        memset (pattern_mask->hi, 0, 32);
@@ -42,16 +46,31 @@ pattern_mask_init (FatPatternMask *pattern_mask, FatBucket *buckets, char **patt
                for (uint8_t i = 0; i < buckets[bucket_id].size; ++i)
                {
                        char *pattern = patterns[buckets[bucket_id].pattern_ids[i]];
-                       pattern_mask_add_fat (pattern_mask, pattern[0], bucket_id);
+                       if (icase)
+                       {
+                               pattern_mask_add_fat (pattern_mask, (char) tolower ((unsigned char) pattern[offset]), bucket_id);
+                               pattern_mask_add_fat (pattern_mask, (char) toupper ((unsigned char) pattern[offset]), bucket_id);
+                       }
+                       else
+                       {
+                               pattern_mask_add_fat (pattern_mask, pattern[offset], bucket_id);
+                       }
                }
        }
 }
 
 void
 fat_teddy_init (FatTeddy *teddy, char **patterns, uint8_t num_patterns)
+{
+       fat_teddy_init_freq (teddy, patterns, num_patterns, NULL);
+}
+
+void
+fat_teddy_init_freq (FatTeddy *teddy, char **patterns, uint8_t num_patterns, const double *byte_freq)
 {
        teddy->patterns = patterns;
        teddy->num_patterns = num_patterns;
+       teddy->icase = 0;
 
        // init buckets
        for (int i = 0; i < 16; ++i)
@@ -59,27 +78,32 @@ fat_teddy_init (FatTeddy *teddy, char **patterns, uint8_t num_patterns)
                teddy->buckets[i].size = 0;
        }
 
-       FatBucket *current_bucket = &teddy->buckets[0];
-       uint8_t current_bucket_id = 0;
-
+       Pattern pats[256];
+       uint8_t bucket_ids[256];
        for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
        {
-               current_bucket->pattern_ids[current_bucket->size] = pattern_id;
-               current_bucket->size++;
+               pats[pattern_id].begin = patterns[pattern_id];
+               pats[pattern_id].size = strlen (patterns[pattern_id]);
+       }
+       teddy->false_positive_rate = teddy_choose_offset (pats, num_patterns, 1, 16, 16, byte_freq, &teddy->offset, bucket_ids);
 
-               if (current_bucket->size == 16)
-               {
-                       current_bucket_id++;
-                       if (current_bucket_id > 16)
-                       {
-                               // panic
-                               assert (0);
-                       }
-                       current_bucket = &teddy->buckets[current_bucket_id];
-               }
+       for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+       {
+               FatBucket *bucket = &teddy->buckets[bucket_ids[pattern_id]];
+               bucket->pattern_ids[bucket->size] = pattern_id;
+               bucket->size++;
        }
 
-       pattern_mask_init (&teddy->pattern_mask, teddy->buckets, teddy->patterns);
+       pattern_mask_init (&teddy->pattern_mask, teddy->buckets, teddy->patterns, teddy->offset, 0);
+       pattern_mask_finish (&teddy->pattern_mask);
+}
+
+void
+fat_teddy_init_icase (FatTeddy *teddy, char **patterns, uint8_t num_patterns)
+{
+       fat_teddy_init (teddy, patterns, num_patterns);
+       teddy->icase = 1;
+       pattern_mask_init (&teddy->pattern_mask, teddy->buckets, teddy->patterns, teddy->offset, 1);
        pattern_mask_finish (&teddy->pattern_mask);
 }
 
@@ -98,7 +122,7 @@ mm256_lookup_1 (__m256i *chunk, FatPatternMask *pattern_mask)
 }
 
 Match
-fat_teddy_verify64 (FatTeddy *teddy, uint64_t lane, char *str, size_t str_size)
+fat_teddy_verify64 (FatTeddy *teddy, uint64_t lane, char *begin, char *str, size_t str_size)
 {
        while (lane != 0)
        {
@@ -106,24 +130,37 @@ fat_teddy_verify64 (FatTeddy *teddy, uint64_t lane, char *str, size_t str_size)
                lane &= ~((uint64_t) (1) << bit);
 
                uint64_t shift = (bit / 16);
-               if (shift > str_size)
+               if (shift >= str_size)
                {
                        break;
                }
-               str_size -= shift;
-               str += shift;
+               // candidates are reported at the fingerprinted byte: shift them back to the pattern start
+               size_t pos_idx = (size_t) (str - begin) + shift;
+               if (pos_idx < teddy->offset)
+               {
+                       continue;
+               }
+               char *pos = begin + pos_idx - teddy->offset;
+               size_t pos_size = str_size - shift + teddy->offset;
                FatBucket *bucket = &teddy->buckets[bit % 16];
 
                for (int i = 0; i < bucket->size; ++i)
                {
                        uint8_t pattern_id = bucket->pattern_ids[i];
                        char *pattern = teddy->patterns[pattern_id];
-                       if (memcmp (str, pattern, strlen (pattern)) == 0)
+                       size_t pattern_size = strlen (pattern);
+                       if (pos_size < pattern_size)
+                       {
+                               continue;
+                       }
+                       int equal = teddy->icase ? icase_memcmp (pos, pattern, pattern_size) == 0
+                                                : memcmp (pos, pattern, pattern_size) == 0;
+                       if (equal)
                        {
                                Match match;
                                match.pattern_id = pattern_id;
-                               match.begin = str;
-                               match.end = str + strlen (pattern);
+                               match.begin = pos;
+                               match.end = pos + pattern_size;
                                return match;
                        }
                }
@@ -132,35 +169,38 @@ fat_teddy_verify64 (FatTeddy *teddy, uint64_t lane, char *str, size_t str_size)
 }
 
 Match
-fat_teddy_verify (FatTeddy *teddy, __m256i *candidate, char *str, size_t str_size)
+fat_teddy_verify (FatTeddy *teddy, __m256i *candidate, char *begin, char *str, size_t str_size)
 {
        __m256i swapped = _mm256_permute4x64_epi64 (*candidate, 0x4e);
        __m256i r1 = _mm256_unpacklo_epi8 (*candidate, swapped);
        __m256i r2 = _mm256_unpackhi_epi8 (*candidate, swapped);
 
        uint64_t lane = _mm256_extract_epi64 (r1, 0);
-       Match match = fat_teddy_verify64 (teddy, lane, str, str_size);
+       Match match = fat_teddy_verify64 (teddy, lane, begin, str, str_size);
        if (match.pattern_id >= 0)
        {
                return match;
        }
        str += 4;
+       str_size = str_size > 4 ? str_size - 4 : 0;
        lane = _mm256_extract_epi64 (r1, 1);
-       match = fat_teddy_verify64 (teddy, lane, str, str_size);
+       match = fat_teddy_verify64 (teddy, lane, begin, str, str_size);
        if (match.pattern_id >= 0)
        {
                return match;
        }
        str += 4;
+       str_size = str_size > 4 ? str_size - 4 : 0;
        lane = _mm256_extract_epi64 (r2, 0);
-       match = fat_teddy_verify64 (teddy, lane, str, str_size);
+       match = fat_teddy_verify64 (teddy, lane, begin, str, str_size);
        if (match.pattern_id >= 0)
        {
                return match;
        }
        str += 4;
+       str_size = str_size > 4 ? str_size - 4 : 0;
        lane = _mm256_extract_epi64 (r2, 1);
-       match = fat_teddy_verify64 (teddy, lane, str, str_size);
+       match = fat_teddy_verify64 (teddy, lane, begin, str, str_size);
        if (match.pattern_id >= 0)
        {
                return match;
@@ -169,7 +209,7 @@ fat_teddy_verify (FatTeddy *teddy, __m256i *candidate, char *str, size_t str_siz
 }
 
 Match
-fat_teddy_find_next (FatTeddy *teddy, char *str, size_t str_size)
+fat_teddy_find_next (FatTeddy *teddy, char *begin, char *str, size_t str_size)
 {
        __m256i chunk = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((__m128i *) str));
 
@@ -177,7 +217,7 @@ fat_teddy_find_next (FatTeddy *teddy, char *str, size_t str_size)
 
        if (!_mm256_testz_si256 (result, result))
        {
-               return fat_teddy_verify (teddy, &result, str, str_size);
+               return fat_teddy_verify (teddy, &result, begin, str, str_size);
        }
        return Match_empty ();
 }
@@ -192,7 +232,7 @@ fat_teddy_find (FatTeddy *teddy, char *str, const size_t str_size)
 
        while (size >= 16)
        {
-               Match match = fat_teddy_find_next (teddy, start, size);
+               Match match = fat_teddy_find_next (teddy, str, start, size);
                if (match.pattern_id >= 0)
                {
                        return match;
@@ -202,7 +242,7 @@ fat_teddy_find (FatTeddy *teddy, char *str, const size_t str_size)
        }
        if (size > 0)
        {
-               return fat_teddy_find_next (teddy, str + str_size - 16, 16);
+               return fat_teddy_find_next (teddy, str, str + str_size - 16, 16);
        }
        return Match_empty ();
 }
\ No newline at end of file
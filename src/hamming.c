@@ -0,0 +1,242 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+
+#include <simdstr/hamming.h>
+#include <simdstr/search.h>
+#include <simdstr/utils/utils.h>
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * hamming_distance (a, b, size) <= k, stopping as soon as k is exceeded.
+ */
+static int
+h_within (const char* a, const char* b, size_t size, size_t k)
+{
+        size_t distance = 0;
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32)
+        {
+                __m256i eq = _mm256_cmpeq_epi8 (_mm256_loadu_si256 ((const __m256i*) (a + pos)),
+                                                _mm256_loadu_si256 ((const __m256i*) (b + pos)));
+                distance += 32 - popcount_32 ((uint32_t) _mm256_movemask_epi8 (eq));
+                if (distance > k)
+                {
+                        return 0;
+                }
+        }
+        for (; pos < size; ++pos)
+        {
+                distance += a[pos] != b[pos];
+        }
+        return distance <= k;
+}
+
+/*
+ * Scalar search for the start positions [start, num_starts) not covered by full blocks, and for k >= 255 where the
+ *  saturated 8 bit counts of the kernels are not exact.
+ */
+static const char*
+h_hamming_search_rest (const char* str, size_t start, size_t num_starts, const char* needle, size_t needle_len, size_t k)
+{
+        for (; start < num_starts; ++start)
+        {
+                if (h_within (str + start, needle, needle_len, k))
+                {
+                        return str + start;
+                }
+        }
+        return NULL;
+}
+
+/*
+ * Start of the next exact occurrence of needle[offset, offset + size) at or after the candidate start from.
+ */
+static size_t
+h_next_segment (const char* str, size_t num_starts, const char* needle, size_t offset, size_t size, size_t from)
+{
+        if (from >= num_starts)
+        {
+                return SIZE_MAX;
+        }
+        const char* pos = simd_generic_search_avx_32 (str + from + offset, num_starts - from + size - 1, needle + offset,
+                                                      size, -1, -1);
+        return pos == NULL ? SIZE_MAX : (size_t) (pos - str) - offset;
+}
+
+// ____________________________________________________________________________
+
+size_t
+hamming_distance (const char* a, const char* b, size_t size)
+{
+        size_t distance = 0;
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32)
+        {
+                __m256i eq = _mm256_cmpeq_epi8 (_mm256_loadu_si256 ((const __m256i*) (a + pos)),
+                                                _mm256_loadu_si256 ((const __m256i*) (b + pos)));
+                distance += 32 - popcount_32 ((uint32_t) _mm256_movemask_epi8 (eq));
+        }
+        for (; pos < size; ++pos)
+        {
+                distance += a[pos] != b[pos];
+        }
+        return distance;
+}
+
+const char*
+simd_hamming_search_avx_32 (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k)
+{
+        if (str == NULL || needle == NULL || needle_len > str_len)
+        {
+                return NULL;
+        }
+        if (k >= needle_len)
+        {
+                return str;
+        }
+        const size_t num_starts = str_len - needle_len + 1;
+        if (k >= 255)
+        {
+                return h_hamming_search_rest (str, 0, num_starts, needle, needle_len, k);
+        }
+        const __m256i limit = _mm256_set1_epi8 ((char) k);
+        const __m256i one = _mm256_set1_epi8 (1);
+        size_t start = 0;
+        for (; start + 32 <= num_starts; start += 32)
+        {
+                // saturating mismatch counts of the start positions [start, start + 32)
+                __m256i mismatches = _mm256_setzero_si256 ();
+                uint32_t alive = 0xffffffffu;
+                for (size_t offset = 0; offset < needle_len && alive != 0; ++offset)
+                {
+                        __m256i block = _mm256_loadu_si256 ((const __m256i*) (str + start + offset));
+                        __m256i eq = _mm256_cmpeq_epi8 (block, _mm256_set1_epi8 (needle[offset]));
+                        mismatches = _mm256_adds_epu8 (mismatches, _mm256_andnot_si256 (eq, one));
+                        if ((offset & 7) == 7)
+                        {
+                                alive = (uint32_t) _mm256_movemask_epi8 (
+                                        _mm256_cmpeq_epi8 (_mm256_min_epu8 (mismatches, limit), mismatches));
+                        }
+                }
+                alive = (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_mm256_min_epu8 (mismatches, limit), mismatches));
+                if (alive != 0)
+                {
+                        return str + start + ctz_32 (alive);
+                }
+        }
+        return h_hamming_search_rest (str, start, num_starts, needle, needle_len, k);
+}
+
+const char*
+simd_hamming_search_avx_64 (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k)
+{
+        if (str == NULL || needle == NULL || needle_len > str_len)
+        {
+                return NULL;
+        }
+        if (k >= needle_len)
+        {
+                return str;
+        }
+        const size_t num_starts = str_len - needle_len + 1;
+        if (k >= 255)
+        {
+                return h_hamming_search_rest (str, 0, num_starts, needle, needle_len, k);
+        }
+        const __m512i limit = _mm512_set1_epi8 ((char) k);
+        const __m512i one = _mm512_set1_epi8 (1);
+        size_t start = 0;
+        for (; start + 64 <= num_starts; start += 64)
+        {
+                __m512i mismatches = _mm512_setzero_si512 ();
+                __mmask64 alive = ~(__mmask64) 0;
+                for (size_t offset = 0; offset < needle_len && alive != 0; ++offset)
+                {
+                        __m512i block = _mm512_loadu_si512 ((const void*) (str + start + offset));
+                        __mmask64 ne = _mm512_cmpneq_epi8_mask (block, _mm512_set1_epi8 (needle[offset]));
+                        mismatches = _mm512_mask_adds_epu8 (mismatches, ne, mismatches, one);
+                        if ((offset & 7) == 7)
+                        {
+                                alive = _mm512_cmple_epu8_mask (mismatches, limit);
+                        }
+                }
+                alive = _mm512_cmple_epu8_mask (mismatches, limit);
+                if (alive != 0)
+                {
+                        return str + start + ctz_64 ((uint64_t) alive);
+                }
+        }
+        return h_hamming_search_rest (str, start, num_starts, needle, needle_len, k);
+}
+
+const char*
+simd_hamming_search_pigeonhole (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k)
+{
+        if (str == NULL || needle == NULL || needle_len > str_len)
+        {
+                return NULL;
+        }
+        const size_t num_starts = str_len - needle_len + 1;
+        const size_t num_segments = k + 1;
+        size_t offsets[HAMMING_MAX_SEGMENTS + 1];
+        size_t next[HAMMING_MAX_SEGMENTS];
+        for (size_t segment = 0; segment <= num_segments; ++segment)
+        {
+                offsets[segment] = segment * needle_len / num_segments;
+        }
+        for (size_t segment = 0; segment < num_segments; ++segment)
+        {
+                next[segment] = h_next_segment (str, num_starts, needle, offsets[segment],
+                                                offsets[segment + 1] - offsets[segment], 0);
+        }
+        for (;;)
+        {
+                // candidates in order of their start: every one is verified once
+                size_t candidate = SIZE_MAX;
+                for (size_t segment = 0; segment < num_segments; ++segment)
+                {
+                        candidate = next[segment] < candidate ? next[segment] : candidate;
+                }
+                if (candidate == SIZE_MAX)
+                {
+                        return NULL;
+                }
+                if (h_within (str + candidate, needle, needle_len, k))
+                {
+                        return str + candidate;
+                }
+                for (size_t segment = 0; segment < num_segments; ++segment)
+                {
+                        if (next[segment] == candidate)
+                        {
+                                next[segment] = h_next_segment (str, num_starts, needle, offsets[segment],
+                                                                offsets[segment + 1] - offsets[segment], candidate + 1);
+                        }
+                }
+        }
+}
+
+const char*
+simd_hamming_search (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k)
+{
+        if (k == 0)
+        {
+                return simd_strstr (str, str_len, needle, needle_len);
+        }
+        if (k < needle_len && k + 1 <= HAMMING_MAX_SEGMENTS && needle_len / (k + 1) >= HAMMING_MIN_SEGMENT_SIZE)
+        {
+                return simd_hamming_search_pigeonhole (str, str_len, needle, needle_len, k);
+        }
+        if (avx512 ())
+        {
+                return simd_hamming_search_avx_64 (str, str_len, needle, needle_len, k);
+        }
+        return simd_hamming_search_avx_32 (str, str_len, needle, needle_len, k);
+}
@@ -0,0 +1,120 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+
+#include <simdstr/iov.h>
+
+// stitched windows of patterns up to this size are kept on the stack
+#define IOV_STACK_BUFFER_SIZE 1024
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_iov_first (const StreamMatch* match, void* user_data)
+{
+        *(StreamMatch*) user_data = *match;
+        return 1;
+}
+
+// ____________________________________________________________________________
+
+int
+Searcher_find_all_iov (const Searcher* searcher, const struct iovec* iov, int iovcnt, StreamCallback callback,
+                       void* user_data)
+{
+        char stack_buffer[IOV_STACK_BUFFER_SIZE];
+        char* buffer = stack_buffer;
+        size_t buffer_size = SearchStream_buffer_size (searcher);
+        if (buffer_size > IOV_STACK_BUFFER_SIZE)
+        {
+                buffer = malloc (buffer_size);
+                if (buffer == NULL)
+                {
+                        return -1;
+                }
+        }
+
+        SearchStream stream;
+        SearchStream_begin_buffer (&stream, searcher, callback, user_data, buffer);
+        for (int i = 0; i < iovcnt; ++i)
+        {
+                if (SearchStream_feed (&stream, (const char*) iov[i].iov_base, iov[i].iov_len))
+                {
+                        break;
+                }
+        }
+        int stopped = SearchStream_end (&stream);
+
+        if (buffer != stack_buffer)
+        {
+                free (buffer);
+        }
+        return stopped;
+}
+
+int
+Searcher_find_iov (const Searcher* searcher, const struct iovec* iov, int iovcnt, StreamMatch* match)
+{
+        match->pattern_id = -1;
+        if (Searcher_find_all_iov (searcher, iov, iovcnt, h_iov_first, match) < 0)
+        {
+                return -1;
+        }
+        return match->pattern_id >= 0;
+}
+
+int
+simd_strstr_iov (const struct iovec* iov, int iovcnt, const char* needle, size_t needle_size, StreamMatch* match)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, needle, needle_size);
+        return Searcher_find_iov (&searcher, iov, iovcnt, match);
+}
+
+int
+SlimTeddy_find_iov (SlimTeddy* teddy, const struct iovec* iov, int iovcnt, StreamMatch* match)
+{
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, teddy);
+        return Searcher_find_iov (&searcher, iov, iovcnt, match);
+}
+
+int
+iov_from_ring (struct iovec* iov, char* ring, size_t capacity, size_t head, size_t size)
+{
+        if (size == 0)
+        {
+                return 0;
+        }
+        iov[0].iov_base = ring + head;
+        if (head + size <= capacity)
+        {
+                iov[0].iov_len = size;
+                return 1;
+        }
+        iov[0].iov_len = capacity - head;
+        iov[1].iov_base = ring;
+        iov[1].iov_len = size - (capacity - head);
+        return 2;
+}
+
+int
+iov_locate (const struct iovec* iov, int iovcnt, uint64_t offset, size_t* segment_offset)
+{
+        for (int i = 0; i < iovcnt; ++i)
+        {
+                if (offset < iov[i].iov_len)
+                {
+                        *segment_offset = (size_t) offset;
+                        return i;
+                }
+                offset -= iov[i].iov_len;
+        }
+        *segment_offset = 0;
+        return iovcnt;
+}
@@ -0,0 +1,409 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/keyword_dict.h>
+
+#define PAGE_SIZE 4096
+// a size class retries with new seeds this often before its table is doubled
+#define KEYWORD_DICT_SEEDS_PER_SIZE 4
+
+typedef struct {
+        const char* begin;
+        size_t size;
+        int32_t keyword_id;
+} KeywordEntry;
+
+// 32 set bytes followed by 32 zero bytes: loading at 32 - size masks the first size bytes
+static const uint8_t k_size_mask[64] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_compare_entries (const void* a, const void* b)
+{
+        const KeywordEntry* x = a;
+        const KeywordEntry* y = b;
+        if (x->size != y->size)
+        {
+                return x->size < y->size ? -1 : 1;
+        }
+        // empty keywords may have a NULL begin
+        int order = x->size > 0 ? memcmp (x->begin, y->begin, x->size) : 0;
+        if (order != 0)
+        {
+                return order;
+        }
+        return (x->keyword_id > y->keyword_id) - (x->keyword_id < y->keyword_id);
+}
+
+static int
+h_compare_descending (const void* a, const void* b)
+{
+        uint64_t x = *(const uint64_t*) a;
+        uint64_t y = *(const uint64_t*) b;
+        return (x < y) - (x > y);
+}
+
+static inline uint64_t
+h_mix (uint64_t x)
+{
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+}
+
+/*
+ * str[0, size) (size <= 32) zero padded to 32 bytes.
+ */
+static inline __m256i
+h_load (const char* str, size_t size)
+{
+        __m256i bytes;
+        if (size == 0)
+        {
+                return _mm256_setzero_si256 ();
+        }
+        if (((uintptr_t) str & (PAGE_SIZE - 1)) <= PAGE_SIZE - 32)
+        {
+                bytes = _mm256_loadu_si256 ((const __m256i*) str);
+        }
+        else
+        {
+                // the 32 bytes would cross into the next page: copy the token
+                char copy[32] = {0};
+                memcpy (copy, str, size);
+                bytes = _mm256_loadu_si256 ((const __m256i*) copy);
+        }
+        return _mm256_and_si256 (bytes, _mm256_loadu_si256 ((const __m256i*) (k_size_mask + 32 - size)));
+}
+
+/*
+ * 64 bit hash of a zero padded token: each 64 bit lane multiplies its seeded low and high halves and keeps the
+ *  (swapped) input as summand, the four lanes are then folded.
+ */
+static inline uint64_t
+h_hash (__m256i bytes, uint64_t seed)
+{
+        const __m256i key = _mm256_xor_si256 (_mm256_set1_epi64x ((long long) seed),
+                                              _mm256_set_epi64x (0x1cad21f72c81017cll, 0xdb979083e96dd4dell,
+                                                                 0x7c01812cf721ad1cll, 0xbe4ba423396cfeb8ll));
+        __m256i keyed = _mm256_xor_si256 (bytes, key);
+        __m256i product = _mm256_mul_epu32 (keyed, _mm256_srli_epi64 (keyed, 32));
+        __m256i acc = _mm256_add_epi64 (product, _mm256_shuffle_epi32 (bytes, _MM_SHUFFLE (1, 0, 3, 2)));
+        __m128i folded = _mm_xor_si128 (_mm256_castsi256_si128 (acc), _mm256_extracti128_si256 (acc, 1));
+        uint64_t lo = (uint64_t) _mm_cvtsi128_si64 (folded);
+        uint64_t hi = (uint64_t) _mm_extract_epi64 (folded, 1);
+        return h_mix (lo ^ h_mix (hi + seed));
+}
+
+static inline uint32_t
+h_bucket (uint64_t hash, uint32_t num_buckets)
+{
+        return (uint32_t) (((hash >> 32) * num_buckets) >> 32);
+}
+
+static inline uint32_t
+h_slot (uint64_t hash, uint16_t displacement, uint32_t num_slots)
+{
+        return (uint32_t) h_mix (hash + displacement * 0x9e3779b97f4a7c15ull) & (num_slots - 1);
+}
+
+static inline const KeywordSlot*
+h_slot_of (const KeywordDict* self, const KeywordTable* table, uint64_t hash)
+{
+        uint16_t displacement = self->displacements[table->displacements + h_bucket (hash, table->num_buckets)];
+        return &self->slots[table->slots + h_slot (hash, displacement, table->num_slots)];
+}
+
+static inline int32_t
+h_confirm (const KeywordSlot* slot, __m256i bytes)
+{
+        __m256i key = _mm256_load_si256 ((const __m256i*) slot->key);
+        return _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (key, bytes)) == -1 ? slot->keyword_id : -1;
+}
+
+/*
+ * Find displacements placing entries[0, num_entries) (distinct) into num_slots slots, storing the slot of entry i
+ *  in local_slots[i]. Returns 0 on success, 1 if a bucket could not be placed and -1 if memory could not be
+ *  allocated.
+ */
+static int
+h_build_table (const KeywordTable* table, const KeywordEntry* entries, size_t num_entries, uint16_t* displacements,
+               uint32_t* local_slots)
+{
+        uint64_t* hashes = malloc (num_entries * sizeof (uint64_t));
+        uint32_t* bucket_begin = calloc (table->num_buckets + 1, sizeof (uint32_t));
+        uint32_t* members = malloc (num_entries * sizeof (uint32_t));
+        uint64_t* order = malloc (table->num_buckets * sizeof (uint64_t));
+        uint8_t* used = calloc (table->num_slots, 1);
+        int result = -1;
+        if (hashes == NULL || bucket_begin == NULL || members == NULL || order == NULL || used == NULL)
+        {
+                goto cleanup;
+        }
+
+        // group the entries by bucket (counting sort)
+        for (size_t idx = 0; idx < num_entries; ++idx)
+        {
+                // keywords are copied: unlike tokens, they need not be followed by readable bytes
+                uint8_t key[KEYWORD_DICT_MAX_SIZE] = {0};
+                if (entries[idx].size > 0)
+                {
+                        memcpy (key, entries[idx].begin, entries[idx].size);
+                }
+                hashes[idx] = h_hash (_mm256_loadu_si256 ((const __m256i*) key), table->seed);
+                bucket_begin[h_bucket (hashes[idx], table->num_buckets) + 1]++;
+        }
+        for (uint32_t bucket = 0; bucket < table->num_buckets; ++bucket)
+        {
+                // largest buckets are placed first
+                order[bucket] = (uint64_t) bucket_begin[bucket + 1] << 32 | bucket;
+                bucket_begin[bucket + 1] += bucket_begin[bucket];
+        }
+        for (size_t idx = 0; idx < num_entries; ++idx)
+        {
+                members[bucket_begin[h_bucket (hashes[idx], table->num_buckets)]++] = (uint32_t) idx;
+        }
+        // bucket_begin[bucket] now is the end of bucket: shift back
+        for (uint32_t bucket = table->num_buckets; bucket > 0; --bucket)
+        {
+                bucket_begin[bucket] = bucket_begin[bucket - 1];
+        }
+        bucket_begin[0] = 0;
+        qsort (order, table->num_buckets, sizeof (uint64_t), h_compare_descending);
+
+        result = 1;
+        for (uint32_t idx = 0; idx < table->num_buckets; ++idx)
+        {
+                uint32_t bucket = (uint32_t) order[idx];
+                uint32_t begin = bucket_begin[bucket];
+                uint32_t end = bucket_begin[bucket + 1];
+                displacements[bucket] = 0;
+                if (begin == end)
+                {
+                        continue;
+                }
+                uint32_t displacement = 0;
+                for (; displacement <= UINT16_MAX; ++displacement)
+                {
+                        uint32_t member = begin;
+                        for (; member < end; ++member)
+                        {
+                                uint32_t slot = h_slot (hashes[members[member]], (uint16_t) displacement, table->num_slots);
+                                if (used[slot])
+                                {
+                                        break;
+                                }
+                                used[slot] = 1;
+                                local_slots[members[member]] = slot;
+                        }
+                        if (member == end)
+                        {
+                                break;
+                        }
+                        // collision: release the slots taken by this attempt
+                        while (member-- > begin)
+                        {
+                                used[local_slots[members[member]]] = 0;
+                        }
+                }
+                if (displacement > UINT16_MAX)
+                {
+                        goto cleanup;
+                }
+                displacements[bucket] = (uint16_t) displacement;
+        }
+        result = 0;
+
+cleanup:
+        free (hashes);
+        free (bucket_begin);
+        free (members);
+        free (order);
+        free (used);
+        return result;
+}
+
+// ____________________________________________________________________________
+
+int
+KeywordDict_init (KeywordDict* self, const Pattern* keywords, size_t num_keywords)
+{
+        memset (self->tables, 0, sizeof (self->tables));
+        self->displacements = NULL;
+        self->slots = NULL;
+        self->num_keywords = num_keywords;
+        if (num_keywords > INT32_MAX)
+        {
+                return -1;
+        }
+        for (size_t idx = 0; idx < num_keywords; ++idx)
+        {
+                if (keywords[idx].size > KEYWORD_DICT_MAX_SIZE)
+                {
+                        return -1;
+                }
+        }
+
+        KeywordEntry* entries = malloc ((num_keywords + 1) * sizeof (KeywordEntry));
+        uint32_t* local_slots = malloc ((num_keywords + 1) * sizeof (uint32_t));
+        // at most num_keywords / 3 + 1 buckets per size
+        self->displacements = malloc ((num_keywords / 3 + KEYWORD_DICT_MAX_SIZE + 1) * sizeof (uint16_t));
+        if (entries == NULL || local_slots == NULL || self->displacements == NULL)
+        {
+                goto fail;
+        }
+        for (size_t idx = 0; idx < num_keywords; ++idx)
+        {
+                entries[idx].begin = keywords[idx].begin;
+                entries[idx].size = keywords[idx].size;
+                entries[idx].keyword_id = (int32_t) idx;
+        }
+        qsort (entries, num_keywords, sizeof (KeywordEntry), h_compare_entries);
+        // drop duplicates, the first one has the lowest id
+        size_t num_entries = 0;
+        for (size_t idx = 0; idx < num_keywords; ++idx)
+        {
+                if (num_entries == 0 || entries[idx].size != entries[num_entries - 1].size ||
+                    (entries[idx].size > 0 &&
+                     memcmp (entries[idx].begin, entries[num_entries - 1].begin, entries[idx].size) != 0))
+                {
+                        entries[num_entries++] = entries[idx];
+                }
+        }
+
+        uint32_t num_buckets = 0;
+        uint32_t num_slots = 0;
+        for (size_t lo = 0; lo < num_entries;)
+        {
+                size_t size = entries[lo].size;
+                size_t hi = lo + 1;
+                while (hi < num_entries && entries[hi].size == size)
+                {
+                        hi++;
+                }
+                size_t num_size = hi - lo;
+                KeywordTable* table = &self->tables[size];
+                table->displacements = num_buckets;
+                table->num_buckets = (uint32_t) (num_size / 3 + 1);
+                table->slots = num_slots;
+                table->num_slots = 1;
+                while (table->num_slots < num_size + num_size / 4)
+                {
+                        table->num_slots *= 2;
+                }
+                for (uint64_t attempt = 0;; ++attempt)
+                {
+                        if (attempt > 0 && attempt % KEYWORD_DICT_SEEDS_PER_SIZE == 0)
+                        {
+                                table->num_slots *= 2;
+                        }
+                        table->seed = h_mix (attempt << 8 | size);
+                        int result = h_build_table (table, entries + lo, num_size, self->displacements + num_buckets,
+                                                    local_slots + lo);
+                        if (result < 0)
+                        {
+                                goto fail;
+                        }
+                        if (result == 0)
+                        {
+                                break;
+                        }
+                }
+                num_buckets += table->num_buckets;
+                num_slots += table->num_slots;
+                lo = hi;
+        }
+
+        if (posix_memalign ((void**) &self->slots, 64, (num_slots + 1) * sizeof (KeywordSlot)) != 0)
+        {
+                self->slots = NULL;
+                goto fail;
+        }
+        memset (self->slots, 0, (num_slots + 1) * sizeof (KeywordSlot));
+        for (uint32_t idx = 0; idx <= num_slots; ++idx)
+        {
+                self->slots[idx].keyword_id = -1;
+        }
+        for (size_t idx = 0; idx < num_entries; ++idx)
+        {
+                KeywordSlot* slot = &self->slots[self->tables[entries[idx].size].slots + local_slots[idx]];
+                if (entries[idx].size > 0)
+                {
+                        memcpy (slot->key, entries[idx].begin, entries[idx].size);
+                }
+                slot->keyword_id = entries[idx].keyword_id;
+        }
+        free (entries);
+        free (local_slots);
+        return 0;
+
+fail:
+        free (entries);
+        free (local_slots);
+        KeywordDict_destroy (self);
+        return -1;
+}
+
+int32_t
+KeywordDict_find (const KeywordDict* self, const char* str, size_t str_size)
+{
+        if (str_size > KEYWORD_DICT_MAX_SIZE || self->tables[str_size].num_slots == 0)
+        {
+                return -1;
+        }
+        const KeywordTable* table = &self->tables[str_size];
+        __m256i bytes = h_load (str, str_size);
+        return h_confirm (h_slot_of (self, table, h_hash (bytes, table->seed)), bytes);
+}
+
+void
+KeywordDict_find_all (const KeywordDict* self, const Pattern* tokens, size_t num_tokens, int32_t* keyword_ids)
+{
+        __m256i bytes[8];
+        const KeywordSlot* slots[8];
+        for (size_t base = 0; base < num_tokens; base += 8)
+        {
+                size_t num_group = num_tokens - base < 8 ? num_tokens - base : 8;
+                // hash the group and prefetch its slots
+                for (size_t idx = 0; idx < num_group; ++idx)
+                {
+                        const Pattern* token = &tokens[base + idx];
+                        slots[idx] = NULL;
+                        if (token->size <= KEYWORD_DICT_MAX_SIZE && self->tables[token->size].num_slots > 0)
+                        {
+                                const KeywordTable* table = &self->tables[token->size];
+                                bytes[idx] = h_load (token->begin, token->size);
+                                slots[idx] = h_slot_of (self, table, h_hash (bytes[idx], table->seed));
+                                _mm_prefetch ((const char*) slots[idx], _MM_HINT_T0);
+                        }
+                }
+                for (size_t idx = 0; idx < num_group; ++idx)
+                {
+                        keyword_ids[base + idx] = slots[idx] == NULL ? -1 : h_confirm (slots[idx], bytes[idx]);
+                }
+        }
+}
+
+void
+KeywordDict_destroy (KeywordDict* self)
+{
+        free (self->displacements);
+        free (self->slots);
+        self->displacements = NULL;
+        self->slots = NULL;
+        memset (self->tables, 0, sizeof (self->tables));
+}
@@ -0,0 +1,63 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <simdstr/line_filter.h>
+#include <simdstr/search.h>
+
+#define LINE_FILTER_BATCH_SIZE 256
+
+void
+LineFilter_init (LineFilter* self, const Searcher* searcher, char* str, size_t str_size)
+{
+        self->searcher = searcher;
+        self->str = str;
+        self->str_size = str_size;
+        self->pos = 0;
+}
+
+size_t
+LineFilter_next (LineFilter* self, LineRange* lines, size_t capacity)
+{
+        size_t num_lines = 0;
+        while (num_lines < capacity && self->pos < self->str_size)
+        {
+                Match match = Searcher_find_from (self->searcher, self->str, self->str_size, self->pos);
+                if (match.pattern_id < 0)
+                {
+                        self->pos = self->str_size;
+                        break;
+                }
+                size_t begin = (size_t) (match.begin - self->str);
+                // pos is a line start: the line of the match starts after the last newline in between
+                const char* newline = simd_memrchr (self->str + self->pos, begin - self->pos, '\n');
+                size_t line_begin = newline != NULL ? (size_t) (newline - self->str) + 1 : self->pos;
+                // skip the rest of the line
+                newline = simd_strchr (match.begin, self->str_size - begin, '\n');
+                size_t line_end = newline != NULL ? (size_t) (newline - self->str) : self->str_size;
+
+                lines[num_lines].begin = line_begin;
+                lines[num_lines].end = line_end;
+                num_lines++;
+                self->pos = line_end + 1;
+        }
+        return num_lines;
+}
+
+size_t
+line_filter_count (const Searcher* searcher, char* str, size_t str_size)
+{
+        LineFilter filter;
+        LineFilter_init (&filter, searcher, str, str_size);
+        LineRange lines[LINE_FILTER_BATCH_SIZE];
+        size_t count = 0;
+        size_t n;
+        while ((n = LineFilter_next (&filter, lines, LINE_FILTER_BATCH_SIZE)) > 0)
+        {
+                count += n;
+        }
+        return count;
+}
@@ -0,0 +1,145 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+
+#include <simdstr/line_index.h>
+#include <simdstr/search.h>
+
+// _____ helper functions _____________________________________________________
+
+static size_t
+h_line_begin (const char* data, size_t offset)
+{
+        const char* newline = simd_memrchr (data, offset, '\n');
+        return newline != NULL ? (size_t) (newline - data) + 1 : 0;
+}
+
+// ____________________________________________________________________________
+
+// ===== LineIndex ====================================================================================================
+
+int
+LineIndex_init (LineIndex* self, const char* data, size_t size)
+{
+        self->data = data;
+        self->size = size;
+        self->num_checkpoints = size / LINE_INDEX_SAMPLE_SIZE + 1;
+        self->checkpoints = malloc (self->num_checkpoints * sizeof (uint64_t));
+        if (self->checkpoints == NULL)
+        {
+                return -1;
+        }
+        self->checkpoints[0] = 0;
+        for (size_t k = 1; k < self->num_checkpoints; ++k)
+        {
+                const char* block = data + (k - 1) * LINE_INDEX_SAMPLE_SIZE;
+                self->checkpoints[k] = self->checkpoints[k - 1] + simd_count_char (block, LINE_INDEX_SAMPLE_SIZE, '\n');
+        }
+        size_t tail = (self->num_checkpoints - 1) * LINE_INDEX_SAMPLE_SIZE;
+        uint64_t newlines = self->checkpoints[self->num_checkpoints - 1] + simd_count_char (data + tail, size - tail, '\n');
+        self->num_lines = newlines + (size > 0 && data[size - 1] != '\n');
+        return 0;
+}
+
+uint64_t
+LineIndex_line (const LineIndex* self, size_t offset)
+{
+        size_t k = offset / LINE_INDEX_SAMPLE_SIZE;
+        size_t begin = k * LINE_INDEX_SAMPLE_SIZE;
+        return 1 + self->checkpoints[k] + simd_count_char (self->data + begin, offset - begin, '\n');
+}
+
+void
+LineIndex_position (const LineIndex* self, size_t offset, uint64_t* line, uint64_t* column)
+{
+        *line = LineIndex_line (self, offset);
+        *column = offset - h_line_begin (self->data, offset) + 1;
+}
+
+void
+LineIndex_line_bounds (const LineIndex* self, size_t offset, size_t* begin, size_t* end)
+{
+        *begin = h_line_begin (self->data, offset);
+        const char* newline = offset < self->size ? simd_strchr (self->data + offset, self->size - offset, '\n') : NULL;
+        *end = newline != NULL ? (size_t) (newline - self->data) : self->size;
+}
+
+size_t
+LineIndex_line_start (const LineIndex* self, uint64_t line)
+{
+        if (line <= 1)
+        {
+                return 0;
+        }
+        // the line starts after newline number (line - 1): find the last checkpoint before it
+        uint64_t newline = line - 1;
+        size_t lo = 0;
+        size_t hi = self->num_checkpoints;
+        while (hi - lo > 1)
+        {
+                size_t mid = lo + (hi - lo) / 2;
+                if (self->checkpoints[mid] < newline)
+                {
+                        lo = mid;
+                }
+                else
+                {
+                        hi = mid;
+                }
+        }
+        size_t pos = lo * LINE_INDEX_SAMPLE_SIZE;
+        for (uint64_t skip = newline - self->checkpoints[lo]; skip > 0; --skip)
+        {
+                const char* found = pos < self->size ? simd_strchr (self->data + pos, self->size - pos, '\n') : NULL;
+                if (found == NULL)
+                {
+                        return self->size;
+                }
+                pos = (size_t) (found - self->data) + 1;
+        }
+        return pos;
+}
+
+void
+LineIndex_destroy (LineIndex* self)
+{
+        free (self->checkpoints);
+        self->checkpoints = NULL;
+        self->num_checkpoints = 0;
+}
+
+// ===== LineCursor ===================================================================================================
+
+void
+LineCursor_init (LineCursor* self, const char* data, size_t size, const LineIndex* index)
+{
+        self->data = data;
+        self->size = size;
+        self->index = index;
+        self->offset = 0;
+        self->line = 1;
+}
+
+uint64_t
+LineCursor_line (LineCursor* self, size_t offset)
+{
+        if (offset >= self->offset)
+        {
+                self->line += simd_count_char (self->data + self->offset, offset - self->offset, '\n');
+        }
+        else if (self->index != NULL)
+        {
+                self->line = LineIndex_line (self->index, offset);
+        }
+        else
+        {
+                self->line = 1 + simd_count_char (self->data, offset, '\n');
+        }
+        self->offset = offset;
+        return self->line;
+}
@@ -0,0 +1,647 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <simdstr/mapped_corpus.h>
+#include <simdstr/match_vector.h>
+#include <simdstr/parallel_search.h>
+
+#define HUGE_PAGE_SIZE (2u << 20)
+// bytes scanned between two software prefetch bursts
+#define PREFETCH_STEP 4096
+#define CACHE_LINE_SIZE 64
+
+// chunks of one node (chunk_ids[0, num_chunks) in ascending order), taken from the front by next
+typedef struct {
+        size_t* chunk_ids;
+        size_t num_chunks;
+        size_t next;
+        char padding[40];
+} NodeQueue;
+
+typedef struct {
+        CorpusScanner* scanner;
+        const Searcher* searcher;
+        char* str;
+        size_t str_size;
+        size_t chunk_size;
+        size_t prefetch_distance;
+
+        // one queue per node, queues[num_nodes] holds the chunks of unknown location
+        NodeQueue* queues;
+        MatchVector* matches;
+} CorpusScan;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_set_cpu (uint64_t* cpus, unsigned cpu)
+{
+        cpus[cpu / 64] |= (uint64_t) 1 << (cpu % 64);
+}
+
+static int
+h_has_cpu (const uint64_t* cpus, unsigned cpu)
+{
+        return cpu < NUMA_MAX_CPUS && (cpus[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+/*
+ * Parse a cpulist ("0-3,8,10-11") into cpus. Returns the number of CPUs.
+ */
+static unsigned
+h_parse_cpulist (const char* list, uint64_t* cpus)
+{
+        unsigned count = 0;
+        const char* cur = list;
+        while (*cur != '\0')
+        {
+                char* end;
+                unsigned long first = strtoul (cur, &end, 10);
+                if (end == cur)
+                {
+                        break;
+                }
+                unsigned long last = first;
+                cur = end;
+                if (*cur == '-')
+                {
+                        last = strtoul (cur + 1, &end, 10);
+                        cur = end;
+                }
+                for (unsigned long cpu = first; cpu <= last && cpu < NUMA_MAX_CPUS; ++cpu)
+                {
+                        if (!h_has_cpu (cpus, (unsigned) cpu))
+                        {
+                                h_set_cpu (cpus, (unsigned) cpu);
+                                count++;
+                        }
+                }
+                if (*cur != ',')
+                {
+                        break;
+                }
+                cur++;
+        }
+        return count;
+}
+
+static int
+h_compare_int (const void* a, const void* b)
+{
+        int x = *(const int*) a;
+        int y = *(const int*) b;
+        return (x > y) - (x < y);
+}
+
+static void
+h_read_node (NumaTopology* self, const char* root, int node_id)
+{
+        char path[4096];
+        snprintf (path, sizeof (path), "%s/node%d/cpulist", root, node_id);
+        FILE* file = fopen (path, "r");
+        if (file == NULL)
+        {
+                return;
+        }
+        char list[4096];
+        size_t length = fread (list, 1, sizeof (list) - 1, file);
+        fclose (file);
+        list[length] = '\0';
+
+        unsigned index = self->num_nodes;
+        memset (self->cpus[index], 0, sizeof (self->cpus[index]));
+        self->num_cpus[index] = h_parse_cpulist (list, self->cpus[index]);
+        // memory only nodes have no CPUs to scan with
+        if (self->num_cpus[index] > 0)
+        {
+                self->node_ids[index] = node_id;
+                self->num_nodes++;
+        }
+}
+
+static void
+h_pin_worker (void* context, unsigned worker_id)
+{
+        CorpusScanner* self = context;
+        int node = self->worker_nodes[worker_id];
+        // worker 0 is the calling thread, it is never pinned
+        if (worker_id == 0 || node < 0)
+        {
+                return;
+        }
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        for (unsigned cpu = 0; cpu < NUMA_MAX_CPUS && cpu < CPU_SETSIZE; ++cpu)
+        {
+                if (h_has_cpu (self->topology.cpus[node], cpu))
+                {
+                        CPU_SET (cpu, &set);
+                }
+        }
+        pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+}
+
+static int
+h_current_node (const CorpusScanner* self)
+{
+        int cpu = sched_getcpu ();
+        return cpu < 0 ? -1 : NumaTopology_cpu_node (&self->topology, (unsigned) cpu);
+}
+
+static int
+h_take (NodeQueue* queue, size_t* chunk_id)
+{
+        if (__atomic_load_n (&queue->next, __ATOMIC_RELAXED) >= queue->num_chunks)
+        {
+                return 0;
+        }
+        size_t next = __atomic_fetch_add (&queue->next, 1, __ATOMIC_ACQ_REL);
+        if (next >= queue->num_chunks)
+        {
+                return 0;
+        }
+        *chunk_id = queue->chunk_ids[next];
+        return 1;
+}
+
+/*
+ * Find all matches starting in str[pos, pos + num_starts), verifying them with at most overlap following bytes.
+ */
+static void
+h_scan_range (CorpusScan* scan, MatchVector* vector, size_t pos, size_t num_starts, size_t overlap)
+{
+        size_t size = num_starts + overlap < scan->str_size - pos ? num_starts + overlap : scan->str_size - pos;
+        int before = pos > 0 ? (unsigned char) scan->str[pos - 1] : SEARCH_EDGE;
+        int after = pos + size < scan->str_size ? (unsigned char) scan->str[pos + size] : SEARCH_EDGE;
+        MatchVector_find_all_window (vector, scan->searcher, scan->str + pos, size, num_starts, before, after);
+}
+
+static void
+h_scan_chunk (CorpusScan* scan, size_t chunk_id)
+{
+        size_t start = chunk_id * scan->chunk_size;
+        size_t end = start + scan->chunk_size < scan->str_size ? start + scan->chunk_size : scan->str_size;
+        size_t overlap = scan->searcher->max_pattern_size > 0 ? scan->searcher->max_pattern_size - 1 : 0;
+        MatchVector* vector = &scan->matches[chunk_id];
+
+        if (scan->prefetch_distance == 0)
+        {
+                h_scan_range (scan, vector, start, end - start, overlap);
+                return;
+        }
+        // scan in steps, prefetching the step prefetch_distance ahead before each one
+        for (size_t pos = start; pos < end; pos += PREFETCH_STEP)
+        {
+                size_t ahead = pos + scan->prefetch_distance;
+                for (size_t line = ahead; line < ahead + PREFETCH_STEP && line < scan->str_size; line += CACHE_LINE_SIZE)
+                {
+                        _mm_prefetch (scan->str + line, _MM_HINT_T0);
+                }
+                size_t num_starts = end - pos < PREFETCH_STEP ? end - pos : PREFETCH_STEP;
+                h_scan_range (scan, vector, pos, num_starts, overlap);
+        }
+}
+
+static void
+h_drain (CorpusScan* scan, unsigned queue)
+{
+        size_t chunk_id;
+        while (h_take (&scan->queues[queue], &chunk_id))
+        {
+                h_scan_chunk (scan, chunk_id);
+        }
+}
+
+static void
+h_scan_task (void* context, size_t task_id, unsigned worker_id)
+{
+        (void) task_id;
+        CorpusScan* scan = context;
+        CorpusScanner* scanner = scan->scanner;
+        unsigned num_nodes = scanner->topology.num_nodes;
+        int node = worker_id == 0 ? h_current_node (scanner) : scanner->worker_nodes[worker_id];
+        unsigned own = node < 0 ? num_nodes : (unsigned) node;
+
+        // own node first, then chunks of unknown location, then help the other nodes
+        h_drain (scan, own);
+        h_drain (scan, num_nodes);
+        for (unsigned queue = 0; queue < num_nodes; ++queue)
+        {
+                h_drain (scan, queue);
+        }
+}
+
+/*
+ * Assign each chunk to the queue of the node holding its first page.
+ */
+static int
+h_build_queues (CorpusScan* scan, size_t num_chunks)
+{
+        unsigned num_nodes = scan->scanner->topology.num_nodes;
+        void** addresses = malloc (num_chunks * sizeof (void*));
+        int* nodes = malloc (num_chunks * sizeof (int));
+        size_t* chunk_ids = malloc (num_chunks * sizeof (size_t));
+        if (addresses == NULL || nodes == NULL || chunk_ids == NULL)
+        {
+                free (addresses);
+                free (nodes);
+                free (chunk_ids);
+                return -1;
+        }
+        for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+        {
+                addresses[chunk_id] = scan->str + chunk_id * scan->chunk_size;
+        }
+        if (num_nodes == 1 || numa_page_nodes (addresses, num_chunks, nodes) != 0)
+        {
+                for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+                {
+                        nodes[chunk_id] = num_nodes == 1 ? scan->scanner->topology.node_ids[0] : -1;
+                }
+        }
+
+        // counting sort of the chunk ids by queue, chunk ids stay ascending within a queue
+        size_t counts[NUMA_MAX_NODES + 1] = {0};
+        for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+        {
+                int index = NumaTopology_node_index (&scan->scanner->topology, nodes[chunk_id]);
+                nodes[chunk_id] = index < 0 ? (int) num_nodes : index;
+                counts[nodes[chunk_id]]++;
+        }
+        size_t offset = 0;
+        for (unsigned queue = 0; queue <= num_nodes; ++queue)
+        {
+                scan->queues[queue].chunk_ids = chunk_ids + offset;
+                scan->queues[queue].num_chunks = 0;
+                scan->queues[queue].next = 0;
+                offset += counts[queue];
+        }
+        for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+        {
+                NodeQueue* queue = &scan->queues[nodes[chunk_id]];
+                queue->chunk_ids[queue->num_chunks++] = chunk_id;
+        }
+        free (addresses);
+        free (nodes);
+        return 0;
+}
+
+/*
+ * Fault in the pages of the read only mapping data[0, size): MADV_POPULATE_READ (Linux 5.14), one read per page on
+ *  older kernels.
+ */
+static void
+h_populate (const char* data, size_t size)
+{
+#ifdef MADV_POPULATE_READ
+        if (madvise ((void*) data, size, MADV_POPULATE_READ) == 0)
+        {
+                return;
+        }
+#endif
+        size_t page_size = (size_t) sysconf (_SC_PAGESIZE);
+        // volatile: the reads must not be optimized away
+        const volatile char* bytes = data;
+        for (size_t pos = 0; pos < size; pos += page_size)
+        {
+                (void) bytes[pos];
+        }
+}
+
+// ____________________________________________________________________________
+
+// ===== NumaTopology =================================================================================================
+
+void
+NumaTopology_discover (NumaTopology* self, const char* sysfs_root)
+{
+        const char* root = sysfs_root != NULL ? sysfs_root : "/sys/devices/system/node";
+        self->num_nodes = 0;
+
+        int node_ids[NUMA_MAX_NODES];
+        unsigned num_ids = 0;
+        DIR* dir = opendir (root);
+        if (dir != NULL)
+        {
+                struct dirent* entry;
+                while ((entry = readdir (dir)) != NULL && num_ids < NUMA_MAX_NODES)
+                {
+                        int node_id;
+                        char rest;
+                        if (sscanf (entry->d_name, "node%d%c", &node_id, &rest) == 1 && node_id >= 0)
+                        {
+                                node_ids[num_ids++] = node_id;
+                        }
+                }
+                closedir (dir);
+        }
+        qsort (node_ids, num_ids, sizeof (int), h_compare_int);
+        for (unsigned i = 0; i < num_ids; ++i)
+        {
+                h_read_node (self, root, node_ids[i]);
+        }
+
+        if (self->num_nodes == 0)
+        {
+                long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+                unsigned num_cpus = cpus > 0 ? (unsigned) cpus : 1;
+                num_cpus = num_cpus < NUMA_MAX_CPUS ? num_cpus : NUMA_MAX_CPUS;
+                memset (self->cpus[0], 0, sizeof (self->cpus[0]));
+                for (unsigned cpu = 0; cpu < num_cpus; ++cpu)
+                {
+                        h_set_cpu (self->cpus[0], cpu);
+                }
+                self->node_ids[0] = 0;
+                self->num_cpus[0] = num_cpus;
+                self->num_nodes = 1;
+        }
+}
+
+int
+NumaTopology_node_index (const NumaTopology* self, int node_id)
+{
+        for (unsigned i = 0; i < self->num_nodes; ++i)
+        {
+                if (self->node_ids[i] == node_id)
+                {
+                        return (int) i;
+                }
+        }
+        return -1;
+}
+
+int
+NumaTopology_cpu_node (const NumaTopology* self, unsigned cpu)
+{
+        for (unsigned i = 0; i < self->num_nodes; ++i)
+        {
+                if (h_has_cpu (self->cpus[i], cpu))
+                {
+                        return (int) i;
+                }
+        }
+        return -1;
+}
+
+int
+numa_page_nodes (void* const* addresses, size_t n, int* nodes)
+{
+        for (size_t i = 0; i < n; ++i)
+        {
+                nodes[i] = -1;
+        }
+        if (n == 0)
+        {
+                return 0;
+        }
+#ifdef SYS_move_pages
+        long page_size = sysconf (_SC_PAGESIZE);
+        void** pages = malloc (n * sizeof (void*));
+        if (pages == NULL)
+        {
+                return -1;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+                pages[i] = (void*) ((uintptr_t) addresses[i] & ~(uintptr_t) (page_size - 1));
+        }
+        // nodes == NULL: query only, status receives the node id or a negative errno
+        long result = syscall (SYS_move_pages, 0, (unsigned long) n, pages, NULL, nodes, 0);
+        free (pages);
+        if (result != 0)
+        {
+                for (size_t i = 0; i < n; ++i)
+                {
+                        nodes[i] = -1;
+                }
+                return -1;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+                nodes[i] = nodes[i] < 0 ? -1 : nodes[i];
+        }
+        return 0;
+#else
+        return -1;
+#endif
+}
+
+// ===== MappedCorpus =================================================================================================
+
+int
+MappedCorpus_open (MappedCorpus* self, const char* path, int flags)
+{
+        self->data = NULL;
+        self->size = 0;
+        self->mapping = NULL;
+        self->mapping_size = 0;
+        self->flags = flags;
+        self->huge_pages = 0;
+
+        int fd = open (path, O_RDONLY);
+        if (fd < 0)
+        {
+                return -1;
+        }
+        struct stat st;
+        if (fstat (fd, &st) != 0)
+        {
+                close (fd);
+                return -1;
+        }
+        self->size = (size_t) st.st_size;
+        if (self->size == 0)
+        {
+                close (fd);
+                return 0;
+        }
+
+        if (flags & MAPPED_CORPUS_COPY)
+        {
+                // over-allocate to align the data to huge pages
+                self->mapping_size = self->size + HUGE_PAGE_SIZE;
+                self->mapping = mmap (NULL, self->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (self->mapping == MAP_FAILED)
+                {
+                        self->mapping = NULL;
+                        close (fd);
+                        return -1;
+                }
+                uintptr_t aligned = ((uintptr_t) self->mapping + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+                self->data = (char*) aligned;
+                if (flags & MAPPED_CORPUS_HUGEPAGE)
+                {
+                        self->huge_pages = madvise (self->data, self->size, MADV_HUGEPAGE) == 0;
+                }
+                size_t done = 0;
+                while (done < self->size)
+                {
+                        ssize_t n = pread (fd, self->data + done, self->size - done, (off_t) done);
+                        if (n < 0 && errno == EINTR)
+                        {
+                                continue;
+                        }
+                        if (n <= 0)
+                        {
+                                int error = n < 0 ? errno : EIO;
+                                close (fd);
+                                MappedCorpus_close (self);
+                                errno = error;
+                                return -1;
+                        }
+                        done += (size_t) n;
+                }
+                close (fd);
+                mprotect (self->mapping, self->mapping_size, PROT_READ);
+                return 0;
+        }
+
+        // MAP_POPULATE would fault the pages in before MADV_HUGEPAGE could apply: populate after the advice instead
+        self->mapping_size = self->size;
+        self->mapping = mmap (NULL, self->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close (fd);
+        if (self->mapping == MAP_FAILED)
+        {
+                self->mapping = NULL;
+                return -1;
+        }
+        self->data = self->mapping;
+#ifdef MADV_HUGEPAGE
+        // only honoured for file mappings if the kernel supports THP for the page cache of this file system
+        if (flags & MAPPED_CORPUS_HUGEPAGE)
+        {
+                self->huge_pages = madvise (self->mapping, self->mapping_size, MADV_HUGEPAGE) == 0;
+        }
+#endif
+        if (flags & MAPPED_CORPUS_SEQUENTIAL)
+        {
+                madvise (self->mapping, self->mapping_size, MADV_SEQUENTIAL);
+        }
+        if (flags & MAPPED_CORPUS_POPULATE)
+        {
+                h_populate (self->data, self->size);
+        }
+        return 0;
+}
+
+void
+MappedCorpus_close (MappedCorpus* self)
+{
+        if (self->mapping != NULL)
+        {
+                munmap (self->mapping, self->mapping_size);
+        }
+        self->data = NULL;
+        self->size = 0;
+        self->mapping = NULL;
+        self->mapping_size = 0;
+}
+
+// ===== CorpusScanner ================================================================================================
+
+int
+CorpusScanner_init (CorpusScanner* self, const NumaTopology* topology, unsigned num_threads)
+{
+        self->topology = *topology;
+        if (num_threads == 0)
+        {
+                for (unsigned i = 0; i < topology->num_nodes; ++i)
+                {
+                        num_threads += topology->num_cpus[i];
+                }
+                num_threads = num_threads > 0 ? num_threads : 1;
+        }
+        self->num_workers = num_threads;
+        self->worker_nodes = malloc (num_threads * sizeof (int));
+        if (self->worker_nodes == NULL)
+        {
+                return -1;
+        }
+        int caller = h_current_node (self);
+        self->worker_nodes[0] = caller;
+        // round robin over the nodes, starting with the node after the one of the calling thread
+        unsigned next = caller < 0 ? 0 : ((unsigned) caller + 1) % topology->num_nodes;
+        for (unsigned i = 1; i < num_threads; ++i)
+        {
+                self->worker_nodes[i] = (int) next;
+                next = (next + 1) % topology->num_nodes;
+        }
+        if (ThreadPool_init (&self->pool, num_threads, h_pin_worker, self) != 0)
+        {
+                free (self->worker_nodes);
+                return -1;
+        }
+        // the pool may have started fewer threads than requested
+        self->num_workers = self->pool.num_threads;
+        return 0;
+}
+
+size_t
+CorpusScanner_find_all (CorpusScanner* self, const Searcher* searcher, char* str, size_t str_size, size_t chunk_size,
+                        size_t prefetch_distance, Match** matches)
+{
+        *matches = NULL;
+        CorpusScan scan;
+        scan.scanner = self;
+        scan.searcher = searcher;
+        scan.str = str;
+        scan.str_size = str_size;
+        scan.chunk_size = chunk_size > 0 ? chunk_size : PARALLEL_SEARCH_CHUNK_SIZE;
+        scan.prefetch_distance = prefetch_distance;
+
+        size_t num_chunks = (str_size + scan.chunk_size - 1) / scan.chunk_size;
+        if (num_chunks == 0)
+        {
+                return 0;
+        }
+        scan.queues = malloc ((self->topology.num_nodes + 1) * sizeof (NodeQueue));
+        scan.matches = malloc (num_chunks * sizeof (MatchVector));
+        if (scan.queues == NULL || scan.matches == NULL || h_build_queues (&scan, num_chunks) != 0)
+        {
+                free (scan.queues);
+                free (scan.matches);
+                return SIZE_MAX;
+        }
+        for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+        {
+                MatchVector_init (&scan.matches[chunk_id]);
+        }
+
+        // one task per worker, each task drains the node queues
+        ThreadPool_run (&self->pool, self->pool.num_threads, h_scan_task, &scan);
+
+        size_t num_matches = MatchVector_merge (scan.matches, num_chunks, matches);
+        free (scan.queues[0].chunk_ids);
+        free (scan.queues);
+        free (scan.matches);
+        return num_matches;
+}
+
+void
+CorpusScanner_destroy (CorpusScanner* self)
+{
+        ThreadPool_destroy (&self->pool);
+        free (self->worker_nodes);
+        self->worker_nodes = NULL;
+}
@@ -0,0 +1,102 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/match_vector.h>
+
+void
+MatchVector_init (MatchVector* self)
+{
+        self->matches = NULL;
+        self->size = 0;
+        self->capacity = 0;
+        self->failed = 0;
+}
+
+void
+MatchVector_push (MatchVector* self, Match match)
+{
+        if (self->failed)
+        {
+                return;
+        }
+        if (self->size == self->capacity)
+        {
+                size_t capacity = self->capacity == 0 ? 16 : 2 * self->capacity;
+                Match* matches = realloc (self->matches, capacity * sizeof (Match));
+                if (matches == NULL)
+                {
+                        self->failed = 1;
+                        return;
+                }
+                self->matches = matches;
+                self->capacity = capacity;
+        }
+        self->matches[self->size++] = match;
+}
+
+void
+MatchVector_free (MatchVector* self)
+{
+        free (self->matches);
+        MatchVector_init (self);
+}
+
+void
+MatchVector_find_all (MatchVector* self, const Searcher* searcher, char* str, size_t str_size, size_t num_starts)
+{
+        MatchVector_find_all_window (self, searcher, str, str_size, num_starts, SEARCH_EDGE, SEARCH_EDGE);
+}
+
+void
+MatchVector_find_all_window (MatchVector* self, const Searcher* searcher, char* str, size_t str_size,
+                             size_t num_starts, int before, int after)
+{
+        size_t pos = 0;
+        while (pos < num_starts && !self->failed)
+        {
+                Match match = Searcher_find_window (searcher, str, str_size, pos, before, after);
+                if (match.pattern_id < 0 || (size_t) (match.begin - str) >= num_starts)
+                {
+                        break;
+                }
+                MatchVector_push (self, match);
+                pos = (size_t) (match.begin - str) + 1;
+        }
+}
+
+size_t
+MatchVector_merge (MatchVector* vectors, size_t num_vectors, Match** matches)
+{
+        size_t num_matches = 0;
+        int failed = 0;
+        for (size_t i = 0; i < num_vectors; ++i)
+        {
+                num_matches += vectors[i].size;
+                failed |= vectors[i].failed;
+        }
+        *matches = NULL;
+        if (!failed && num_matches > 0)
+        {
+                *matches = malloc (num_matches * sizeof (Match));
+                failed = *matches == NULL;
+        }
+        size_t pos = 0;
+        for (size_t i = 0; i < num_vectors; ++i)
+        {
+                if (!failed && vectors[i].size > 0)
+                {
+                        memcpy (*matches + pos, vectors[i].matches, vectors[i].size * sizeof (Match));
+                        pos += vectors[i].size;
+                }
+                MatchVector_free (&vectors[i]);
+        }
+        return failed ? SIZE_MAX : num_matches;
+}
@@ -0,0 +1,164 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/match_vector.h>
+#include <simdstr/parallel_search.h>
+
+typedef struct {
+        const Searcher* searcher;
+        char* str;
+        size_t str_size;
+        size_t chunk_size;
+
+        // parallel_find: leftmost chunk with a match, per chunk results
+        size_t best_chunk;
+        Match* first_matches;
+
+        // parallel_find_all: per chunk results
+        MatchVector* all_matches;
+} ParallelSearch;
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * Scanned range of chunk: all start positions of the chunk plus the bytes needed to verify matches starting there,
+ *  and the bytes around the range (see Searcher_find_window).
+ */
+static void
+h_chunk_range (const ParallelSearch* search, size_t chunk_id, char** begin, size_t* size, size_t* num_starts,
+               int* before, int* after)
+{
+        size_t start = chunk_id * search->chunk_size;
+        size_t end = start + search->chunk_size < search->str_size ? start + search->chunk_size : search->str_size;
+        size_t overlap = search->searcher->max_pattern_size > 0 ? search->searcher->max_pattern_size - 1 : 0;
+        size_t scan_end = end + overlap < search->str_size ? end + overlap : search->str_size;
+        *begin = search->str + start;
+        *size = scan_end - start;
+        *num_starts = end - start;
+        *before = start > 0 ? (unsigned char) search->str[start - 1] : SEARCH_EDGE;
+        *after = scan_end < search->str_size ? (unsigned char) search->str[scan_end] : SEARCH_EDGE;
+}
+
+static void
+h_find_task (void* context, size_t chunk_id, unsigned worker_id)
+{
+        (void) worker_id;
+        ParallelSearch* search = context;
+        // cancelled: a chunk left of this one already has a match
+        if (chunk_id > __atomic_load_n (&search->best_chunk, __ATOMIC_ACQUIRE))
+        {
+                return;
+        }
+
+        char* begin;
+        size_t size;
+        size_t num_starts;
+        int before;
+        int after;
+        h_chunk_range (search, chunk_id, &begin, &size, &num_starts, &before, &after);
+        Match match = Searcher_find_window (search->searcher, begin, size, 0, before, after);
+        if (match.pattern_id < 0 || (size_t) (match.begin - begin) >= num_starts)
+        {
+                return;
+        }
+        search->first_matches[chunk_id] = match;
+
+        size_t best = __atomic_load_n (&search->best_chunk, __ATOMIC_ACQUIRE);
+        while (chunk_id < best)
+        {
+                if (__atomic_compare_exchange_n (&search->best_chunk, &best, chunk_id, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                        break;
+                }
+        }
+}
+
+static void
+h_find_all_task (void* context, size_t chunk_id, unsigned worker_id)
+{
+        (void) worker_id;
+        ParallelSearch* search = context;
+        MatchVector* vector = &search->all_matches[chunk_id];
+
+        char* begin;
+        size_t size;
+        size_t num_starts;
+        int before;
+        int after;
+        h_chunk_range (search, chunk_id, &begin, &size, &num_starts, &before, &after);
+
+        MatchVector_find_all_window (vector, search->searcher, begin, size, num_starts, before, after);
+}
+
+static size_t
+h_num_chunks (ParallelSearch* search, size_t* chunk_size)
+{
+        if (*chunk_size == 0)
+        {
+                *chunk_size = PARALLEL_SEARCH_CHUNK_SIZE;
+        }
+        return (search->str_size + *chunk_size - 1) / *chunk_size;
+}
+
+// ____________________________________________________________________________
+
+Match
+parallel_find (ThreadPool* pool, const Searcher* searcher, char* str, size_t str_size, size_t chunk_size)
+{
+        ParallelSearch search;
+        search.searcher = searcher;
+        search.str = str;
+        search.str_size = str_size;
+        size_t num_chunks = h_num_chunks (&search, &chunk_size);
+        search.chunk_size = chunk_size;
+        search.best_chunk = SIZE_MAX;
+        search.first_matches = malloc (num_chunks * sizeof (Match));
+        search.all_matches = NULL;
+        if (search.first_matches == NULL)
+        {
+                return Searcher_find (searcher, str, str_size);
+        }
+
+        ThreadPool_run (pool, num_chunks, h_find_task, &search);
+
+        Match match = search.best_chunk == SIZE_MAX ? Match_empty () : search.first_matches[search.best_chunk];
+        free (search.first_matches);
+        return match;
+}
+
+size_t
+parallel_find_all (ThreadPool* pool, const Searcher* searcher, char* str, size_t str_size, size_t chunk_size,
+                   Match** matches)
+{
+        ParallelSearch search;
+        search.searcher = searcher;
+        search.str = str;
+        search.str_size = str_size;
+        size_t num_chunks = h_num_chunks (&search, &chunk_size);
+        search.chunk_size = chunk_size;
+        search.first_matches = NULL;
+        search.all_matches = malloc ((num_chunks > 0 ? num_chunks : 1) * sizeof (MatchVector));
+        *matches = NULL;
+        if (search.all_matches == NULL)
+        {
+                return SIZE_MAX;
+        }
+        for (size_t chunk_id = 0; chunk_id < num_chunks; ++chunk_id)
+        {
+                MatchVector_init (&search.all_matches[chunk_id]);
+        }
+
+        ThreadPool_run (pool, num_chunks, h_find_all_task, &search);
+
+        // merge the per chunk results in chunk order
+        size_t num_matches = MatchVector_merge (search.all_matches, num_chunks, matches);
+        free (search.all_matches);
+        return num_matches;
+}
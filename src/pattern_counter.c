@@ -0,0 +1,180 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/pattern_counter.h>
+
+typedef struct {
+        const PatternCounter* counter;
+        char* str;
+        size_t str_size;
+        size_t chunk_size;
+        // num_threads arrays of stride counters
+        uint64_t* worker_counts;
+        size_t stride;
+} PatternCount;
+
+typedef struct {
+        Pattern pattern;
+        size_t id;
+} PatternOrder;
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_compare_size (const void* a, const void* b)
+{
+        const PatternOrder* pa = a;
+        const PatternOrder* pb = b;
+        if (pa->pattern.size != pb->pattern.size)
+        {
+                return pa->pattern.size > pb->pattern.size ? 1 : -1;
+        }
+        return (pa->id > pb->id) - (pa->id < pb->id);
+}
+
+static void
+h_count_task (void* context, size_t chunk_id, unsigned worker_id)
+{
+        PatternCount* count = context;
+        size_t start = chunk_id * count->chunk_size;
+        size_t end = start + count->chunk_size < count->str_size ? start + count->chunk_size : count->str_size;
+        // occurrences starting in the chunk may end behind it
+        size_t overlap = count->counter->max_pattern_size - 1;
+        size_t scan_end = end + overlap < count->str_size ? end + overlap : count->str_size;
+        PatternCounter_count (count->counter, count->str + start, scan_end - start, end - start,
+                              count->worker_counts + worker_id * count->stride);
+}
+
+// ____________________________________________________________________________
+
+int
+PatternCounter_init (PatternCounter* self, const Pattern* patterns, size_t num_patterns, int icase)
+{
+        self->num_patterns = num_patterns;
+        self->max_pattern_size = 1;
+        self->num_teddies = (num_patterns + PATTERN_COUNTER_GROUP_SIZE - 1) / PATTERN_COUNTER_GROUP_SIZE;
+        self->patterns = malloc ((num_patterns > 0 ? num_patterns : 1) * sizeof (Pattern));
+        self->pattern_ids = malloc ((num_patterns > 0 ? num_patterns : 1) * sizeof (size_t));
+        self->teddies = malloc ((self->num_teddies > 0 ? self->num_teddies : 1) * sizeof (SlimTeddy));
+        if (self->patterns == NULL || self->pattern_ids == NULL || self->teddies == NULL)
+        {
+                PatternCounter_destroy (self);
+                return -1;
+        }
+
+        // sort by size so that short patterns do not limit the number of masks of the other groups
+        PatternOrder* order = malloc ((num_patterns > 0 ? num_patterns : 1) * sizeof (*order));
+        if (order == NULL)
+        {
+                PatternCounter_destroy (self);
+                return -1;
+        }
+        for (size_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                if (patterns[pattern_id].size == 0)
+                {
+                        free (order);
+                        PatternCounter_destroy (self);
+                        return -1;
+                }
+                order[pattern_id].pattern = patterns[pattern_id];
+                order[pattern_id].id = pattern_id;
+                if (patterns[pattern_id].size > self->max_pattern_size)
+                {
+                        self->max_pattern_size = patterns[pattern_id].size;
+                }
+        }
+        qsort (order, num_patterns, sizeof (*order), h_compare_size);
+        for (size_t idx = 0; idx < num_patterns; ++idx)
+        {
+                self->patterns[idx] = order[idx].pattern;
+                self->pattern_ids[idx] = order[idx].id;
+        }
+        free (order);
+
+        for (size_t teddy_id = 0; teddy_id < self->num_teddies; ++teddy_id)
+        {
+                size_t begin = teddy_id * PATTERN_COUNTER_GROUP_SIZE;
+                size_t size = num_patterns - begin < PATTERN_COUNTER_GROUP_SIZE ? num_patterns - begin : PATTERN_COUNTER_GROUP_SIZE;
+                // sorted: the first pattern of the group is the shortest
+                uint8_t num_masks = (uint8_t) (self->patterns[begin].size < 3 ? self->patterns[begin].size : 3);
+                if (icase)
+                {
+                        SlimTeddy_init_icase (&self->teddies[teddy_id], self->patterns + begin, (uint8_t) size, num_masks);
+                }
+                else
+                {
+                        SlimTeddy_init (&self->teddies[teddy_id], self->patterns + begin, (uint8_t) size, num_masks);
+                }
+        }
+        return 0;
+}
+
+void
+PatternCounter_count (const PatternCounter* self, char* str, size_t str_size, size_t num_starts, uint64_t* counts)
+{
+        for (size_t teddy_id = 0; teddy_id < self->num_teddies; ++teddy_id)
+        {
+                const SlimTeddy* teddy = &self->teddies[teddy_id];
+                uint64_t group_counts[PATTERN_COUNTER_GROUP_SIZE] = {0};
+                SlimTeddy_count (teddy, str, str_size, num_starts, group_counts);
+                const size_t* pattern_ids = self->pattern_ids + teddy_id * PATTERN_COUNTER_GROUP_SIZE;
+                for (uint8_t pattern_id = 0; pattern_id < teddy->num_patterns; ++pattern_id)
+                {
+                        counts[pattern_ids[pattern_id]] += group_counts[pattern_id];
+                }
+        }
+}
+
+int
+PatternCounter_parallel_count (const PatternCounter* self, ThreadPool* pool, char* str, size_t str_size,
+                               size_t chunk_size, uint64_t* counts)
+{
+        PatternCount count;
+        count.counter = self;
+        count.str = str;
+        count.str_size = str_size;
+        count.chunk_size = chunk_size > 0 ? chunk_size : PATTERN_COUNTER_CHUNK_SIZE;
+        // a cache line per worker at least, workers must not share lines
+        count.stride = (self->num_patterns + 7) & ~(size_t) 7;
+        count.stride = count.stride > 0 ? count.stride : 8;
+        void* worker_counts = NULL;
+        if (posix_memalign (&worker_counts, 64, pool->num_threads * count.stride * sizeof (uint64_t)) != 0)
+        {
+                return -1;
+        }
+        count.worker_counts = worker_counts;
+        memset (count.worker_counts, 0, pool->num_threads * count.stride * sizeof (uint64_t));
+
+        size_t num_chunks = (str_size + count.chunk_size - 1) / count.chunk_size;
+        ThreadPool_run (pool, num_chunks, h_count_task, &count);
+
+        for (unsigned worker_id = 0; worker_id < pool->num_threads; ++worker_id)
+        {
+                const uint64_t* worker_counts = count.worker_counts + worker_id * count.stride;
+                for (size_t pattern_id = 0; pattern_id < self->num_patterns; ++pattern_id)
+                {
+                        counts[pattern_id] += worker_counts[pattern_id];
+                }
+        }
+        free (count.worker_counts);
+        return 0;
+}
+
+void
+PatternCounter_destroy (PatternCounter* self)
+{
+        free (self->patterns);
+        free (self->pattern_ids);
+        free (self->teddies);
+        self->patterns = NULL;
+        self->pattern_ids = NULL;
+        self->teddies = NULL;
+}
@@ -0,0 +1,184 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <simdstr/pattern_syntax.h>
+
+void
+pattern_set_add (uint8_t* set, unsigned first, unsigned last)
+{
+        for (unsigned byte = first; byte <= last; ++byte)
+        {
+                set[byte / 8] |= (uint8_t) (1u << (byte % 8));
+        }
+}
+
+void
+pattern_set_fold (uint8_t* set)
+{
+        for (unsigned byte = 'A'; byte <= 'Z'; ++byte)
+        {
+                unsigned lower = byte | 0x20;
+                if (((set[byte / 8] >> (byte % 8)) | (set[lower / 8] >> (lower % 8))) & 1)
+                {
+                        pattern_set_add (set, byte, byte);
+                        pattern_set_add (set, lower, lower);
+                }
+        }
+}
+
+int
+pattern_hex_digit (char c)
+{
+        if (c >= '0' && c <= '9')
+        {
+                return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+                return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+                return c - 'A' + 10;
+        }
+        return -1;
+}
+
+int
+pattern_parse_escape (const char** cur, const char* end, uint8_t* set, uint8_t* byte)
+{
+        if (*cur == end)
+        {
+                return -1;
+        }
+        char c = *(*cur)++;
+        uint8_t shorthand[32] = {0};
+        int hi;
+        int lo;
+        switch (c)
+        {
+                case 'd':
+                case 'D':
+                        pattern_set_add (shorthand, '0', '9');
+                        break;
+                case 'w':
+                case 'W':
+                        pattern_set_add (shorthand, '0', '9');
+                        pattern_set_add (shorthand, 'A', 'Z');
+                        pattern_set_add (shorthand, 'a', 'z');
+                        pattern_set_add (shorthand, '_', '_');
+                        break;
+                case 's':
+                case 'S':
+                        pattern_set_add (shorthand, '\t', '\r');
+                        pattern_set_add (shorthand, ' ', ' ');
+                        break;
+                case 'x':
+                        hi = end - *cur >= 2 ? pattern_hex_digit ((*cur)[0]) : -1;
+                        lo = hi < 0 ? -1 : pattern_hex_digit ((*cur)[1]);
+                        if (lo < 0)
+                        {
+                                return -1;
+                        }
+                        *cur += 2;
+                        *byte = (uint8_t) (hi << 4 | lo);
+                        return 0;
+                case 'n':
+                        *byte = '\n';
+                        return 0;
+                case 't':
+                        *byte = '\t';
+                        return 0;
+                case 'r':
+                        *byte = '\r';
+                        return 0;
+                case '0':
+                        *byte = '\0';
+                        return 0;
+                default:
+                        *byte = (uint8_t) c;
+                        return 0;
+        }
+        // upper case shorthands are negated
+        int negate = c >= 'A' && c <= 'Z';
+        for (unsigned idx = 0; idx < 32; ++idx)
+        {
+                set[idx] |= negate ? (uint8_t) ~shorthand[idx] : shorthand[idx];
+        }
+        return 1;
+}
+
+int
+pattern_parse_class (const char** cur, const char* end, uint8_t* set, int icase)
+{
+        uint8_t members[32] = {0};
+        int negate = *cur < end && **cur == '^';
+        *cur += negate;
+        for (;;)
+        {
+                if (*cur == end)
+                {
+                        return -1;
+                }
+                if (**cur == ']')
+                {
+                        break;
+                }
+                uint8_t first;
+                uint8_t last;
+                if (**cur == '\\')
+                {
+                        (*cur)++;
+                        int kind = pattern_parse_escape (cur, end, members, &first);
+                        if (kind < 0)
+                        {
+                                return -1;
+                        }
+                        if (kind == 1)
+                        {
+                                continue;
+                        }
+                }
+                else
+                {
+                        first = (uint8_t) *(*cur)++;
+                }
+                last = first;
+                if (end - *cur >= 2 && (*cur)[0] == '-' && (*cur)[1] != ']')
+                {
+                        (*cur)++;
+                        if (**cur == '\\')
+                        {
+                                (*cur)++;
+                                if (pattern_parse_escape (cur, end, members, &last) != 0)
+                                {
+                                        return -1;
+                                }
+                        }
+                        else
+                        {
+                                last = (uint8_t) *(*cur)++;
+                        }
+                        if (last < first)
+                        {
+                                return -1;
+                        }
+                }
+                pattern_set_add (members, first, last);
+        }
+        (*cur)++;
+        if (icase)
+        {
+                // fold before negating: [^a] must exclude 'A' as well
+                pattern_set_fold (members);
+        }
+        for (unsigned idx = 0; idx < 32; ++idx)
+        {
+                set[idx] = negate ? (uint8_t) ~members[idx] : members[idx];
+        }
+        return 0;
+}
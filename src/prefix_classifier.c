@@ -0,0 +1,310 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/prefix_classifier.h>
+#include <simdstr/utils/utils.h>
+
+typedef struct {
+        const char* begin;
+        size_t size;
+        int32_t pattern_id;
+} PrefixEntry;
+
+typedef struct {
+        PrefixClassifier* classifier;
+        // patterns in lexicographic order (equal patterns by id)
+        PrefixEntry* entries;
+        size_t nodes_capacity;
+        size_t labels_capacity;
+        size_t edges_capacity;
+        size_t children_capacity;
+} PrefixBuild;
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_compare_entries (const void* a, const void* b)
+{
+        const PrefixEntry* x = a;
+        const PrefixEntry* y = b;
+        size_t size = x->size < y->size ? x->size : y->size;
+        // empty patterns may have a NULL begin
+        int order = size > 0 ? memcmp (x->begin, y->begin, size) : 0;
+        if (order != 0)
+        {
+                return order;
+        }
+        if (x->size != y->size)
+        {
+                return x->size < y->size ? -1 : 1;
+        }
+        return (x->pattern_id > y->pattern_id) - (x->pattern_id < y->pattern_id);
+}
+
+/*
+ * Grow *array (of element_size bytes) to hold size elements. Returns -1 if memory could not be allocated.
+ */
+static int
+h_reserve (void** array, size_t* capacity, size_t size, size_t element_size)
+{
+        if (size <= *capacity)
+        {
+                return 0;
+        }
+        size_t new_capacity = *capacity > 0 ? *capacity : 64;
+        while (new_capacity < size)
+        {
+                new_capacity *= 2;
+        }
+        void* grown = realloc (*array, new_capacity * element_size);
+        if (grown == NULL)
+        {
+                return -1;
+        }
+        *array = grown;
+        *capacity = new_capacity;
+        return 0;
+}
+
+/*
+ * Node for entries[lo, hi), which share their first depth bytes. Returns the node index or -1.
+ */
+static int64_t
+h_build (PrefixBuild* build, size_t lo, size_t hi, size_t depth)
+{
+        PrefixClassifier* self = build->classifier;
+        const PrefixEntry* first = &build->entries[lo];
+        const PrefixEntry* last = &build->entries[hi - 1];
+        // the common prefix of the first and the last entry is shared by all entries
+        size_t end = depth;
+        size_t limit = first->size < last->size ? first->size : last->size;
+        while (end < limit && first->begin[end] == last->begin[end])
+        {
+                end++;
+        }
+
+        if (h_reserve ((void**) &self->nodes, &build->nodes_capacity, self->num_nodes + 1, sizeof (PrefixNode)) != 0 ||
+            h_reserve ((void**) &self->labels, &build->labels_capacity, self->labels_size + end - depth, 1) != 0)
+        {
+                return -1;
+        }
+        size_t node_id = self->num_nodes++;
+        PrefixNode* node = &self->nodes[node_id];
+        node->label = (uint32_t) self->labels_size;
+        node->label_size = (uint32_t) (end - depth);
+        // labels, edges and children are NULL until something is stored in them (memcpy/memset need valid pointers)
+        if (end > depth)
+        {
+                memcpy (self->labels + self->labels_size, first->begin + depth, end - depth);
+                self->labels_size += end - depth;
+        }
+        // entries ending here come first, the first one has the lowest id
+        node->pattern_id = lo < hi && build->entries[lo].size == end ? build->entries[lo].pattern_id : -1;
+        while (lo < hi && build->entries[lo].size == end)
+        {
+                lo++;
+        }
+
+        uint32_t num_edges = 0;
+        for (size_t idx = lo; idx < hi; ++idx)
+        {
+                num_edges += idx == lo || build->entries[idx].begin[end] != build->entries[idx - 1].begin[end];
+        }
+        size_t edges = self->num_edges;
+        size_t num_slots = (num_edges + 31) & ~(size_t) 31;
+        if (h_reserve ((void**) &self->edges, &build->edges_capacity, edges + num_slots, 1) != 0)
+        {
+                return -1;
+        }
+        if (h_reserve ((void**) &self->children, &build->children_capacity, edges + num_slots, sizeof (uint32_t)) != 0)
+        {
+                return -1;
+        }
+        if (num_slots > 0)
+        {
+                memset (self->edges + edges, 0, num_slots);
+                memset (self->children + edges, 0, num_slots * sizeof (uint32_t));
+                self->num_edges += num_slots;
+        }
+        node->edges = (uint32_t) edges;
+        node->num_edges = num_edges;
+
+        // node is invalidated by growing the arrays
+        size_t slot = edges;
+        for (size_t group_lo = lo; group_lo < hi; ++slot)
+        {
+                uint8_t byte = (uint8_t) build->entries[group_lo].begin[end];
+                size_t group_hi = group_lo + 1;
+                while (group_hi < hi && (uint8_t) build->entries[group_hi].begin[end] == byte)
+                {
+                        group_hi++;
+                }
+                int64_t child = h_build (build, group_lo, group_hi, end + 1);
+                if (child < 0)
+                {
+                        return -1;
+                }
+                self->edges[slot] = byte;
+                self->children[slot] = (uint32_t) child;
+                group_lo = group_hi;
+        }
+        return (int64_t) node_id;
+}
+
+/*
+ * Child of node along byte, -1 if there is none.
+ */
+static inline int64_t
+h_child (const PrefixClassifier* self, const PrefixNode* node, uint8_t byte)
+{
+        const __m256i needle = _mm256_set1_epi8 ((char) byte);
+        for (uint32_t base = 0; base < node->num_edges; base += 32)
+        {
+                __m256i edges = _mm256_loadu_si256 ((const __m256i*) (self->edges + node->edges + base));
+                uint32_t mask = (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (edges, needle));
+                uint32_t remaining = node->num_edges - base;
+                mask &= remaining < 32 ? (1u << remaining) - 1 : UINT32_MAX;
+                if (mask != 0)
+                {
+                        return self->children[node->edges + base + ctz_32 (mask)];
+                }
+        }
+        return -1;
+}
+
+// ____________________________________________________________________________
+
+int
+PrefixClassifier_init (PrefixClassifier* self, const Pattern* patterns, size_t num_patterns)
+{
+        self->nodes = NULL;
+        self->num_nodes = 0;
+        self->labels = NULL;
+        self->labels_size = 0;
+        self->edges = NULL;
+        self->children = NULL;
+        self->num_edges = 0;
+        self->num_patterns = num_patterns;
+        memset (self->root_children, 0xff, sizeof (self->root_children));
+        if (num_patterns > INT32_MAX)
+        {
+                return -1;
+        }
+
+        PrefixBuild build;
+        build.classifier = self;
+        build.nodes_capacity = 0;
+        build.labels_capacity = 0;
+        build.edges_capacity = 0;
+        build.children_capacity = 0;
+        build.entries = malloc ((num_patterns + 1) * sizeof (PrefixEntry));
+        if (build.entries == NULL)
+        {
+                return -1;
+        }
+        for (size_t idx = 0; idx < num_patterns; ++idx)
+        {
+                build.entries[idx].begin = patterns[idx].begin;
+                build.entries[idx].size = patterns[idx].size;
+                build.entries[idx].pattern_id = (int32_t) idx;
+        }
+        qsort (build.entries, num_patterns, sizeof (PrefixEntry), h_compare_entries);
+
+        int64_t root = 0;
+        if (num_patterns > 0)
+        {
+                root = h_build (&build, 0, num_patterns, 0);
+        }
+        else if (h_reserve ((void**) &self->nodes, &build.nodes_capacity, 1, sizeof (PrefixNode)) == 0)
+        {
+                PrefixNode empty = {0, 0, 0, 0, -1};
+                self->nodes[self->num_nodes++] = empty;
+        }
+        else
+        {
+                root = -1;
+        }
+        free (build.entries);
+        if (root < 0)
+        {
+                PrefixClassifier_destroy (self);
+                return -1;
+        }
+
+        const PrefixNode* node = &self->nodes[0];
+        for (uint32_t idx = 0; idx < node->num_edges; ++idx)
+        {
+                self->root_children[self->edges[node->edges + idx]] = (int32_t) self->children[node->edges + idx];
+        }
+        return 0;
+}
+
+int32_t
+PrefixClassifier_find (const PrefixClassifier* self, const char* str, size_t str_size, size_t* prefix_size)
+{
+        int32_t best = -1;
+        size_t best_size = 0;
+        size_t pos = 0;
+        int64_t node_id = 0;
+        for (;;)
+        {
+                const PrefixNode* node = &self->nodes[node_id];
+                if (node->label_size > str_size - pos ||
+                    (node->label_size > 0 && memcmp (str + pos, self->labels + node->label, node->label_size) != 0))
+                {
+                        break;
+                }
+                pos += node->label_size;
+                if (node->pattern_id >= 0)
+                {
+                        best = node->pattern_id;
+                        best_size = pos;
+                }
+                if (pos == str_size)
+                {
+                        break;
+                }
+                node_id = node_id == 0 ? self->root_children[(uint8_t) str[pos]] : h_child (self, node, (uint8_t) str[pos]);
+                if (node_id < 0)
+                {
+                        break;
+                }
+                pos++;
+        }
+        if (prefix_size != NULL)
+        {
+                *prefix_size = best_size;
+        }
+        return best;
+}
+
+void
+PrefixClassifier_classify (const PrefixClassifier* self, const Pattern* strings, size_t num_strings,
+                           int32_t* pattern_ids)
+{
+        for (size_t idx = 0; idx < num_strings; ++idx)
+        {
+                pattern_ids[idx] = PrefixClassifier_find (self, strings[idx].begin, strings[idx].size, NULL);
+        }
+}
+
+void
+PrefixClassifier_destroy (PrefixClassifier* self)
+{
+        free (self->nodes);
+        free (self->labels);
+        free (self->edges);
+        free (self->children);
+        self->nodes = NULL;
+        self->labels = NULL;
+        self->edges = NULL;
+        self->children = NULL;
+}
@@ -0,0 +1,423 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/query.h>
+#include <simdstr/search.h>
+
+// three-valued evaluation results
+#define QUERY_FALSE 0
+#define QUERY_TRUE 1
+#define QUERY_UNKNOWN 2
+
+typedef struct {
+        Query* query;
+        const char* cur;
+        // next free byte of query->text
+        size_t text_pos;
+} QueryParser;
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_add_node (Query* self, QueryNodeKind kind, uint8_t term, int left, int right)
+{
+        if (self->num_nodes >= QUERY_MAX_NODES)
+        {
+                return -1;
+        }
+        QueryNode* node = &self->nodes[self->num_nodes];
+        node->kind = kind;
+        node->term = term;
+        node->left = (int16_t) left;
+        node->right = (int16_t) right;
+        return self->num_nodes++;
+}
+
+/*
+ * Value of node given the terms hit so far. If final, terms not hit are known to be absent.
+ */
+static int
+h_eval (const Query* self, int node_id, uint64_t hits, int final)
+{
+        const QueryNode* node = &self->nodes[node_id];
+        int left;
+        int right;
+        switch (node->kind)
+        {
+                case QUERY_TERM:
+                        if ((hits >> node->term) & 1)
+                        {
+                                return QUERY_TRUE;
+                        }
+                        return final ? QUERY_FALSE : QUERY_UNKNOWN;
+                case QUERY_AND:
+                        left = h_eval (self, node->left, hits, final);
+                        if (left == QUERY_FALSE)
+                        {
+                                return QUERY_FALSE;
+                        }
+                        right = h_eval (self, node->right, hits, final);
+                        if (right == QUERY_FALSE)
+                        {
+                                return QUERY_FALSE;
+                        }
+                        return left == QUERY_TRUE && right == QUERY_TRUE ? QUERY_TRUE : QUERY_UNKNOWN;
+                case QUERY_OR:
+                        left = h_eval (self, node->left, hits, final);
+                        if (left == QUERY_TRUE)
+                        {
+                                return QUERY_TRUE;
+                        }
+                        right = h_eval (self, node->right, hits, final);
+                        if (right == QUERY_TRUE)
+                        {
+                                return QUERY_TRUE;
+                        }
+                        return left == QUERY_FALSE && right == QUERY_FALSE ? QUERY_FALSE : QUERY_UNKNOWN;
+                case QUERY_NOT:
+                        left = h_eval (self, node->left, hits, final);
+                        return left == QUERY_UNKNOWN ? QUERY_UNKNOWN : !left;
+        }
+        return QUERY_UNKNOWN;
+}
+
+static void
+h_skip_space (QueryParser* parser)
+{
+        while (*parser->cur == ' ' || *parser->cur == '\t' || *parser->cur == '\n' || *parser->cur == '\r')
+        {
+                parser->cur++;
+        }
+}
+
+static int
+h_is_word_char (char c)
+{
+        return c != '\0' && strchr (" \t\n\r&|!()\"", c) == NULL;
+}
+
+static int h_parse_or (QueryParser* parser);
+
+static int
+h_parse_term (QueryParser* parser)
+{
+        Query* query = parser->query;
+        char* begin = query->text + parser->text_pos;
+        size_t size = 0;
+        if (*parser->cur == '"')
+        {
+                parser->cur++;
+                while (*parser->cur != '"')
+                {
+                        if (*parser->cur == '\0')
+                        {
+                                return -1;
+                        }
+                        if (*parser->cur == '\\' && (parser->cur[1] == '"' || parser->cur[1] == '\\'))
+                        {
+                                parser->cur++;
+                        }
+                        begin[size++] = *parser->cur++;
+                }
+                parser->cur++;
+        }
+        else
+        {
+                while (h_is_word_char (*parser->cur))
+                {
+                        begin[size++] = *parser->cur++;
+                }
+        }
+        parser->text_pos += size;
+        return Query_term (query, begin, size);
+}
+
+static int
+h_parse_unary (QueryParser* parser)
+{
+        h_skip_space (parser);
+        if (*parser->cur == '!')
+        {
+                parser->cur++;
+                int child = h_parse_unary (parser);
+                return child < 0 ? -1 : Query_not (parser->query, child);
+        }
+        if (*parser->cur == '(')
+        {
+                parser->cur++;
+                int node = h_parse_or (parser);
+                h_skip_space (parser);
+                if (node < 0 || *parser->cur != ')')
+                {
+                        return -1;
+                }
+                parser->cur++;
+                return node;
+        }
+        return h_parse_term (parser);
+}
+
+static int
+h_parse_and (QueryParser* parser)
+{
+        int node = h_parse_unary (parser);
+        for (;;)
+        {
+                h_skip_space (parser);
+                char c = *parser->cur;
+                if (node < 0 || c == '\0' || c == '|' || c == ')')
+                {
+                        return node;
+                }
+                if (c == '&')
+                {
+                        parser->cur++;
+                }
+                int right = h_parse_unary (parser);
+                node = right < 0 ? -1 : Query_and (parser->query, node, right);
+        }
+}
+
+static int
+h_parse_or (QueryParser* parser)
+{
+        int node = h_parse_and (parser);
+        for (;;)
+        {
+                h_skip_space (parser);
+                if (node < 0 || *parser->cur != '|')
+                {
+                        return node;
+                }
+                parser->cur++;
+                int right = h_parse_and (parser);
+                node = right < 0 ? -1 : Query_or (parser->query, node, right);
+        }
+}
+
+/*
+ * Add the terms starting at doc[pos] to *hits. The searcher reports one term per position, terms sharing a start
+ *  (e.g. a prefix of another term) are verified here. Returns the end of the last term added (pos if none).
+ */
+static size_t
+h_hits_at (const Query* self, const char* doc, size_t doc_size, size_t pos, uint64_t* hits)
+{
+        size_t end = pos;
+        for (uint8_t term_id = 0; term_id < self->num_terms; ++term_id)
+        {
+                const Pattern* term = &self->terms[term_id];
+                uint64_t bit = (uint64_t) 1 << term_id;
+                if ((*hits & bit) != 0 || term->size > doc_size - pos)
+                {
+                        continue;
+                }
+                int equal = self->icase ? icase_memcmp (doc + pos, term->begin, term->size) == 0
+                                        : memcmp (doc + pos, term->begin, term->size) == 0;
+                if (equal)
+                {
+                        *hits |= bit;
+                        end = pos + term->size > end ? pos + term->size : end;
+                }
+        }
+        return end;
+}
+
+// ____________________________________________________________________________
+
+void
+Query_init (Query* self)
+{
+        self->num_nodes = 0;
+        self->root = -1;
+        self->num_terms = 0;
+        self->text = NULL;
+        self->text_size = 0;
+        self->icase = 0;
+}
+
+int
+Query_term (Query* self, const char* term, size_t term_size)
+{
+        if (term_size == 0)
+        {
+                return -1;
+        }
+        uint8_t term_id = 0;
+        while (term_id < self->num_terms &&
+               (self->terms[term_id].size != term_size || memcmp (self->terms[term_id].begin, term, term_size) != 0))
+        {
+                term_id++;
+        }
+        if (term_id == self->num_terms)
+        {
+                if (self->num_terms >= QUERY_MAX_TERMS)
+                {
+                        return -1;
+                }
+                self->terms[term_id].begin = (char*) term;
+                self->terms[term_id].size = term_size;
+                self->num_terms++;
+        }
+        return h_add_node (self, QUERY_TERM, term_id, -1, -1);
+}
+
+int
+Query_and (Query* self, int left, int right)
+{
+        if (left < 0 || right < 0)
+        {
+                return -1;
+        }
+        return h_add_node (self, QUERY_AND, 0, left, right);
+}
+
+int
+Query_or (Query* self, int left, int right)
+{
+        if (left < 0 || right < 0)
+        {
+                return -1;
+        }
+        return h_add_node (self, QUERY_OR, 0, left, right);
+}
+
+int
+Query_not (Query* self, int child)
+{
+        if (child < 0)
+        {
+                return -1;
+        }
+        return h_add_node (self, QUERY_NOT, 0, child, -1);
+}
+
+int
+Query_parse (Query* self, const char* expression)
+{
+        // terms point into text, it must not be reallocated
+        if (self->text != NULL)
+        {
+                return -1;
+        }
+        self->text_size = strlen (expression) + 1;
+        self->text = malloc (self->text_size);
+        if (self->text == NULL)
+        {
+                return -1;
+        }
+        QueryParser parser;
+        parser.query = self;
+        parser.cur = expression;
+        parser.text_pos = 0;
+        int root = h_parse_or (&parser);
+        h_skip_space (&parser);
+        return *parser.cur == '\0' ? root : -1;
+}
+
+int
+Query_compile (Query* self, int root, int icase)
+{
+        if (root < 0 || root >= self->num_nodes || self->num_terms == 0)
+        {
+                return -1;
+        }
+        self->root = (int16_t) root;
+        self->icase = icase;
+        if (self->num_terms == 1)
+        {
+                if (icase)
+                {
+                        Searcher_init_needle_icase (&self->searcher, self->terms[0].begin, self->terms[0].size);
+                }
+                else
+                {
+                        Searcher_init_needle (&self->searcher, self->terms[0].begin, self->terms[0].size);
+                }
+                return 0;
+        }
+        size_t min_size = SIZE_MAX;
+        for (uint8_t term_id = 0; term_id < self->num_terms; ++term_id)
+        {
+                min_size = self->terms[term_id].size < min_size ? self->terms[term_id].size : min_size;
+        }
+        uint8_t num_masks = (uint8_t) (min_size < 3 ? min_size : 3);
+        if (icase)
+        {
+                SlimTeddy_init_icase (&self->teddy, self->terms, self->num_terms, num_masks);
+        }
+        else
+        {
+                SlimTeddy_init (&self->teddy, self->terms, self->num_terms, num_masks);
+        }
+        Searcher_init_slim_teddy (&self->searcher, &self->teddy);
+        return 0;
+}
+
+QueryResult
+Query_eval (const Query* self, char* doc, size_t doc_size)
+{
+        QueryResult result;
+        result.hits = 0;
+        result.scanned = 0;
+        // e.g. "A | !A" is decided before the scan
+        int value = h_eval (self, self->root, 0, 0);
+
+        size_t pos = 0;
+        while (value == QUERY_UNKNOWN && pos < doc_size)
+        {
+                Match match = Searcher_find_from (&self->searcher, doc, doc_size, pos);
+                if (match.pattern_id < 0)
+                {
+                        break;
+                }
+                pos = (size_t) (match.begin - doc);
+                uint64_t hits = result.hits;
+                size_t end = h_hits_at (self, doc, doc_size, pos, &hits);
+                if (hits != result.hits)
+                {
+                        result.hits = hits;
+                        value = h_eval (self, self->root, result.hits, 0);
+                        result.scanned = end;
+                }
+                pos++;
+        }
+        if (value == QUERY_UNKNOWN)
+        {
+                value = h_eval (self, self->root, result.hits, 1);
+                result.scanned = doc_size;
+        }
+        result.match = value == QUERY_TRUE;
+        return result;
+}
+
+int
+Query_match (const Query* self, char* doc, size_t doc_size)
+{
+        return Query_eval (self, doc, doc_size).match;
+}
+
+size_t
+Query_filter (const Query* self, const Pattern* docs, size_t num_docs, uint8_t* results)
+{
+        size_t num_matches = 0;
+        for (size_t i = 0; i < num_docs; ++i)
+        {
+                results[i] = (uint8_t) Query_match (self, docs[i].begin, docs[i].size);
+                num_matches += results[i];
+        }
+        return num_matches;
+}
+
+void
+Query_destroy (Query* self)
+{
+        free (self->text);
+        self->text = NULL;
+}
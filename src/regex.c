@@ -0,0 +1,1011 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/pattern_syntax.h>
+#include <simdstr/regex.h>
+#include <simdstr/search.h>
+#include <simdstr/utils/utils.h>
+
+#define REGEX_WORDS (REGEX_MAX_POSITIONS / 64)
+
+#define REGEX_DEAD_STATE 0
+#define REGEX_START_STATE 1
+#define REGEX_UNANCHORED_START_STATE 2
+#define REGEX_REVERSE_START_STATE 3
+#define REGEX_REVERSE_UNANCHORED_START_STATE 4
+
+typedef enum {
+        REGEX_CLASS,
+        REGEX_EMPTY,
+        REGEX_CONCAT,
+        REGEX_ALT,
+        REGEX_STAR,
+        REGEX_PLUS,
+        REGEX_QUEST,
+} RegexNodeKind;
+
+// syntax tree node: byte set for REGEX_CLASS, children linked by next for the others
+typedef struct {
+        RegexNodeKind kind;
+        int16_t child;
+        int16_t next;
+        uint8_t set[32];
+} RegexNode;
+
+typedef struct {
+        const char* cur;
+        const char* end;
+        RegexNode nodes[REGEX_MAX_NODES];
+        int16_t num_nodes;
+        // class sets hold both cases of their letters
+        int icase;
+} RegexParser;
+
+typedef struct {
+        uint8_t num;
+        uint8_t sizes[REGEX_MAX_LITERALS];
+        char strs[REGEX_MAX_LITERALS][REGEX_MAX_LITERAL_SIZE];
+} LiteralSet;
+
+typedef struct {
+        // the node matches exactly the strings of exact
+        int is_exact;
+        LiteralSet exact;
+        // every match of the node contains one of the strings of required (num == 0: there is no such set)
+        LiteralSet required;
+} LiteralInfo;
+
+// _____ helper functions _____________________________________________________________________________________________
+
+// --- parser ---
+
+static int16_t
+h_node (RegexParser* parser, RegexNodeKind kind, int16_t child)
+{
+        if (parser->num_nodes == REGEX_MAX_NODES)
+        {
+                return -1;
+        }
+        RegexNode* node = &parser->nodes[parser->num_nodes];
+        node->kind = kind;
+        node->child = child;
+        node->next = -1;
+        memset (node->set, 0, 32);
+        return parser->num_nodes++;
+}
+
+/*
+ * Deep copy of the subtree at node (without its siblings).
+ */
+static int16_t
+h_clone (RegexParser* parser, int16_t node)
+{
+        int16_t copy = h_node (parser, parser->nodes[node].kind, -1);
+        if (copy < 0)
+        {
+                return -1;
+        }
+        memcpy (parser->nodes[copy].set, parser->nodes[node].set, 32);
+        int16_t prev = -1;
+        for (int16_t child = parser->nodes[node].child; child >= 0; child = parser->nodes[child].next)
+        {
+                int16_t child_copy = h_clone (parser, child);
+                if (child_copy < 0)
+                {
+                        return -1;
+                }
+                if (prev < 0)
+                {
+                        parser->nodes[copy].child = child_copy;
+                }
+                else
+                {
+                        parser->nodes[prev].next = child_copy;
+                }
+                prev = child_copy;
+        }
+        return copy;
+}
+
+/*
+ * atom{min_count,max_count} (max_count < 0: unbounded) as a concatenation of copies of atom.
+ */
+static int16_t
+h_repeat (RegexParser* parser, int16_t atom, long min_count, long max_count)
+{
+        int16_t concat = h_node (parser, REGEX_CONCAT, -1);
+        if (concat < 0)
+        {
+                return -1;
+        }
+        int16_t prev = -1;
+        long num_items = max_count < 0 ? min_count + 1 : max_count;
+        for (long idx = 0; idx < num_items; ++idx)
+        {
+                int16_t item = idx == 0 ? atom : h_clone (parser, atom);
+                if (item >= 0 && idx >= min_count)
+                {
+                        item = h_node (parser, max_count < 0 ? REGEX_STAR : REGEX_QUEST, item);
+                }
+                if (item < 0)
+                {
+                        return -1;
+                }
+                if (prev < 0)
+                {
+                        parser->nodes[concat].child = item;
+                }
+                else
+                {
+                        parser->nodes[prev].next = item;
+                }
+                prev = item;
+        }
+        if (prev < 0)
+        {
+                parser->nodes[concat].kind = REGEX_EMPTY;
+        }
+        return concat;
+}
+
+static int16_t h_parse_alt (RegexParser* parser);
+
+static int16_t
+h_parse_atom (RegexParser* parser)
+{
+        int16_t node;
+        uint8_t byte;
+        switch (*parser->cur)
+        {
+                case '(':
+                        parser->cur++;
+                        node = h_parse_alt (parser);
+                        if (node < 0 || parser->cur == parser->end || *parser->cur != ')')
+                        {
+                                return -1;
+                        }
+                        parser->cur++;
+                        return node;
+                case '.':
+                        parser->cur++;
+                        node = h_node (parser, REGEX_CLASS, -1);
+                        if (node >= 0)
+                        {
+                                memset (parser->nodes[node].set, 0xff, 32);
+                        }
+                        return node;
+                case '[':
+                        parser->cur++;
+                        node = h_node (parser, REGEX_CLASS, -1);
+                        if (node < 0 ||
+                            pattern_parse_class (&parser->cur, parser->end, parser->nodes[node].set, parser->icase) != 0)
+                        {
+                                return -1;
+                        }
+                        return node;
+                case '\\':
+                        parser->cur++;
+                        node = h_node (parser, REGEX_CLASS, -1);
+                        if (node < 0)
+                        {
+                                return -1;
+                        }
+                        switch (pattern_parse_escape (&parser->cur, parser->end, parser->nodes[node].set, &byte))
+                        {
+                                case -1:
+                                        return -1;
+                                case 0:
+                                        pattern_set_add (parser->nodes[node].set, byte, byte);
+                        }
+                        if (parser->icase)
+                        {
+                                pattern_set_fold (parser->nodes[node].set);
+                        }
+                        return node;
+                case '*':
+                case '+':
+                case '?':
+                case '{':
+                case '^':
+                case '$':
+                        return -1;
+                default:
+                        byte = (uint8_t) *parser->cur++;
+                        node = h_node (parser, REGEX_CLASS, -1);
+                        if (node >= 0)
+                        {
+                                pattern_set_add (parser->nodes[node].set, byte, byte);
+                                if (parser->icase)
+                                {
+                                        pattern_set_fold (parser->nodes[node].set);
+                                }
+                        }
+                        return node;
+        }
+}
+
+static int16_t
+h_parse_repeat (RegexParser* parser)
+{
+        int16_t node = h_parse_atom (parser);
+        while (node >= 0 && parser->cur < parser->end)
+        {
+                char c = *parser->cur;
+                if (c == '*' || c == '+' || c == '?')
+                {
+                        parser->cur++;
+                        node = h_node (parser, c == '*' ? REGEX_STAR : c == '+' ? REGEX_PLUS : REGEX_QUEST, node);
+                        continue;
+                }
+                if (c != '{')
+                {
+                        break;
+                }
+                // {n}, {n,} or {n,m}
+                char* end;
+                long min_count = strtol (parser->cur + 1, &end, 10);
+                long max_count = min_count;
+                if (end == parser->cur + 1 || min_count < 0 || min_count > REGEX_MAX_POSITIONS)
+                {
+                        return -1;
+                }
+                if (*end == ',')
+                {
+                        const char* max_begin = end + 1;
+                        max_count = strtol (max_begin, &end, 10);
+                        if (end == max_begin)
+                        {
+                                max_count = -1;
+                        }
+                        else if (max_count < min_count || max_count > REGEX_MAX_POSITIONS)
+                        {
+                                return -1;
+                        }
+                }
+                if (*end != '}' || end >= parser->end)
+                {
+                        return -1;
+                }
+                parser->cur = end + 1;
+                node = h_repeat (parser, node, min_count, max_count);
+        }
+        return node;
+}
+
+static int16_t
+h_parse_concat (RegexParser* parser)
+{
+        int16_t concat = h_node (parser, REGEX_CONCAT, -1);
+        int16_t prev = -1;
+        while (concat >= 0 && parser->cur < parser->end && *parser->cur != '|' && *parser->cur != ')')
+        {
+                int16_t item = h_parse_repeat (parser);
+                if (item < 0)
+                {
+                        return -1;
+                }
+                if (prev < 0)
+                {
+                        parser->nodes[concat].child = item;
+                }
+                else
+                {
+                        parser->nodes[prev].next = item;
+                }
+                prev = item;
+        }
+        if (concat >= 0 && prev < 0)
+        {
+                parser->nodes[concat].kind = REGEX_EMPTY;
+        }
+        return concat;
+}
+
+static int16_t
+h_parse_alt (RegexParser* parser)
+{
+        int16_t first = h_parse_concat (parser);
+        if (first < 0 || parser->cur == parser->end || *parser->cur != '|')
+        {
+                return first;
+        }
+        int16_t alt = h_node (parser, REGEX_ALT, first);
+        int16_t prev = first;
+        while (alt >= 0 && parser->cur < parser->end && *parser->cur == '|')
+        {
+                parser->cur++;
+                int16_t item = h_parse_concat (parser);
+                if (item < 0)
+                {
+                        return -1;
+                }
+                parser->nodes[prev].next = item;
+                prev = item;
+        }
+        return alt;
+}
+
+// --- literals ---
+
+static int
+h_member (const uint8_t* set, unsigned byte)
+{
+        return (set[byte / 8] >> (byte % 8)) & 1;
+}
+
+/*
+ * The byte a class matches (lower case if icase), -1 if it matches none or several bytes.
+ */
+static int
+h_class_byte (const uint8_t* set, int icase)
+{
+        int byte = -1;
+        unsigned num_members = 0;
+        for (unsigned c = 0; c < 256; ++c)
+        {
+                if (c != '\n' && h_member (set, c))
+                {
+                        byte = num_members == 0 ? (int) c : byte;
+                        num_members++;
+                }
+        }
+        if (num_members == 1 || (icase && num_members == 2 && byte >= 'A' && byte <= 'Z'))
+        {
+                return icase && byte >= 'A' && byte <= 'Z' ? byte | 0x20 : byte;
+        }
+        return -1;
+}
+
+static int
+h_literals_add (LiteralSet* self, const char* str, size_t size)
+{
+        for (uint8_t idx = 0; idx < self->num; ++idx)
+        {
+                if (self->sizes[idx] == size && memcmp (self->strs[idx], str, size) == 0)
+                {
+                        return 0;
+                }
+        }
+        if (self->num == REGEX_MAX_LITERALS || size > REGEX_MAX_LITERAL_SIZE)
+        {
+                return -1;
+        }
+        memcpy (self->strs[self->num], str, size);
+        self->sizes[self->num++] = (uint8_t) size;
+        return 0;
+}
+
+static int
+h_literals_union (LiteralSet* self, const LiteralSet* other)
+{
+        for (uint8_t idx = 0; idx < other->num; ++idx)
+        {
+                if (h_literals_add (self, other->strs[idx], other->sizes[idx]) != 0)
+                {
+                        return -1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * All concatenations a + b. Returns -1 if they exceed the limits.
+ */
+static int
+h_literals_cross (const LiteralSet* a, const LiteralSet* b, LiteralSet* result)
+{
+        char str[2 * REGEX_MAX_LITERAL_SIZE];
+        result->num = 0;
+        for (uint8_t i = 0; i < a->num; ++i)
+        {
+                for (uint8_t j = 0; j < b->num; ++j)
+                {
+                        memcpy (str, a->strs[i], a->sizes[i]);
+                        memcpy (str + a->sizes[i], b->strs[j], b->sizes[j]);
+                        if (h_literals_add (result, str, a->sizes[i] + b->sizes[j]) != 0)
+                        {
+                                return -1;
+                        }
+                }
+        }
+        return 0;
+}
+
+/*
+ * Size of the shortest literal (0 for empty sets and sets containing the empty string).
+ */
+static size_t
+h_literals_score (const LiteralSet* self)
+{
+        size_t score = self->num == 0 ? 0 : SIZE_MAX;
+        for (uint8_t idx = 0; idx < self->num; ++idx)
+        {
+                score = self->sizes[idx] < score ? self->sizes[idx] : score;
+        }
+        return score;
+}
+
+/*
+ * Keep the more selective required set: longer shortest literal, then fewer literals.
+ */
+static void
+h_literals_consider (LiteralSet* best, const LiteralSet* candidate)
+{
+        size_t score = h_literals_score (candidate);
+        size_t best_score = h_literals_score (best);
+        if (score > 0 && (score > best_score || (score == best_score && candidate->num < best->num)))
+        {
+                *best = *candidate;
+        }
+}
+
+static void
+h_literals (const RegexParser* parser, int16_t node, int icase, LiteralInfo* info)
+{
+        const RegexNode* n = &parser->nodes[node];
+        LiteralInfo child;
+        LiteralSet run;
+        LiteralSet cross;
+        info->is_exact = 0;
+        info->exact.num = 0;
+        info->required.num = 0;
+        switch (n->kind)
+        {
+                case REGEX_CLASS:
+                {
+                        int byte = h_class_byte (n->set, icase);
+                        if (byte >= 0)
+                        {
+                                char c = (char) byte;
+                                info->is_exact = 1;
+                                h_literals_add (&info->exact, &c, 1);
+                                info->required = info->exact;
+                        }
+                        break;
+                }
+                case REGEX_EMPTY:
+                        info->is_exact = 1;
+                        h_literals_add (&info->exact, "", 0);
+                        break;
+                case REGEX_CONCAT:
+                        // merge runs of exact items, every run and every item requirement is a candidate
+                        info->is_exact = 1;
+                        run.num = 0;
+                        h_literals_add (&run, "", 0);
+                        for (int16_t item = n->child; item >= 0; item = parser->nodes[item].next)
+                        {
+                                h_literals (parser, item, icase, &child);
+                                if (child.is_exact && h_literals_cross (&run, &child.exact, &cross) == 0)
+                                {
+                                        run = cross;
+                                        continue;
+                                }
+                                info->is_exact = 0;
+                                h_literals_consider (&info->required, &run);
+                                if (child.is_exact)
+                                {
+                                        run = child.exact;
+                                }
+                                else
+                                {
+                                        h_literals_consider (&info->required, &child.required);
+                                        run.num = 0;
+                                        h_literals_add (&run, "", 0);
+                                }
+                        }
+                        h_literals_consider (&info->required, &run);
+                        if (info->is_exact)
+                        {
+                                info->exact = run;
+                        }
+                        break;
+                case REGEX_ALT:
+                {
+                        int has_required = 1;
+                        info->is_exact = 1;
+                        for (int16_t item = n->child; item >= 0; item = parser->nodes[item].next)
+                        {
+                                h_literals (parser, item, icase, &child);
+                                if (info->is_exact && (!child.is_exact || h_literals_union (&info->exact, &child.exact) != 0))
+                                {
+                                        info->is_exact = 0;
+                                }
+                                if (has_required && (h_literals_score (&child.required) == 0 ||
+                                                     h_literals_union (&info->required, &child.required) != 0))
+                                {
+                                        has_required = 0;
+                                }
+                        }
+                        if (!info->is_exact)
+                        {
+                                info->exact.num = 0;
+                        }
+                        if (!has_required)
+                        {
+                                info->required.num = 0;
+                        }
+                        break;
+                }
+                case REGEX_STAR:
+                        break;
+                case REGEX_PLUS:
+                        h_literals (parser, n->child, icase, &child);
+                        info->required = child.required;
+                        break;
+                case REGEX_QUEST:
+                        h_literals (parser, n->child, icase, &child);
+                        info->exact = child.exact;
+                        info->is_exact = child.is_exact && h_literals_add (&info->exact, "", 0) == 0;
+                        break;
+        }
+}
+
+// --- automaton ---
+
+static void
+h_bits_or (uint64_t* self, const uint64_t* other)
+{
+        for (unsigned word = 0; word < REGEX_WORDS; ++word)
+        {
+                self[word] |= other[word];
+        }
+}
+
+/*
+ * Glushkov construction: first and last positions of node and whether it matches the empty string. Adds the follow
+ *  sets within node. Returns -1 if there are too many positions.
+ */
+static int
+h_glushkov (Regex* self, const RegexParser* parser, int16_t node, uint64_t* first, uint64_t* last, int* nullable)
+{
+        const RegexNode* n = &parser->nodes[node];
+        uint64_t child_first[REGEX_WORDS];
+        uint64_t child_last[REGEX_WORDS];
+        int child_nullable;
+        memset (first, 0, sizeof (child_first));
+        memset (last, 0, sizeof (child_last));
+        *nullable = n->kind != REGEX_CLASS && n->kind != REGEX_ALT;
+        switch (n->kind)
+        {
+                case REGEX_CLASS:
+                {
+                        if (self->num_positions == REGEX_MAX_POSITIONS)
+                        {
+                                return -1;
+                        }
+                        uint16_t position = self->num_positions++;
+                        uint64_t bit = (uint64_t) 1 << (position % 64);
+                        for (unsigned byte = 0; byte < 256; ++byte)
+                        {
+                                if (byte != '\n' && h_member (n->set, byte))
+                                {
+                                        self->byte_positions[byte][position / 64] |= bit;
+                                }
+                        }
+                        first[position / 64] = bit;
+                        last[position / 64] = bit;
+                        return 0;
+                }
+                case REGEX_EMPTY:
+                        return 0;
+                case REGEX_CONCAT:
+                        for (int16_t item = n->child; item >= 0; item = parser->nodes[item].next)
+                        {
+                                if (h_glushkov (self, parser, item, child_first, child_last, &child_nullable) != 0)
+                                {
+                                        return -1;
+                                }
+                                for (uint16_t position = 0; position < self->num_positions; ++position)
+                                {
+                                        if ((last[position / 64] >> (position % 64)) & 1)
+                                        {
+                                                h_bits_or (self->follow[position], child_first);
+                                        }
+                                }
+                                if (*nullable)
+                                {
+                                        h_bits_or (first, child_first);
+                                }
+                                if (!child_nullable)
+                                {
+                                        memset (last, 0, sizeof (child_last));
+                                }
+                                h_bits_or (last, child_last);
+                                *nullable = *nullable && child_nullable;
+                        }
+                        return 0;
+                case REGEX_ALT:
+                        for (int16_t item = n->child; item >= 0; item = parser->nodes[item].next)
+                        {
+                                if (h_glushkov (self, parser, item, child_first, child_last, &child_nullable) != 0)
+                                {
+                                        return -1;
+                                }
+                                h_bits_or (first, child_first);
+                                h_bits_or (last, child_last);
+                                *nullable = *nullable || child_nullable;
+                        }
+                        return 0;
+                case REGEX_STAR:
+                case REGEX_PLUS:
+                case REGEX_QUEST:
+                        if (h_glushkov (self, parser, n->child, first, last, &child_nullable) != 0)
+                        {
+                                return -1;
+                        }
+                        if (n->kind != REGEX_QUEST)
+                        {
+                                for (uint16_t position = 0; position < self->num_positions; ++position)
+                                {
+                                        if ((last[position / 64] >> (position % 64)) & 1)
+                                        {
+                                                h_bits_or (self->follow[position], first);
+                                        }
+                                }
+                        }
+                        *nullable = n->kind == REGEX_PLUS ? child_nullable : 1;
+                        return 0;
+        }
+        return -1;
+}
+
+// --- DFA cache ---
+
+static size_t
+h_state_hash (const uint64_t* set, uint8_t unanchored, uint8_t reverse)
+{
+        uint64_t hash = (uint64_t) unanchored | (uint64_t) reverse << 1;
+        for (unsigned word = 0; word < REGEX_WORDS; ++word)
+        {
+                hash = (hash ^ set[word]) * 0x9e3779b97f4a7c15ull;
+        }
+        return (size_t) (hash ^ (hash >> 29));
+}
+
+/*
+ * Index of the cached state (set, unanchored, reverse), added if it is new. Returns -1 if the cache is full.
+ */
+static int32_t
+h_state (Regex* self, const uint64_t* set, uint8_t unanchored, uint8_t reverse)
+{
+        size_t slot = h_state_hash (set, unanchored, reverse) & (self->table_size - 1);
+        while (self->table[slot] >= 0)
+        {
+                RegexState* state = &self->states[self->table[slot]];
+                if (state->unanchored == unanchored && state->reverse == reverse &&
+                    memcmp (state->set, set, sizeof (state->set)) == 0)
+                {
+                        return self->table[slot];
+                }
+                slot = (slot + 1) & (self->table_size - 1);
+        }
+        if (self->num_states == self->cache_states)
+        {
+                return -1;
+        }
+        int32_t index = (int32_t) self->num_states++;
+        RegexState* state = &self->states[index];
+        memcpy (state->set, set, sizeof (state->set));
+        state->unanchored = unanchored;
+        state->reverse = reverse;
+        state->accepting = 0;
+        const uint64_t* accepting = reverse ? self->first : self->last;
+        for (unsigned word = 0; word < REGEX_WORDS; ++word)
+        {
+                state->accepting |= (set[word] & accepting[word]) != 0;
+        }
+        memset (state->next, 0xff, sizeof (state->next));
+        self->table[slot] = index;
+        return index;
+}
+
+/*
+ * Drop all cached states but the dead and the start states.
+ */
+static void
+h_flush (Regex* self)
+{
+        uint64_t set[REGEX_WORDS] = {0};
+        memset (self->table, 0xff, self->table_size * sizeof (int32_t));
+        self->num_states = 0;
+        h_state (self, set, 0, 0);
+        set[0] = 1;
+        h_state (self, set, 0, 0);
+        h_state (self, set, 1, 0);
+        h_state (self, set, 0, 1);
+        h_state (self, set, 1, 1);
+}
+
+static int32_t
+h_step (Regex* self, int32_t current, uint8_t byte)
+{
+        RegexState* state = &self->states[current];
+        if (state->next[byte] >= 0)
+        {
+                return state->next[byte];
+        }
+        uint64_t set[REGEX_WORDS] = {0};
+        uint64_t (*follow)[REGEX_WORDS] = state->reverse ? self->reverse_follow : self->follow;
+        for (unsigned word = 0; word < REGEX_WORDS; ++word)
+        {
+                uint64_t bits = state->set[word];
+                while (bits != 0)
+                {
+                        h_bits_or (set, follow[word * 64 + ctz_64 (bits)]);
+                        bits &= bits - 1;
+                }
+        }
+        for (unsigned word = 0; word < REGEX_WORDS; ++word)
+        {
+                set[word] &= self->byte_positions[byte][word];
+        }
+        uint8_t unanchored = state->unanchored;
+        uint8_t reverse = state->reverse;
+        set[0] |= unanchored;
+        int32_t next = h_state (self, set, unanchored, reverse);
+        if (next >= 0)
+        {
+                state->next[byte] = next;
+                return next;
+        }
+        // the flush invalidates current
+        h_flush (self);
+        self->num_flushes++;
+        return h_state (self, set, unanchored, reverse);
+}
+
+static inline int
+h_accepts (const Regex* self, int32_t state, size_t pos, size_t end)
+{
+        return self->states[state].accepting && (!self->anchored_end || pos == end);
+}
+
+/*
+ * Leftmost-longest match in str[begin, end), a line (begin is a line start if line_start) or its end.
+ */
+static int
+h_match_line (Regex* self, char* str, size_t begin, size_t end, int line_start, Match* match)
+{
+        size_t start = begin;
+        if (self->anchored_start && !line_start)
+        {
+                return 0;
+        }
+        if (!self->anchored_start)
+        {
+                // leftmost start: the reversed automaton reads the line backwards from its end (only matches ending
+                //  there if anchored_end) and accepts at every match start
+                int32_t state = self->anchored_end ? REGEX_REVERSE_START_STATE : REGEX_REVERSE_UNANCHORED_START_STATE;
+                start = SIZE_MAX;
+                size_t pos = end;
+                for (;;)
+                {
+                        if (self->states[state].accepting)
+                        {
+                                start = pos;
+                        }
+                        if (pos == begin || state == REGEX_DEAD_STATE)
+                        {
+                                break;
+                        }
+                        state = h_step (self, state, (uint8_t) str[--pos]);
+                }
+                if (start == SIZE_MAX)
+                {
+                        return 0;
+                }
+        }
+        // longest match from start
+        int32_t state = REGEX_START_STATE;
+        size_t match_end = SIZE_MAX;
+        size_t pos = start;
+        for (;;)
+        {
+                if (h_accepts (self, state, pos, end))
+                {
+                        match_end = pos;
+                }
+                if (pos == end || state == REGEX_DEAD_STATE)
+                {
+                        break;
+                }
+                state = h_step (self, state, (uint8_t) str[pos++]);
+        }
+        if (match_end == SIZE_MAX)
+        {
+                return 0;
+        }
+        match->pattern_id = 0;
+        match->begin = str + start;
+        match->end = str + match_end;
+        return 1;
+}
+
+// ____________________________________________________________________________________________________________________
+
+int
+Regex_compile (Regex* self, const char* pattern, int icase, size_t cache_states)
+{
+        self->states = NULL;
+        self->table = NULL;
+        RegexParser* parser = malloc (sizeof (RegexParser));
+        if (parser == NULL)
+        {
+                return -1;
+        }
+        parser->cur = pattern;
+        parser->end = pattern + strlen (pattern);
+        parser->num_nodes = 0;
+        parser->icase = icase;
+        self->anchored_start = parser->cur < parser->end && *parser->cur == '^';
+        parser->cur += self->anchored_start;
+        // a trailing '$' unless it is escaped
+        self->anchored_end = 0;
+        if (parser->end > parser->cur && parser->end[-1] == '$')
+        {
+                size_t num_backslashes = 0;
+                while (parser->end - 1 - num_backslashes > parser->cur && parser->end[-2 - (ptrdiff_t) num_backslashes] == '\\')
+                {
+                        num_backslashes++;
+                }
+                self->anchored_end = num_backslashes % 2 == 0;
+        }
+        parser->end -= self->anchored_end;
+
+        int16_t root = h_parse_alt (parser);
+        if (root < 0 || parser->cur != parser->end)
+        {
+                free (parser);
+                return -1;
+        }
+
+        memset (self->follow, 0, sizeof (self->follow));
+        memset (self->byte_positions, 0, sizeof (self->byte_positions));
+        self->num_positions = 1;
+        uint64_t first[REGEX_WORDS];
+        int nullable;
+        if (h_glushkov (self, parser, root, first, self->last, &nullable) != 0)
+        {
+                free (parser);
+                return -1;
+        }
+        memcpy (self->follow[0], first, sizeof (first));
+        self->last[0] |= (uint64_t) nullable;
+
+        // reversed automaton: position 0 leads to the last positions, matches start at the first ones
+        memset (self->reverse_follow, 0, sizeof (self->reverse_follow));
+        for (uint16_t position = 1; position < self->num_positions; ++position)
+        {
+                uint64_t bit = (uint64_t) 1 << (position % 64);
+                for (uint16_t next = 1; next < self->num_positions; ++next)
+                {
+                        if ((self->follow[position][next / 64] >> (next % 64)) & 1)
+                        {
+                                self->reverse_follow[next][position / 64] |= bit;
+                        }
+                }
+        }
+        memcpy (self->reverse_follow[0], self->last, sizeof (self->last));
+        self->reverse_follow[0][0] &= ~(uint64_t) 1;
+        memcpy (self->first, first, sizeof (first));
+        self->first[0] |= (uint64_t) nullable;
+
+        LiteralInfo info;
+        h_literals (parser, root, icase, &info);
+        free (parser);
+        self->num_literals = info.required.num;
+        size_t min_size = SIZE_MAX;
+        for (uint8_t literal_id = 0; literal_id < self->num_literals; ++literal_id)
+        {
+                memcpy (self->literals[literal_id], info.required.strs[literal_id], info.required.sizes[literal_id]);
+                self->literal_patterns[literal_id].begin = self->literals[literal_id];
+                self->literal_patterns[literal_id].size = info.required.sizes[literal_id];
+                min_size = info.required.sizes[literal_id] < min_size ? info.required.sizes[literal_id] : min_size;
+        }
+        if (self->num_literals == 1)
+        {
+                if (icase)
+                {
+                        Searcher_init_needle_icase (&self->searcher, self->literals[0], min_size);
+                }
+                else
+                {
+                        Searcher_init_needle (&self->searcher, self->literals[0], min_size);
+                }
+        }
+        else if (self->num_literals > 1)
+        {
+                uint8_t num_masks = (uint8_t) (min_size < 3 ? min_size : 3);
+                if (icase)
+                {
+                        SlimTeddy_init_icase (&self->teddy, self->literal_patterns, self->num_literals, num_masks);
+                }
+                else
+                {
+                        SlimTeddy_init (&self->teddy, self->literal_patterns, self->num_literals, num_masks);
+                }
+                Searcher_init_slim_teddy (&self->searcher, &self->teddy);
+        }
+
+        self->cache_states = cache_states == 0 ? REGEX_DEFAULT_CACHE_STATES : cache_states < 8 ? 8 : cache_states;
+        self->table_size = 1;
+        while (self->table_size < 2 * self->cache_states)
+        {
+                self->table_size <<= 1;
+        }
+        self->states = malloc (self->cache_states * sizeof (RegexState));
+        self->table = malloc (self->table_size * sizeof (int32_t));
+        if (self->states == NULL || self->table == NULL)
+        {
+                Regex_destroy (self);
+                return -1;
+        }
+        self->num_flushes = 0;
+        h_flush (self);
+        return 0;
+}
+
+Match
+Regex_find (Regex* self, char* str, size_t str_size)
+{
+        return Regex_find_from (self, str, str_size, 0);
+}
+
+Match
+Regex_find_from (Regex* self, char* str, size_t str_size, size_t from)
+{
+        Match match = Match_empty ();
+        size_t pos = from;
+        if (self->num_literals == 0)
+        {
+                // every line is a candidate
+                while (pos <= str_size)
+                {
+                        const char* newline = pos < str_size ? simd_strchr (str + pos, str_size - pos, '\n') : NULL;
+                        size_t end = newline != NULL ? (size_t) (newline - str) : str_size;
+                        if (h_match_line (self, str, pos, end, pos == 0 || str[pos - 1] == '\n', &match))
+                        {
+                                return match;
+                        }
+                        pos = end + 1;
+                }
+                return match;
+        }
+        while (pos < str_size)
+        {
+                Match hit = Searcher_find_from (&self->searcher, str, str_size, pos);
+                if (hit.pattern_id < 0)
+                {
+                        break;
+                }
+                size_t hit_pos = (size_t) (hit.begin - str);
+                // the lines in between contain no literal
+                const char* newline = simd_memrchr (str + pos, hit_pos - pos, '\n');
+                size_t begin = newline != NULL ? (size_t) (newline - str) + 1 : pos;
+                newline = simd_strchr (hit.begin, str_size - hit_pos, '\n');
+                size_t end = newline != NULL ? (size_t) (newline - str) : str_size;
+                if (h_match_line (self, str, begin, end, begin == 0 || str[begin - 1] == '\n', &match))
+                {
+                        return match;
+                }
+                pos = end + 1;
+        }
+        return Match_empty ();
+}
+
+void
+Regex_destroy (Regex* self)
+{
+        free (self->states);
+        free (self->table);
+        self->states = NULL;
+        self->table = NULL;
+}
@@ -28,7 +28,7 @@ strchrchr (const char *str, size_t str_len, int fst, int snd)
 {
         if (fst == snd)
         {
-                return strchr (str, fst);
+                return memchr (str, fst, str_len);
         }
 
         for (size_t i = 0; i < str_len; ++i)
@@ -39,50 +39,42 @@ strchrchr (const char *str, size_t str_len, int fst, int snd)
         return NULL;
 }
 
+/*
+ * Find the first occurrence of substr that lies completely within str[0, str_len).
+ */
 const char *
 rest_strstr (const char *str, size_t str_len, const char *substr, size_t substr_len)
 {
-        for (/**/; str_len > 0; --str_len)
+        if (substr_len > str_len)
         {
-                bool match = true;
-                for (size_t p_i = 0; p_i < substr_len; ++p_i)
-                {
-                        if (*str != substr[p_i])
-                        {
-                                match = false;
-                                break;
-                        }
-                        str++;
-                }
-                if (match)
+                return NULL;
+        }
+        for (size_t i = 0; i + substr_len <= str_len; ++i)
+        {
+                if (memcmp (str + i, substr, substr_len) == 0)
                 {
-                        return str - substr_len;
+                        return str + i;
                 }
-                str++;
         }
         return NULL;
 }
 
+/*
+ * Case insensitive rest_strstr.
+ */
 const char *
 rest_stristr (const char *str, size_t str_len, const char *substr, size_t substr_len)
 {
-        for (/**/; str_len > 0; --str_len)
+        if (substr_len > str_len)
         {
-                bool match = true;
-                for (size_t p_i = 0; p_i < substr_len; ++p_i)
-                {
-                        if (tolower (*str) != tolower (substr[p_i]))
-                        {
-                                match = false;
-                                break;
-                        }
-                        str++;
-                }
-                if (match)
+                return NULL;
+        }
+        for (size_t i = 0; i + substr_len <= str_len; ++i)
+        {
+                if (icase_memcmp (str + i, substr, substr_len) == 0)
                 {
-                        return str - substr_len;
+                        return str + i;
                 }
-                str++;
         }
         return NULL;
 }
@@ -215,32 +207,34 @@ simd_generic_search_avx_32 (const char *str, size_t str_len, const char *substr,
         {
                 return NULL;
         }
-        fst_index = fst_index < 0 ? 0 : fst_index;
-        snd_index = snd_index < 0 ? (int) (substr_len - 1) : snd_index;
-        if (fst_index >= substr_len || snd_index >= substr_len || snd_index <= fst_index || snd_index < 1)
+        if (substr_len == 0)
         {
-                return NULL;
+                return str;
         }
-
         // perform simd_strchr if pattern size is 1
         if (substr_len == 1)
         {
                 return simd_strchr (str, str_len, *substr);
         }
+        fst_index = fst_index < 0 ? 0 : fst_index;
+        snd_index = snd_index < 0 ? (int) (substr_len - 1) : snd_index;
+        if (fst_index >= substr_len || snd_index >= substr_len || snd_index <= fst_index || snd_index < 1)
+        {
+                return NULL;
+        }
+
 
         // ensure proper memory alignment
-        if (((uintptr_t) str & 0x1fu) != 0)
+        if (((uintptr_t) str & 0x1fu) != 0 && str_len >= 64 + substr_len)
         {
                 size_t unaligned_size = 32 - (((uintptr_t) str) & 0x1fu);
-                const char *result = rest_strstr (str, unaligned_size + substr_len, substr, substr_len);
+                const char *result = rest_strstr (str, unaligned_size + substr_len - 1, substr, substr_len);
                 if (result != NULL)
                 {
                         return result;
                 }
-                else
-                {
-                        str += unaligned_size;
-                }
+                str += unaligned_size;
+                str_len -= unaligned_size;
         }
 
         int fst_snd_distance = snd_index - fst_index;
@@ -250,13 +244,13 @@ simd_generic_search_avx_32 (const char *str, size_t str_len, const char *substr,
         // load last char of pattern
         const __m256i last = _mm256_set1_epi8 (substr[snd_index]);
 
-        // we are using 256 bits (32 bytes) vectors. If remaining str is smaller than
-        // 32, we stop and perform std::strstr on the remaining str
-        while (str_len >= 32 + substr_len)
+        // we are using 256 bits (32 bytes) vectors covering 32 start positions. If less than 32 start positions remain,
+        //  we stop and perform rest_strstr on the remaining str
+        while (str_len >= 32 + substr_len - 1)
         {
-                uint32_t mask = h_simd_generic_search_32_block_cmp (str, first, last, fst_snd_distance);
+                uint32_t mask = h_simd_generic_search_32_block_cmp (str + fst_index, first, last, fst_snd_distance);
 
-                const char *match = h_simd_generic_search_32_mask_cmp (str, substr, substr_len, mask, fst_index);
+                const char *match = h_simd_generic_search_32_mask_cmp (str + fst_index, substr, substr_len, mask, fst_index);
                 if (match != NULL)
                 {
                         return match;
@@ -264,7 +258,7 @@ simd_generic_search_avx_32 (const char *str, size_t str_len, const char *substr,
                 str_len -= 32;
                 str += 32;
         }
-        return strstr (str, substr);
+        return rest_strstr (str, str_len, substr, substr_len);
 }
 
 const char *
@@ -274,18 +268,22 @@ simd_generic_search_avx_64 (const char *str, size_t str_len, const char *substr,
         {
                 return NULL;
         }
-        fst_index = fst_index < 0 ? 0 : fst_index;
-        snd_index = snd_index < 0 ? (int) (substr_len - 1) : snd_index;
-        if (fst_index >= substr_len || snd_index >= substr_len || snd_index <= fst_index || snd_index < 1)
+        if (substr_len == 0)
         {
-                return NULL;
+                return str;
         }
-
         // perform simd_strchr if pattern size is 1
         if (substr_len == 1)
         {
                 return simd_strchr (str, str_len, *substr);
         }
+        fst_index = fst_index < 0 ? 0 : fst_index;
+        snd_index = snd_index < 0 ? (int) (substr_len - 1) : snd_index;
+        if (fst_index >= substr_len || snd_index >= substr_len || snd_index <= fst_index || snd_index < 1)
+        {
+                return NULL;
+        }
+
 
         /*
         // ensure proper memory alignment
@@ -311,21 +309,21 @@ simd_generic_search_avx_64 (const char *str, size_t str_len, const char *substr,
         // load last char of pattern
         const __m512i last = _mm512_set1_epi8 (substr[snd_index]);
 
-        // we are using 256 bit (32 bytes) vectors. If remaining str is smaller than
-        // 32, we stop and perform std::strstr on the remaining str
-        while (str_len >= 32 + substr_len)
+        // we are using 512 bit (64 bytes) vectors covering 64 start positions. If less than 64 start positions remain,
+        //  we stop and perform rest_strstr on the remaining str
+        while (str_len >= 64 + substr_len - 1)
         {
-                uint64_t mask = h_simd_generic_search_64_block_cmp (str, first, last, fst_snd_distance);
+                uint64_t mask = h_simd_generic_search_64_block_cmp (str + fst_index, first, last, fst_snd_distance);
 
-                const char *match = h_simd_generic_search_64_mask_cmp (str, substr, substr_len, mask, fst_index);
+                const char *match = h_simd_generic_search_64_mask_cmp (str + fst_index, substr, substr_len, mask, fst_index);
                 if (match != NULL)
                 {
                         return match;
                 }
-                str_len -= 32;
-                str += 32;
+                str_len -= 64;
+                str += 64;
         }
-        return strstr (str, substr);
+        return rest_strstr (str, str_len, substr, substr_len);
 }
 
 // ____________________________________________________________________________
@@ -337,13 +335,13 @@ simd_strchr (const char *str, size_t str_len, int c)
                 return NULL;
         if (str_len < 32)
         {
-                return strchr (str, c);
+                return memchr (str, c, str_len);
         }
         // load c into SIMD vector
         const __m256i _c = _mm256_set1_epi8 (c);
 
         // we are using 256 bits (32 bytes) vectors. If remaining str is smaller than
-        // 32, we stop and perform std::strchr on the remaining str
+        // 32, we stop and perform memchr on the remaining str
         while (str_len >= 32)
         {
                 // load next 32 bytes
@@ -362,7 +360,7 @@ simd_strchr (const char *str, size_t str_len, int c)
                 str_len -= 32;
                 str += 32;
         }
-        return strchr (str, c);
+        return memchr (str, c, str_len);
 }
 
 const char *
@@ -408,15 +406,80 @@ simd_strichr (const char *str, size_t str_len, int c)
         return strchrchr (str, str_len, lower, upper);
 }
 
+size_t
+simd_count_char (const char *str, size_t str_len, int c)
+{
+        if (str == NULL)
+                return 0;
+        size_t count = 0;
+        const __m256i _c = _mm256_set1_epi8 ((char) c);
+        // 128 bytes per iteration: four independent loads and compares, two 64 bit masks
+        while (str_len >= 128)
+        {
+                const __m256i eq0 = _mm256_cmpeq_epi8 (_c, _mm256_loadu_si256 ((const __m256i *) str));
+                const __m256i eq1 = _mm256_cmpeq_epi8 (_c, _mm256_loadu_si256 ((const __m256i *) (str + 32)));
+                const __m256i eq2 = _mm256_cmpeq_epi8 (_c, _mm256_loadu_si256 ((const __m256i *) (str + 64)));
+                const __m256i eq3 = _mm256_cmpeq_epi8 (_c, _mm256_loadu_si256 ((const __m256i *) (str + 96)));
+                uint64_t mask01 = (uint32_t) _mm256_movemask_epi8 (eq0) | ((uint64_t) (uint32_t) _mm256_movemask_epi8 (eq1) << 32);
+                uint64_t mask23 = (uint32_t) _mm256_movemask_epi8 (eq2) | ((uint64_t) (uint32_t) _mm256_movemask_epi8 (eq3) << 32);
+                count += popcount_64 (mask01) + popcount_64 (mask23);
+                str_len -= 128;
+                str += 128;
+        }
+        while (str_len >= 32)
+        {
+                const __m256i block = _mm256_loadu_si256 ((const __m256i *) str);
+                const __m256i eq = _mm256_cmpeq_epi8 (_c, block);
+                count += popcount_32 ((uint32_t) _mm256_movemask_epi8 (eq));
+                str_len -= 32;
+                str += 32;
+        }
+        for (size_t i = 0; i < str_len; ++i)
+        {
+                count += str[i] == (char) c;
+        }
+        return count;
+}
+
+const char *
+simd_memrchr (const char *str, size_t str_len, int c)
+{
+        if (str == NULL)
+                return NULL;
+        const __m256i _c = _mm256_set1_epi8 ((char) c);
+        // scan 32 byte blocks from the end
+        while (str_len >= 32)
+        {
+                const __m256i block = _mm256_loadu_si256 ((const __m256i *) (str + str_len - 32));
+                uint32_t mask = (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_c, block));
+                if (mask != 0)
+                {
+                        return str + str_len - 32 + (31 - clz_32 (mask));
+                }
+                str_len -= 32;
+        }
+        while (str_len > 0)
+        {
+                str_len--;
+                if (str[str_len] == (char) c)
+                        return str + str_len;
+        }
+        return NULL;
+}
+
 const char *
 simd_strstr (const char *str, size_t str_len, const char *substr, size_t substr_len)
 {
         if (avx512()) {
-                simd_generic_search_avx_64 (str, str_len, substr, substr_len, -1, -1);
+                return simd_generic_search_avx_64 (str, str_len, substr, substr_len, -1, -1);
         } else if (avx2()) {
-                simd_generic_search_avx_32 (str, str_len, substr, substr_len, -1, -1);
+                return simd_generic_search_avx_32 (str, str_len, substr, substr_len, -1, -1);
         }
-        return NULL;
+        if (str == NULL || substr == NULL)
+        {
+                return NULL;
+        }
+        return rest_strstr (str, str_len, substr, substr_len);
 }
 
 const char *
@@ -424,6 +487,8 @@ simd_stristr (const char *str, size_t str_len, const char *substr, size_t substr
 {
         if (str == NULL || substr == NULL || substr_len > str_len)
                 return NULL;
+        if (substr_len == 0)
+                return str;
         if (substr_len == 1)
                 return simd_strichr (str, str_len, substr[0]);
         if (str_len < 32 + substr_len)
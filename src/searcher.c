@@ -0,0 +1,334 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <string.h>
+
+#include <simdstr/search.h>
+#include <simdstr/searcher.h>
+
+// bytes around the searched window, SEARCH_EDGE for buffer edges
+typedef struct {
+        int before;
+        int after;
+} WindowContext;
+
+void
+Searcher_init_needle (Searcher* self, const char* needle, size_t needle_size)
+{
+        self->kind = SEARCHER_NEEDLE;
+        self->needle.begin = (char*) needle;
+        self->needle.size = needle_size;
+        self->slim_teddy = NULL;
+        self->fat_teddy = NULL;
+        self->min_pattern_size = needle_size;
+        self->max_pattern_size = needle_size;
+        self->icase = 0;
+        self->flags = 0;
+}
+
+void
+Searcher_init_needle_icase (Searcher* self, const char* needle, size_t needle_size)
+{
+        Searcher_init_needle (self, needle, needle_size);
+        self->icase = 1;
+}
+
+void
+Searcher_init_slim_teddy (Searcher* self, SlimTeddy* teddy)
+{
+        self->kind = SEARCHER_SLIM_TEDDY;
+        self->slim_teddy = teddy;
+        self->fat_teddy = NULL;
+        self->min_pattern_size = SIZE_MAX;
+        self->max_pattern_size = 0;
+        self->icase = teddy->icase;
+        self->flags = 0;
+        for (uint16_t pattern_id = 0; pattern_id < teddy->num_patterns; ++pattern_id)
+        {
+                size_t size = teddy->patterns[pattern_id].size;
+                self->min_pattern_size = size < self->min_pattern_size ? size : self->min_pattern_size;
+                self->max_pattern_size = size > self->max_pattern_size ? size : self->max_pattern_size;
+        }
+}
+
+void
+Searcher_init_fat_teddy (Searcher* self, FatTeddy* teddy)
+{
+        self->kind = SEARCHER_FAT_TEDDY;
+        self->slim_teddy = NULL;
+        self->fat_teddy = teddy;
+        self->min_pattern_size = SIZE_MAX;
+        self->max_pattern_size = 0;
+        self->icase = teddy->icase;
+        self->flags = 0;
+        for (uint16_t pattern_id = 0; pattern_id < teddy->num_patterns; ++pattern_id)
+        {
+                size_t size = strlen (teddy->patterns[pattern_id]);
+                self->min_pattern_size = size < self->min_pattern_size ? size : self->min_pattern_size;
+                self->max_pattern_size = size > self->max_pattern_size ? size : self->max_pattern_size;
+        }
+}
+
+void
+Searcher_set_flags (Searcher* self, uint32_t flags)
+{
+        self->flags = flags;
+}
+
+uint16_t
+Searcher_num_patterns (const Searcher* self)
+{
+        switch (self->kind)
+        {
+                case SEARCHER_SLIM_TEDDY:
+                        return self->slim_teddy->num_patterns;
+                case SEARCHER_FAT_TEDDY:
+                        return self->fat_teddy->num_patterns;
+                default:
+                        return 1;
+        }
+}
+
+size_t
+Searcher_pattern_size (const Searcher* self, uint16_t pattern_id)
+{
+        switch (self->kind)
+        {
+                case SEARCHER_SLIM_TEDDY:
+                        return self->slim_teddy->patterns[pattern_id].size;
+                case SEARCHER_FAT_TEDDY:
+                        return strlen (self->fat_teddy->patterns[pattern_id]);
+                default:
+                        return self->needle.size;
+        }
+}
+
+// _____ helper functions _____________________________________________________
+
+// word bytes [A-Za-z0-9_]
+static const uint8_t h_word_byte[256] = {
+        ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1, ['8'] = 1, ['9'] = 1,
+        ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1, ['I'] = 1, ['J'] = 1,
+        ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1, ['Q'] = 1, ['R'] = 1, ['S'] = 1, ['T'] = 1,
+        ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1, ['Y'] = 1, ['Z'] = 1, ['_'] = 1,
+        ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1, ['i'] = 1, ['j'] = 1,
+        ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1, ['q'] = 1, ['r'] = 1, ['s'] = 1, ['t'] = 1,
+        ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1, ['y'] = 1, ['z'] = 1,
+};
+
+static const char*
+h_pattern_begin (const Searcher* self, uint16_t pattern_id)
+{
+        switch (self->kind)
+        {
+                case SEARCHER_SLIM_TEDDY:
+                        return self->slim_teddy->patterns[pattern_id].begin;
+                case SEARCHER_FAT_TEDDY:
+                        return self->fat_teddy->patterns[pattern_id];
+                default:
+                        return self->needle.begin;
+        }
+}
+
+/*
+ * str[begin, end) satisfies the flags of self within the window str[0, str_size).
+ */
+static int
+h_accept (const Searcher* self, const char* str, size_t str_size, WindowContext context, size_t begin, size_t end)
+{
+        uint32_t flags = self->flags;
+        int before = begin > 0 ? (unsigned char) str[begin - 1] : context.before;
+        int after = end < str_size ? (unsigned char) str[end] : context.after;
+        // '\n' stands for the buffer edges (a non-word line break)
+        unsigned char before_byte = before == SEARCH_EDGE ? '\n' : (unsigned char) before;
+        unsigned char after_byte = after == SEARCH_EDGE ? '\n' : (unsigned char) after;
+        if ((flags & SEARCH_WORD) && (h_word_byte[before_byte] || h_word_byte[after_byte]))
+        {
+                return 0;
+        }
+        if (((flags & SEARCH_LINE_START) && before_byte != '\n') || ((flags & SEARCH_LINE_END) && after_byte != '\n'))
+        {
+                return 0;
+        }
+        return (!(flags & SEARCH_BUFFER_START) || before == SEARCH_EDGE) &&
+               (!(flags & SEARCH_BUFFER_END) || after == SEARCH_EDGE);
+}
+
+/*
+ * Lowest pattern id matching at str[pos] and satisfying the flags.
+ */
+static Match
+h_match_at (const Searcher* self, char* str, size_t str_size, WindowContext context, size_t pos)
+{
+        uint16_t num_patterns = Searcher_num_patterns (self);
+        for (uint16_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                size_t size = Searcher_pattern_size (self, pattern_id);
+                const char* pattern = h_pattern_begin (self, pattern_id);
+                if (size > str_size - pos || !h_accept (self, str, str_size, context, pos, pos + size))
+                {
+                        continue;
+                }
+                if (self->icase ? icase_memcmp (str + pos, pattern, size) == 0 : memcmp (str + pos, pattern, size) == 0)
+                {
+                        Match match;
+                        match.pattern_id = (int16_t) pattern_id;
+                        match.begin = str + pos;
+                        match.end = str + pos + size;
+                        return match;
+                }
+        }
+        return Match_empty ();
+}
+
+/*
+ * Scalar multi-pattern search for haystacks that are too short for the Teddy kernels (< 16 bytes).
+ */
+static Match
+h_searcher_find_short (const Searcher* self, char* str, size_t str_size)
+{
+        uint16_t num_patterns = Searcher_num_patterns (self);
+        for (size_t pos = 0; pos < str_size; ++pos)
+        {
+                for (uint16_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+                {
+                        size_t size = Searcher_pattern_size (self, pattern_id);
+                        const char* pattern = h_pattern_begin (self, pattern_id);
+                        if (size > str_size - pos)
+                        {
+                                continue;
+                        }
+                        if (self->icase ? icase_memcmp (str + pos, pattern, size) == 0 : memcmp (str + pos, pattern, size) == 0)
+                        {
+                                Match match;
+                                match.pattern_id = (int16_t) pattern_id;
+                                match.begin = str + pos;
+                                match.end = str + pos + size;
+                                return match;
+                        }
+                }
+        }
+        return Match_empty ();
+}
+
+/*
+ * Leftmost match of any pattern, ignoring the flags.
+ */
+static Match
+h_find_any (const Searcher* self, char* str, size_t str_size)
+{
+        if (str_size < self->min_pattern_size)
+        {
+                return Match_empty ();
+        }
+        switch (self->kind)
+        {
+                case SEARCHER_NEEDLE: {
+                        const char* pos = self->icase ? simd_stristr (str, str_size, self->needle.begin, self->needle.size)
+                                                      : simd_strstr (str, str_size, self->needle.begin, self->needle.size);
+                        if (pos == NULL)
+                        {
+                                return Match_empty ();
+                        }
+                        Match match;
+                        match.pattern_id = 0;
+                        match.begin = (char*) pos;
+                        match.end = (char*) pos + self->needle.size;
+                        return match;
+                }
+                case SEARCHER_SLIM_TEDDY:
+                        if (str_size < 16)
+                        {
+                                return h_searcher_find_short (self, str, str_size);
+                        }
+                        return SlimTeddy_find (self->slim_teddy, str, str_size);
+                case SEARCHER_FAT_TEDDY:
+                        if (str_size < 16)
+                        {
+                                return h_searcher_find_short (self, str, str_size);
+                        }
+                        return fat_teddy_find (self->fat_teddy, str, str_size);
+        }
+        return Match_empty ();
+}
+
+// ____________________________________________________________________________
+
+Match
+Searcher_find (const Searcher* self, char* str, size_t str_size)
+{
+        return Searcher_find_from (self, str, str_size, 0);
+}
+
+Match
+Searcher_find_from (const Searcher* self, char* str, size_t str_size, size_t from)
+{
+        return Searcher_find_window (self, str, str_size, from, SEARCH_EDGE, SEARCH_EDGE);
+}
+
+Match
+Searcher_find_window (const Searcher* self, char* str, size_t str_size, size_t from, int before, int after)
+{
+        if (from > str_size)
+        {
+                return Match_empty ();
+        }
+        if (self->flags == 0)
+        {
+                return h_find_any (self, str + from, str_size - from);
+        }
+        WindowContext context;
+        context.before = before;
+        context.after = after;
+        // buffer anchors: only one position per pattern is possible, no scan
+        if (self->flags & SEARCH_BUFFER_START)
+        {
+                return from == 0 && str_size > 0 ? h_match_at (self, str, str_size, context, 0) : Match_empty ();
+        }
+        if (self->flags & SEARCH_BUFFER_END)
+        {
+                Match best = Match_empty ();
+                uint16_t num_patterns = Searcher_num_patterns (self);
+                for (uint16_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+                {
+                        size_t size = Searcher_pattern_size (self, pattern_id);
+                        if (size > str_size - from || (best.pattern_id >= 0 && str + str_size - size >= best.begin))
+                        {
+                                continue;
+                        }
+                        Match match = h_match_at (self, str, str_size, context, str_size - size);
+                        if (match.pattern_id >= 0 && match.end == str + str_size)
+                        {
+                                best = match;
+                        }
+                }
+                return best;
+        }
+
+        size_t pos = from;
+        while (pos < str_size)
+        {
+                Match match = h_find_any (self, str + pos, str_size - pos);
+                if (match.pattern_id < 0)
+                {
+                        break;
+                }
+                size_t begin = (size_t) (match.begin - str);
+                if (h_accept (self, str, str_size, context, begin, (size_t) (match.end - str)))
+                {
+                        return match;
+                }
+                // another pattern may match at the same position
+                match = h_match_at (self, str, str_size, context, begin);
+                if (match.pattern_id >= 0)
+                {
+                        return match;
+                }
+                pos = begin + 1;
+        }
+        return Match_empty ();
+}
@@ -0,0 +1,284 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/pattern_syntax.h>
+#include <simdstr/shift_or.h>
+#include <simdstr/utils/utils.h>
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * Parse pattern into the sets of its positions (holding both cases of their letters if icase). Returns the number of
+ *  positions or -1.
+ */
+static int
+h_parse (const char* pattern, uint8_t sets[SHIFT_OR_MAX_PATTERN_SIZE][32], int icase)
+{
+        int size = 0;
+        const char* cur = pattern;
+        const char* end = pattern + strlen (pattern);
+        while (cur != end)
+        {
+                if (*cur == '{')
+                {
+                        char* count_end;
+                        unsigned long count = strtoul (cur + 1, &count_end, 10);
+                        if (size == 0 || count_end == cur + 1 || *count_end != '}' || count == 0 ||
+                            size - 1 + count > SHIFT_OR_MAX_PATTERN_SIZE)
+                        {
+                                return -1;
+                        }
+                        for (unsigned long repeat = 1; repeat < count; ++repeat)
+                        {
+                                memcpy (sets[size], sets[size - 1], 32);
+                                size++;
+                        }
+                        cur = count_end + 1;
+                        continue;
+                }
+                if (size == SHIFT_OR_MAX_PATTERN_SIZE)
+                {
+                        return -1;
+                }
+                uint8_t* set = sets[size];
+                memset (set, 0, 32);
+                uint8_t byte;
+                switch (*cur)
+                {
+                        case '.':
+                                cur++;
+                                memset (set, 0xff, 32);
+                                break;
+                        case '[':
+                                cur++;
+                                if (pattern_parse_class (&cur, end, set, icase) != 0)
+                                {
+                                        return -1;
+                                }
+                                break;
+                        case '\\':
+                                cur++;
+                                switch (pattern_parse_escape (&cur, end, set, &byte))
+                                {
+                                        case -1:
+                                                return -1;
+                                        case 0:
+                                                pattern_set_add (set, byte, byte);
+                                }
+                                break;
+                        default:
+                                byte = (uint8_t) *cur++;
+                                pattern_set_add (set, byte, byte);
+                }
+                if (icase)
+                {
+                        pattern_set_fold (set);
+                }
+                size++;
+        }
+        return size > 0 ? size : -1;
+}
+
+/*
+ * Bitmask of the 32 bytes at str that can start a pattern (bitmap lookup by nibbles).
+ */
+static inline uint32_t
+h_start_mask (const ShiftOr* self, const char* str)
+{
+        const __m256i nibble = _mm256_set1_epi8 (0x0f);
+        const __m256i bit_of_hi = _mm256_setr_epi8 (1, 2, 4, 8, 16, 32, 64, (char) 128, 1, 2, 4, 8, 16, 32, 64, (char) 128,
+                                                    1, 2, 4, 8, 16, 32, 64, (char) 128, 1, 2, 4, 8, 16, 32, 64, (char) 128);
+        const __m256i table_lo = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) self->start_lo));
+        const __m256i table_hi = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) self->start_hi));
+
+        __m256i chunk = _mm256_loadu_si256 ((const __m256i*) str);
+        __m256i lo = _mm256_and_si256 (chunk, nibble);
+        __m256i hi = _mm256_and_si256 (_mm256_srli_epi16 (chunk, 4), nibble);
+        __m256i row = _mm256_blendv_epi8 (_mm256_shuffle_epi8 (table_lo, lo), _mm256_shuffle_epi8 (table_hi, lo),
+                                          _mm256_cmpgt_epi8 (hi, _mm256_set1_epi8 (7)));
+        __m256i member = _mm256_and_si256 (row, _mm256_shuffle_epi8 (bit_of_hi, hi));
+        return ~(uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (member, _mm256_setzero_si256 ()));
+}
+
+/*
+ * Record the patterns whose match ends at str[pos] (cleared match bit in state) if they start left of best.
+ */
+static inline void
+h_record (const ShiftOr* self, const uint64_t* state, char* str, size_t pos, Match* best)
+{
+        for (uint8_t pattern_id = 0; pattern_id < self->num_patterns; ++pattern_id)
+        {
+                if ((state[pattern_id] & self->match_bits[pattern_id]) != 0)
+                {
+                        continue;
+                }
+                char* begin = str + pos + 1 - self->sizes[pattern_id];
+                if (best->pattern_id < 0 || begin < best->begin || (begin == best->begin && pattern_id < best->pattern_id))
+                {
+                        best->pattern_id = pattern_id;
+                        best->begin = begin;
+                        best->end = str + pos + 1;
+                }
+        }
+}
+
+/*
+ * A match ending at pos or later cannot start left of best.
+ */
+static inline int
+h_decided (const ShiftOr* self, const Match* best, char* str, size_t pos)
+{
+        return best->pattern_id >= 0 && pos + 1 > (size_t) (best->begin - str) + self->max_pattern_size;
+}
+
+// ____________________________________________________________________________
+
+int
+ShiftOr_init (ShiftOr* self, const char* const* patterns, uint8_t num_patterns, int icase)
+{
+        if (num_patterns == 0 || num_patterns > SHIFT_OR_MAX_PATTERNS)
+        {
+                return -1;
+        }
+        memset (self->masks, 0xff, sizeof (self->masks));
+        memset (self->match_bits, 0, sizeof (self->match_bits));
+        memset (self->ignore_bits, 0xff, sizeof (self->ignore_bits));
+        memset (self->start_lo, 0, sizeof (self->start_lo));
+        memset (self->start_hi, 0, sizeof (self->start_hi));
+        memset (self->sizes, 0, sizeof (self->sizes));
+        self->num_patterns = num_patterns;
+        self->max_pattern_size = 0;
+
+        uint8_t sets[SHIFT_OR_MAX_PATTERN_SIZE][32];
+        for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                int size = h_parse (patterns[pattern_id], sets, icase);
+                if (size < 0)
+                {
+                        return -1;
+                }
+                self->sizes[pattern_id] = (uint8_t) size;
+                self->max_pattern_size = size > self->max_pattern_size ? (uint8_t) size : self->max_pattern_size;
+                self->match_bits[pattern_id] = (uint64_t) 1 << (size - 1);
+                self->ignore_bits[pattern_id] = ~(self->match_bits[pattern_id] - 1);
+                for (int position = 0; position < size; ++position)
+                {
+                        for (unsigned byte = 0; byte < 256; ++byte)
+                        {
+                                if (!((sets[position][byte / 8] >> (byte % 8)) & 1))
+                                {
+                                        continue;
+                                }
+                                self->masks[byte][pattern_id] &= ~((uint64_t) 1 << position);
+                                if (position == 0)
+                                {
+                                        uint8_t* table = byte < 128 ? self->start_lo : self->start_hi;
+                                        table[byte & 0x0f] |= (uint8_t) (1u << ((byte >> 4) & 7));
+                                }
+                        }
+                }
+        }
+        return 0;
+}
+
+Match
+ShiftOr_find (const ShiftOr* self, char* str, size_t str_size)
+{
+        if (avx512 ())
+        {
+                return ShiftOr_find_avx_64 (self, str, str_size);
+        }
+        return ShiftOr_find_avx_32 (self, str, str_size);
+}
+
+Match
+ShiftOr_find_avx_32 (const ShiftOr* self, char* str, size_t str_size)
+{
+        const int two_registers = self->num_patterns > 4;
+        const __m256i ones = _mm256_set1_epi64x (-1);
+        const __m256i match0 = _mm256_loadu_si256 ((const __m256i*) self->match_bits);
+        const __m256i match1 = _mm256_loadu_si256 ((const __m256i*) (self->match_bits + 4));
+        const __m256i ignore0 = _mm256_loadu_si256 ((const __m256i*) self->ignore_bits);
+        const __m256i ignore1 = _mm256_loadu_si256 ((const __m256i*) (self->ignore_bits + 4));
+        __m256i state0 = ones;
+        __m256i state1 = ones;
+        Match best = Match_empty ();
+
+        size_t pos = 0;
+        while (pos < str_size && !h_decided (self, &best, str, pos))
+        {
+                // no partial match: skip the bytes that cannot start a pattern
+                if (pos + 32 <= str_size && _mm256_testc_si256 (_mm256_or_si256 (state0, ignore0), ones) &&
+                    (!two_registers || _mm256_testc_si256 (_mm256_or_si256 (state1, ignore1), ones)))
+                {
+                        uint32_t starts = h_start_mask (self, str + pos);
+                        if (starts == 0)
+                        {
+                                pos += 32;
+                                continue;
+                        }
+                        pos += ctz_32 (starts);
+                }
+                const uint64_t* masks = self->masks[(uint8_t) str[pos]];
+                state0 = _mm256_or_si256 (_mm256_slli_epi64 (state0, 1), _mm256_loadu_si256 ((const __m256i*) masks));
+                int hit = !_mm256_testc_si256 (state0, match0);
+                if (two_registers)
+                {
+                        state1 = _mm256_or_si256 (_mm256_slli_epi64 (state1, 1), _mm256_loadu_si256 ((const __m256i*) (masks + 4)));
+                        hit |= !_mm256_testc_si256 (state1, match1);
+                }
+                if (hit)
+                {
+                        uint64_t state[SHIFT_OR_MAX_PATTERNS];
+                        _mm256_storeu_si256 ((__m256i*) state, state0);
+                        _mm256_storeu_si256 ((__m256i*) (state + 4), state1);
+                        h_record (self, state, str, pos, &best);
+                }
+                pos++;
+        }
+        return best;
+}
+
+Match
+ShiftOr_find_avx_64 (const ShiftOr* self, char* str, size_t str_size)
+{
+        const __m512i ones = _mm512_set1_epi64 (-1);
+        const __m512i match = _mm512_loadu_si512 ((const void*) self->match_bits);
+        const __m512i ignore = _mm512_loadu_si512 ((const void*) self->ignore_bits);
+        __m512i state = ones;
+        Match best = Match_empty ();
+
+        size_t pos = 0;
+        while (pos < str_size && !h_decided (self, &best, str, pos))
+        {
+                if (pos + 32 <= str_size && _mm512_cmpneq_epi64_mask (_mm512_or_si512 (state, ignore), ones) == 0)
+                {
+                        uint32_t starts = h_start_mask (self, str + pos);
+                        if (starts == 0)
+                        {
+                                pos += 32;
+                                continue;
+                        }
+                        pos += ctz_32 (starts);
+                }
+                const uint64_t* masks = self->masks[(uint8_t) str[pos]];
+                state = _mm512_or_si512 (_mm512_slli_epi64 (state, 1), _mm512_loadu_si512 ((const void*) masks));
+                // lanes with a cleared match bit
+                if (_mm512_cmpneq_epi64_mask (_mm512_and_si512 (state, match), match) != 0)
+                {
+                        uint64_t lanes[SHIFT_OR_MAX_PATTERNS];
+                        _mm512_storeu_si512 ((void*) lanes, state);
+                        h_record (self, lanes, str, pos, &best);
+                }
+                pos++;
+        }
+        return best;
+}
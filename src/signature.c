@@ -0,0 +1,656 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/pattern_syntax.h>
+#include <simdstr/search.h>
+#include <simdstr/signature.h>
+#include <simdstr/utils/utils.h>
+
+typedef struct {
+        Signature* signature;
+        // a gap was read and closes the current segment with the next position
+        int gap_pending;
+        uint32_t gap_min;
+        uint32_t gap_max;
+} SignatureParser;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_parser_init (SignatureParser* parser, Signature* signature)
+{
+        parser->signature = signature;
+        parser->gap_pending = 0;
+        parser->gap_min = 0;
+        parser->gap_max = 0;
+        signature->size = 0;
+        signature->num_segments = 0;
+        signature->num_classes = 0;
+}
+
+static int
+h_add_position (SignatureParser* parser, uint8_t value, uint8_t mask, uint8_t class_id)
+{
+        Signature* self = parser->signature;
+        if (self->size >= SIGNATURE_MAX_SIZE)
+        {
+                return -1;
+        }
+        if (self->num_segments == 0 || parser->gap_pending)
+        {
+                if (self->num_segments >= SIGNATURE_MAX_SEGMENTS)
+                {
+                        return -1;
+                }
+                SignatureSegment* segment = &self->segments[self->num_segments++];
+                segment->begin = self->size;
+                segment->size = 0;
+                segment->gap_min = (uint16_t) parser->gap_min;
+                segment->gap_max = (uint16_t) parser->gap_max;
+                segment->has_classes = 0;
+                parser->gap_pending = 0;
+                parser->gap_min = 0;
+                parser->gap_max = 0;
+        }
+        SignatureSegment* segment = &self->segments[self->num_segments - 1];
+        self->value[self->size] = value & mask;
+        self->mask[self->size] = mask;
+        self->class_id[self->size] = class_id;
+        segment->has_classes |= class_id != 0;
+        segment->size++;
+        self->size++;
+        return 0;
+}
+
+static int
+h_add_byte (SignatureParser* parser, uint8_t byte)
+{
+        return h_add_position (parser, byte, 0xff, 0);
+}
+
+/*
+ * Byte class given as 256 bit set. Bits on which all members agree become the care mask; the class is checked exactly
+ *  if the value/mask pair also accepts non-members.
+ */
+static int
+h_add_class (SignatureParser* parser, const uint8_t* set)
+{
+        uint8_t all_ones = 0xff;
+        uint8_t all_zeros = 0xff;
+        unsigned num_members = 0;
+        for (unsigned byte = 0; byte < 256; ++byte)
+        {
+                if (set[byte / 8] & (1u << (byte % 8)))
+                {
+                        all_ones &= (uint8_t) byte;
+                        all_zeros &= (uint8_t) ~byte;
+                        num_members++;
+                }
+        }
+        if (num_members == 0)
+        {
+                return -1;
+        }
+        uint8_t mask = all_ones | all_zeros;
+        if (num_members == (256u >> popcount_32 (mask)))
+        {
+                return h_add_position (parser, all_ones, mask, 0);
+        }
+        Signature* self = parser->signature;
+        if (self->num_classes >= SIGNATURE_MAX_CLASSES)
+        {
+                return -1;
+        }
+        memcpy (self->classes[self->num_classes], set, 32);
+        self->num_classes++;
+        return h_add_position (parser, all_ones, mask, self->num_classes);
+}
+
+static int
+h_add_gap (SignatureParser* parser, unsigned long gap_min, unsigned long gap_max)
+{
+        // gaps at the edges are not part of a match
+        if (parser->signature->size == 0 || gap_min > gap_max || parser->gap_max + gap_max > SIGNATURE_MAX_SPAN)
+        {
+                return -1;
+        }
+        parser->gap_pending = 1;
+        parser->gap_min += (uint32_t) gap_min;
+        parser->gap_max += (uint32_t) gap_max;
+        return 0;
+}
+
+/*
+ * Two rarest (byte frequency model) exact bytes of segment, as positions relative to its begin (-1 if unused). Returns
+ *  the probability that both match at a random position.
+ */
+static double
+h_segment_anchors (const Signature* self, const SignatureSegment* segment, const double* freq, int16_t* anchor0,
+                   int16_t* anchor1)
+{
+        const uint8_t* value = self->value + segment->begin;
+        *anchor0 = -1;
+        *anchor1 = -1;
+        for (int16_t pos = 0; pos < (int16_t) segment->size; ++pos)
+        {
+                if (self->mask[segment->begin + pos] != 0xff || self->class_id[segment->begin + pos] != 0)
+                {
+                        continue;
+                }
+                double pos_freq = freq[value[pos]];
+                if (*anchor0 < 0 || pos_freq < freq[value[*anchor0]])
+                {
+                        *anchor1 = *anchor0;
+                        *anchor0 = pos;
+                }
+                else if (*anchor1 < 0 || pos_freq < freq[value[*anchor1]])
+                {
+                        *anchor1 = pos;
+                }
+        }
+        if (*anchor1 >= 0 && *anchor1 < *anchor0)
+        {
+                int16_t tmp = *anchor0;
+                *anchor0 = *anchor1;
+                *anchor1 = tmp;
+        }
+        return (*anchor0 >= 0 ? freq[value[*anchor0]] : 1.0) * (*anchor1 >= 0 ? freq[value[*anchor1]] : 1.0);
+}
+
+/*
+ * Anchor the segment whose anchors are least likely to match (the first one on ties: less to verify backwards).
+ */
+static int
+h_choose_anchors (Signature* self)
+{
+        double freq[256];
+        byte_freq_default (freq);
+        double best = 2.0;
+        self->anchor_segment = 0;
+        self->anchor0 = -1;
+        self->anchor1 = -1;
+        for (uint8_t segment_id = 0; segment_id < self->num_segments; ++segment_id)
+        {
+                int16_t anchor0;
+                int16_t anchor1;
+                double probability = h_segment_anchors (self, &self->segments[segment_id], freq, &anchor0, &anchor1);
+                if (anchor0 >= 0 && probability < best)
+                {
+                        best = probability;
+                        self->anchor_segment = segment_id;
+                        self->anchor0 = anchor0;
+                        self->anchor1 = anchor1;
+                }
+        }
+        return 0;
+}
+
+static int
+h_parser_finish (SignatureParser* parser)
+{
+        Signature* self = parser->signature;
+        if (self->size == 0 || parser->gap_pending)
+        {
+                return -1;
+        }
+        size_t min_offset = 0;
+        size_t max_offset = 0;
+        for (uint8_t segment_id = 0; segment_id < self->num_segments; ++segment_id)
+        {
+                SignatureSegment* segment = &self->segments[segment_id];
+                if (segment_id > 0)
+                {
+                        min_offset += self->segments[segment_id - 1].size + segment->gap_min;
+                        max_offset += self->segments[segment_id - 1].size + segment->gap_max;
+                }
+                if (max_offset + segment->size > SIGNATURE_MAX_SPAN)
+                {
+                        return -1;
+                }
+                segment->min_offset = (uint16_t) min_offset;
+                segment->max_offset = (uint16_t) max_offset;
+        }
+        const SignatureSegment* last = &self->segments[self->num_segments - 1];
+        self->min_match_size = last->min_offset + last->size;
+        self->max_match_size = last->max_offset + last->size;
+        return h_choose_anchors (self);
+}
+
+static int
+h_parse_number (const char** cur, unsigned long* number)
+{
+        char* end;
+        if (**cur < '0' || **cur > '9')
+        {
+                return -1;
+        }
+        *number = strtoul (*cur, &end, 10);
+        *cur = end;
+        return *number <= SIGNATURE_MAX_SPAN ? 0 : -1;
+}
+
+/*
+ * (byte & mask) == value for the positions of segment at str, then the exact check of its classes.
+ */
+static inline int
+h_segment_match (const Signature* self, const SignatureSegment* segment, const char* str)
+{
+        const uint8_t* value = self->value + segment->begin;
+        const uint8_t* mask = self->mask + segment->begin;
+        size_t pos = 0;
+        for (; pos + 32 <= segment->size; pos += 32)
+        {
+                __m256i bytes = _mm256_loadu_si256 ((const __m256i*) (str + pos));
+                __m256i masked = _mm256_and_si256 (bytes, _mm256_loadu_si256 ((const __m256i*) (mask + pos)));
+                __m256i equal = _mm256_cmpeq_epi8 (masked, _mm256_loadu_si256 ((const __m256i*) (value + pos)));
+                if ((uint32_t) _mm256_movemask_epi8 (equal) != 0xffffffffu)
+                {
+                        return 0;
+                }
+        }
+        for (; pos + 16 <= segment->size; pos += 16)
+        {
+                __m128i bytes = _mm_loadu_si128 ((const __m128i*) (str + pos));
+                __m128i masked = _mm_and_si128 (bytes, _mm_loadu_si128 ((const __m128i*) (mask + pos)));
+                __m128i equal = _mm_cmpeq_epi8 (masked, _mm_loadu_si128 ((const __m128i*) (value + pos)));
+                if (_mm_movemask_epi8 (equal) != 0xffff)
+                {
+                        return 0;
+                }
+        }
+        for (; pos < segment->size; ++pos)
+        {
+                if (((uint8_t) str[pos] & mask[pos]) != value[pos])
+                {
+                        return 0;
+                }
+        }
+        if (segment->has_classes)
+        {
+                const uint8_t* class_id = self->class_id + segment->begin;
+                for (pos = 0; pos < segment->size; ++pos)
+                {
+                        uint8_t byte = (uint8_t) str[pos];
+                        if (class_id[pos] != 0 && !(self->classes[class_id[pos] - 1][byte / 8] & (1u << (byte % 8))))
+                        {
+                                return 0;
+                        }
+                }
+        }
+        return 1;
+}
+
+/*
+ * Match of the segments [segment_id, num_segments) with segment_id placed at str[pos]. The reachable offsets (relative
+ *  to pos) of every following segment are kept in a byte map, so all placements of the gaps are covered. *end receives
+ *  the end of the placement ending first.
+ */
+static int
+h_verify_forward (const Signature* self, uint8_t segment_id, const char* str, size_t str_size, size_t pos, size_t* end)
+{
+        const SignatureSegment* placed = &self->segments[segment_id];
+        if (pos + placed->size > str_size || !h_segment_match (self, placed, str + pos))
+        {
+                return 0;
+        }
+        if (segment_id + 1 == self->num_segments)
+        {
+                *end = pos + placed->size;
+                return 1;
+        }
+
+        uint8_t reach[2][SIGNATURE_MAX_SPAN];
+        uint8_t* cur = reach[0];
+        uint8_t* next = reach[1];
+        const size_t available = str_size - pos;
+        size_t lo = 0;
+        size_t hi = 0;
+        cur[0] = 1;
+        for (; segment_id < self->num_segments; ++segment_id)
+        {
+                const SignatureSegment* segment = &self->segments[segment_id];
+                const SignatureSegment* following = segment_id + 1 < self->num_segments ? segment + 1 : NULL;
+                if (following != NULL)
+                {
+                        memset (next + lo + segment->size + following->gap_min, 0,
+                                hi - lo + following->gap_max - following->gap_min + 1u);
+                }
+                size_t next_lo = SIZE_MAX;
+                size_t next_hi = 0;
+                for (size_t offset = lo; offset <= hi; ++offset)
+                {
+                        if (!cur[offset])
+                        {
+                                continue;
+                        }
+                        if (offset + segment->size > available)
+                        {
+                                break;
+                        }
+                        if (segment != placed && !h_segment_match (self, segment, str + pos + offset))
+                        {
+                                continue;
+                        }
+                        if (following == NULL)
+                        {
+                                *end = pos + offset + segment->size;
+                                return 1;
+                        }
+                        // the placements are visited in increasing order: only mark the new part of the range
+                        size_t from = offset + segment->size + following->gap_min;
+                        size_t to = offset + segment->size + following->gap_max;
+                        from = next_lo != SIZE_MAX && next_hi + 1 > from ? next_hi + 1 : from;
+                        memset (next + from, 1, to + 1 - from);
+                        next_lo = next_lo == SIZE_MAX ? from : next_lo;
+                        next_hi = to;
+                }
+                if (next_lo == SIZE_MAX)
+                {
+                        return 0;
+                }
+                uint8_t* tmp = cur;
+                cur = next;
+                next = tmp;
+                lo = next_lo;
+                hi = next_hi;
+        }
+        return 0;
+}
+
+/*
+ * Mirror image of h_verify_forward for the segments [0, segment_id) in front of segment_id placed at str[pos] (which
+ *  matched already): the byte map holds the distances back from pos. *start receives the leftmost match start.
+ */
+static int
+h_verify_backward (const Signature* self, uint8_t segment_id, const char* str, size_t pos, size_t* start)
+{
+        uint8_t reach[2][SIGNATURE_MAX_SPAN];
+        uint8_t* cur = reach[0];
+        uint8_t* next = reach[1];
+        size_t lo = 0;
+        size_t hi = 0;
+        cur[0] = 1;
+        for (; segment_id > 0; --segment_id)
+        {
+                const SignatureSegment* following = &self->segments[segment_id];
+                const SignatureSegment* segment = following - 1;
+                // distances back of the placements of segment, which must not start before str
+                size_t next_lo = lo + segment->size + following->gap_min;
+                size_t next_hi = hi + segment->size + following->gap_max;
+                next_hi = next_hi < pos ? next_hi : pos;
+                if (next_lo > next_hi)
+                {
+                        return 0;
+                }
+                memset (next + next_lo, 0, next_hi - next_lo + 1);
+                size_t marked = next_lo;
+                for (size_t distance = lo; distance <= hi; ++distance)
+                {
+                        if (!cur[distance])
+                        {
+                                continue;
+                        }
+                        size_t from = distance + segment->size + following->gap_min;
+                        size_t to = distance + segment->size + following->gap_max;
+                        from = from > marked ? from : marked;
+                        to = to < next_hi ? to : next_hi;
+                        if (from <= to)
+                        {
+                                memset (next + from, 1, to + 1 - from);
+                                marked = to + 1;
+                        }
+                }
+                lo = SIZE_MAX;
+                for (size_t distance = next_lo; distance <= next_hi; ++distance)
+                {
+                        if (next[distance] && h_segment_match (self, segment, str + pos - distance))
+                        {
+                                lo = lo == SIZE_MAX ? distance : lo;
+                                hi = distance;
+                        }
+                        else
+                        {
+                                next[distance] = 0;
+                        }
+                }
+                if (lo == SIZE_MAX)
+                {
+                        return 0;
+                }
+                uint8_t* tmp = cur;
+                cur = next;
+                next = tmp;
+        }
+        *start = pos - hi;
+        return 1;
+}
+
+/*
+ * Anchor segment placed at str[pos]: lower *best to the leftmost start of a match with this placement. Placements at
+ *  *best + max_offset or later cannot start further left, *limit is lowered to exclude them.
+ */
+static void
+h_verify_anchor (const Signature* self, const char* str, size_t str_size, size_t pos, size_t* best, size_t* limit)
+{
+        size_t start;
+        size_t end;
+        if (h_verify_forward (self, self->anchor_segment, str, str_size, pos, &end) &&
+            h_verify_backward (self, self->anchor_segment, str, pos, &start) && start < *best)
+        {
+                *best = start;
+                size_t max_offset = self->segments[self->anchor_segment].max_offset;
+                *limit = start + max_offset < *limit ? start + max_offset : *limit;
+        }
+}
+
+static Match
+h_match (const char* str, size_t start, size_t end)
+{
+        Match match;
+        match.pattern_id = 0;
+        match.begin = (char*) str + start;
+        match.end = (char*) str + end;
+        return match;
+}
+
+// ____________________________________________________________________________
+
+int
+Signature_parse_hex (Signature* self, const char* hex)
+{
+        SignatureParser parser;
+        h_parser_init (&parser, self);
+        const char* cur = hex;
+        while (*cur != '\0')
+        {
+                int ok;
+                if (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')
+                {
+                        cur++;
+                        continue;
+                }
+                if (*cur == '[')
+                {
+                        unsigned long gap_min;
+                        unsigned long gap_max;
+                        cur++;
+                        ok = h_parse_number (&cur, &gap_min) == 0;
+                        gap_max = gap_min;
+                        if (ok && *cur == '-')
+                        {
+                                cur++;
+                                ok = h_parse_number (&cur, &gap_max) == 0;
+                        }
+                        ok = ok && *cur++ == ']' && h_add_gap (&parser, gap_min, gap_max) == 0;
+                }
+                else
+                {
+                        int hi = cur[0] == '?' ? 0 : pattern_hex_digit (cur[0]);
+                        int lo = hi < 0 || cur[1] == '\0' ? -1 : cur[1] == '?' ? 0 : pattern_hex_digit (cur[1]);
+                        uint8_t mask = (uint8_t) ((cur[0] == '?' ? 0 : 0xf0) | (cur[1] == '?' ? 0 : 0x0f));
+                        ok = lo >= 0 && h_add_position (&parser, (uint8_t) (hi << 4 | lo), mask, 0) == 0;
+                        cur += 2;
+                }
+                if (!ok)
+                {
+                        return -1;
+                }
+        }
+        return h_parser_finish (&parser);
+}
+
+int
+Signature_parse (Signature* self, const char* pattern)
+{
+        SignatureParser parser;
+        h_parser_init (&parser, self);
+        const char* cur = pattern;
+        const char* end = pattern + strlen (pattern);
+        while (cur != end)
+        {
+                int ok;
+                uint8_t byte;
+                uint8_t set[32] = {0};
+                unsigned long gap_min;
+                unsigned long gap_max;
+                switch (*cur)
+                {
+                        case '?':
+                                cur++;
+                                ok = h_add_position (&parser, 0, 0, 0) == 0;
+                                break;
+                        case '*':
+                                cur++;
+                                ok = h_add_gap (&parser, 0, SIGNATURE_STAR_GAP) == 0;
+                                break;
+                        case '{':
+                                cur++;
+                                ok = h_parse_number (&cur, &gap_min) == 0;
+                                gap_max = gap_min;
+                                if (ok && *cur == ',')
+                                {
+                                        cur++;
+                                        ok = h_parse_number (&cur, &gap_max) == 0;
+                                }
+                                ok = ok && *cur++ == '}' && h_add_gap (&parser, gap_min, gap_max) == 0;
+                                break;
+                        case '[':
+                                cur++;
+                                ok = pattern_parse_class (&cur, end, set, 0) == 0 && h_add_class (&parser, set) == 0;
+                                break;
+                        case '\\':
+                                cur++;
+                                switch (pattern_parse_escape (&cur, end, set, &byte))
+                                {
+                                        case 0:
+                                                ok = h_add_byte (&parser, byte) == 0;
+                                                break;
+                                        case 1:
+                                                ok = h_add_class (&parser, set) == 0;
+                                                break;
+                                        default:
+                                                ok = 0;
+                                }
+                                break;
+                        default:
+                                ok = h_add_byte (&parser, (uint8_t) *cur++) == 0;
+                }
+                if (!ok)
+                {
+                        return -1;
+                }
+        }
+        return h_parser_finish (&parser);
+}
+
+Match
+Signature_find (const Signature* self, char* str, size_t str_size)
+{
+        if (str_size < self->min_match_size)
+        {
+                return Match_empty ();
+        }
+        // last possible start
+        const size_t last = str_size - self->min_match_size;
+        size_t end;
+
+        if (self->anchor0 < 0)
+        {
+                for (size_t start = 0; start <= last; ++start)
+                {
+                        if (h_verify_forward (self, 0, str, str_size, start, &end))
+                        {
+                                return h_match (str, start, end);
+                        }
+                }
+                return Match_empty ();
+        }
+
+        // placements of the anchor segment, in [first_pos, limit)
+        const SignatureSegment* anchored = &self->segments[self->anchor_segment];
+        const size_t first_pos = anchored->min_offset;
+        const size_t last_pos = last + anchored->min_offset;
+        const size_t anchor0 = (size_t) self->anchor0;
+        const uint8_t value0 = self->value[anchored->begin + anchor0];
+        size_t best = SIZE_MAX;
+        size_t limit = last_pos + 1;
+        if (self->anchor1 < 0)
+        {
+                size_t pos = first_pos;
+                while (pos < limit)
+                {
+                        const char* hit = simd_strchr (str + pos + anchor0, limit - pos, (char) value0);
+                        if (hit == NULL)
+                        {
+                                break;
+                        }
+                        pos = (size_t) (hit - str) - anchor0;
+                        h_verify_anchor (self, str, str_size, pos, &best, &limit);
+                        pos++;
+                }
+        }
+        else
+        {
+                // two anchors: 32 positions per block, loads stay within str as anchor1 < anchored->size
+                const size_t anchor1 = (size_t) self->anchor1;
+                const uint8_t value1 = self->value[anchored->begin + anchor1];
+                const __m256i first = _mm256_set1_epi8 ((char) value0);
+                const __m256i second = _mm256_set1_epi8 ((char) value1);
+                size_t pos = first_pos;
+                for (; pos + 32 <= last_pos + 1 && pos < limit; pos += 32)
+                {
+                        __m256i bytes0 = _mm256_loadu_si256 ((const __m256i*) (str + pos + anchor0));
+                        __m256i bytes1 = _mm256_loadu_si256 ((const __m256i*) (str + pos + anchor1));
+                        __m256i eq0 = _mm256_cmpeq_epi8 (first, bytes0);
+                        __m256i eq1 = _mm256_cmpeq_epi8 (second, bytes1);
+                        uint32_t mask = (uint32_t) _mm256_movemask_epi8 (_mm256_and_si256 (eq0, eq1));
+                        while (mask != 0 && pos + ctz_32 (mask) < limit)
+                        {
+                                h_verify_anchor (self, str, str_size, pos + ctz_32 (mask), &best, &limit);
+                                mask &= mask - 1;
+                        }
+                }
+                for (; pos < limit; ++pos)
+                {
+                        if ((uint8_t) str[pos + anchor0] == value0 && (uint8_t) str[pos + anchor1] == value1)
+                        {
+                                h_verify_anchor (self, str, str_size, pos, &best, &limit);
+                        }
+                }
+        }
+        if (best == SIZE_MAX)
+        {
+                return Match_empty ();
+        }
+        // the leftmost start may end first with another placement of the anchor segment
+        h_verify_forward (self, 0, str, str_size, best, &end);
+        return h_match (str, best, end);
+}
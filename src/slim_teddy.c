@@ -6,12 +6,111 @@
 */
 
 #include <assert.h>
+#include <ctype.h>
 #include <emmintrin.h>
 #include <string.h>
 
+#include <simdstr/search.h>
 #include <simdstr/slim_teddy.h>
+#include <simdstr/teddy_buckets.h>
 #include <simdstr/utils/utils.h>
 
+// _____ helper functions _____________________________________________________
+
+/*
+ * Candidate bits of the 16 positions at cur (bit 8 * i + bucket_id for the last fingerprint byte at cur + i).
+ */
+static inline __m128i
+h_candidates (const SlimTeddy* self, const char* cur, __m128i* prev0, __m128i* prev1, __m128i* prev2)
+{
+        __m128i chunk = _mm_loadu_si128 ((const __m128i*) cur);
+        SlimPatternMask* masks = (SlimPatternMask*) self->pattern_mask;
+        __m128i result0;
+        __m128i result1;
+        __m128i result2;
+        __m128i result3;
+        __m128i result;
+        switch (self->num_masks)
+        {
+                case 1:
+                        mm_lookup_1 (&chunk, masks, &result0);
+                        return result0;
+                case 2:
+                        mm_lookup_2 (&chunk, masks, &result0, &result1);
+                        result = _mm_and_si128 (_mm_alignr_epi8 (result0, *prev0, 15), result1);
+                        *prev0 = result0;
+                        return result;
+                case 3:
+                        mm_lookup_3 (&chunk, masks, &result0, &result1, &result2);
+                        result = _mm_and_si128 (_mm_alignr_epi8 (result0, *prev0, 14), _mm_alignr_epi8 (result1, *prev1, 15));
+                        result = _mm_and_si128 (result, result2);
+                        *prev0 = result0;
+                        *prev1 = result1;
+                        return result;
+                default:
+                        mm_lookup_4 (&chunk, masks, &result0, &result1, &result2, &result3);
+                        result = _mm_and_si128 (_mm_alignr_epi8 (result0, *prev0, 13), _mm_alignr_epi8 (result1, *prev1, 14));
+                        result = _mm_and_si128 (result, _mm_alignr_epi8 (result2, *prev2, 15));
+                        result = _mm_and_si128 (result, result3);
+                        *prev0 = result0;
+                        *prev1 = result1;
+                        *prev2 = result2;
+                        return result;
+        }
+}
+
+/*
+ * Verify the candidates of the 8 positions starting at str[lane_pos] and count the matching patterns. Positions below
+ *  min_pos were already verified.
+ */
+static inline void
+h_count_lane (const SlimTeddy* self, uint64_t lane, const char* str, size_t str_size, size_t lane_pos, size_t min_pos,
+              size_t num_starts, uint64_t* counts)
+{
+        const size_t back = self->offset + self->num_masks - 1;
+        while (lane != 0)
+        {
+                uint64_t bit = ctz_64 (lane);
+                lane &= lane - 1;
+
+                size_t pos_idx = lane_pos + bit / 8;
+                if (pos_idx < min_pos || pos_idx < back || pos_idx - back >= num_starts)
+                {
+                        continue;
+                }
+                size_t start = pos_idx - back;
+                const SlimBucket* bucket = &self->buckets[bit % 8];
+                for (uint8_t pidx = 0; pidx < bucket->size; ++pidx)
+                {
+                        uint8_t pattern_id = bucket->pattern_ids[pidx];
+                        const Pattern* pattern = &self->patterns[pattern_id];
+                        if (str_size - start < pattern->size)
+                        {
+                                continue;
+                        }
+                        int equal = self->icase ? icase_memcmp (str + start, pattern->begin, pattern->size) == 0
+                                                : memcmp (str + start, pattern->begin, pattern->size) == 0;
+                        counts[pattern_id] += equal;
+                }
+        }
+}
+
+static inline void
+h_count_chunk (const SlimTeddy* self, __m128i candidates, const char* str, size_t str_size, size_t chunk_pos,
+               size_t min_pos, size_t num_starts, uint64_t* counts)
+{
+        if (_mm_testz_si128 (candidates, candidates))
+        {
+                return;
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128 ((__m128i*) lanes, candidates);
+        h_count_lane (self, lanes[0], str, str_size, chunk_pos, min_pos, num_starts, counts);
+        h_count_lane (self, lanes[1], str, str_size, chunk_pos + 8, min_pos, num_starts, counts);
+}
+
+// ____________________________________________________________________________
+
 void
 SlimPatternMask_init (SlimPatternMask* self, SlimBucket* buckets, Pattern* patterns)
 {
@@ -23,8 +122,17 @@ SlimPatternMask_init (SlimPatternMask* self, SlimBucket* buckets, Pattern* patte
                 SlimBucket* bucket = &buckets[bucket_id];
                 for (uint8_t pidx = 0; pidx < bucket->size; ++pidx)
                 {
-                        Pattern* pattern = &patterns[pidx];
-                        SlimPatternMask_add (self, pattern->begin[self->id], bucket_id);
+                        Pattern* pattern = &patterns[bucket->pattern_ids[pidx]];
+                        char byte = pattern->begin[self->offset + self->id];
+                        if (self->icase)
+                        {
+                                SlimPatternMask_add (self, (char) tolower ((unsigned char) byte), bucket_id);
+                                SlimPatternMask_add (self, (char) toupper ((unsigned char) byte), bucket_id);
+                        }
+                        else
+                        {
+                                SlimPatternMask_add (self, byte, bucket_id);
+                        }
                 }
         }
 }
@@ -50,38 +158,52 @@ SlimPatternMask_build (SlimPatternMask* self)
 void
 SlimTeddy_init (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks)
 {
+        SlimTeddy_init_freq (self, patterns, num_patterns, num_masks, NULL);
+}
+
+void
+SlimTeddy_init_freq (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, const double* byte_freq)
+{
+        assert (num_patterns <= 64);
+
         self->patterns = patterns;
         self->num_patterns = num_patterns;
         self->num_masks = num_masks;
+        self->icase = 0;
 
         for (uint8_t bidx = 0; bidx < 8; ++bidx)
         {
                 self->buckets[bidx].size = 0;
         }
 
-        SlimBucket* current_bucket = &self->buckets[0];
-        uint8_t current_bucket_id = 0;
+        uint8_t bucket_ids[64];
+        self->false_positive_rate = teddy_choose_offset (self->patterns, self->num_patterns, self->num_masks, 8, 8, byte_freq, &self->offset, bucket_ids);
 
         for (uint8_t pattern_id = 0; pattern_id < self->num_patterns; ++pattern_id)
         {
-                current_bucket->pattern_ids[current_bucket->size] = pattern_id;
-                current_bucket->size++;
-
-                if (current_bucket->size == 8)
-                {
-                        current_bucket_id++;
-                        if (current_bucket_id > 8)
-                        {
-                                // panic
-                                assert (0);
-                        }
-                        current_bucket = &self->buckets[current_bucket_id];
-                }
+                SlimBucket* bucket = &self->buckets[bucket_ids[pattern_id]];
+                bucket->pattern_ids[bucket->size] = pattern_id;
+                bucket->size++;
         }
 
         for (uint8_t mask_idx = 0; mask_idx < self->num_masks; ++mask_idx)
         {
                 self->pattern_mask[mask_idx].id = mask_idx;
+                self->pattern_mask[mask_idx].offset = self->offset;
+                self->pattern_mask[mask_idx].icase = self->icase;
+                SlimPatternMask_init (&self->pattern_mask[mask_idx], self->buckets, self->patterns);
+                SlimPatternMask_build (&self->pattern_mask[mask_idx]);
+        }
+}
+
+void
+SlimTeddy_init_icase (SlimTeddy* self, Pattern* patterns, uint8_t num_patterns, uint8_t num_masks)
+{
+        SlimTeddy_init (self, patterns, num_patterns, num_masks);
+        self->icase = 1;
+        for (uint8_t mask_idx = 0; mask_idx < self->num_masks; ++mask_idx)
+        {
+                self->pattern_mask[mask_idx].icase = 1;
                 SlimPatternMask_init (&self->pattern_mask[mask_idx], self->buckets, self->patterns);
                 SlimPatternMask_build (&self->pattern_mask[mask_idx]);
         }
@@ -107,6 +229,123 @@ SlimTeddy_find (SlimTeddy* self, char* str, size_t str_size)
         return Match_empty();
 }
 
+void
+SlimTeddy_retire (SlimTeddy* self, uint8_t pattern_id)
+{
+        for (uint8_t bidx = 0; bidx < 8; ++bidx)
+        {
+                SlimBucket* bucket = &self->buckets[bidx];
+                for (uint8_t pidx = 0; pidx < bucket->size; ++pidx)
+                {
+                        if (bucket->pattern_ids[pidx] == pattern_id)
+                        {
+                                // keep the bucket order, it decides between patterns matching at the same position
+                                memmove (&bucket->pattern_ids[pidx], &bucket->pattern_ids[pidx + 1], bucket->size - pidx - 1);
+                                bucket->size--;
+                                for (uint8_t mask_idx = 0; mask_idx < self->num_masks; ++mask_idx)
+                                {
+                                        SlimPatternMask_init (&self->pattern_mask[mask_idx], self->buckets, self->patterns);
+                                        SlimPatternMask_build (&self->pattern_mask[mask_idx]);
+                                }
+                                return;
+                        }
+                }
+        }
+}
+
+uint8_t
+SlimTeddy_find_each (const SlimTeddy* self, char* str, size_t str_size, Match* firsts)
+{
+        SlimTeddy active = *self;
+        for (uint8_t pattern_id = 0; pattern_id < self->num_patterns; ++pattern_id)
+        {
+                firsts[pattern_id] = Match_empty ();
+        }
+
+        uint8_t num_found = 0;
+        size_t pos = 0;
+        while (num_found < self->num_patterns && str_size - pos >= 16)
+        {
+                Match match = SlimTeddy_find (&active, str + pos, str_size - pos);
+                if (match.pattern_id < 0)
+                {
+                        return num_found;
+                }
+                firsts[match.pattern_id] = match;
+                num_found++;
+                SlimTeddy_retire (&active, (uint8_t) match.pattern_id);
+                // other patterns may start at the same position
+                pos = (size_t) (match.begin - str);
+        }
+        // tail too short for a Teddy scan
+        for (uint8_t pattern_id = 0; pattern_id < self->num_patterns && num_found < self->num_patterns; ++pattern_id)
+        {
+                if (firsts[pattern_id].pattern_id >= 0)
+                {
+                        continue;
+                }
+                Pattern* pattern = &self->patterns[pattern_id];
+                const char* begin = self->icase ? simd_stristr (str + pos, str_size - pos, pattern->begin, pattern->size)
+                                                : simd_strstr (str + pos, str_size - pos, pattern->begin, pattern->size);
+                if (begin != NULL)
+                {
+                        firsts[pattern_id].pattern_id = pattern_id;
+                        firsts[pattern_id].begin = (char*) begin;
+                        firsts[pattern_id].end = (char*) begin + pattern->size;
+                        num_found++;
+                }
+        }
+        return num_found;
+}
+
+void
+SlimTeddy_count (const SlimTeddy* self, char* str, size_t str_size, size_t num_starts, uint64_t* counts)
+{
+        num_starts = num_starts < str_size ? num_starts : str_size;
+        if (str_size < 16)
+        {
+                for (size_t start = 0; start < num_starts; ++start)
+                {
+                        for (uint8_t pattern_id = 0; pattern_id < self->num_patterns; ++pattern_id)
+                        {
+                                const Pattern* pattern = &self->patterns[pattern_id];
+                                if (str_size - start < pattern->size)
+                                {
+                                        continue;
+                                }
+                                int equal = self->icase ? icase_memcmp (str + start, pattern->begin, pattern->size) == 0
+                                                        : memcmp (str + start, pattern->begin, pattern->size) == 0;
+                                counts[pattern_id] += equal;
+                        }
+                }
+                return;
+        }
+
+        // candidates are reported at the last fingerprint byte, back bytes behind the pattern start
+        const size_t back = self->offset + self->num_masks - 1;
+        size_t scan_end = num_starts + back < str_size ? num_starts + back : str_size;
+
+        __m128i prev0 = _mm_set1_epi8 ((char) (uint8_t) 0xff);
+        __m128i prev1 = prev0;
+        __m128i prev2 = prev0;
+        size_t pos = 0;
+        for (; pos + 16 <= scan_end; pos += 16)
+        {
+                __m128i candidates = h_candidates (self, str + pos, &prev0, &prev1, &prev2);
+                h_count_chunk (self, candidates, str, str_size, pos, 0, num_starts, counts);
+        }
+        if (pos < scan_end)
+        {
+                // last block overlaps the scanned part: skip the positions verified already
+                size_t tail = scan_end >= 16 ? scan_end - 16 : 0;
+                prev0 = _mm_set1_epi8 ((char) (uint8_t) 0xff);
+                prev1 = prev0;
+                prev2 = prev0;
+                __m128i candidates = h_candidates (self, str + tail, &prev0, &prev1, &prev2);
+                h_count_chunk (self, candidates, str, str_size, tail, pos, num_starts, counts);
+        }
+}
+
 Match SlimTeddy_find_1(SlimTeddy* self, char* str, size_t str_size)
 {
         assert (str_size >= 16);
@@ -116,7 +355,7 @@ Match SlimTeddy_find_1(SlimTeddy* self, char* str, size_t str_size)
 
         while (cur_size >= 16)
         {
-                Match match = SlimTeddy_find_one_1 (self, cur, cur_size);
+                Match match = SlimTeddy_find_one_1 (self, str, cur, cur_size);
                 if (match.pattern_id >= 0)
                 {
                         return match;
@@ -127,7 +366,8 @@ Match SlimTeddy_find_1(SlimTeddy* self, char* str, size_t str_size)
         if (cur_size > 0)
         {
                 cur = str + str_size - 16;
-                return SlimTeddy_find_one_1 (self, cur, cur_size);
+                cur_size = 16;
+                return SlimTeddy_find_one_1 (self, str, cur, cur_size);
         }
         return Match_empty();
 }
@@ -143,7 +383,7 @@ Match SlimTeddy_find_2(SlimTeddy* self, char* str, size_t str_size)
 
         while (cur_size >= 16)
         {
-                Match match = SlimTeddy_find_one_2 (self, cur, cur_size, &prev0);
+                Match match = SlimTeddy_find_one_2 (self, str, cur, cur_size, &prev0);
                 if (match.pattern_id >= 0)
                 {
                         return match;
@@ -155,7 +395,8 @@ Match SlimTeddy_find_2(SlimTeddy* self, char* str, size_t str_size)
         {
                 prev0 = _mm_set1_epi8 ((char)(uint8_t)0xff);
                 cur = str + str_size - 16;
-                return SlimTeddy_find_one_2 (self, cur, cur_size, &prev0);
+                cur_size = 16;
+                return SlimTeddy_find_one_2 (self, str, cur, cur_size, &prev0);
         }
         return Match_empty();
 }
@@ -172,7 +413,7 @@ Match SlimTeddy_find_3(SlimTeddy* self, char* str, size_t str_size)
 
         while (cur_size >= 16)
         {
-                Match match = SlimTeddy_find_one_3 (self, cur, cur_size, &prev0, &prev1);
+                Match match = SlimTeddy_find_one_3 (self, str, cur, cur_size, &prev0, &prev1);
                 if (match.pattern_id >= 0)
                 {
                         return match;
@@ -185,7 +426,8 @@ Match SlimTeddy_find_3(SlimTeddy* self, char* str, size_t str_size)
                 prev0 = _mm_set1_epi8 ((char)(uint8_t)0xff);
                 prev1 = _mm_set1_epi8 ((char)(uint8_t)0xff);
                 cur = str + str_size - 16;
-                return SlimTeddy_find_one_3 (self, cur, cur_size, &prev0, &prev1);
+                cur_size = 16;
+                return SlimTeddy_find_one_3 (self, str, cur, cur_size, &prev0, &prev1);
         }
         return Match_empty();
 }
@@ -203,7 +445,7 @@ Match SlimTeddy_find_4(SlimTeddy* self, char* str, size_t str_size)
 
         while (cur_size >= 16)
         {
-                Match match = SlimTeddy_find_one_4 (self, cur, cur_size, &prev0, &prev1, &prev2);
+                Match match = SlimTeddy_find_one_4 (self, str, cur, cur_size, &prev0, &prev1, &prev2);
                 if (match.pattern_id >= 0)
                 {
                         return match;
@@ -217,13 +459,14 @@ Match SlimTeddy_find_4(SlimTeddy* self, char* str, size_t str_size)
                 prev1 = _mm_set1_epi8 ((char)(uint8_t)0xff);
                 prev2 = _mm_set1_epi8 ((char)(uint8_t)0xff);
                 cur = str + str_size - 16;
-                return SlimTeddy_find_one_4 (self, cur, cur_size, &prev0, &prev1, &prev2);
+                cur_size = 16;
+                return SlimTeddy_find_one_4 (self, str, cur, cur_size, &prev0, &prev1, &prev2);
         }
         return Match_empty();
 }
 
 Match
-SlimTeddy_find_one_1 (SlimTeddy* self, char* cur, size_t cur_size)
+SlimTeddy_find_one_1 (SlimTeddy* self, char* str, char* cur, size_t cur_size)
 {
         __m128i chunk = _mm_loadu_si128 ((__m128i*) cur);
         __m128i result;
@@ -232,12 +475,12 @@ SlimTeddy_find_one_1 (SlimTeddy* self, char* cur, size_t cur_size)
 
         if (!_mm_testz_si128 (result, result))
         {
-                return SlimTeddy_verify (self, &result, cur, cur_size);
+                return SlimTeddy_verify (self, &result, str, cur, cur_size);
         }
         return Match_empty ();
 }
 
-Match SlimTeddy_find_one_2 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0)
+Match SlimTeddy_find_one_2 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0)
 {
         __m128i chunk = _mm_loadu_si128 ((const __m128i*) cur);
         __m128i result0;
@@ -251,11 +494,11 @@ Match SlimTeddy_find_one_2 (SlimTeddy* self, char* cur, size_t cur_size, __m128i
 
         if (!_mm_testz_si128 (result, result))
         {
-                return SlimTeddy_verify (self, &result, cur, cur_size);
+                return SlimTeddy_verify (self, &result, str, cur, cur_size);
         }
         return Match_empty ();
 }
-Match SlimTeddy_find_one_3 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1)
+Match SlimTeddy_find_one_3 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1)
 {
         __m128i chunk = _mm_loadu_si128 ((const __m128i*) cur);
         __m128i result0;
@@ -273,12 +516,12 @@ Match SlimTeddy_find_one_3 (SlimTeddy* self, char* cur, size_t cur_size, __m128i
 
         if (!_mm_testz_si128 (result, result))
         {
-                return SlimTeddy_verify (self, &result, cur, cur_size);
+                return SlimTeddy_verify (self, &result, str, cur, cur_size);
         }
         return Match_empty ();
 }
 
-Match SlimTeddy_find_one_4 (SlimTeddy* self, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1, __m128i* prev2) {
+Match SlimTeddy_find_one_4 (SlimTeddy* self, char* str, char* cur, size_t cur_size, __m128i* prev0, __m128i* prev1, __m128i* prev2) {
         __m128i chunk = _mm_loadu_si128 ((const __m128i*) cur);
         __m128i result0;
         __m128i result1;
@@ -299,19 +542,19 @@ Match SlimTeddy_find_one_4 (SlimTeddy* self, char* cur, size_t cur_size, __m128i
 
         if (!_mm_testz_si128 (result, result))
         {
-                return SlimTeddy_verify (self, &result, cur, cur_size);
+                return SlimTeddy_verify (self, &result, str, cur, cur_size);
         }
         return Match_empty ();
 }
 
 
 Match
-SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* cur, size_t cur_size)
+SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* str, char* cur, size_t cur_size)
 {
         // [0..63]
         uint64_t lanes[2];
-        _mm_storeu_epi64 (lanes, *candidate);
-        Match match = SlimTeddy_verify64 (self, lanes[0], cur, cur_size);
+        _mm_storeu_si128 ((__m128i*) lanes, *candidate);
+        Match match = SlimTeddy_verify64 (self, lanes[0], str, cur, cur_size);
         if (match.pattern_id >= 0)
         {
                 return match;
@@ -319,7 +562,7 @@ SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* cur, size_t cur_siz
         cur += 8;
         cur_size -= 8;
         // [64..127]
-        match = SlimTeddy_verify64 (self, lanes[1], cur, cur_size);
+        match = SlimTeddy_verify64 (self, lanes[1], str, cur, cur_size);
         if (match.pattern_id >= 0)
         {
                 return match;
@@ -328,20 +571,28 @@ SlimTeddy_verify (SlimTeddy* self, __m128i* candidate, char* cur, size_t cur_siz
 }
 
 Match
-SlimTeddy_verify64 (SlimTeddy* self, uint64_t lane, char* cur, size_t cur_size)
+SlimTeddy_verify64 (SlimTeddy* self, uint64_t lane, char* str, char* cur, size_t cur_size)
 {
+        // candidates are reported at the last fingerprint byte: shift them back to the pattern start
+        const size_t back = self->offset + self->num_masks - 1;
+
         while (lane != 0)
         {
                 uint64_t bit = ctz_64 (lane);
                 lane &= ~((uint64_t) (1) << bit);
 
                 uint64_t shift = (bit / 8);
-                if (shift > cur_size)
+                if (shift >= cur_size)
                 {
                         break;
                 }
-                cur_size -= shift;
-                cur += shift;
+                size_t pos_idx = (size_t) (cur - str) + shift;
+                if (pos_idx < back)
+                {
+                        continue;
+                }
+                char* pos = str + pos_idx - back;
+                size_t pos_size = cur_size - shift + back;
 
                 SlimBucket* bucket = &self->buckets[bit % 8];
 
@@ -349,16 +600,18 @@ SlimTeddy_verify64 (SlimTeddy* self, uint64_t lane, char* cur, size_t cur_size)
                 {
                         uint8_t pattern_id = bucket->pattern_ids[pidx];
                         Pattern* pattern = &self->patterns[pattern_id];
-                        if (cur_size < pattern->size)
+                        if (pos_size < pattern->size)
                         {
                                 continue;
                         }
-                        if (memcmp (cur, pattern->begin, pattern->size) == 0)
+                        int equal = self->icase ? icase_memcmp (pos, pattern->begin, pattern->size) == 0
+                                                : memcmp (pos, pattern->begin, pattern->size) == 0;
+                        if (equal)
                         {
                                 Match match;
                                 match.pattern_id = pattern_id;
-                                match.begin = cur;
-                                match.end = cur + pattern->size;
+                                match.begin = pos;
+                                match.end = pos + pattern->size;
                                 return match;
                         }
                 }
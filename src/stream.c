@@ -0,0 +1,178 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/stream.h>
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * Bytes kept between chunks: a match starting in front of them ends within the current chunk. With flags, also the byte
+ *  behind the match.
+ */
+static size_t
+h_keep (const Searcher* searcher)
+{
+        size_t keep = searcher->max_pattern_size > 0 ? searcher->max_pattern_size - 1 : 0;
+        return searcher->flags != 0 ? keep + 1 : keep;
+}
+
+/*
+ * Report all matches in str[0, str_size) that start before limit. str[0] is at stream offset `offset`, before is the
+ *  stream byte in front of it. Matches are limited to str (the stream end if it is the last window).
+ */
+static int
+h_stream_scan (SearchStream* self, char* str, size_t str_size, size_t limit, uint64_t offset, int before)
+{
+        size_t pos = 0;
+        while (pos < limit)
+        {
+                Match match = Searcher_find_window (self->searcher, str, str_size, pos, before, SEARCH_EDGE);
+                if (match.pattern_id < 0 || (size_t) (match.begin - str) >= limit)
+                {
+                        break;
+                }
+                StreamMatch stream_match;
+                stream_match.pattern_id = match.pattern_id;
+                stream_match.begin = offset + (uint64_t) (match.begin - str);
+                stream_match.end = offset + (uint64_t) (match.end - str);
+                if (self->callback (&stream_match, self->user_data) != 0)
+                {
+                        self->stopped = 1;
+                        return 1;
+                }
+                pos = (size_t) (match.begin - str) + 1;
+        }
+        return 0;
+}
+
+static void
+h_stream_init (SearchStream* self, const Searcher* searcher, StreamCallback callback, void* user_data)
+{
+        self->searcher = searcher;
+        self->callback = callback;
+        self->user_data = user_data;
+        self->pending_size = 0;
+        self->offset = 0;
+        self->before = SEARCH_EDGE;
+        self->stopped = 0;
+}
+
+// ____________________________________________________________________________
+
+size_t
+SearchStream_buffer_size (const Searcher* searcher)
+{
+        size_t keep = h_keep (searcher);
+        return 3 * keep + 2;
+}
+
+int
+SearchStream_begin (SearchStream* self, const Searcher* searcher, StreamCallback callback, void* user_data)
+{
+        h_stream_init (self, searcher, callback, user_data);
+
+        char* buffer = malloc (SearchStream_buffer_size (searcher));
+        if (buffer == NULL)
+        {
+                self->pending = NULL;
+                self->window = NULL;
+                self->owns_buffers = 0;
+                return -1;
+        }
+        size_t keep = h_keep (searcher);
+        self->pending = buffer;
+        self->window = buffer + keep + 1;
+        self->owns_buffers = 1;
+        return 0;
+}
+
+void
+SearchStream_begin_buffer (SearchStream* self, const Searcher* searcher, StreamCallback callback, void* user_data,
+                           char* buffer)
+{
+        h_stream_init (self, searcher, callback, user_data);
+
+        size_t keep = h_keep (searcher);
+        self->pending = buffer;
+        self->window = buffer + keep + 1;
+        self->owns_buffers = 0;
+}
+
+int
+SearchStream_feed (SearchStream* self, const char* chunk, size_t chunk_size)
+{
+        if (self->stopped)
+        {
+                return 1;
+        }
+        const size_t keep = h_keep (self->searcher);
+        const uint64_t chunk_offset = self->offset + self->pending_size;
+        // stream byte in front of the chunk
+        int chunk_before = self->pending_size > 0 ? (unsigned char) self->pending[self->pending_size - 1] : self->before;
+
+        if (self->pending_size > 0)
+        {
+                // seam: resolve the start positions of the pending bytes using the head of the chunk
+                size_t take = chunk_size < keep ? chunk_size : keep;
+                size_t window_size = self->pending_size + take;
+                memcpy (self->window, self->pending, self->pending_size);
+                memcpy (self->window + self->pending_size, chunk, take);
+
+                size_t resolved = window_size > keep ? window_size - keep : 0;
+                resolved = resolved < self->pending_size ? resolved : self->pending_size;
+                if (h_stream_scan (self, self->window, window_size, resolved, self->offset, self->before))
+                {
+                        return 1;
+                }
+
+                if (take == chunk_size)
+                {
+                        // chunk was absorbed completely: keep the unresolved tail of the window
+                        self->pending_size = window_size - resolved;
+                        memcpy (self->pending, self->window + resolved, self->pending_size);
+                        self->offset += resolved;
+                        self->before = resolved > 0 ? (unsigned char) self->window[resolved - 1] : self->before;
+                        return 0;
+                }
+                self->pending_size = 0;
+        }
+
+        // body: matches starting in the chunk that are known to end within the chunk
+        size_t limit = chunk_size > keep ? chunk_size - keep : 0;
+        if (h_stream_scan (self, (char*) chunk, chunk_size, limit, chunk_offset, chunk_before))
+        {
+                return 1;
+        }
+
+        self->pending_size = chunk_size - limit;
+        memcpy (self->pending, chunk + limit, self->pending_size);
+        self->offset = chunk_offset + limit;
+        self->before = limit > 0 ? (unsigned char) chunk[limit - 1] : chunk_before;
+        return 0;
+}
+
+int
+SearchStream_end (SearchStream* self)
+{
+        int stopped = self->stopped;
+        if (!stopped && self->pending_size > 0)
+        {
+                stopped = h_stream_scan (self, self->pending, self->pending_size, self->pending_size, self->offset,
+                                         self->before);
+        }
+        self->pending_size = 0;
+        if (self->owns_buffers)
+        {
+                free (self->pending);
+        }
+        self->pending = NULL;
+        self->window = NULL;
+        return stopped;
+}
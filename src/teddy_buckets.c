@@ -0,0 +1,295 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <simdstr/teddy_buckets.h>
+#include <simdstr/utils/utils.h>
+
+#define TEDDY_MAX_BUCKETS 16
+#define TEDDY_MAX_LOCAL_SEARCH_PASSES 16
+// probability differences below this are considered ties
+#define TEDDY_EPSILON 1e-12
+
+void
+TeddyFingerprint_init (TeddyFingerprint* self)
+{
+        memset (self, 0, sizeof (TeddyFingerprint));
+}
+
+void
+TeddyFingerprint_add (TeddyFingerprint* self, const Pattern* pattern, uint8_t offset, uint8_t num_masks)
+{
+        for (uint8_t mask_idx = 0; mask_idx < num_masks; ++mask_idx)
+        {
+                uint8_t byte = (uint8_t) pattern->begin[offset + mask_idx];
+                self->lo[mask_idx] |= (uint16_t) (1u << (byte & 0xf));
+                self->hi[mask_idx] |= (uint16_t) (1u << (byte >> 4));
+        }
+}
+
+double
+TeddyFingerprint_probability (const TeddyFingerprint* self, uint8_t num_masks, const double* byte_freq)
+{
+        double probability = 1.0;
+        for (uint8_t mask_idx = 0; mask_idx < num_masks; ++mask_idx)
+        {
+                double mask_probability = 0.0;
+                for (int hi = 0; hi < 16; ++hi)
+                {
+                        if ((self->hi[mask_idx] & (1u << hi)) == 0)
+                        {
+                                continue;
+                        }
+                        for (int lo = 0; lo < 16; ++lo)
+                        {
+                                if ((self->lo[mask_idx] & (1u << lo)) != 0)
+                                {
+                                        mask_probability += byte_freq[(hi << 4) | lo];
+                                }
+                        }
+                }
+                probability *= mask_probability;
+        }
+        return probability;
+}
+
+// _____ helper functions _____________________________________________________
+
+static double
+h_bucket_probability (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset, const uint8_t* bucket_ids,
+                      uint8_t bucket_id, const double* byte_freq)
+{
+        TeddyFingerprint fingerprint;
+        TeddyFingerprint_init (&fingerprint);
+        bool empty = true;
+        for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                if (bucket_ids[pattern_id] == bucket_id)
+                {
+                        TeddyFingerprint_add (&fingerprint, &patterns[pattern_id], offset, num_masks);
+                        empty = false;
+                }
+        }
+        return empty ? 0.0 : TeddyFingerprint_probability (&fingerprint, num_masks, byte_freq);
+}
+
+// ____________________________________________________________________________
+
+double
+teddy_assign_buckets (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset,
+                      uint8_t num_buckets, uint8_t bucket_capacity, const double* byte_freq, uint8_t* bucket_ids)
+{
+        assert (num_buckets <= TEDDY_MAX_BUCKETS);
+        assert (num_patterns <= num_buckets * bucket_capacity);
+
+        double default_freq[256];
+        if (byte_freq == NULL)
+        {
+                byte_freq_default (default_freq);
+                byte_freq = default_freq;
+        }
+
+        // process patterns with the most frequent fingerprints first: they claim buckets of their own while rarer
+        //  patterns are added to buckets where they cause the least additional candidates.
+        uint8_t order[256];
+        double probability[256];
+        for (uint16_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                TeddyFingerprint fingerprint;
+                TeddyFingerprint_init (&fingerprint);
+                TeddyFingerprint_add (&fingerprint, &patterns[pattern_id], offset, num_masks);
+                probability[pattern_id] = TeddyFingerprint_probability (&fingerprint, num_masks, byte_freq);
+                order[pattern_id] = (uint8_t) pattern_id;
+        }
+        for (uint16_t i = 1; i < num_patterns; ++i)
+        {
+                uint8_t pattern_id = order[i];
+                uint16_t j = i;
+                for (/**/; j > 0 && probability[order[j - 1]] < probability[pattern_id]; --j)
+                {
+                        order[j] = order[j - 1];
+                }
+                order[j] = pattern_id;
+        }
+
+        TeddyFingerprint buckets[TEDDY_MAX_BUCKETS];
+        double bucket_probability[TEDDY_MAX_BUCKETS];
+        uint8_t bucket_size[TEDDY_MAX_BUCKETS];
+        for (uint8_t bucket_id = 0; bucket_id < num_buckets; ++bucket_id)
+        {
+                TeddyFingerprint_init (&buckets[bucket_id]);
+                bucket_probability[bucket_id] = 0.0;
+                bucket_size[bucket_id] = 0;
+        }
+
+        // greedy: add each pattern to the bucket with the smallest increase of its firing probability
+        for (uint16_t i = 0; i < num_patterns; ++i)
+        {
+                const Pattern* pattern = &patterns[order[i]];
+                int best_bucket = -1;
+                double best_delta = 0.0;
+                double best_probability = 0.0;
+                for (uint8_t bucket_id = 0; bucket_id < num_buckets; ++bucket_id)
+                {
+                        if (bucket_size[bucket_id] == bucket_capacity)
+                        {
+                                continue;
+                        }
+                        TeddyFingerprint merged = buckets[bucket_id];
+                        TeddyFingerprint_add (&merged, pattern, offset, num_masks);
+                        double merged_probability = TeddyFingerprint_probability (&merged, num_masks, byte_freq);
+                        double delta = merged_probability - bucket_probability[bucket_id];
+                        // prefer smaller buckets on ties to keep verification cheap
+                        if (best_bucket < 0 || delta < best_delta - TEDDY_EPSILON
+                            || (delta <= best_delta + TEDDY_EPSILON && bucket_size[bucket_id] < bucket_size[best_bucket]))
+                        {
+                                best_bucket = bucket_id;
+                                best_delta = delta;
+                                best_probability = merged_probability;
+                        }
+                }
+                assert (best_bucket >= 0);
+                TeddyFingerprint_add (&buckets[best_bucket], pattern, offset, num_masks);
+                bucket_probability[best_bucket] = best_probability;
+                bucket_size[best_bucket]++;
+                bucket_ids[order[i]] = (uint8_t) best_bucket;
+        }
+
+        // local search: move single patterns to other buckets as long as the total firing probability decreases
+        for (int pass = 0; pass < TEDDY_MAX_LOCAL_SEARCH_PASSES; ++pass)
+        {
+                bool improved = false;
+                for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+                {
+                        uint8_t from = bucket_ids[pattern_id];
+                        bucket_ids[pattern_id] = 0xff;
+                        double from_probability = h_bucket_probability (patterns, num_patterns, num_masks, offset, bucket_ids, from, byte_freq);
+                        double removal_gain = bucket_probability[from] - from_probability;
+
+                        int best_bucket = -1;
+                        double best_gain = TEDDY_EPSILON;
+                        double best_probability = 0.0;
+                        for (uint8_t bucket_id = 0; bucket_id < num_buckets; ++bucket_id)
+                        {
+                                if (bucket_id == from || bucket_size[bucket_id] == bucket_capacity)
+                                {
+                                        continue;
+                                }
+                                bucket_ids[pattern_id] = bucket_id;
+                                double to_probability = h_bucket_probability (patterns, num_patterns, num_masks, offset, bucket_ids, bucket_id, byte_freq);
+                                double gain = removal_gain - (to_probability - bucket_probability[bucket_id]);
+                                if (gain > best_gain)
+                                {
+                                        best_bucket = bucket_id;
+                                        best_gain = gain;
+                                        best_probability = to_probability;
+                                }
+                        }
+
+                        if (best_bucket < 0)
+                        {
+                                bucket_ids[pattern_id] = from;
+                                continue;
+                        }
+                        bucket_ids[pattern_id] = (uint8_t) best_bucket;
+                        bucket_probability[from] = from_probability;
+                        bucket_probability[best_bucket] = best_probability;
+                        bucket_size[from]--;
+                        bucket_size[best_bucket]++;
+                        improved = true;
+                }
+                if (!improved)
+                {
+                        break;
+                }
+        }
+
+        return teddy_false_positive_rate (patterns, num_patterns, num_masks, offset, num_buckets, bucket_ids, byte_freq);
+}
+
+double
+teddy_false_positive_rate (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset,
+                           uint8_t num_buckets, const uint8_t* bucket_ids, const double* byte_freq)
+{
+        double default_freq[256];
+        if (byte_freq == NULL)
+        {
+                byte_freq_default (default_freq);
+                byte_freq = default_freq;
+        }
+
+        // buckets are assumed to fire independently
+        double none_fires = 1.0;
+        for (uint8_t bucket_id = 0; bucket_id < num_buckets; ++bucket_id)
+        {
+                none_fires *= 1.0 - h_bucket_probability (patterns, num_patterns, num_masks, offset, bucket_ids, bucket_id, byte_freq);
+        }
+        return 1.0 - none_fires;
+}
+
+uint32_t
+teddy_fingerprint_collisions (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t offset)
+{
+        uint32_t collisions = 0;
+        for (uint8_t i = 0; i < num_patterns; ++i)
+        {
+                for (uint8_t j = i + 1; j < num_patterns; ++j)
+                {
+                        if (memcmp (patterns[i].begin + offset, patterns[j].begin + offset, num_masks) == 0)
+                        {
+                                collisions++;
+                        }
+                }
+        }
+        return collisions;
+}
+
+double
+teddy_choose_offset (const Pattern* patterns, uint8_t num_patterns, uint8_t num_masks, uint8_t num_buckets,
+                     uint8_t bucket_capacity, const double* byte_freq, uint8_t* offset, uint8_t* bucket_ids)
+{
+        double default_freq[256];
+        if (byte_freq == NULL)
+        {
+                byte_freq_default (default_freq);
+                byte_freq = default_freq;
+        }
+
+        size_t min_size = SIZE_MAX;
+        for (uint8_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                min_size = patterns[pattern_id].size < min_size ? patterns[pattern_id].size : min_size;
+        }
+        size_t max_offset = min_size > num_masks ? min_size - num_masks : 0;
+        max_offset = max_offset > TEDDY_MAX_OFFSET ? TEDDY_MAX_OFFSET : max_offset;
+
+        *offset = 0;
+        uint32_t best_collisions = teddy_fingerprint_collisions (patterns, num_patterns, num_masks, 0);
+        double best_rate = teddy_assign_buckets (patterns, num_patterns, num_masks, 0, num_buckets, bucket_capacity, byte_freq, bucket_ids);
+
+        for (uint8_t candidate = 1; candidate <= max_offset; ++candidate)
+        {
+                uint32_t collisions = teddy_fingerprint_collisions (patterns, num_patterns, num_masks, candidate);
+                if (collisions > best_collisions)
+                {
+                        continue;
+                }
+                uint8_t candidate_bucket_ids[256];
+                double rate = teddy_assign_buckets (patterns, num_patterns, num_masks, candidate, num_buckets, bucket_capacity, byte_freq, candidate_bucket_ids);
+                if (collisions < best_collisions || rate < best_rate - TEDDY_EPSILON)
+                {
+                        *offset = candidate;
+                        best_collisions = collisions;
+                        best_rate = rate;
+                        memcpy (bucket_ids, candidate_bucket_ids, num_patterns);
+                }
+        }
+        return best_rate;
+}
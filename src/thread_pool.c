@@ -0,0 +1,243 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <simdstr/thread_pool.h>
+
+#define RANGE(begin, end) (((uint64_t) (begin) << 32) | (uint64_t) (end))
+#define RANGE_BEGIN(range) ((uint32_t) ((range) >> 32))
+#define RANGE_END(range) ((uint32_t) (range))
+
+typedef struct {
+        ThreadPool* pool;
+        unsigned worker_id;
+        ThreadPoolWorkerInit worker_init;
+        void* init_context;
+} WorkerArgs;
+
+// _____ helper functions _____________________________________________________
+
+static int
+h_pop (WorkQueue* queue, size_t* task_id)
+{
+        uint64_t range = __atomic_load_n (&queue->range, __ATOMIC_ACQUIRE);
+        while (RANGE_BEGIN (range) < RANGE_END (range))
+        {
+                uint64_t popped = RANGE (RANGE_BEGIN (range) + 1, RANGE_END (range));
+                if (__atomic_compare_exchange_n (&queue->range, &range, popped, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                        *task_id = RANGE_BEGIN (range);
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/*
+ * Move the back half of the largest range of the other workers to the queue of worker_id.
+ */
+static int
+h_steal (ThreadPool* pool, unsigned worker_id)
+{
+        for (;;)
+        {
+                unsigned victim = pool->num_threads;
+                uint32_t victim_size = 0;
+                uint64_t range = 0;
+                for (unsigned i = 0; i < pool->num_threads; ++i)
+                {
+                        uint64_t r = __atomic_load_n (&pool->queues[i].range, __ATOMIC_ACQUIRE);
+                        uint32_t size = RANGE_END (r) - RANGE_BEGIN (r);
+                        if (i != worker_id && RANGE_BEGIN (r) < RANGE_END (r) && size > victim_size)
+                        {
+                                victim = i;
+                                victim_size = size;
+                                range = r;
+                        }
+                }
+                if (victim == pool->num_threads)
+                {
+                        return 0;
+                }
+                uint32_t mid = RANGE_BEGIN (range) + victim_size / 2;
+                if (__atomic_compare_exchange_n (&pool->queues[victim].range, &range, RANGE (RANGE_BEGIN (range), mid), 0,
+                                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                        __atomic_store_n (&pool->queues[worker_id].range, RANGE (mid, RANGE_END (range)), __ATOMIC_RELEASE);
+                        return 1;
+                }
+        }
+}
+
+static void
+h_work (ThreadPool* pool, unsigned worker_id)
+{
+        size_t task_id;
+        for (;;)
+        {
+                while (h_pop (&pool->queues[worker_id], &task_id))
+                {
+                        pool->task (pool->context, task_id, worker_id);
+                }
+                if (!h_steal (pool, worker_id))
+                {
+                        return;
+                }
+        }
+}
+
+static void*
+h_worker_main (void* arg)
+{
+        WorkerArgs args = *(WorkerArgs*) arg;
+        free (arg);
+        ThreadPool* pool = args.pool;
+        if (args.worker_init != NULL)
+        {
+                args.worker_init (args.init_context, args.worker_id);
+        }
+
+        uint64_t seen = 0;
+        for (;;)
+        {
+                pthread_mutex_lock (&pool->mutex);
+                while (pool->generation == seen && !pool->shutdown)
+                {
+                        pthread_cond_wait (&pool->start, &pool->mutex);
+                }
+                if (pool->shutdown)
+                {
+                        pthread_mutex_unlock (&pool->mutex);
+                        return NULL;
+                }
+                seen = pool->generation;
+                pthread_mutex_unlock (&pool->mutex);
+
+                h_work (pool, args.worker_id);
+
+                pthread_mutex_lock (&pool->mutex);
+                if (--pool->active == 0)
+                {
+                        pthread_cond_signal (&pool->done);
+                }
+                pthread_mutex_unlock (&pool->mutex);
+        }
+}
+
+// ____________________________________________________________________________
+
+int
+ThreadPool_init (ThreadPool* self, unsigned num_threads, ThreadPoolWorkerInit worker_init, void* init_context)
+{
+        if (num_threads == 0)
+        {
+                long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+                num_threads = cpus > 0 ? (unsigned) cpus : 1;
+        }
+        self->num_threads = num_threads;
+        self->generation = 0;
+        self->active = 0;
+        self->shutdown = 0;
+        self->task = NULL;
+        self->context = NULL;
+        self->threads = malloc (num_threads * sizeof (pthread_t));
+        void* queues = NULL;
+        if (posix_memalign (&queues, 64, num_threads * sizeof (WorkQueue)) != 0)
+        {
+                queues = NULL;
+        }
+        self->queues = queues;
+        if (self->threads == NULL || self->queues == NULL)
+        {
+                free (self->threads);
+                free (self->queues);
+                return -1;
+        }
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+                self->queues[i].range = 0;
+        }
+        pthread_mutex_init (&self->mutex, NULL);
+        pthread_cond_init (&self->start, NULL);
+        pthread_cond_init (&self->done, NULL);
+
+        if (worker_init != NULL)
+        {
+                worker_init (init_context, 0);
+        }
+        for (unsigned i = 1; i < num_threads; ++i)
+        {
+                WorkerArgs* args = malloc (sizeof (WorkerArgs));
+                if (args != NULL)
+                {
+                        args->pool = self;
+                        args->worker_id = i;
+                        args->worker_init = worker_init;
+                        args->init_context = init_context;
+                }
+                if (args == NULL || pthread_create (&self->threads[i], NULL, h_worker_main, args) != 0)
+                {
+                        free (args);
+                        // run with the workers started so far
+                        self->num_threads = i;
+                        break;
+                }
+        }
+        return 0;
+}
+
+void
+ThreadPool_run (ThreadPool* self, size_t num_tasks, ThreadPoolTask task, void* context)
+{
+        if (num_tasks == 0)
+        {
+                return;
+        }
+        for (unsigned i = 0; i < self->num_threads; ++i)
+        {
+                uint32_t begin = (uint32_t) (num_tasks * i / self->num_threads);
+                uint32_t end = (uint32_t) (num_tasks * (i + 1) / self->num_threads);
+                __atomic_store_n (&self->queues[i].range, RANGE (begin, end), __ATOMIC_RELAXED);
+        }
+
+        pthread_mutex_lock (&self->mutex);
+        self->task = task;
+        self->context = context;
+        self->active = self->num_threads - 1;
+        self->generation++;
+        pthread_cond_broadcast (&self->start);
+        pthread_mutex_unlock (&self->mutex);
+
+        h_work (self, 0);
+
+        pthread_mutex_lock (&self->mutex);
+        while (self->active > 0)
+        {
+                pthread_cond_wait (&self->done, &self->mutex);
+        }
+        pthread_mutex_unlock (&self->mutex);
+}
+
+void
+ThreadPool_destroy (ThreadPool* self)
+{
+        pthread_mutex_lock (&self->mutex);
+        self->shutdown = 1;
+        pthread_cond_broadcast (&self->start);
+        pthread_mutex_unlock (&self->mutex);
+        for (unsigned i = 1; i < self->num_threads; ++i)
+        {
+                pthread_join (self->threads[i], NULL);
+        }
+        pthread_mutex_destroy (&self->mutex);
+        pthread_cond_destroy (&self->start);
+        pthread_cond_destroy (&self->done);
+        free (self->threads);
+        free (self->queues);
+}
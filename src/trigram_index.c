@@ -0,0 +1,578 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <fcntl.h>
+#include <immintrin.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <simdstr/match_vector.h>
+#include <simdstr/trigram_index.h>
+
+// number of distinct trigrams
+#define TRIGRAM_SPACE (1u << 24)
+
+typedef struct {
+        const char* str;
+        size_t str_size;
+        size_t block_size;
+
+        // per worker bitmap of the trigrams seen in the current block (cleared after each block)
+        uint64_t** seen;
+        // distinct trigrams of each block
+        uint32_t** block_trigrams;
+        uint32_t* block_num_trigrams;
+        int failed;
+} TrigramBuild;
+
+typedef struct {
+        const Searcher* searcher;
+        char* str;
+        size_t str_size;
+        size_t block_size;
+        const uint32_t* blocks;
+        MatchVector* matches;
+} TrigramScan;
+
+// posting list of one pattern trigram
+typedef struct {
+        const uint32_t* begin;
+        const uint32_t* end;
+} PostingRange;
+
+// _____ helper functions _____________________________________________________
+
+/*
+ * Trigrams starting at str[0, 8) (reads str[0, 16)).
+ */
+static inline void
+h_trigrams_8 (const char* str, uint32_t* trigrams)
+{
+        const __m256i gather = _mm256_setr_epi8 (0, 1, 2, -1, 1, 2, 3, -1, 2, 3, 4, -1, 3, 4, 5, -1,
+                                                 4, 5, 6, -1, 5, 6, 7, -1, 6, 7, 8, -1, 7, 8, 9, -1);
+        __m256i bytes = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i*) str));
+        _mm256_storeu_si256 ((__m256i*) trigrams, _mm256_shuffle_epi8 (bytes, gather));
+}
+
+static inline uint32_t
+h_trigram (const char* str)
+{
+        return (uint32_t) (uint8_t) str[0] | (uint32_t) (uint8_t) str[1] << 8 | (uint32_t) (uint8_t) str[2] << 16;
+}
+
+static inline void
+h_add_trigram (uint64_t* seen, uint32_t trigram, uint32_t* trigrams, uint32_t* num_trigrams)
+{
+        uint64_t bit = (uint64_t) 1 << (trigram % 64);
+        if ((seen[trigram / 64] & bit) == 0)
+        {
+                seen[trigram / 64] |= bit;
+                trigrams[(*num_trigrams)++] = trigram;
+        }
+}
+
+static void
+h_index_task (void* context, size_t block_id, unsigned worker_id)
+{
+        TrigramBuild* build = context;
+        size_t begin = block_id * build->block_size;
+        size_t end = begin + build->block_size + TRIGRAM_INDEX_OVERLAP + 2;
+        end = end < build->str_size ? end : build->str_size;
+        uint32_t num_trigrams = 0;
+        uint32_t* trigrams = end - begin >= 3 ? malloc ((end - begin - 2) * sizeof (uint32_t)) : NULL;
+        if (trigrams == NULL)
+        {
+                if (end - begin >= 3)
+                {
+                        __atomic_store_n (&build->failed, 1, __ATOMIC_RELAXED);
+                }
+                build->block_trigrams[block_id] = NULL;
+                build->block_num_trigrams[block_id] = 0;
+                return;
+        }
+
+        uint64_t* seen = build->seen[worker_id];
+        uint32_t batch[8];
+        size_t pos = begin;
+        // 8 trigrams per shuffle while 16 bytes can be loaded
+        while (pos + 10 <= end && pos + 16 <= build->str_size)
+        {
+                h_trigrams_8 (build->str + pos, batch);
+                for (unsigned idx = 0; idx < 8; ++idx)
+                {
+                        h_add_trigram (seen, batch[idx], trigrams, &num_trigrams);
+                }
+                pos += 8;
+        }
+        for (; pos + 3 <= end; ++pos)
+        {
+                h_add_trigram (seen, h_trigram (build->str + pos), trigrams, &num_trigrams);
+        }
+        for (uint32_t idx = 0; idx < num_trigrams; ++idx)
+        {
+                seen[trigrams[idx] / 64] = 0;
+        }
+
+        uint32_t* shrunk = realloc (trigrams, num_trigrams * sizeof (uint32_t));
+        build->block_trigrams[block_id] = shrunk != NULL ? shrunk : trigrams;
+        build->block_num_trigrams[block_id] = num_trigrams;
+}
+
+/*
+ * Byte offsets of the offsets and postings arrays in the file layout. Returns the total size.
+ */
+static size_t
+h_layout (const TrigramIndexHeader* header, size_t* offsets_pos, size_t* postings_pos)
+{
+        size_t trigrams_size = (header->num_trigrams * sizeof (uint32_t) + 7) & ~(size_t) 7;
+        *offsets_pos = sizeof (TrigramIndexHeader) + trigrams_size;
+        *postings_pos = *offsets_pos + (header->num_trigrams + 1) * sizeof (uint64_t);
+        return *postings_pos + header->num_postings * sizeof (uint32_t);
+}
+
+static void
+h_attach (TrigramIndex* self)
+{
+        size_t offsets_pos;
+        size_t postings_pos;
+        memcpy (&self->header, self->memory, sizeof (TrigramIndexHeader));
+        h_layout (&self->header, &offsets_pos, &postings_pos);
+        self->trigrams = (const uint32_t*) ((const char*) self->memory + sizeof (TrigramIndexHeader));
+        self->offsets = (const uint64_t*) ((const char*) self->memory + offsets_pos);
+        self->postings = (const uint32_t*) ((const char*) self->memory + postings_pos);
+}
+
+/*
+ * Check the attached arrays: trigrams ascend, the posting ranges tile postings and every posting list ascends over
+ *  valid block ids (so no list holds more than num_blocks entries).
+ */
+static int
+h_validate (const TrigramIndex* self)
+{
+        const TrigramIndexHeader* header = &self->header;
+        if (self->offsets[0] != 0 || self->offsets[header->num_trigrams] != header->num_postings)
+        {
+                return 0;
+        }
+        for (uint64_t rank = 0; rank < header->num_trigrams; ++rank)
+        {
+                uint64_t begin = self->offsets[rank];
+                uint64_t end = self->offsets[rank + 1];
+                uint32_t trigram = self->trigrams[rank];
+                if (trigram >= TRIGRAM_SPACE || (rank > 0 && trigram <= self->trigrams[rank - 1]) || end < begin ||
+                    end > header->num_postings)
+                {
+                        return 0;
+                }
+                for (uint64_t pos = begin; pos < end; ++pos)
+                {
+                        if (self->postings[pos] >= header->num_blocks ||
+                            (pos > begin && self->postings[pos] <= self->postings[pos - 1]))
+                        {
+                                return 0;
+                        }
+                }
+        }
+        return 1;
+}
+
+static int
+h_compare_trigrams (const void* a, const void* b)
+{
+        uint32_t x = *(const uint32_t*) a;
+        uint32_t y = *(const uint32_t*) b;
+        return (x > y) - (x < y);
+}
+
+static int
+h_compare_ranges (const void* a, const void* b)
+{
+        const PostingRange* x = a;
+        const PostingRange* y = b;
+        ptrdiff_t size_x = x->end - x->begin;
+        ptrdiff_t size_y = y->end - y->begin;
+        return (size_x > size_y) - (size_x < size_y);
+}
+
+/*
+ * First element of [begin, end) that is >= value.
+ */
+static const uint32_t*
+h_lower_bound (const uint32_t* begin, const uint32_t* end, uint32_t value)
+{
+        while (begin < end)
+        {
+                const uint32_t* mid = begin + (end - begin) / 2;
+                if (*mid < value)
+                {
+                        begin = mid + 1;
+                }
+                else
+                {
+                        end = mid;
+                }
+        }
+        return begin;
+}
+
+static void
+h_scan_task (void* context, size_t candidate_id, unsigned worker_id)
+{
+        (void) worker_id;
+        TrigramScan* scan = context;
+        size_t start = scan->blocks[candidate_id] * scan->block_size;
+        size_t end = start + scan->block_size < scan->str_size ? start + scan->block_size : scan->str_size;
+        size_t overlap = scan->searcher->max_pattern_size > 0 ? scan->searcher->max_pattern_size - 1 : 0;
+        size_t scan_end = end + overlap < scan->str_size ? end + overlap : scan->str_size;
+        int before = start > 0 ? (unsigned char) scan->str[start - 1] : SEARCH_EDGE;
+        int after = scan_end < scan->str_size ? (unsigned char) scan->str[scan_end] : SEARCH_EDGE;
+        MatchVector_find_all_window (&scan->matches[candidate_id], scan->searcher, scan->str + start, scan_end - start,
+                                     end - start, before, after);
+}
+
+// ____________________________________________________________________________
+
+int
+TrigramIndex_build (TrigramIndex* self, ThreadPool* pool, const char* str, size_t str_size, size_t block_size)
+{
+        self->memory = NULL;
+        self->mapped = 0;
+        block_size = block_size == 0 ? TRIGRAM_INDEX_BLOCK_SIZE : block_size;
+        size_t num_blocks = (str_size + block_size - 1) / block_size;
+        if (num_blocks > UINT32_MAX)
+        {
+                return -1;
+        }
+        unsigned num_workers = pool != NULL ? pool->num_threads : 1;
+
+        TrigramBuild build;
+        build.str = str;
+        build.str_size = str_size;
+        build.block_size = block_size;
+        build.failed = 0;
+        build.seen = calloc (num_workers, sizeof (uint64_t*));
+        build.block_trigrams = calloc (num_blocks + 1, sizeof (uint32_t*));
+        build.block_num_trigrams = calloc (num_blocks + 1, sizeof (uint32_t));
+        uint32_t* ranks = calloc (TRIGRAM_SPACE, sizeof (uint32_t));
+        uint64_t* cursors = NULL;
+        build.failed = build.seen == NULL || build.block_trigrams == NULL || build.block_num_trigrams == NULL || ranks == NULL;
+        for (unsigned worker_id = 0; !build.failed && worker_id < num_workers; ++worker_id)
+        {
+                build.seen[worker_id] = calloc (TRIGRAM_SPACE / 64, sizeof (uint64_t));
+                build.failed = build.seen[worker_id] == NULL;
+        }
+
+        if (!build.failed)
+        {
+                if (pool != NULL)
+                {
+                        ThreadPool_run (pool, num_blocks, h_index_task, &build);
+                }
+                else
+                {
+                        for (size_t block_id = 0; block_id < num_blocks; ++block_id)
+                        {
+                                h_index_task (&build, block_id, 0);
+                        }
+                }
+        }
+
+        // count the blocks of every trigram, then store the posting lists in block order
+        TrigramIndexHeader header;
+        memset (&header, 0, sizeof (header));
+        memcpy (header.magic, TRIGRAM_INDEX_MAGIC, sizeof (header.magic));
+        header.corpus_size = str_size;
+        header.block_size = block_size;
+        header.overlap = TRIGRAM_INDEX_OVERLAP;
+        header.num_blocks = num_blocks;
+        for (size_t block_id = 0; !build.failed && block_id < num_blocks; ++block_id)
+        {
+                for (uint32_t idx = 0; idx < build.block_num_trigrams[block_id]; ++idx)
+                {
+                        header.num_trigrams += ranks[build.block_trigrams[block_id][idx]]++ == 0;
+                }
+                header.num_postings += build.block_num_trigrams[block_id];
+        }
+        size_t offsets_pos;
+        size_t postings_pos;
+        self->memory_size = h_layout (&header, &offsets_pos, &postings_pos);
+        self->memory = build.failed ? NULL : malloc (self->memory_size);
+        cursors = build.failed ? NULL : malloc ((header.num_trigrams + 1) * sizeof (uint64_t));
+        if (self->memory != NULL && cursors != NULL)
+        {
+                char* memory = self->memory;
+                memcpy (memory, &header, sizeof (header));
+                memset (memory + sizeof (header), 0, offsets_pos - sizeof (header));
+                uint32_t* trigrams = (uint32_t*) (memory + sizeof (header));
+                uint64_t* offsets = (uint64_t*) (memory + offsets_pos);
+                uint32_t* postings = (uint32_t*) (memory + postings_pos);
+                uint32_t rank = 0;
+                offsets[0] = 0;
+                for (uint32_t trigram = 0; trigram < TRIGRAM_SPACE; ++trigram)
+                {
+                        if (ranks[trigram] > 0)
+                        {
+                                trigrams[rank] = trigram;
+                                offsets[rank + 1] = offsets[rank] + ranks[trigram];
+                                cursors[rank] = offsets[rank];
+                                ranks[trigram] = rank++;
+                        }
+                }
+                for (size_t block_id = 0; block_id < num_blocks; ++block_id)
+                {
+                        for (uint32_t idx = 0; idx < build.block_num_trigrams[block_id]; ++idx)
+                        {
+                                postings[cursors[ranks[build.block_trigrams[block_id][idx]]]++] = (uint32_t) block_id;
+                        }
+                }
+                h_attach (self);
+        }
+        else
+        {
+                free (self->memory);
+                self->memory = NULL;
+                build.failed = 1;
+        }
+
+        for (unsigned worker_id = 0; build.seen != NULL && worker_id < num_workers; ++worker_id)
+        {
+                free (build.seen[worker_id]);
+        }
+        for (size_t block_id = 0; build.block_trigrams != NULL && block_id < num_blocks; ++block_id)
+        {
+                free (build.block_trigrams[block_id]);
+        }
+        free (build.seen);
+        free (build.block_trigrams);
+        free (build.block_num_trigrams);
+        free (ranks);
+        free (cursors);
+        return build.failed ? -1 : 0;
+}
+
+int
+TrigramIndex_save (const TrigramIndex* self, const char* path)
+{
+        FILE* file = fopen (path, "wb");
+        if (file == NULL)
+        {
+                return -1;
+        }
+        size_t written = fwrite (self->memory, 1, self->memory_size, file);
+        int closed = fclose (file);
+        return written == self->memory_size && closed == 0 ? 0 : -1;
+}
+
+int
+TrigramIndex_open (TrigramIndex* self, const char* path)
+{
+        self->memory = NULL;
+        self->mapped = 0;
+        int fd = open (path, O_RDONLY);
+        if (fd < 0)
+        {
+                return -1;
+        }
+        struct stat st;
+        if (fstat (fd, &st) != 0 || (size_t) st.st_size < sizeof (TrigramIndexHeader))
+        {
+                close (fd);
+                return -1;
+        }
+        void* mapping = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close (fd);
+        if (mapping == MAP_FAILED)
+        {
+                return -1;
+        }
+
+        TrigramIndexHeader header;
+        memcpy (&header, mapping, sizeof (header));
+        size_t file_size = (size_t) st.st_size;
+        size_t offsets_pos;
+        size_t postings_pos;
+        int valid = memcmp (header.magic, TRIGRAM_INDEX_MAGIC, sizeof (header.magic)) == 0 && header.block_size > 0 &&
+                    header.overlap == TRIGRAM_INDEX_OVERLAP &&
+                    header.num_blocks == (header.corpus_size + header.block_size - 1) / header.block_size &&
+                    header.num_trigrams <= TRIGRAM_SPACE && header.num_postings <= file_size / sizeof (uint32_t) &&
+                    h_layout (&header, &offsets_pos, &postings_pos) == file_size;
+        if (!valid)
+        {
+                munmap (mapping, file_size);
+                return -1;
+        }
+        self->memory = mapping;
+        self->memory_size = file_size;
+        self->mapped = 1;
+        h_attach (self);
+        if (!h_validate (self))
+        {
+                munmap (mapping, file_size);
+                self->memory = NULL;
+                self->mapped = 0;
+                return -1;
+        }
+        return 0;
+}
+
+size_t
+TrigramIndex_candidates (const TrigramIndex* self, const char* pattern, size_t pattern_size, uint32_t* blocks)
+{
+        if (pattern_size < 3)
+        {
+                for (size_t block_id = 0; block_id < self->header.num_blocks; ++block_id)
+                {
+                        blocks[block_id] = (uint32_t) block_id;
+                }
+                return self->header.num_blocks;
+        }
+        // trigrams of the prefix indexed for the block a match starts in
+        size_t prefix_size = pattern_size < self->header.overlap + 2 ? pattern_size : self->header.overlap + 2;
+        uint32_t trigrams[TRIGRAM_INDEX_OVERLAP];
+        size_t num_trigrams = prefix_size - 2;
+        for (size_t pos = 0; pos < num_trigrams; ++pos)
+        {
+                trigrams[pos] = h_trigram (pattern + pos);
+        }
+        qsort (trigrams, num_trigrams, sizeof (uint32_t), h_compare_trigrams);
+
+        PostingRange ranges[TRIGRAM_INDEX_OVERLAP];
+        size_t num_ranges = 0;
+        const uint32_t* trigrams_end = self->trigrams + self->header.num_trigrams;
+        for (size_t idx = 0; idx < num_trigrams; ++idx)
+        {
+                if (idx > 0 && trigrams[idx] == trigrams[idx - 1])
+                {
+                        continue;
+                }
+                const uint32_t* found = h_lower_bound (self->trigrams, trigrams_end, trigrams[idx]);
+                if (found == trigrams_end || *found != trigrams[idx])
+                {
+                        return 0;
+                }
+                size_t rank = (size_t) (found - self->trigrams);
+                ranges[num_ranges].begin = self->postings + self->offsets[rank];
+                ranges[num_ranges].end = self->postings + self->offsets[rank + 1];
+                num_ranges++;
+        }
+
+        // intersect starting with the shortest posting list
+        qsort (ranges, num_ranges, sizeof (PostingRange), h_compare_ranges);
+        size_t num_blocks = (size_t) (ranges[0].end - ranges[0].begin);
+        memcpy (blocks, ranges[0].begin, num_blocks * sizeof (uint32_t));
+        for (size_t idx = 1; idx < num_ranges && num_blocks > 0; ++idx)
+        {
+                const uint32_t* cur = ranges[idx].begin;
+                size_t num_kept = 0;
+                for (size_t pos = 0; pos < num_blocks; ++pos)
+                {
+                        cur = h_lower_bound (cur, ranges[idx].end, blocks[pos]);
+                        if (cur == ranges[idx].end)
+                        {
+                                break;
+                        }
+                        if (*cur == blocks[pos])
+                        {
+                                blocks[num_kept++] = blocks[pos];
+                        }
+                }
+                num_blocks = num_kept;
+        }
+        return num_blocks;
+}
+
+size_t
+TrigramIndex_find_all (const TrigramIndex* self, ThreadPool* pool, const Pattern* patterns, size_t num_patterns,
+                       const Searcher* searcher, char* str, size_t str_size, Match** matches)
+{
+        *matches = NULL;
+        if (str_size != self->header.corpus_size)
+        {
+                return SIZE_MAX;
+        }
+        size_t num_blocks = self->header.num_blocks;
+        uint8_t* is_candidate = calloc (num_blocks + 1, 1);
+        uint32_t* blocks = malloc ((num_blocks + 1) * sizeof (uint32_t));
+        if (is_candidate == NULL || blocks == NULL)
+        {
+                free (is_candidate);
+                free (blocks);
+                return SIZE_MAX;
+        }
+        // union of the candidate blocks of all patterns
+        for (size_t pattern_id = 0; pattern_id < num_patterns; ++pattern_id)
+        {
+                size_t num_candidates = TrigramIndex_candidates (self, patterns[pattern_id].begin, patterns[pattern_id].size, blocks);
+                for (size_t idx = 0; idx < num_candidates; ++idx)
+                {
+                        is_candidate[blocks[idx]] = 1;
+                }
+        }
+        size_t num_candidates = 0;
+        for (size_t block_id = 0; block_id < num_blocks; ++block_id)
+        {
+                if (is_candidate[block_id])
+                {
+                        blocks[num_candidates++] = (uint32_t) block_id;
+                }
+        }
+        free (is_candidate);
+
+        TrigramScan scan;
+        scan.searcher = searcher;
+        scan.str = str;
+        scan.str_size = str_size;
+        scan.block_size = self->header.block_size;
+        scan.blocks = blocks;
+        scan.matches = malloc ((num_candidates + 1) * sizeof (MatchVector));
+        if (scan.matches == NULL)
+        {
+                free (blocks);
+                return SIZE_MAX;
+        }
+        for (size_t idx = 0; idx < num_candidates; ++idx)
+        {
+                MatchVector_init (&scan.matches[idx]);
+        }
+        if (pool != NULL)
+        {
+                ThreadPool_run (pool, num_candidates, h_scan_task, &scan);
+        }
+        else
+        {
+                for (size_t idx = 0; idx < num_candidates; ++idx)
+                {
+                        h_scan_task (&scan, idx, 0);
+                }
+        }
+        size_t num_matches = MatchVector_merge (scan.matches, num_candidates, matches);
+        free (scan.matches);
+        free (blocks);
+        return num_matches;
+}
+
+void
+TrigramIndex_destroy (TrigramIndex* self)
+{
+        if (self->mapped)
+        {
+                munmap (self->memory, self->memory_size);
+        }
+        else
+        {
+                free (self->memory);
+        }
+        self->memory = NULL;
+}
@@ -0,0 +1,510 @@
+/**
+* Copyright 2024, Leon Freist (https://github.com/lfreist)
+* Author: Leon Freist <freist.leon@gmail.com>
+*
+* This file is part of simd_string.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define URING_SUPPORTED 1
+#else
+#define URING_SUPPORTED 0
+#endif
+
+#include <simdstr/uring_reader.h>
+
+// alignment of buffers, offsets and sizes required by O_DIRECT
+#define DIRECT_ALIGNMENT 4096
+
+typedef struct {
+        UringReader* reader;
+        int fd;
+        int direct;
+} UringFile;
+
+// _____ helper functions _____________________________________________________
+
+static void
+h_close_ring (UringReader* self)
+{
+#if URING_SUPPORTED
+        if (self->sqes != NULL)
+        {
+                munmap (self->sqes, self->sqes_size);
+        }
+        if (self->cq_ring != NULL && self->cq_ring != self->sq_ring)
+        {
+                munmap (self->cq_ring, self->cq_ring_size);
+        }
+        if (self->sq_ring != NULL)
+        {
+                munmap (self->sq_ring, self->sq_ring_size);
+        }
+#endif
+        if (self->ring_fd >= 0)
+        {
+                close (self->ring_fd);
+        }
+        self->ring_fd = -1;
+        self->sq_ring = NULL;
+        self->cq_ring = NULL;
+        self->sqes = NULL;
+}
+
+static size_t
+h_round_up (size_t size, size_t alignment)
+{
+        return (size + alignment - 1) / alignment * alignment;
+}
+
+#if URING_SUPPORTED
+static int
+h_setup (UringReader* self)
+{
+        struct io_uring_params params;
+        memset (&params, 0, sizeof (params));
+        int fd = (int) syscall (__NR_io_uring_setup, self->entries, &params);
+        if (fd < 0)
+        {
+                return -1;
+        }
+        self->ring_fd = fd;
+        self->entries = params.sq_entries;
+        self->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+        self->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+        int single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap && self->cq_ring_size > self->sq_ring_size)
+        {
+                self->sq_ring_size = self->cq_ring_size;
+        }
+
+        self->sq_ring = mmap (NULL, self->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                              IORING_OFF_SQ_RING);
+        if (self->sq_ring == MAP_FAILED)
+        {
+                self->sq_ring = NULL;
+                return -1;
+        }
+        self->cq_ring = single_mmap ? self->sq_ring
+                                    : mmap (NULL, self->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                            fd, IORING_OFF_CQ_RING);
+        if (self->cq_ring == MAP_FAILED)
+        {
+                self->cq_ring = NULL;
+                return -1;
+        }
+        self->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+        self->sqes = mmap (NULL, self->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (self->sqes == MAP_FAILED)
+        {
+                self->sqes = NULL;
+                return -1;
+        }
+
+        char* sq = self->sq_ring;
+        self->sq_head = (unsigned*) (sq + params.sq_off.head);
+        self->sq_tail = (unsigned*) (sq + params.sq_off.tail);
+        self->sq_mask = (unsigned*) (sq + params.sq_off.ring_mask);
+        self->sq_array = (unsigned*) (sq + params.sq_off.array);
+        char* cq = self->cq_ring;
+        self->cq_head = (unsigned*) (cq + params.cq_off.head);
+        self->cq_tail = (unsigned*) (cq + params.cq_off.tail);
+        self->cq_mask = (unsigned*) (cq + params.cq_off.ring_mask);
+        self->cqes = cq + params.cq_off.cqes;
+        return 0;
+}
+
+static void
+h_register_buffers (UringReader* self)
+{
+        struct iovec* iov = malloc (self->num_buffers * sizeof (struct iovec));
+        if (iov == NULL)
+        {
+                return;
+        }
+        for (unsigned i = 0; i < self->num_buffers; ++i)
+        {
+                iov[i].iov_base = self->buffers + (size_t) i * self->buffer_size;
+                iov[i].iov_len = self->buffer_size;
+        }
+        // fails e.g. if the buffers exceed RLIMIT_MEMLOCK, plain reads are used then
+        self->registered =
+                syscall (__NR_io_uring_register, self->ring_fd, IORING_REGISTER_BUFFERS, iov, self->num_buffers) == 0;
+        free (iov);
+}
+
+/*
+ * The kernel supports IORING_OP_READ (Linux 5.6, like IORING_REGISTER_PROBE itself).
+ */
+static int
+h_probe_read (UringReader* self)
+{
+        size_t probe_size = sizeof (struct io_uring_probe) + IORING_OP_LAST * sizeof (struct io_uring_probe_op);
+        struct io_uring_probe* probe = calloc (1, probe_size);
+        if (probe == NULL)
+        {
+                return 0;
+        }
+        int supported =
+                syscall (__NR_io_uring_register, self->ring_fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0 &&
+                probe->last_op >= IORING_OP_READ &&
+                (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+        free (probe);
+        return supported;
+}
+
+/*
+ * Queue the read of the missing part of slot_id and submit it. O_DIRECT reads restart at the last aligned position
+ *  before filled: the bytes read again are the same and overwrite themselves.
+ */
+static int
+h_submit (UringFile* file, unsigned slot_id)
+{
+        UringReader* self = file->reader;
+        UringSlot* slot = &self->slots[slot_id];
+        size_t size = file->direct ? h_round_up (slot->size, DIRECT_ALIGNMENT) : slot->size;
+        slot->read_begin = file->direct ? slot->filled / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT : slot->filled;
+
+        unsigned tail = *self->sq_tail;
+        unsigned index = tail & *self->sq_mask;
+        struct io_uring_sqe* sqe = (struct io_uring_sqe*) self->sqes + index;
+        memset (sqe, 0, sizeof (*sqe));
+        sqe->opcode = self->registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = file->fd;
+        sqe->off = slot->offset + slot->read_begin;
+        sqe->addr = (uint64_t) (uintptr_t) (self->buffers + (size_t) slot_id * self->buffer_size + slot->read_begin);
+        sqe->len = (uint32_t) (size - slot->read_begin);
+        sqe->buf_index = (uint16_t) (self->registered ? slot_id : 0);
+        sqe->user_data = slot_id;
+        self->sq_array[index] = index;
+        __atomic_store_n (self->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        for (;;)
+        {
+                long submitted = syscall (__NR_io_uring_enter, self->ring_fd, 1, 0, 0, NULL, 0);
+                if (submitted >= 0)
+                {
+                        break;
+                }
+                if (errno != EINTR && errno != EAGAIN)
+                {
+                        return -1;
+                }
+        }
+        self->in_flight++;
+        return 0;
+}
+
+/*
+ * Wait for at least one completion (if wait) and process all available ones.
+ */
+static int
+h_reap (UringFile* file, int wait)
+{
+        UringReader* self = file->reader;
+        while (wait && syscall (__NR_io_uring_enter, self->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+        {
+                if (errno != EINTR)
+                {
+                        return -1;
+                }
+        }
+
+        unsigned head = *self->cq_head;
+        unsigned tail = __atomic_load_n (self->cq_tail, __ATOMIC_ACQUIRE);
+        int result = 0;
+        for (; head != tail; ++head)
+        {
+                struct io_uring_cqe* cqe = (struct io_uring_cqe*) self->cqes + (head & *self->cq_mask);
+                UringSlot* slot = &self->slots[cqe->user_data];
+                self->in_flight--;
+                if (cqe->res == -EAGAIN || cqe->res == -EINTR)
+                {
+                        result |= h_submit (file, (unsigned) cqe->user_data);
+                }
+                else if (cqe->res < 0)
+                {
+                        slot->error = -cqe->res;
+                        slot->done = 1;
+                }
+                else if (slot->read_begin + (size_t) cqe->res <= slot->filled)
+                {
+                        // end of file before filled (no new byte): the file shrank since fstat
+                        slot->size = slot->filled;
+                        slot->done = 1;
+                }
+                else
+                {
+                        slot->filled = slot->read_begin + (size_t) cqe->res;
+                        if (slot->filled >= slot->size)
+                        {
+                                slot->filled = slot->size;
+                                slot->done = 1;
+                        }
+                        else
+                        {
+                                // short read: request the rest into the same buffer
+                                result |= h_submit (file, (unsigned) cqe->user_data);
+                        }
+                }
+        }
+        __atomic_store_n (self->cq_head, head, __ATOMIC_RELEASE);
+        return result;
+}
+
+static int
+h_read_uring (UringFile* file, uint64_t file_size, UringChunkCallback callback, void* user_data)
+{
+        UringReader* self = file->reader;
+        uint64_t num_chunks = (file_size + self->buffer_size - 1) / self->buffer_size;
+        int result = 0;
+        int error = 0;
+
+        // chunk k is read into slot k % num_buffers
+        for (uint64_t k = 0; k < num_chunks && k < self->num_buffers && result == 0; ++k)
+        {
+                UringSlot* slot = &self->slots[k];
+                slot->offset = k * self->buffer_size;
+                slot->size = file_size - slot->offset < self->buffer_size ? (size_t) (file_size - slot->offset)
+                                                                          : self->buffer_size;
+                slot->filled = 0;
+                slot->done = 0;
+                slot->error = 0;
+                if (h_submit (file, (unsigned) k) != 0)
+                {
+                        error = errno;
+                        result = -1;
+                }
+        }
+
+        for (uint64_t k = 0; k < num_chunks && result == 0; ++k)
+        {
+                unsigned slot_id = (unsigned) (k % self->num_buffers);
+                UringSlot* slot = &self->slots[slot_id];
+                while (!slot->done && result == 0)
+                {
+                        if (h_reap (file, 1) != 0)
+                        {
+                                error = errno;
+                                result = -1;
+                        }
+                }
+                if (result != 0)
+                {
+                        break;
+                }
+                if (slot->error != 0)
+                {
+                        error = slot->error;
+                        result = -1;
+                        break;
+                }
+                if (callback (self->buffers + (size_t) slot_id * self->buffer_size, slot->filled, slot->offset,
+                              user_data) != 0)
+                {
+                        result = 1;
+                        break;
+                }
+                uint64_t next = k + self->num_buffers;
+                if (next < num_chunks)
+                {
+                        slot->offset = next * self->buffer_size;
+                        slot->size = file_size - slot->offset < self->buffer_size ? (size_t) (file_size - slot->offset)
+                                                                                  : self->buffer_size;
+                        slot->filled = 0;
+                        slot->done = 0;
+                        slot->error = 0;
+                        if (h_submit (file, slot_id) != 0)
+                        {
+                                error = errno;
+                                result = -1;
+                        }
+                }
+        }
+
+        // the kernel must not write into the buffers once they are reused
+        while (self->in_flight > 0)
+        {
+                if (h_reap (file, 1) != 0 && errno != EINTR)
+                {
+                        break;
+                }
+        }
+        errno = error;
+        return result;
+}
+#endif
+
+static int
+h_read_sync (UringFile* file, UringChunkCallback callback, void* user_data)
+{
+        UringReader* self = file->reader;
+        uint64_t offset = 0;
+        for (;;)
+        {
+                ssize_t n = pread (file->fd, self->buffers, self->buffer_size, (off_t) offset);
+                if (n < 0 && errno == EINTR)
+                {
+                        continue;
+                }
+                if (n < 0)
+                {
+                        return -1;
+                }
+                if (n == 0)
+                {
+                        return 0;
+                }
+                if (callback (self->buffers, (size_t) n, offset, user_data) != 0)
+                {
+                        return 1;
+                }
+                offset += (uint64_t) n;
+        }
+}
+
+/*
+ * Feed chunk to the SearchStream user_data. Stops reading (without stopping the stream) if chunk does not continue the
+ *  bytes fed so far: the stream offsets of later matches would be wrong.
+ */
+static int
+h_feed_stream (const char* chunk, size_t chunk_size, uint64_t offset, void* user_data)
+{
+        SearchStream* stream = user_data;
+        if (offset != stream->offset + stream->pending_size)
+        {
+                return 1;
+        }
+        return SearchStream_feed (stream, chunk, chunk_size);
+}
+
+// ____________________________________________________________________________
+
+int
+UringReader_init (UringReader* self, unsigned num_buffers, size_t buffer_size, int flags)
+{
+        memset (self, 0, sizeof (UringReader));
+        self->ring_fd = -1;
+        self->flags = flags;
+        self->num_buffers = num_buffers > 0 ? num_buffers : URING_READER_NUM_BUFFERS;
+        self->buffer_size = h_round_up (buffer_size > 0 ? buffer_size : URING_READER_BUFFER_SIZE, DIRECT_ALIGNMENT);
+        self->slots = calloc (self->num_buffers, sizeof (UringSlot));
+        void* buffers = NULL;
+        if (posix_memalign (&buffers, DIRECT_ALIGNMENT, (size_t) self->num_buffers * self->buffer_size) != 0)
+        {
+                buffers = NULL;
+        }
+        self->buffers = buffers;
+        if (self->slots == NULL || self->buffers == NULL)
+        {
+                free (self->slots);
+                free (self->buffers);
+                return -1;
+        }
+
+#if URING_SUPPORTED
+        self->entries = self->num_buffers;
+        if (h_setup (self) == 0 && h_probe_read (self))
+        {
+                h_register_buffers (self);
+        }
+        else
+        {
+                // e.g. kernel without io_uring or IORING_OP_READ, or forbidden by seccomp: keep the buffers for pread
+                h_close_ring (self);
+        }
+#endif
+        return 0;
+}
+
+int
+UringReader_read_file (UringReader* self, const char* path, UringChunkCallback callback, void* user_data)
+{
+        UringFile file;
+        file.reader = self;
+        file.direct = 0;
+        file.fd = -1;
+#ifdef O_DIRECT
+        if (self->flags & URING_READER_DIRECT)
+        {
+                file.fd = open (path, O_RDONLY | O_DIRECT);
+                file.direct = file.fd >= 0;
+        }
+#endif
+        // file system without O_DIRECT support: read through the page cache
+        if (file.fd < 0)
+        {
+                file.fd = open (path, O_RDONLY);
+        }
+        if (file.fd < 0)
+        {
+                return -1;
+        }
+
+        int result;
+#if URING_SUPPORTED
+        struct stat st;
+        if (self->ring_fd >= 0 && fstat (file.fd, &st) == 0 && S_ISREG (st.st_mode))
+        {
+                result = h_read_uring (&file, (uint64_t) st.st_size, callback, user_data);
+        }
+        else
+        {
+                result = h_read_sync (&file, callback, user_data);
+        }
+#else
+        result = h_read_sync (&file, callback, user_data);
+#endif
+        int error = errno;
+        close (file.fd);
+        errno = error;
+        return result;
+}
+
+int
+UringReader_search_file (UringReader* self, const char* path, const Searcher* searcher, StreamCallback callback,
+                         void* user_data)
+{
+        SearchStream stream;
+        if (SearchStream_begin (&stream, searcher, callback, user_data) != 0)
+        {
+                return -1;
+        }
+        int result = UringReader_read_file (self, path, h_feed_stream, &stream);
+        int error = errno;
+        // also releases the stream buffers if reading failed or was stopped
+        int stopped = SearchStream_end (&stream);
+        errno = error;
+        if (result == 1 && !stopped)
+        {
+                // stopped by h_feed_stream: a chunk did not continue the previous one
+                errno = EIO;
+                return -1;
+        }
+        return result == 0 && stopped ? 1 : result;
+}
+
+void
+UringReader_destroy (UringReader* self)
+{
+        h_close_ring (self);
+        free (self->slots);
+        free (self->buffers);
+        self->slots = NULL;
+        self->buffers = NULL;
+}
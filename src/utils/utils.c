@@ -10,3 +10,46 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
+
+void
+byte_freq_default (double* freq)
+{
+        // relative frequencies of english letters (a..z) in percent
+        static const double letters[26] = {8.2, 1.5, 2.8, 4.3, 12.7, 2.2, 2.0, 6.1, 7.0, 0.15, 0.77, 4.0, 2.4,
+                                           6.7, 7.5, 1.9, 0.095, 6.0, 6.3, 9.1, 2.8, 0.98, 2.4, 0.15, 2.0, 0.074};
+        double sum = 0;
+        for (int byte = 0; byte < 256; ++byte)
+        {
+                double weight = 0.01;
+                if (byte >= 'a' && byte <= 'z')
+                {
+                        weight = letters[byte - 'a'];
+                }
+                else if (byte >= 'A' && byte <= 'Z')
+                {
+                        weight = letters[byte - 'A'] * 0.1;
+                }
+                else if (byte >= '0' && byte <= '9')
+                {
+                        weight = 0.6;
+                }
+                else if (byte == ' ')
+                {
+                        weight = 15.0;
+                }
+                else if (byte == '\n')
+                {
+                        weight = 1.5;
+                }
+                else if (byte > ' ' && byte < 0x7f)
+                {
+                        weight = 0.2;
+                }
+                freq[byte] = weight;
+                sum += weight;
+        }
+        for (int byte = 0; byte < 256; ++byte)
+        {
+                freq[byte] /= sum;
+        }
+}
@@ -0,0 +1,280 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+
+#include <simdstr/column.h>
+
+#define NUM_ROWS 20000
+
+static char* data;
+static int32_t offsets[NUM_ROWS + 1];
+static StringColumn column;
+
+static void
+test_setup (void)
+{
+        data = malloc (NUM_ROWS * 100);
+        uint32_t state = 5;
+        const char* words[] = {"foo", "bar", "fo", "o", "baz ", "", "FOO", "xfoox", "ba", "foobarbazfoobarbaz"};
+        offsets[0] = 0;
+        for (size_t row = 0; row < NUM_ROWS; ++row)
+        {
+                size_t num_words = (test_random (&state) >> 16) % 6;
+                int32_t size = 0;
+                for (size_t w = 0; w < num_words; ++w)
+                {
+                        const char* word = words[(test_random (&state) >> 16) % 10];
+                        memcpy (data + offsets[row] + size, word, strlen (word));
+                        size += (int32_t) strlen (word);
+                }
+                offsets[row + 1] = offsets[row] + size;
+        }
+        StringColumn_init (&column, data, offsets, NUM_ROWS);
+}
+
+static void
+test_teardown (void)
+{
+        free (data);
+}
+
+static int
+naive_contains (const StringColumn* self, size_t row, const Pattern* patterns, size_t num_patterns)
+{
+        const char* str = self->data + self->offsets[row];
+        size_t size = (size_t) (self->offsets[row + 1] - self->offsets[row]);
+        for (size_t p = 0; p < num_patterns; ++p)
+        {
+                if (memmem (str, size, patterns[p].begin, patterns[p].size) != NULL)
+                {
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+static int
+check_contains (const StringColumn* self, const Searcher* searcher, const Pattern* patterns, size_t num_patterns,
+                size_t* num_selected)
+{
+        uint8_t bitmap[(NUM_ROWS + 7) / 8];
+        uint32_t rows[NUM_ROWS];
+        *num_selected = StringColumn_contains (self, searcher, bitmap);
+        if (StringColumn_contains_rows (self, searcher, rows) != *num_selected)
+        {
+                return 0;
+        }
+        size_t num_expected = 0;
+        for (size_t row = 0; row < self->num_rows; ++row)
+        {
+                int expected = naive_contains (self, row, patterns, num_patterns);
+                if (((bitmap[row / 8] >> (row % 8)) & 1) != expected || (expected && rows[num_expected++] != row))
+                {
+                        return 0;
+                }
+        }
+        return num_expected == *num_selected;
+}
+
+MU_TEST (row_of_test)
+{
+        // rows "ab", "", "", "c", "", "de"
+        int32_t row_offsets[] = {0, 2, 2, 2, 3, 3, 5};
+        StringColumn small;
+        StringColumn_init (&small, "abcde", row_offsets, 6);
+        size_t expected[] = {0, 0, 3, 5, 5};
+        for (size_t pos = 0; pos < 5; ++pos)
+        {
+                mu_assert_int_eq ((int) expected[pos], (int) StringColumn_row_of (&small, 0, pos));
+        }
+        mu_assert_int_eq (3, (int) StringColumn_row_of (&small, 3, 2));
+}
+
+MU_TEST (contains_test)
+{
+        size_t num_selected;
+        Searcher searcher;
+        Pattern foo = {"foo", 3};
+        Searcher_init_needle (&searcher, "foo", 3);
+        mu_check (check_contains (&column, &searcher, &foo, 1, &num_selected));
+        mu_check (num_selected > 1000 && num_selected < NUM_ROWS);
+
+        // "fo" + "o" and "ba" + "z" cross row ends in many places
+        Pattern patterns[3] = {{"oof", 3}, {"baz", 3}, {"ofo", 3}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 3, 3);
+        Searcher_init_slim_teddy (&searcher, &teddy);
+        mu_check (check_contains (&column, &searcher, patterns, 3, &num_selected));
+        mu_check (num_selected > 0);
+
+        // a slice: offsets not starting at 0
+        StringColumn slice;
+        StringColumn_init (&slice, data, offsets + 777, 5000);
+        Searcher_init_needle (&searcher, "foo", 3);
+        mu_check (check_contains (&slice, &searcher, &foo, 1, &num_selected));
+        StringColumn_init (&slice, data, offsets + 777, 0);
+        mu_check (check_contains (&slice, &searcher, &foo, 1, &num_selected));
+        mu_assert_int_eq (0, (int) num_selected);
+
+        // the leftmost match crosses the row end, a shorter pattern at the same offset does not
+        const char cross_data[] = "xxxxxxxxxxxxabcdyy";
+        const int32_t cross_offsets[3] = {0, 14, 18};
+        Pattern cross_patterns[2] = {{"abcd", 4}, {"ab", 2}};
+        StringColumn cross;
+        StringColumn_init (&cross, cross_data, cross_offsets, 2);
+        uint8_t bitmap;
+        for (int order = 0; order < 2; ++order)
+        {
+                SlimTeddy_init (&teddy, cross_patterns, 2, 2);
+                Searcher_init_slim_teddy (&searcher, &teddy);
+                mu_assert_int_eq (1, (int) StringColumn_contains (&cross, &searcher, &bitmap));
+                mu_assert_int_eq (1, bitmap);
+                Pattern swap = cross_patterns[0];
+                cross_patterns[0] = cross_patterns[1];
+                cross_patterns[1] = swap;
+        }
+
+        // long pattern, no row holds it
+        Pattern long_pattern = {"foobarbazfoobarbazfoobarbaz foo", 31};
+        Searcher_init_needle (&searcher, long_pattern.begin, long_pattern.size);
+        mu_check (check_contains (&column, &searcher, &long_pattern, 1, &num_selected));
+}
+
+MU_TEST (icase_test)
+{
+        Searcher searcher;
+        Searcher_init_needle_icase (&searcher, "foo", 3);
+        uint8_t bitmap[(NUM_ROWS + 7) / 8];
+        size_t num_icase = StringColumn_contains (&column, &searcher, bitmap);
+        Pattern patterns[2] = {{"foo", 3}, {"FOO", 3}};
+        size_t num_selected;
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 2, 3);
+        Searcher_init_slim_teddy (&searcher, &teddy);
+        mu_check (check_contains (&column, &searcher, patterns, 2, &num_selected));
+        mu_assert_int_eq ((int) num_selected, (int) num_icase);
+}
+
+static int
+naive_eval (StringPredicateKind kind, const char* str, size_t size, const char* needle, size_t needle_size, int icase)
+{
+        int (*compare) (const char*, const char*, size_t) = icase ? (int (*) (const char*, const char*, size_t)) strncasecmp
+                                                                  : (int (*) (const char*, const char*, size_t)) memcmp;
+        switch (kind)
+        {
+                case STRING_PREDICATE_STARTS_WITH:
+                        return size >= needle_size && compare (str, needle, needle_size) == 0;
+                case STRING_PREDICATE_ENDS_WITH:
+                        return size >= needle_size && compare (str + size - needle_size, needle, needle_size) == 0;
+                case STRING_PREDICATE_EQUALS:
+                        return size == needle_size && compare (str, needle, needle_size) == 0;
+                case STRING_PREDICATE_CONTAINS:
+                        for (size_t pos = 0; pos + needle_size <= size; ++pos)
+                        {
+                                if (compare (str + pos, needle, needle_size) == 0)
+                                {
+                                        return 1;
+                                }
+                        }
+                        return 0;
+        }
+        return 0;
+}
+
+MU_TEST (predicate_test)
+{
+        const char* needles[] = {"", "fo", "foo", "baz foo", "bar", "barbazfoo", "FOOBARBAZFOOBARB",
+                                 "foobarbazfoobarbaz", "barbazfoobarbazfoobarbazfoobarbaz", "bazfoobarbazfoobarbazfoobarbaz foobarbaz"};
+        uint8_t bitmap[(NUM_ROWS + 7) / 8];
+        uint8_t strings_bitmap[(NUM_ROWS + 7) / 8];
+        Pattern* strings = malloc (NUM_ROWS * sizeof (Pattern));
+        for (size_t row = 0; row < NUM_ROWS; ++row)
+        {
+                strings[row].begin = data + offsets[row];
+                strings[row].size = (uint64_t) (offsets[row + 1] - offsets[row]);
+        }
+        for (int kind = STRING_PREDICATE_STARTS_WITH; kind <= STRING_PREDICATE_CONTAINS; ++kind)
+        {
+                for (size_t n = 0; n < sizeof (needles) / sizeof (needles[0]); ++n)
+                {
+                        for (int icase = 0; icase < 2; ++icase)
+                        {
+                                StringPredicate predicate;
+                                StringPredicate_init (&predicate, (StringPredicateKind) kind, needles[n], strlen (needles[n]), icase);
+                                size_t num_selected = StringPredicate_column (&predicate, &column, bitmap);
+                                mu_check (StringPredicate_strings (&predicate, strings, NUM_ROWS, strings_bitmap) == num_selected);
+                                size_t num_expected = 0;
+                                int equal = memcmp (bitmap, strings_bitmap, sizeof (bitmap)) == 0;
+                                for (size_t row = 0; row < NUM_ROWS; ++row)
+                                {
+                                        int expected = naive_eval ((StringPredicateKind) kind, strings[row].begin, strings[row].size,
+                                                                   needles[n], strlen (needles[n]), icase);
+                                        equal &= ((bitmap[row / 8] >> (row % 8)) & 1) == expected;
+                                        num_expected += expected;
+                                }
+                                mu_check (equal);
+                                mu_assert_int_eq ((int) num_expected, (int) num_selected);
+                        }
+                }
+        }
+        free (strings);
+}
+
+MU_TEST (page_test)
+{
+        // strings ending right before an inaccessible page
+        char* pages = mmap (NULL, 2 * 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        mu_check (pages != MAP_FAILED);
+        mprotect (pages + 4096, 4096, PROT_NONE);
+        memcpy (pages + 4096 - 40, "prefix of a string near the page end", 37);
+        memcpy (pages + 4096 - 3, "end", 3);
+        Pattern strings[3] = {{pages + 4096 - 40, 36}, {pages + 4096 - 3, 3}, {pages + 4096 - 10, 10}};
+        uint8_t bitmap;
+        StringPredicate predicate;
+        StringPredicate_init (&predicate, STRING_PREDICATE_STARTS_WITH, "end", 3, 0);
+        mu_assert_int_eq (1, (int) StringPredicate_strings (&predicate, strings, 3, &bitmap));
+        mu_assert_int_eq (2, bitmap);
+        StringPredicate_init (&predicate, STRING_PREDICATE_ENDS_WITH, "page end", 8, 1);
+        mu_assert_int_eq (1, (int) StringPredicate_strings (&predicate, strings, 3, &bitmap));
+        mu_assert_int_eq (1, bitmap);
+        StringPredicate_init (&predicate, STRING_PREDICATE_EQUALS, "PREFIX OF A STRING NEAR THE PAGE END", 36, 1);
+        mu_assert_int_eq (1, (int) StringPredicate_strings (&predicate, strings, 3, &bitmap));
+        StringPredicate_init (&predicate, STRING_PREDICATE_ENDS_WITH, "end", 3, 0);
+        mu_assert_int_eq (2, (int) StringPredicate_strings (&predicate, strings + 1, 2, &bitmap));
+        StringPredicate_init (&predicate, STRING_PREDICATE_EQUALS, "GE END\0end", 10, 1);
+        mu_assert_int_eq (1, (int) StringPredicate_strings (&predicate, strings, 3, &bitmap));
+        mu_assert_int_eq (4, bitmap);
+        munmap (pages, 2 * 4096);
+}
+
+MU_TEST_SUITE (column_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (row_of_test);
+        MU_RUN_TEST (contains_test);
+        MU_RUN_TEST (icase_test);
+        MU_RUN_TEST (predicate_test);
+        MU_RUN_TEST (page_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (column_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
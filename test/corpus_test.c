@@ -0,0 +1,223 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <simdstr/corpus.h>
+
+#define NUM_FILES 4
+#define PIECE_SIZE 4096
+
+static char root[64];
+static char paths[NUM_FILES][128];
+static char* contents[NUM_FILES];
+static size_t sizes[NUM_FILES] = {64, 200000, 0, 100003};
+static ThreadPool pool;
+
+typedef struct {
+        const Searcher* searcher;
+        size_t num_calls;
+        size_t stop_after;
+        int order_ok;
+        int matches_ok;
+        int errors[NUM_FILES + 1];
+} Collector;
+
+static void
+test_setup (void)
+{
+        strcpy (root, "/tmp/corpus_testXXXXXX");
+        mkdtemp (root);
+        char dir[128];
+        snprintf (dir, sizeof (dir), "%s/b", root);
+        mkdir (dir, 0700);
+        const char* names[NUM_FILES] = {"a.txt", "b/c.txt", "b/d.txt", "e.txt"};
+        uint32_t state = 3;
+        for (int i = 0; i < NUM_FILES; ++i)
+        {
+                snprintf (paths[i], sizeof (paths[i]), "%s/%s", root, names[i]);
+                contents[i] = malloc (sizes[i] + 1);
+                test_random_text (contents[i], sizes[i], "abcdefgh ", 9, &state);
+                // needles at the file start and end and across piece boundaries
+                for (size_t pos = 0; pos + 8 <= sizes[i]; pos += PIECE_SIZE - 3)
+                {
+                        memcpy (contents[i] + pos, "needle42", 8);
+                }
+                if (sizes[i] >= 8)
+                {
+                        memcpy (contents[i] + sizes[i] - 8, "needle42", 8);
+                }
+                // needles starting at a piece start and ending at the end of the bytes read for a piece, inside words
+                for (size_t pos = PIECE_SIZE; pos + PIECE_SIZE + 8 <= sizes[i]; pos += 3 * PIECE_SIZE)
+                {
+                        memcpy (contents[i] + pos - 1, "xneedle42", 9);
+                        memcpy (contents[i] + pos + PIECE_SIZE - 1, "needle42x", 9);
+                }
+                FILE* file = fopen (paths[i], "wb");
+                fwrite (contents[i], 1, sizes[i], file);
+                fclose (file);
+        }
+        ThreadPool_init (&pool, 3, NULL, NULL);
+}
+
+static void
+test_teardown (void)
+{
+        ThreadPool_destroy (&pool);
+        for (int i = 0; i < NUM_FILES; ++i)
+        {
+                unlink (paths[i]);
+                free (contents[i]);
+        }
+        char dir[128];
+        snprintf (dir, sizeof (dir), "%s/b", root);
+        rmdir (dir);
+        rmdir (root);
+}
+
+static int
+collect (const CorpusFileResult* result, void* user_data)
+{
+        Collector* collector = user_data;
+        size_t file_id = collector->num_calls++;
+        collector->order_ok &= result->file_id == file_id;
+        collector->errors[file_id < NUM_FILES ? file_id : NUM_FILES] = result->error;
+        if (result->error != 0)
+        {
+                return 0;
+        }
+        collector->order_ok &= strcmp (result->path, paths[file_id]) == 0;
+
+        // compare with a sequential search of the file
+        size_t num_matches = 0;
+        size_t pos = 0;
+        for (;;)
+        {
+                Match match = Searcher_find_from (collector->searcher, contents[file_id], sizes[file_id], pos);
+                if (match.pattern_id < 0)
+                {
+                        break;
+                }
+                uint64_t begin = (uint64_t) (match.begin - contents[file_id]);
+                if (num_matches >= result->num_matches || result->matches[num_matches].begin != begin ||
+                    result->matches[num_matches].pattern_id != match.pattern_id)
+                {
+                        collector->matches_ok = 0;
+                }
+                num_matches++;
+                pos = (size_t) begin + 1;
+        }
+        collector->matches_ok &= num_matches == result->num_matches;
+        return collector->num_calls == collector->stop_after;
+}
+
+static void
+collector_init (Collector* collector, const Searcher* searcher, size_t stop_after)
+{
+        memset (collector, 0, sizeof (Collector));
+        collector->searcher = searcher;
+        collector->stop_after = stop_after;
+        collector->order_ok = 1;
+        collector->matches_ok = 1;
+}
+
+MU_TEST (list_test)
+{
+        char** list;
+        size_t num_paths;
+        mu_assert_int_eq (0, corpus_list_files (root, &list, &num_paths));
+        mu_assert_int_eq (NUM_FILES, (int) num_paths);
+        for (size_t i = 0; i < num_paths && i < NUM_FILES; ++i)
+        {
+                mu_check (strcmp (list[i], paths[i]) == 0);
+        }
+        corpus_free_file_list (list, num_paths);
+        mu_assert_int_eq (-1, corpus_list_files ("/nonexistent", &list, &num_paths));
+}
+
+MU_TEST (search_directory_test)
+{
+        Pattern patterns[2] = {{"needle42", 8}, {"hgfedcba", 8}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 2, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+
+        size_t piece_sizes[] = {PIECE_SIZE, 0};
+        for (int i = 0; i < 2; ++i)
+        {
+                Collector collector;
+                collector_init (&collector, &searcher, 0);
+                mu_assert_int_eq (0, corpus_search_directory (&pool, &searcher, root, piece_sizes[i], collect, &collector));
+                mu_assert_int_eq (NUM_FILES, (int) collector.num_calls);
+                mu_check (collector.order_ok);
+                mu_check (collector.matches_ok);
+        }
+}
+
+MU_TEST (search_files_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "needle42", 8);
+        const char* files[3] = {paths[3], "/nonexistent/file", paths[1]};
+
+        Collector collector;
+        collector_init (&collector, &searcher, 0);
+        mu_assert_int_eq (0, corpus_search_files (&pool, &searcher, files, 3, PIECE_SIZE, collect, &collector));
+        mu_assert_int_eq (3, (int) collector.num_calls);
+        mu_assert_int_eq (ENOENT, collector.errors[1]);
+
+        // stop after the second file
+        collector_init (&collector, &searcher, 2);
+        mu_assert_int_eq (0, corpus_search_directory (&pool, &searcher, root, PIECE_SIZE, collect, &collector));
+        mu_assert_int_eq (2, (int) collector.num_calls);
+        mu_check (collector.matches_ok);
+}
+
+MU_TEST (search_flags_test)
+{
+        // piece seams and the read windows inside pieces must not look like word boundaries
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "needle42", 8);
+        uint32_t flags[2] = {SEARCH_WORD, SEARCH_BUFFER_START | SEARCH_BUFFER_END};
+        for (int i = 0; i < 2; ++i)
+        {
+                Searcher_set_flags (&searcher, flags[i]);
+                Collector collector;
+                collector_init (&collector, &searcher, 0);
+                mu_assert_int_eq (0, corpus_search_directory (&pool, &searcher, root, PIECE_SIZE, collect, &collector));
+                mu_assert_int_eq (NUM_FILES, (int) collector.num_calls);
+                mu_check (collector.matches_ok);
+        }
+}
+
+MU_TEST_SUITE (corpus_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (list_test);
+        MU_RUN_TEST (search_directory_test);
+        MU_RUN_TEST (search_files_test);
+        MU_RUN_TEST (search_flags_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (corpus_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
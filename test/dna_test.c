@@ -0,0 +1,172 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/dna.h>
+
+#define TEXT_SIZE 8011
+
+static char* text;
+static DnaText dna;
+
+static uint32_t
+next (uint32_t* state)
+{
+        return test_random (state) >> 8;
+}
+
+static void
+test_setup (void)
+{
+        uint32_t state = 7;
+        text = malloc (TEXT_SIZE);
+        for (size_t idx = 0; idx < TEXT_SIZE; ++idx)
+        {
+                text[idx] = "ACGTacgt"[next (&state) % 8];
+        }
+        DnaText_init (&dna, text, TEXT_SIZE);
+}
+
+static void
+test_teardown (void)
+{
+        DnaText_destroy (&dna);
+        free (text);
+}
+
+static size_t
+code (char c)
+{
+        switch (c | 0x20)
+        {
+                case 'a': return 0;
+                case 'c': return 1;
+                case 't': return 2;
+                default: return 3;
+        }
+}
+
+static int
+naive_match (const char* pattern, size_t size, size_t pos, size_t max_mismatches)
+{
+        size_t mismatches = 0;
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+                mismatches += code (text[pos + idx]) != code (pattern[idx]);
+        }
+        return mismatches <= max_mismatches;
+}
+
+MU_TEST (pack_test)
+{
+        uint64_t words[3];
+        mu_assert_int_eq (0, (int) dna_pack ("ACTGacgt", 8, words));
+        mu_check (words[0] == (0 | 1 << 2 | 2 << 4 | 3 << 6 | 0 << 8 | 1 << 10 | 3 << 12 | 2 << 14));
+
+        // packed text against the scalar codes
+        int equal = 1;
+        for (size_t idx = 0; idx < TEXT_SIZE; ++idx)
+        {
+                equal &= (dna.words[idx / 32] >> (2 * (idx % 32)) & 3) == code (text[idx]);
+        }
+        mu_check (equal);
+        mu_check (dna.words[TEXT_SIZE / 32] >> (2 * (TEXT_SIZE % 32)) == 0);
+        mu_assert_int_eq (0, (int) dna.num_invalid);
+
+        const char* invalid = "ACGTNNACGTACGTACGTACGTACGTACGTACGTACGTACGTAC\nGT";
+        mu_assert_int_eq (3, (int) dna_pack (invalid, strlen (invalid), words));
+        mu_assert_int_eq (0, (int) dna_pack ("", 0, words));
+}
+
+MU_TEST (find_test)
+{
+        uint32_t state = 11;
+        char pattern[80];
+        int equal = 1;
+        size_t num_found = 0;
+        for (size_t round = 0; round < 120; ++round)
+        {
+                // text excerpts (with mutations) of 1 ... 80 bases
+                size_t size = 1 + next (&state) % 80;
+                size_t source = next (&state) % (TEXT_SIZE - size);
+                memcpy (pattern, text + source, size);
+                for (size_t mutations = next (&state) % 4; mutations > 0; --mutations)
+                {
+                        pattern[next (&state) % size] = "ACGT"[next (&state) % 4];
+                }
+                size_t max_mismatches = next (&state) % 4;
+                size_t from = next (&state) % 3 == 0 ? next (&state) % TEXT_SIZE : 0;
+                DnaPattern packed;
+                mu_assert_int_eq (0, DnaPattern_init (&packed, pattern, size));
+
+                int64_t expected = -1;
+                size_t count = 0;
+                for (size_t pos = 0; pos + size <= TEXT_SIZE; ++pos)
+                {
+                        if (naive_match (pattern, size, pos, max_mismatches))
+                        {
+                                count++;
+                                expected = expected < 0 && pos >= from ? (int64_t) pos : expected;
+                        }
+                }
+                equal &= DnaText_find_from (&dna, &packed, max_mismatches, from) == expected;
+                equal &= DnaText_count (&dna, &packed, max_mismatches) == count;
+                num_found += expected >= 0;
+                DnaPattern_destroy (&packed);
+        }
+        mu_check (equal);
+        mu_check (num_found > 40);
+}
+
+MU_TEST (edge_test)
+{
+        DnaPattern pattern;
+        DnaText small;
+        mu_assert_int_eq (0, DnaText_init (&small, "ACGTTGCA", 8));
+
+        mu_assert_int_eq (0, DnaPattern_init (&pattern, "TGCA", 4));
+        mu_assert_int_eq (4, (int) DnaText_find_from (&small, &pattern, 0, 0));
+        mu_assert_int_eq (4, (int) DnaText_find_from (&small, &pattern, 0, 4));
+        mu_assert_int_eq (-1, (int) DnaText_find_from (&small, &pattern, 0, 5));
+        mu_assert_int_eq (-1, (int) DnaText_find_from (&small, &pattern, 0, 100));
+        // every position matches with 4 mismatches
+        mu_assert_int_eq (5, (int) DnaText_count (&small, &pattern, 4));
+        DnaPattern_destroy (&pattern);
+
+        mu_assert_int_eq (0, DnaPattern_init (&pattern, "", 0));
+        mu_assert_int_eq (3, (int) DnaText_find_from (&small, &pattern, 0, 3));
+        mu_assert_int_eq (9, (int) DnaText_count (&small, &pattern, 0));
+        DnaPattern_destroy (&pattern);
+
+        mu_assert_int_eq (0, DnaPattern_init (&pattern, "ACGTTGCAA", 9));
+        mu_assert_int_eq (-1, (int) DnaText_find_from (&small, &pattern, 2, 0));
+        mu_assert_int_eq (0, (int) DnaText_count (&small, &pattern, 2));
+        DnaPattern_destroy (&pattern);
+        DnaText_destroy (&small);
+}
+
+MU_TEST_SUITE (dna_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (pack_test);
+        MU_RUN_TEST (find_test);
+        MU_RUN_TEST (edge_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (dna_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
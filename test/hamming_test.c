@@ -0,0 +1,150 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/hamming.h>
+
+#define TEXT_SIZE 30000
+
+typedef const char* (*HammingSearch) (const char*, size_t, const char*, size_t, size_t);
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 23;
+        test_random_text (text, TEXT_SIZE, "ACGT", 4, &state);
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+static const char*
+naive_search (const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k)
+{
+        for (size_t start = 0; start + needle_len <= str_len; ++start)
+        {
+                size_t distance = 0;
+                for (size_t i = 0; i < needle_len; ++i)
+                {
+                        distance += str[start + i] != needle[i];
+                }
+                if (distance <= k)
+                {
+                        return str + start;
+                }
+        }
+        return NULL;
+}
+
+/*
+ * All occurrences reported by search (resuming behind every occurrence) equal the naive ones.
+ */
+static int
+check_search (HammingSearch search, const char* str, size_t str_len, const char* needle, size_t needle_len, size_t k,
+              size_t* num_matches)
+{
+        *num_matches = 0;
+        size_t from = 0;
+        for (;;)
+        {
+                const char* expected = naive_search (str + from, str_len - from, needle, needle_len, k);
+                const char* found = search (str + from, str_len - from, needle, needle_len, k);
+                if (found != expected)
+                {
+                        return 0;
+                }
+                if (found == NULL)
+                {
+                        return 1;
+                }
+                (*num_matches)++;
+                from = (size_t) (found - str) + 1;
+        }
+}
+
+MU_TEST (distance_test)
+{
+        mu_assert_int_eq (0, (int) hamming_distance (text, text, TEXT_SIZE));
+        mu_assert_int_eq (2, (int) hamming_distance ("kitten", "sitted", 6));
+        // blocks and tail
+        char a[100];
+        char b[100];
+        memset (a, 'x', 100);
+        memset (b, 'x', 100);
+        b[0] = b[31] = b[32] = b[99] = 'y';
+        mu_assert_int_eq (4, (int) hamming_distance (a, b, 100));
+}
+
+MU_TEST (kernel_test)
+{
+        HammingSearch searches[4] = {simd_hamming_search, simd_hamming_search_avx_32, simd_hamming_search_avx_64,
+                                     simd_hamming_search_pigeonhole};
+        // needle length and k: short and long needles (blocks of the verifier), small and large k/m
+        size_t configs[][2] = {{5, 1}, {8, 2}, {12, 3}, {20, 4}, {40, 9}, {70, 20}, {16, 1}, {33, 7}};
+        for (size_t s = 0; s < 4; ++s)
+        {
+                for (size_t c = 0; c < sizeof (configs) / sizeof (configs[0]); ++c)
+                {
+                        size_t needle_len = configs[c][0];
+                        size_t k = configs[c][1];
+                        // a needle occurring approximately: a text window with a few substitutions
+                        char needle[70];
+                        memcpy (needle, text + 12345, needle_len);
+                        needle[needle_len / 2] = 'X';
+                        size_t num_matches;
+                        mu_check (check_search (searches[s], text, TEXT_SIZE, needle, needle_len, k, &num_matches));
+                        mu_check (num_matches > 0);
+                        // short haystacks: tails only
+                        mu_check (check_search (searches[s], text + 12300, 100, needle, needle_len, k, &num_matches));
+                }
+        }
+}
+
+MU_TEST (edge_test)
+{
+        char str[] = "product code AB-1234-XY and AB-1294-XZ";
+        mu_check (simd_hamming_search (str, strlen (str), "AB-1294-XY", 10, 0) == NULL);
+        mu_check (simd_hamming_search (str, strlen (str), "AB-1294-XY", 10, 1) == str + 13);
+        mu_check (simd_hamming_search (str + 14, strlen (str) - 14, "AB-1294-XY", 10, 1) == str + 28);
+        // k >= needle_len matches everywhere, needles longer than the haystack never
+        mu_check (simd_hamming_search_avx_32 (str, strlen (str), "zzz", 3, 3) == str);
+        mu_check (simd_hamming_search_avx_64 (str, 2, "zzz", 3, 5) == NULL);
+        // k beyond the 8 bit counters
+        char long_needle[600];
+        memcpy (long_needle, text + 100, 600);
+        memset (long_needle, 'N', 300);
+        mu_check (simd_hamming_search_avx_32 (text, TEXT_SIZE, long_needle, 600, 300) == text + 100);
+        mu_check (simd_hamming_search_avx_32 (text, TEXT_SIZE, long_needle, 600, 254) == NULL);
+        mu_check (simd_hamming_search_avx_64 (text, TEXT_SIZE, long_needle, 600, 254) == NULL);
+}
+
+MU_TEST_SUITE (hamming_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (distance_test);
+        MU_RUN_TEST (kernel_test);
+        MU_RUN_TEST (edge_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (hamming_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
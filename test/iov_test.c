@@ -0,0 +1,91 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+
+#include <simdstr/iov.h>
+
+static char message[] = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nSet-Cookie: session=deadbeef\r\n\r\n<html>secret</html>";
+
+MU_TEST (needle_across_segments_test)
+{
+        size_t size = strlen (message);
+        size_t expected = (size_t) (strstr (message, "session=deadbeef") - message);
+
+        // split the message at every possible position into three segments
+        for (size_t fst = 0; fst < size; ++fst)
+        {
+                for (size_t snd = fst; snd < size; snd += 7)
+                {
+                        struct iovec iov[3] = {{message, fst}, {message + fst, snd - fst}, {message + snd, size - snd}};
+                        StreamMatch match;
+                        mu_check (simd_strstr_iov (iov, 3, "session=deadbeef", 16, &match));
+                        mu_assert_int_eq ((int) expected, (int) match.begin);
+                }
+        }
+
+        struct iovec iov[2] = {{message, 60}, {message + 60, size - 60}};
+        StreamMatch match;
+        mu_check (!simd_strstr_iov (iov, 2, "session=cafe", 12, &match));
+}
+
+MU_TEST (teddy_test)
+{
+        Pattern patterns[3] = {{"secret", 6}, {"password", 8}, {"deadbeef", 8}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 3, 1);
+
+        size_t size = strlen (message);
+        size_t expected = (size_t) (strstr (message, "deadbeef") - message);
+        for (size_t split = 0; split < size; ++split)
+        {
+                struct iovec iov[2] = {{message, split}, {message + split, size - split}};
+                StreamMatch match;
+                mu_check (SlimTeddy_find_iov (&teddy, iov, 2, &match));
+                mu_assert_int_eq (2, match.pattern_id);
+                mu_assert_int_eq ((int) expected, (int) match.begin);
+
+                size_t segment_offset;
+                int segment = iov_locate (iov, 2, match.begin, &segment_offset);
+                mu_assert_int_eq (expected < split ? 0 : 1, segment);
+                mu_assert_int_eq ((int) (expected < split ? expected : expected - split), (int) segment_offset);
+        }
+}
+
+MU_TEST (ring_test)
+{
+        char ring[32];
+        const char* data = "xxxx needle yyyy";
+        size_t head = 26;
+        for (size_t i = 0; i < 16; ++i)
+        {
+                ring[(head + i) % 32] = data[i];
+        }
+
+        struct iovec iov[2];
+        int iovcnt = iov_from_ring (iov, ring, 32, head, 16);
+        mu_assert_int_eq (2, iovcnt);
+
+        StreamMatch match;
+        mu_check (simd_strstr_iov (iov, iovcnt, "needle", 6, &match));
+        mu_assert_int_eq (5, (int) match.begin);
+}
+
+MU_TEST_SUITE (iov_test)
+{
+        MU_RUN_TEST (needle_across_segments_test);
+        MU_RUN_TEST (teddy_test);
+        MU_RUN_TEST (ring_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (iov_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <simdstr/keyword_dict.h>
+
+#define NUM_KEYWORDS 5000
+#define NUM_TOKENS 20000
+
+static char keyword_text[NUM_KEYWORDS][KEYWORD_DICT_MAX_SIZE];
+static Pattern keywords[NUM_KEYWORDS];
+static KeywordDict dict;
+
+static uint32_t
+next (uint32_t* state)
+{
+        return test_random (state) >> 8;
+}
+
+static void
+test_setup (void)
+{
+        uint32_t state = 5;
+        for (size_t idx = 0; idx < NUM_KEYWORDS; ++idx)
+        {
+                // mostly short identifiers over a small alphabet, so that many keywords share a size
+                size_t size = next (&state) % 4 == 0 ? 1 + next (&state) % KEYWORD_DICT_MAX_SIZE : 2 + next (&state) % 8;
+                for (size_t pos = 0; pos < size; ++pos)
+                {
+                        keyword_text[idx][pos] = "etaoinshrd_"[next (&state) % 11];
+                }
+                keywords[idx].begin = keyword_text[idx];
+                keywords[idx].size = size;
+        }
+        mu_check (KeywordDict_init (&dict, keywords, NUM_KEYWORDS) == 0);
+}
+
+static void
+test_teardown (void)
+{
+        KeywordDict_destroy (&dict);
+}
+
+static int32_t
+naive_find (const char* str, size_t str_size)
+{
+        for (size_t idx = 0; idx < NUM_KEYWORDS; ++idx)
+        {
+                if (keywords[idx].size == str_size && memcmp (keywords[idx].begin, str, str_size) == 0)
+                {
+                        return (int32_t) idx;
+                }
+        }
+        return -1;
+}
+
+MU_TEST (find_test)
+{
+        // keywords (possibly with a changed byte) and random tokens, embedded in a text so that loads read on
+        char* text = malloc (NUM_TOKENS * 40 + 32);
+        Pattern* tokens = malloc (NUM_TOKENS * sizeof (Pattern));
+        int32_t* ids = malloc (NUM_TOKENS * sizeof (int32_t));
+        uint32_t state = 9;
+        char* pos = text;
+        for (size_t idx = 0; idx < NUM_TOKENS; ++idx)
+        {
+                const Pattern* keyword = &keywords[next (&state) % NUM_KEYWORDS];
+                size_t size = next (&state) % 3 == 0 ? next (&state) % 40 : keyword->size;
+                memcpy (pos, keyword->begin, keyword->size < size ? keyword->size : size);
+                for (size_t rest = keyword->size; rest < size; ++rest)
+                {
+                        pos[rest] = "etaoinshrd_"[next (&state) % 11];
+                }
+                if (size > 0 && next (&state) % 4 == 0)
+                {
+                        pos[next (&state) % size] = "etaoinshrd_"[next (&state) % 11];
+                }
+                pos[size] = ' ';
+                tokens[idx].begin = pos;
+                tokens[idx].size = size;
+                pos += size + 1;
+        }
+
+        int equal = 1;
+        size_t num_found = 0;
+        KeywordDict_find_all (&dict, tokens, NUM_TOKENS, ids);
+        for (size_t idx = 0; idx < NUM_TOKENS; ++idx)
+        {
+                int32_t expected = naive_find (tokens[idx].begin, tokens[idx].size);
+                equal &= KeywordDict_find (&dict, tokens[idx].begin, tokens[idx].size) == expected;
+                equal &= ids[idx] == expected;
+                num_found += expected >= 0;
+        }
+        mu_check (equal);
+        mu_check (num_found > NUM_TOKENS / 2);
+        mu_check (num_found < NUM_TOKENS);
+
+        // every keyword finds itself (or its lowest duplicate)
+        for (size_t idx = 0; idx < NUM_KEYWORDS; ++idx)
+        {
+                equal &= KeywordDict_find (&dict, keywords[idx].begin, keywords[idx].size) ==
+                         naive_find (keywords[idx].begin, keywords[idx].size);
+        }
+        mu_check (equal);
+        free (text);
+        free (tokens);
+        free (ids);
+}
+
+MU_TEST (edge_test)
+{
+        Pattern set[6] = {{"while", 5}, {"", 0}, {"for", 3}, {"while", 5}, {"0123456789abcdef0123456789abcdef", 32},
+                          {NULL, 0}};
+        // tokens are read in 32 byte vectors
+        char text[64] = "for(while whilE 0123456789abcdef0123456789abcdef!";
+        KeywordDict small;
+        // the empty keyword also given with a NULL begin (a duplicate of keyword 1)
+        mu_assert_int_eq (0, KeywordDict_init (&small, set, 6));
+        mu_assert_int_eq (0, KeywordDict_find (&small, text + 4, 5));
+        mu_assert_int_eq (1, KeywordDict_find (&small, text, 0));
+        mu_assert_int_eq (1, KeywordDict_find (&small, NULL, 0));
+        mu_assert_int_eq (2, KeywordDict_find (&small, text, 3));
+        mu_assert_int_eq (-1, KeywordDict_find (&small, text, 4));
+        mu_assert_int_eq (-1, KeywordDict_find (&small, text + 10, 5));
+        mu_assert_int_eq (4, KeywordDict_find (&small, text + 16, 32));
+        mu_assert_int_eq (-1, KeywordDict_find (&small, text + 16, 33));
+        KeywordDict_destroy (&small);
+
+        // no keywords, keywords longer than KEYWORD_DICT_MAX_SIZE
+        mu_assert_int_eq (0, KeywordDict_init (&small, set, 0));
+        mu_assert_int_eq (-1, KeywordDict_find (&small, text, 3));
+        mu_assert_int_eq (-1, KeywordDict_find (&small, text, 0));
+        KeywordDict_destroy (&small);
+        Pattern long_keyword = {"0123456789abcdef0123456789abcdef!", 33};
+        mu_assert_int_eq (-1, KeywordDict_init (&small, &long_keyword, 1));
+}
+
+MU_TEST (page_test)
+{
+        // tokens ending right before an inaccessible page
+        char* pages = mmap (NULL, 2 * 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        mu_check (pages != MAP_FAILED);
+        mprotect (pages + 4096, 4096, PROT_NONE);
+        memcpy (pages + 4096 - 5, "while", 5);
+        memcpy (pages + 4096 - 40, "0123456789abcdef0123456789abcdef", 32);
+        Pattern set[2] = {{"while", 5}, {"0123456789abcdef0123456789abcdef", 32}};
+        Pattern tokens[3] = {{pages + 4096 - 5, 5}, {pages + 4096 - 40, 32}, {pages + 4096 - 3, 3}};
+        int32_t ids[3];
+        KeywordDict small;
+        mu_assert_int_eq (0, KeywordDict_init (&small, set, 2));
+        KeywordDict_find_all (&small, tokens, 3, ids);
+        mu_check (ids[0] == 0 && ids[1] == 1 && ids[2] == -1);
+        KeywordDict_destroy (&small);
+        munmap (pages, 2 * 4096);
+}
+
+MU_TEST_SUITE (keyword_dict_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (find_test);
+        MU_RUN_TEST (edge_test);
+        MU_RUN_TEST (page_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (keyword_dict_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/line_filter.h>
+
+#define TEXT_SIZE 200000
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 9;
+        for (size_t i = 0; i < TEXT_SIZE; ++i)
+        {
+                test_random (&state);
+                text[i] = (state >> 16) % 30 == 0 ? '\n' : "abcdefgh "[(state >> 20) % 9];
+        }
+        // dense matches, several per line, a match at the very start and end, a match crossing a newline
+        for (size_t pos = 0; pos + 3 <= TEXT_SIZE; pos += 97)
+        {
+                memcpy (text + pos, "ERR", 3);
+        }
+        memcpy (text + TEXT_SIZE - 4, "WARN", 4);
+        memcpy (text + 1000, "WA\nRN", 5);
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+/*
+ * Naive filter: every line containing a match.
+ */
+static size_t
+naive_filter (const Searcher* searcher, LineRange* lines, size_t capacity)
+{
+        size_t num_lines = 0;
+        size_t begin = 0;
+        while (begin < TEXT_SIZE)
+        {
+                char* newline = memchr (text + begin, '\n', TEXT_SIZE - begin);
+                size_t end = newline != NULL ? (size_t) (newline - text) : TEXT_SIZE;
+                // matches starting in the line (they may extend past its end)
+                Match match = Searcher_find (searcher, text + begin, TEXT_SIZE - begin);
+                if (match.pattern_id >= 0 && match.begin < text + end)
+                {
+                        if (num_lines < capacity)
+                        {
+                                lines[num_lines].begin = begin;
+                                lines[num_lines].end = end;
+                        }
+                        num_lines++;
+                }
+                begin = end + 1;
+        }
+        return num_lines;
+}
+
+static void
+check_filter (const Searcher* searcher, size_t batch_size, int* ok, size_t* num_lines)
+{
+        static LineRange expected[TEXT_SIZE / 4];
+        size_t num_expected = naive_filter (searcher, expected, TEXT_SIZE / 4);
+
+        LineFilter filter;
+        LineFilter_init (&filter, searcher, text, TEXT_SIZE);
+        LineRange lines[7];
+        size_t total = 0;
+        size_t n;
+        *ok = 1;
+        while ((n = LineFilter_next (&filter, lines, batch_size)) > 0)
+        {
+                *ok &= n <= batch_size;
+                for (size_t i = 0; i < n; ++i, ++total)
+                {
+                        *ok &= total < num_expected && expected[total].begin == lines[i].begin &&
+                               expected[total].end == lines[i].end;
+                }
+        }
+        *ok &= total == num_expected;
+        *num_lines = total;
+}
+
+MU_TEST (needle_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "ERR", 3);
+        int ok;
+        size_t num_lines;
+        check_filter (&searcher, 7, &ok, &num_lines);
+        mu_check (ok);
+        mu_check (num_lines > 1000);
+        mu_assert_int_eq ((int) num_lines, (int) line_filter_count (&searcher, text, TEXT_SIZE));
+}
+
+MU_TEST (teddy_test)
+{
+        Pattern patterns[3] = {{"WARN", 4}, {"hgfe", 4}, {"ERR", 3}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 3, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+        for (size_t batch_size = 1; batch_size <= 7; batch_size += 3)
+        {
+                int ok;
+                size_t num_lines;
+                check_filter (&searcher, batch_size, &ok, &num_lines);
+                mu_check (ok);
+        }
+
+        // the last line has no trailing newline
+        LineFilter filter;
+        LineRange line;
+        LineFilter_init (&filter, &searcher, text + TEXT_SIZE - 4, 4);
+        mu_assert_int_eq (1, (int) LineFilter_next (&filter, &line, 1));
+        mu_assert_int_eq (0, (int) line.begin);
+        mu_assert_int_eq (4, (int) line.end);
+        mu_assert_int_eq (0, (int) LineFilter_next (&filter, &line, 1));
+}
+
+MU_TEST_SUITE (line_filter_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (needle_test);
+        MU_RUN_TEST (teddy_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (line_filter_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
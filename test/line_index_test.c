@@ -0,0 +1,142 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/line_index.h>
+#include <simdstr/search.h>
+
+#define TEXT_SIZE 100000
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 5;
+        for (size_t i = 0; i < TEXT_SIZE; ++i)
+        {
+                test_random (&state);
+                // mostly short lines, some empty lines and a line longer than a checkpoint sample
+                text[i] = (i > 20000 && i < 30000) || (state >> 16) % 40 != 0 ? 'a' + (char) ((state >> 20) % 26) : '\n';
+        }
+        text[50] = '\n';
+        text[51] = '\n';
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+static uint64_t
+naive_line (size_t offset)
+{
+        uint64_t line = 1;
+        for (size_t i = 0; i < offset; ++i)
+        {
+                line += text[i] == '\n';
+        }
+        return line;
+}
+
+MU_TEST (count_test)
+{
+        for (size_t size = 0; size < 300; ++size)
+        {
+                size_t expected = 0;
+                const char* last = NULL;
+                for (size_t i = 0; i < size; ++i)
+                {
+                        expected += text[i + 7] == '\n';
+                        last = text[i + 7] == '\n' ? text + i + 7 : last;
+                }
+                mu_assert_int_eq ((int) expected, (int) simd_count_char (text + 7, size, '\n'));
+                mu_check (simd_memrchr (text + 7, size, '\n') == last);
+        }
+        mu_assert_int_eq ((int) naive_line (TEXT_SIZE) - 1, (int) simd_count_char (text, TEXT_SIZE, '\n'));
+}
+
+MU_TEST (index_test)
+{
+        LineIndex index;
+        mu_assert_int_eq (0, LineIndex_init (&index, text, TEXT_SIZE));
+        mu_assert_int_eq ((int) naive_line (TEXT_SIZE), (int) index.num_lines);
+
+        for (size_t offset = 0; offset <= TEXT_SIZE; offset += 997)
+        {
+                uint64_t expected = naive_line (offset);
+                mu_assert_int_eq ((int) expected, (int) LineIndex_line (&index, offset));
+
+                size_t begin;
+                size_t end;
+                LineIndex_line_bounds (&index, offset, &begin, &end);
+                mu_check (begin <= offset && offset <= end);
+                mu_check (begin == 0 || text[begin - 1] == '\n');
+                mu_check (end == TEXT_SIZE || text[end] == '\n');
+                mu_assert_int_eq ((int) begin, (int) LineIndex_line_start (&index, expected));
+
+                uint64_t line;
+                uint64_t column;
+                LineIndex_position (&index, offset, &line, &column);
+                mu_assert_int_eq ((int) expected, (int) line);
+                mu_assert_int_eq ((int) (offset - begin + 1), (int) column);
+        }
+        // empty line between text[50] and text[51]
+        size_t begin;
+        size_t end;
+        mu_assert_int_eq (51, (int) LineIndex_line_start (&index, naive_line (51)));
+        LineIndex_line_bounds (&index, 51, &begin, &end);
+        mu_assert_int_eq (51, (int) begin);
+        mu_assert_int_eq (51, (int) end);
+        mu_assert_int_eq (TEXT_SIZE, (int) LineIndex_line_start (&index, index.num_lines + 1));
+        LineIndex_destroy (&index);
+
+        mu_assert_int_eq (0, LineIndex_init (&index, text, 0));
+        mu_assert_int_eq (0, (int) index.num_lines);
+        mu_assert_int_eq (1, (int) LineIndex_line (&index, 0));
+        LineIndex_destroy (&index);
+}
+
+MU_TEST (cursor_test)
+{
+        LineIndex index;
+        LineIndex_init (&index, text, TEXT_SIZE);
+        LineCursor cursor;
+        LineCursor_init (&cursor, text, TEXT_SIZE, &index);
+        LineCursor plain;
+        LineCursor_init (&plain, text, TEXT_SIZE, NULL);
+        size_t offsets[] = {0, 10, 52, 4096, 25000, 25000, 99999, 300, 70000};
+        for (size_t i = 0; i < 9; ++i)
+        {
+                mu_assert_int_eq ((int) naive_line (offsets[i]), (int) LineCursor_line (&cursor, offsets[i]));
+                mu_assert_int_eq ((int) naive_line (offsets[i]), (int) LineCursor_line (&plain, offsets[i]));
+        }
+        LineIndex_destroy (&index);
+}
+
+MU_TEST_SUITE (line_index_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (count_test);
+        MU_RUN_TEST (index_test);
+        MU_RUN_TEST (cursor_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (line_index_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,184 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <simdstr/mapped_corpus.h>
+#include <simdstr/parallel_search.h>
+
+#define TEXT_SIZE (1u << 20)
+#define CHUNK_SIZE 8192
+
+static char* text;
+static char corpus_path[64];
+static char sysfs_root[64];
+
+static void
+write_file (const char* path, const char* content, size_t size)
+{
+        FILE* file = fopen (path, "wb");
+        fwrite (content, 1, size, file);
+        fclose (file);
+}
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 7;
+        test_random_text (text, TEXT_SIZE, "abcdefgh ", 9, &state);
+        size_t positions[] = {0, CHUNK_SIZE - 2, 4096 - 5, 3 * CHUNK_SIZE + 4090, TEXT_SIZE - 8};
+        for (size_t i = 0; i < 5; ++i)
+        {
+                memcpy (text + positions[i], "needle42", 8);
+        }
+        strcpy (corpus_path, "/tmp/mapped_corpus_testXXXXXX");
+        int fd = mkstemp (corpus_path);
+        close (fd);
+        write_file (corpus_path, text, TEXT_SIZE);
+
+        // fake sysfs: two nodes with CPUs, one memory only node
+        char path[256];
+        strcpy (sysfs_root, "/tmp/mapped_corpus_nodesXXXXXX");
+        mkdtemp (sysfs_root);
+        const char* lists[] = {"0-3,8\n", "4-7\n", "\n"};
+        for (int node = 0; node < 3; ++node)
+        {
+                snprintf (path, sizeof (path), "%s/node%d", sysfs_root, node);
+                mkdir (path, 0700);
+                snprintf (path, sizeof (path), "%s/node%d/cpulist", sysfs_root, node);
+                write_file (path, lists[node], strlen (lists[node]));
+        }
+}
+
+static void
+test_teardown (void)
+{
+        char path[256];
+        for (int node = 0; node < 3; ++node)
+        {
+                snprintf (path, sizeof (path), "%s/node%d/cpulist", sysfs_root, node);
+                unlink (path);
+                snprintf (path, sizeof (path), "%s/node%d", sysfs_root, node);
+                rmdir (path);
+        }
+        rmdir (sysfs_root);
+        unlink (corpus_path);
+        free (text);
+}
+
+MU_TEST (topology_test)
+{
+        NumaTopology topology;
+        NumaTopology_discover (&topology, sysfs_root);
+        mu_assert_int_eq (2, (int) topology.num_nodes);
+        mu_assert_int_eq (5, (int) topology.num_cpus[0]);
+        mu_assert_int_eq (4, (int) topology.num_cpus[1]);
+        mu_assert_int_eq (0, NumaTopology_cpu_node (&topology, 8));
+        mu_assert_int_eq (1, NumaTopology_cpu_node (&topology, 5));
+        mu_assert_int_eq (-1, NumaTopology_cpu_node (&topology, 9));
+        mu_assert_int_eq (-1, NumaTopology_node_index (&topology, 2));
+
+        // no NUMA information: a single node
+        NumaTopology_discover (&topology, "/nonexistent");
+        mu_assert_int_eq (1, (int) topology.num_nodes);
+        mu_check (topology.num_cpus[0] >= 1);
+}
+
+MU_TEST (map_test)
+{
+        int flags[] = {MAPPED_CORPUS_DEFAULT, 0, MAPPED_CORPUS_COPY | MAPPED_CORPUS_HUGEPAGE};
+        for (int i = 0; i < 3; ++i)
+        {
+                MappedCorpus corpus;
+                mu_assert_int_eq (0, MappedCorpus_open (&corpus, corpus_path, flags[i]));
+                mu_assert_int_eq (TEXT_SIZE, (int) corpus.size);
+                mu_check (memcmp (corpus.data, text, TEXT_SIZE) == 0);
+
+                int node;
+                void* address = corpus.data;
+                numa_page_nodes (&address, 1, &node);
+                mu_check (node >= -1);
+                MappedCorpus_close (&corpus);
+        }
+
+        MappedCorpus corpus;
+        mu_assert_int_eq (-1, MappedCorpus_open (&corpus, "/nonexistent/corpus", MAPPED_CORPUS_DEFAULT));
+}
+
+MU_TEST (scan_test)
+{
+        MappedCorpus corpus;
+        MappedCorpus_open (&corpus, corpus_path, MAPPED_CORPUS_DEFAULT);
+        Pattern patterns[2] = {{"needle42", 8}, {"hgfedcba", 8}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 2, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+
+        ThreadPool pool;
+        ThreadPool_init (&pool, 2, NULL, NULL);
+        Match* expected;
+        size_t num_expected = parallel_find_all (&pool, &searcher, corpus.data, corpus.size, CHUNK_SIZE, &expected);
+        ThreadPool_destroy (&pool);
+        mu_check (num_expected >= 5);
+
+        const char* roots[] = {NULL, sysfs_root};
+        size_t distances[] = {0, CORPUS_PREFETCH_DISTANCE};
+        for (int r = 0; r < 2; ++r)
+        {
+                NumaTopology topology;
+                NumaTopology_discover (&topology, roots[r]);
+                CorpusScanner scanner;
+                mu_assert_int_eq (0, CorpusScanner_init (&scanner, &topology, 3));
+                mu_assert_int_eq ((int) scanner.pool.num_threads, (int) scanner.num_workers);
+                for (int d = 0; d < 2; ++d)
+                {
+                        Match* matches;
+                        size_t num_matches = CorpusScanner_find_all (&scanner, &searcher, corpus.data, corpus.size,
+                                                                     CHUNK_SIZE, distances[d], &matches);
+                        mu_assert_int_eq ((int) num_expected, (int) num_matches);
+                        for (size_t i = 0; i < num_expected && i < num_matches; ++i)
+                        {
+                                mu_assert_int_eq (expected[i].pattern_id, matches[i].pattern_id);
+                                mu_assert_int_eq ((int) (expected[i].begin - corpus.data),
+                                                  (int) (matches[i].begin - corpus.data));
+                        }
+                        free (matches);
+                }
+                Match* matches;
+                mu_assert_int_eq (0, (int) CorpusScanner_find_all (&scanner, &searcher, corpus.data, 0, 0, 0, &matches));
+                CorpusScanner_destroy (&scanner);
+        }
+        free (expected);
+        MappedCorpus_close (&corpus);
+}
+
+MU_TEST_SUITE (mapped_corpus_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (topology_test);
+        MU_RUN_TEST (map_test);
+        MU_RUN_TEST (scan_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (mapped_corpus_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
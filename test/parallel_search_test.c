@@ -0,0 +1,140 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/parallel_search.h>
+
+#define TEXT_SIZE (1u << 20)
+#define CHUNK_SIZE 4096
+
+static char* text;
+static ThreadPool pool;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 42;
+        test_random_text (text, TEXT_SIZE, "abcdefgh ", 9, &state);
+        // plant needles, some of them crossing chunk boundaries
+        size_t positions[] = {100, CHUNK_SIZE - 3, 7 * CHUNK_SIZE - 1, 100000, TEXT_SIZE - 9};
+        for (size_t i = 0; i < 5; ++i)
+        {
+                memcpy (text + positions[i], "needle42", 8);
+        }
+        memcpy (text + 50000, "pattern", 7);
+        ThreadPool_init (&pool, 4, NULL, NULL);
+}
+
+static void
+test_teardown (void)
+{
+        ThreadPool_destroy (&pool);
+        free (text);
+}
+
+static size_t
+sequential_find_all (const Searcher* searcher, Match* matches, size_t capacity)
+{
+        size_t num_matches = 0;
+        size_t pos = 0;
+        for (;;)
+        {
+                Match match = Searcher_find (searcher, text + pos, TEXT_SIZE - pos);
+                if (match.pattern_id < 0)
+                {
+                        return num_matches;
+                }
+                if (num_matches < capacity)
+                {
+                        matches[num_matches] = match;
+                }
+                num_matches++;
+                pos = (size_t) (match.begin - text) + 1;
+        }
+}
+
+MU_TEST (find_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "needle42", 8);
+
+        Match match = parallel_find (&pool, &searcher, text, TEXT_SIZE, CHUNK_SIZE);
+        mu_assert_int_eq (100, (int) (match.begin - text));
+
+        memcpy (text + 100, "xxxxxxxx", 8);
+        match = parallel_find (&pool, &searcher, text, TEXT_SIZE, CHUNK_SIZE);
+        mu_assert_int_eq (CHUNK_SIZE - 3, (int) (match.begin - text));
+        memcpy (text + 100, "needle42", 8);
+
+        Searcher_init_needle (&searcher, "needle43", 8);
+        match = parallel_find (&pool, &searcher, text, TEXT_SIZE, CHUNK_SIZE);
+        mu_assert_int_eq (-1, match.pattern_id);
+}
+
+MU_TEST (find_all_test)
+{
+        Pattern patterns[3] = {{"needle42", 8}, {"pattern", 7}, {"hgfedcba", 8}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 3, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+
+        Match expected[64];
+        size_t num_expected = sequential_find_all (&searcher, expected, 64);
+        mu_check (num_expected >= 6 && num_expected <= 64);
+
+        Match* matches;
+        size_t num_matches = parallel_find_all (&pool, &searcher, text, TEXT_SIZE, CHUNK_SIZE, &matches);
+        mu_assert_int_eq ((int) num_expected, (int) num_matches);
+        for (size_t i = 0; i < num_expected && i < num_matches; ++i)
+        {
+                mu_assert_int_eq (expected[i].pattern_id, matches[i].pattern_id);
+                mu_assert_int_eq ((int) (expected[i].begin - text), (int) (matches[i].begin - text));
+        }
+        free (matches);
+}
+
+MU_TEST (flags_test)
+{
+        // the chunk seam at offset 9 lies inside the word "aterror"
+        char str[] = "aaaaaaaaterror ism and more error and errors";
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "error", 5);
+        Searcher_set_flags (&searcher, SEARCH_WORD);
+        Match match = parallel_find (&pool, &searcher, str, strlen (str), 9);
+        mu_assert_int_eq (28, (int) (match.begin - str));
+
+        Match* matches;
+        mu_assert_int_eq (1, (int) parallel_find_all (&pool, &searcher, str, strlen (str), 9, &matches));
+        mu_assert_int_eq (28, (int) (matches[0].begin - str));
+        free (matches);
+
+        Searcher_set_flags (&searcher, SEARCH_BUFFER_START);
+        mu_assert_int_eq (-1, parallel_find (&pool, &searcher, str, strlen (str), 9).pattern_id);
+}
+
+MU_TEST_SUITE (parallel_search_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (find_test);
+        MU_RUN_TEST (find_all_test);
+        MU_RUN_TEST (flags_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (parallel_search_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,172 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/pattern_counter.h>
+#include <simdstr/search.h>
+
+#define TEXT_SIZE 300000
+#define NUM_PATTERNS 150
+
+static char* text;
+static Pattern patterns[NUM_PATTERNS];
+static char pattern_text[NUM_PATTERNS * 8];
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 5;
+        test_random_text (text, TEXT_SIZE, "abcdAB", 6, &state);
+        // patterns of 1 to 6 bytes over the text alphabet, some of them duplicates or self-overlapping
+        for (size_t pattern_id = 0; pattern_id < NUM_PATTERNS; ++pattern_id)
+        {
+                size_t size = 1 + (test_random (&state) >> 16) % 6;
+                char* begin = pattern_text + pattern_id * 8;
+                test_random_text (begin, size, "abcdAB", 6, &state);
+                patterns[pattern_id].begin = begin;
+                patterns[pattern_id].size = size;
+        }
+        memcpy (pattern_text, "aaaa", 4);
+        patterns[0].size = 4;
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+static uint64_t
+naive_count (const Pattern* pattern, int icase)
+{
+        uint64_t count = 0;
+        for (size_t start = 0; start + pattern->size <= TEXT_SIZE; ++start)
+        {
+                count += icase ? icase_memcmp (text + start, pattern->begin, pattern->size) == 0
+                               : memcmp (text + start, pattern->begin, pattern->size) == 0;
+        }
+        return count;
+}
+
+MU_TEST (slim_count_test)
+{
+        Pattern slim_patterns[4] = {{"aa", 2}, {"abc", 3}, {"dAB", 3}, {"bcda", 4}};
+        for (uint8_t num_masks = 1; num_masks <= 2; ++num_masks)
+        {
+                SlimTeddy teddy;
+                SlimTeddy_init (&teddy, slim_patterns, 4, num_masks);
+                uint64_t counts[4] = {0};
+                SlimTeddy_count (&teddy, text, TEXT_SIZE, TEXT_SIZE, counts);
+                for (uint8_t pattern_id = 0; pattern_id < 4; ++pattern_id)
+                {
+                        mu_check (counts[pattern_id] > 0);
+                        mu_check (counts[pattern_id] == naive_count (&slim_patterns[pattern_id], 0));
+                }
+
+                // only occurrences starting in [0, num_starts), odd sizes exercise the overlapping last block
+                for (size_t size = 1; size < 70; size += 7)
+                {
+                        uint64_t part_counts[4] = {0};
+                        SlimTeddy_count (&teddy, text, size + 3, size, part_counts);
+                        for (uint8_t pattern_id = 0; pattern_id < 4; ++pattern_id)
+                        {
+                                Pattern* pattern = &slim_patterns[pattern_id];
+                                uint64_t expected = 0;
+                                for (size_t start = 0; start < size; ++start)
+                                {
+                                        expected += start + pattern->size <= size + 3 &&
+                                                    memcmp (text + start, pattern->begin, pattern->size) == 0;
+                                }
+                                mu_check (part_counts[pattern_id] == expected);
+                        }
+                }
+        }
+}
+
+MU_TEST (count_test)
+{
+        PatternCounter counter;
+        mu_assert_int_eq (0, PatternCounter_init (&counter, patterns, NUM_PATTERNS, 0));
+        mu_assert_int_eq (3, (int) counter.num_teddies);
+
+        static uint64_t counts[NUM_PATTERNS];
+        memset (counts, 0, sizeof (counts));
+        PatternCounter_count (&counter, text, TEXT_SIZE, TEXT_SIZE, counts);
+        for (size_t pattern_id = 0; pattern_id < NUM_PATTERNS; ++pattern_id)
+        {
+                mu_check (counts[pattern_id] == naive_count (&patterns[pattern_id], 0));
+        }
+        PatternCounter_destroy (&counter);
+}
+
+MU_TEST (icase_count_test)
+{
+        PatternCounter counter;
+        mu_assert_int_eq (0, PatternCounter_init (&counter, patterns, 70, 1));
+        uint64_t counts[70] = {0};
+        PatternCounter_count (&counter, text, TEXT_SIZE, TEXT_SIZE, counts);
+        for (size_t pattern_id = 0; pattern_id < 70; ++pattern_id)
+        {
+                mu_check (counts[pattern_id] == naive_count (&patterns[pattern_id], 1));
+        }
+        PatternCounter_destroy (&counter);
+}
+
+MU_TEST (parallel_count_test)
+{
+        PatternCounter counter;
+        mu_assert_int_eq (0, PatternCounter_init (&counter, patterns, NUM_PATTERNS, 0));
+        ThreadPool pool;
+        mu_assert_int_eq (0, ThreadPool_init (&pool, 4, NULL, NULL));
+
+        static uint64_t expected[NUM_PATTERNS];
+        memset (expected, 0, sizeof (expected));
+        PatternCounter_count (&counter, text, TEXT_SIZE, TEXT_SIZE, expected);
+        // chunk sizes not aligned to blocks or pattern sizes
+        size_t chunk_sizes[3] = {0, 4099, 777};
+        for (size_t i = 0; i < 3; ++i)
+        {
+                static uint64_t counts[NUM_PATTERNS];
+                memset (counts, 0, sizeof (counts));
+                mu_assert_int_eq (0, PatternCounter_parallel_count (&counter, &pool, text, TEXT_SIZE, chunk_sizes[i], counts));
+                mu_check (memcmp (counts, expected, sizeof (counts)) == 0);
+        }
+
+        ThreadPool_destroy (&pool);
+        PatternCounter_destroy (&counter);
+}
+
+MU_TEST (invalid_test)
+{
+        Pattern invalid[2] = {{"a", 1}, {"", 0}};
+        PatternCounter counter;
+        mu_assert_int_eq (-1, PatternCounter_init (&counter, invalid, 2, 0));
+}
+
+MU_TEST_SUITE (pattern_counter_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (slim_count_test);
+        MU_RUN_TEST (count_test);
+        MU_RUN_TEST (icase_count_test);
+        MU_RUN_TEST (parallel_count_test);
+        MU_RUN_TEST (invalid_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (pattern_counter_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
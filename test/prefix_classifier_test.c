@@ -0,0 +1,170 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/prefix_classifier.h>
+
+#define NUM_PATTERNS 500
+#define NUM_INPUTS 20000
+
+static char pattern_text[NUM_PATTERNS][48];
+static Pattern patterns[NUM_PATTERNS];
+static PrefixClassifier classifier;
+
+static void
+test_setup (void)
+{
+        const char* methods[] = {"GET /", "POST /", "PUT /api/", "DELETE /api/v2/"};
+        const char* segments[] = {"api/", "v1/", "v2/", "users", "items/", "", "static/", "x"};
+        uint32_t state = 3;
+        for (size_t idx = 0; idx < NUM_PATTERNS; ++idx)
+        {
+                test_random (&state);
+                int size = snprintf (pattern_text[idx], 48, "%s%s%s", methods[(state >> 16) % 4],
+                                     segments[(state >> 20) % 8], segments[(state >> 24) % 8]);
+                // distinct tails and some patterns appearing twice
+                if (idx % 7 != 0)
+                {
+                        size += snprintf (pattern_text[idx] + size, 48 - (size_t) size, "%zu", idx % 97);
+                }
+                patterns[idx].begin = pattern_text[idx];
+                patterns[idx].size = (uint64_t) size;
+        }
+        PrefixClassifier_init (&classifier, patterns, NUM_PATTERNS);
+}
+
+static void
+test_teardown (void)
+{
+        PrefixClassifier_destroy (&classifier);
+}
+
+static int32_t
+naive_find (const char* str, size_t str_size, size_t* prefix_size)
+{
+        int32_t best = -1;
+        for (size_t idx = 0; idx < NUM_PATTERNS; ++idx)
+        {
+                size_t size = patterns[idx].size;
+                if (size <= str_size && memcmp (str, patterns[idx].begin, size) == 0 &&
+                    (best < 0 || size > patterns[best].size))
+                {
+                        best = (int32_t) idx;
+                }
+        }
+        *prefix_size = best < 0 ? 0 : patterns[best].size;
+        return best;
+}
+
+MU_TEST (find_test)
+{
+        char input[64];
+        uint32_t state = 17;
+        int equal = 1;
+        size_t num_found = 0;
+        for (size_t idx = 0; idx < NUM_INPUTS; ++idx)
+        {
+                // a pattern (possibly cut or changed) followed by arbitrary bytes
+                test_random (&state);
+                const Pattern* pattern = &patterns[(state >> 8) % NUM_PATTERNS];
+                size_t size = (state >> 20) % 8 == 0 ? (state >> 24) % (pattern->size + 1) : pattern->size;
+                memcpy (input, pattern->begin, size);
+                test_random_text (input + size, sizeof (input) - size, "0123456789/ax?", 14, &state);
+                if ((state >> 28) == 0)
+                {
+                        input[(state >> 8) % sizeof (input)] = 'Z';
+                }
+                size_t input_size = (state >> 12) % sizeof (input);
+                size_t prefix_size;
+                size_t expected_size;
+                int32_t found = PrefixClassifier_find (&classifier, input, input_size, &prefix_size);
+                int32_t expected = naive_find (input, input_size, &expected_size);
+                equal &= found == expected && prefix_size == expected_size;
+                num_found += found >= 0;
+        }
+        mu_check (equal);
+        mu_check (num_found > NUM_INPUTS / 4);
+}
+
+MU_TEST (edge_test)
+{
+        // nested prefixes, duplicates, the empty pattern and bytes >= 0x80
+        Pattern set[6] = {{"abc", 3}, {"a", 1}, {"abcdef", 6}, {"abc", 3}, {"", 0}, {"\xff\x80", 2}};
+        PrefixClassifier small;
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, set, 6));
+        size_t prefix_size;
+        mu_assert_int_eq (0, PrefixClassifier_find (&small, "abcde", 5, &prefix_size));
+        mu_assert_int_eq (3, (int) prefix_size);
+        mu_assert_int_eq (2, PrefixClassifier_find (&small, "abcdefg", 7, NULL));
+        mu_assert_int_eq (1, PrefixClassifier_find (&small, "ab", 2, NULL));
+        mu_assert_int_eq (4, PrefixClassifier_find (&small, "b", 1, &prefix_size));
+        mu_assert_int_eq (0, (int) prefix_size);
+        mu_assert_int_eq (5, PrefixClassifier_find (&small, "\xff\x80!", 3, NULL));
+        PrefixClassifier_destroy (&small);
+
+        // no patterns, a single pattern (a label at the root)
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, set, 0));
+        mu_assert_int_eq (-1, PrefixClassifier_find (&small, "abc", 3, NULL));
+        PrefixClassifier_destroy (&small);
+        // empty patterns and strings without data
+        Pattern empty[2] = {{"ab", 2}, {NULL, 0}};
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, empty, 2));
+        mu_assert_int_eq (1, PrefixClassifier_find (&small, NULL, 0, NULL));
+        mu_assert_int_eq (0, PrefixClassifier_find (&small, "abc", 3, NULL));
+        PrefixClassifier_destroy (&small);
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, empty + 1, 1));
+        mu_assert_int_eq (0, PrefixClassifier_find (&small, NULL, 0, NULL));
+        PrefixClassifier_destroy (&small);
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, set + 2, 1));
+        mu_assert_int_eq (0, PrefixClassifier_find (&small, "abcdef", 6, NULL));
+        mu_assert_int_eq (-1, PrefixClassifier_find (&small, "abcde", 5, NULL));
+        PrefixClassifier_destroy (&small);
+
+        // many edges at one node
+        char bytes[256][2];
+        Pattern fanout[256];
+        for (size_t idx = 0; idx < 256; ++idx)
+        {
+                bytes[idx][0] = 'k';
+                bytes[idx][1] = (char) (255 - idx);
+                fanout[idx].begin = bytes[idx];
+                fanout[idx].size = 2;
+        }
+        mu_assert_int_eq (0, PrefixClassifier_init (&small, fanout, 256));
+        int equal = 1;
+        for (size_t idx = 0; idx < 256; ++idx)
+        {
+                equal &= PrefixClassifier_find (&small, bytes[idx], 2, NULL) == (int32_t) idx;
+        }
+        mu_check (equal);
+        int32_t ids[2];
+        PrefixClassifier_classify (&small, fanout + 100, 2, ids);
+        mu_check (ids[0] == 100 && ids[1] == 101);
+        PrefixClassifier_destroy (&small);
+}
+
+MU_TEST_SUITE (prefix_classifier_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (find_test);
+        MU_RUN_TEST (edge_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (prefix_classifier_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
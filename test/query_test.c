@@ -0,0 +1,260 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/query.h>
+#include <simdstr/search.h>
+
+#define NUM_DOCS 300
+#define DOC_SIZE 600
+
+static char* docs_text;
+static Pattern docs[NUM_DOCS];
+
+static void
+test_setup (void)
+{
+        static const char* words[] = {"error", "warn", "timeout", "debug", "info", "Connection Refused", "ok", "retry"};
+        docs_text = malloc (NUM_DOCS * DOC_SIZE);
+        uint32_t state = 17;
+        for (size_t i = 0; i < NUM_DOCS; ++i)
+        {
+                char* doc = docs_text + i * DOC_SIZE;
+                // documents of varying size built from few words, so every combination of terms occurs
+                size_t size = 20 + (test_random (&state) >> 16) % (DOC_SIZE - 40);
+                size_t pos = 0;
+                while (pos < size)
+                {
+                        test_random (&state);
+                        const char* word = (state >> 16) % 3 == 0 ? words[(state >> 20) % 8] : "lorem";
+                        size_t word_size = strlen (word);
+                        if (pos + word_size + 1 > size)
+                        {
+                                break;
+                        }
+                        memcpy (doc + pos, word, word_size);
+                        doc[pos + word_size] = ' ';
+                        pos += word_size + 1;
+                }
+                docs[i].begin = doc;
+                docs[i].size = pos;
+        }
+}
+
+static void
+test_teardown (void)
+{
+        free (docs_text);
+}
+
+/*
+ * Naive evaluation: one full search per term.
+ */
+static int
+naive_eval (const Query* query, int node_id, const Pattern* doc, int icase)
+{
+        const QueryNode* node = &query->nodes[node_id];
+        const Pattern* term = &query->terms[node->term];
+        switch (node->kind)
+        {
+                case QUERY_TERM:
+                        if (icase)
+                        {
+                                return simd_stristr (doc->begin, doc->size, term->begin, term->size) != NULL;
+                        }
+                        return simd_strstr (doc->begin, doc->size, term->begin, term->size) != NULL;
+                case QUERY_AND:
+                        return naive_eval (query, node->left, doc, icase) && naive_eval (query, node->right, doc, icase);
+                case QUERY_OR:
+                        return naive_eval (query, node->left, doc, icase) || naive_eval (query, node->right, doc, icase);
+                case QUERY_NOT:
+                        return !naive_eval (query, node->left, doc, icase);
+        }
+        return 0;
+}
+
+/*
+ * Compare Query_eval/Query_filter with the naive evaluation on all docs. Returns the number of matching docs or -1.
+ */
+static int
+check_query (const char* expression, int icase)
+{
+        Query query;
+        Query_init (&query);
+        int root = Query_parse (&query, expression);
+        if (root < 0 || Query_compile (&query, root, icase) != 0)
+        {
+                Query_destroy (&query);
+                return -1;
+        }
+        uint8_t results[NUM_DOCS];
+        size_t num_matches = Query_filter (&query, docs, NUM_DOCS, results);
+        int ok = 1;
+        size_t num_expected = 0;
+        for (size_t i = 0; i < NUM_DOCS; ++i)
+        {
+                int expected = naive_eval (&query, root, &docs[i], icase);
+                num_expected += expected;
+                ok &= results[i] == expected;
+                QueryResult result = Query_eval (&query, docs[i].begin, docs[i].size);
+                ok &= result.match == expected && result.scanned <= docs[i].size;
+        }
+        Query_destroy (&query);
+        return ok && num_matches == num_expected ? (int) num_expected : -1;
+}
+
+MU_TEST (eval_test)
+{
+        mu_check (check_query ("error", 0) > 0);
+        mu_check (check_query ("error & warn", 0) > 0);
+        mu_check (check_query ("error warn !debug", 0) > 0);
+        mu_check (check_query ("error & (timeout | \"Connection Refused\") & !debug", 0) > 0);
+        mu_check (check_query ("!(info | ok) | retry warn", 0) > 0);
+        mu_check (check_query ("!timeout", 0) > 0);
+        mu_check (check_query ("error | warn | timeout | debug | info | ok | retry", 0) > 0);
+        // single character terms limit the number of masks
+        mu_check (check_query ("e & !z", 0) > 0);
+        // terms that never occur
+        mu_assert_int_eq (0, check_query ("missing & error", 0));
+        mu_assert_int_eq (0, check_query ("\"connection refused\"", 0));
+}
+
+MU_TEST (icase_test)
+{
+        mu_check (check_query ("\"connection refused\"", 1) > 0);
+        mu_check (check_query ("ERROR & !\"connection REFUSED\"", 1) > 0);
+        mu_check (check_query ("Timeout", 1) > 0);
+}
+
+MU_TEST (early_exit_test)
+{
+        char doc[] = "error ... warn ... lots of text that does not need to be scanned ... debug";
+        Query query;
+        Query_init (&query);
+        int root = Query_parse (&query, "error | debug");
+        mu_check (Query_compile (&query, root, 0) == 0);
+        QueryResult result = Query_eval (&query, doc, strlen (doc));
+        mu_check (result.match);
+        mu_assert_int_eq (5, (int) result.scanned);
+        mu_assert_int_eq (1, (int) result.hits);
+        Query_destroy (&query);
+
+        // a hit of a negated term decides an AND
+        Query_init (&query);
+        root = Query_parse (&query, "debug & !warn");
+        mu_check (Query_compile (&query, root, 0) == 0);
+        result = Query_eval (&query, doc, strlen (doc));
+        mu_check (!result.match);
+        mu_assert_int_eq (14, (int) result.scanned);
+        Query_destroy (&query);
+
+        // absent terms are only known after the whole document
+        Query_init (&query);
+        root = Query_parse (&query, "error & !missing");
+        mu_check (Query_compile (&query, root, 0) == 0);
+        result = Query_eval (&query, doc, strlen (doc));
+        mu_check (result.match);
+        mu_assert_int_eq ((int) strlen (doc), (int) result.scanned);
+        Query_destroy (&query);
+}
+
+MU_TEST (prefix_term_test)
+{
+        // one term is a prefix of the other: both start at the same offset
+        char doc[] = "xx error yy and more text";
+        const char* expressions[4] = {"err & error", "error & err", "error & !err", "ERR & Error"};
+        int expected[4] = {1, 1, 0, 1};
+        for (int idx = 0; idx < 4; ++idx)
+        {
+                Query query;
+                Query_init (&query);
+                int root = Query_parse (&query, expressions[idx]);
+                mu_check (Query_compile (&query, root, idx == 3) == 0);
+                QueryResult result = Query_eval (&query, doc, strlen (doc));
+                mu_assert_int_eq (expected[idx], result.match);
+                mu_assert_int_eq (3, (int) result.hits);
+                mu_assert_int_eq (8, (int) result.scanned);
+                Query_destroy (&query);
+        }
+        mu_check (check_query ("err & error & !erro", 0) >= 0);
+        mu_check (check_query ("e | er | err | error", 1) > 0);
+}
+
+MU_TEST (builder_test)
+{
+        char doc[] = "the quick brown fox";
+        Query query;
+        Query_init (&query);
+        int fox = Query_term (&query, "fox", 3);
+        int dog = Query_term (&query, "dog", 3);
+        // equal terms share their index
+        int fox2 = Query_term (&query, "fox", 3);
+        mu_assert_int_eq (2, query.num_terms);
+        mu_assert_int_eq (query.nodes[fox].term, query.nodes[fox2].term);
+        mu_assert_int_eq (-1, Query_term (&query, "", 0));
+        mu_assert_int_eq (-1, Query_and (&query, fox, -1));
+        int root = Query_and (&query, fox2, Query_not (&query, dog));
+        mu_check (Query_compile (&query, root, 0) == 0);
+        mu_check (Query_match (&query, doc, strlen (doc)));
+        Query_destroy (&query);
+}
+
+MU_TEST (parse_test)
+{
+        Query query;
+        const char* invalid[] = {"", "a &", "(a | b", "a | b)", "\"open", "!", "a | | b", "()"};
+        for (size_t i = 0; i < sizeof (invalid) / sizeof (invalid[0]); ++i)
+        {
+                Query_init (&query);
+                mu_assert_int_eq (-1, Query_parse (&query, invalid[i]));
+                Query_destroy (&query);
+        }
+
+        // escapes in quoted terms
+        Query_init (&query);
+        int root = Query_parse (&query, "\"say \\\"hi\\\"\" | \"back\\\\slash\"");
+        mu_check (root >= 0);
+        mu_assert_int_eq (2, query.num_terms);
+        mu_check (query.terms[0].size == 8 && memcmp (query.terms[0].begin, "say \"hi\"", 8) == 0);
+        mu_check (query.terms[1].size == 10 && memcmp (query.terms[1].begin, "back\\slash", 10) == 0);
+        mu_check (Query_compile (&query, root, 0) == 0);
+        char doc[] = "they say \"hi\" here";
+        mu_check (Query_match (&query, doc, strlen (doc)));
+        Query_destroy (&query);
+
+        // AND binds tighter than OR
+        Query_init (&query);
+        root = Query_parse (&query, "a b | c");
+        mu_check (root >= 0);
+        mu_assert_int_eq (QUERY_OR, query.nodes[root].kind);
+        mu_assert_int_eq (QUERY_AND, query.nodes[query.nodes[root].left].kind);
+        Query_destroy (&query);
+}
+
+MU_TEST_SUITE (query_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (eval_test);
+        MU_RUN_TEST (icase_test);
+        MU_RUN_TEST (early_exit_test);
+        MU_RUN_TEST (prefix_term_test);
+        MU_RUN_TEST (builder_test);
+        MU_RUN_TEST (parse_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (query_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
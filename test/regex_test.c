@@ -0,0 +1,255 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/regex.h>
+
+#define TEXT_SIZE 200000
+
+static char* text;
+static Regex regex;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE + 1);
+        const char* words[] = {"ERROR ", "WARN ", "timeout=", "id=", "user ", "retry ", "42", "7 ", "x", "\n"};
+        uint32_t state = 11;
+        size_t pos = 0;
+        while (pos < TEXT_SIZE)
+        {
+                const char* word = words[(test_random (&state) >> 16) % 10];
+                size_t size = strlen (word);
+                size = pos + size > TEXT_SIZE ? TEXT_SIZE - pos : size;
+                memcpy (text + pos, word, size);
+                pos += size;
+        }
+        text[TEXT_SIZE] = '\0';
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+/*
+ * All matches of Regex (resuming one byte behind every match begin) equal the POSIX leftmost-longest ones.
+ */
+static int
+check_posix (const char* pattern, const char* posix_pattern, int icase, size_t cache_states, size_t* num_matches)
+{
+        regex_t posix;
+        if (regcomp (&posix, posix_pattern, REG_EXTENDED | REG_NEWLINE | (icase ? REG_ICASE : 0)) != 0)
+        {
+                return 0;
+        }
+        int ok = Regex_compile (&regex, pattern, icase, cache_states) == 0;
+        *num_matches = 0;
+        size_t from = 0;
+        while (ok && from <= TEXT_SIZE)
+        {
+                regmatch_t expected;
+                int flags = from == 0 || text[from - 1] == '\n' ? 0 : REG_NOTBOL;
+                int found_expected = regexec (&posix, text + from, 1, &expected, flags) == 0;
+                Match found = Regex_find_from (&regex, text, TEXT_SIZE, from);
+                if (!found_expected || found.pattern_id < 0)
+                {
+                        ok = !found_expected && found.pattern_id < 0;
+                        break;
+                }
+                ok = found.begin == text + from + expected.rm_so && found.end == text + from + expected.rm_eo;
+                (*num_matches)++;
+                from = (size_t) (found.begin - text) + 1;
+        }
+        Regex_destroy (&regex);
+        regfree (&posix);
+        return ok;
+}
+
+MU_TEST (literals_test)
+{
+        mu_assert_int_eq (0, Regex_compile (&regex, "ERROR .* timeout=\\d+", 0, 0));
+        mu_assert_int_eq (1, regex.num_literals);
+        mu_check (regex.literal_patterns[0].size == 9 && memcmp (regex.literals[0], " timeout=", 9) == 0);
+        Regex_destroy (&regex);
+        // alternations of literals are expanded
+        mu_assert_int_eq (0, Regex_compile (&regex, "(error|warn(ing)?) code", 1, 0));
+        mu_assert_int_eq (3, regex.num_literals);
+        mu_check (memcmp (regex.literals[1], "warning code", 12) == 0);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "id=(\\d+|none), (ERROR|WARN)", 0, 0));
+        mu_assert_int_eq (2, regex.num_literals);
+        Regex_destroy (&regex);
+        // icase literals are lower case, classes of one letter in both cases are literals
+        mu_assert_int_eq (0, Regex_compile (&regex, "[Tt]ime[Oo]ut", 1, 0));
+        mu_assert_int_eq (1, regex.num_literals);
+        mu_check (memcmp (regex.literals[0], "timeout", 7) == 0);
+        Regex_destroy (&regex);
+        // nothing required
+        mu_assert_int_eq (0, Regex_compile (&regex, "[0-9]+x?", 0, 0));
+        mu_assert_int_eq (0, regex.num_literals);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "a|b*", 0, 0));
+        mu_assert_int_eq (0, regex.num_literals);
+        Regex_destroy (&regex);
+}
+
+MU_TEST (syntax_test)
+{
+        const char* invalid[] = {"(ab", "ab)", "[a-", "[z-a]", "*a", "a{2", "a{3,1}", "a^b", "a$b", "\\x4", "ab\\"};
+        for (size_t idx = 0; idx < sizeof (invalid) / sizeof (invalid[0]); ++idx)
+        {
+                mu_assert_int_eq (-1, Regex_compile (&regex, invalid[idx], 0, 0));
+        }
+        // escaped '$' is a literal
+        char str[] = "price: 5$ each\n";
+        mu_assert_int_eq (0, Regex_compile (&regex, "\\d\\$", 0, 0));
+        Match match = Regex_find (&regex, str, strlen (str));
+        mu_check (match.begin == str + 7 && match.end == str + 9);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "\\S+ each$", 0, 0));
+        match = Regex_find (&regex, str, strlen (str));
+        mu_check (match.begin == str + 7 && match.end == str + 14);
+        Regex_destroy (&regex);
+}
+
+MU_TEST (find_test)
+{
+        char str[] = "INFO start\nERROR db timeout=30 retry\nERROR timeout\nerror x timeout=5\n";
+        mu_assert_int_eq (0, Regex_compile (&regex, "ERROR .* timeout=\\d+", 0, 0));
+        Match match = Regex_find (&regex, str, strlen (str));
+        mu_assert_int_eq (0, match.pattern_id);
+        mu_check (match.begin == str + 11 && match.end == str + 30);
+        mu_assert_int_eq (-1, Regex_find_from (&regex, str, strlen (str), 12).pattern_id);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "ERROR .* timeout=\\d+", 1, 0));
+        match = Regex_find_from (&regex, str, strlen (str), 12);
+        mu_check (match.begin == str + 51 && match.end == str + 68);
+        Regex_destroy (&regex);
+        // anchors are line anchors, matches never span lines
+        mu_assert_int_eq (0, Regex_compile (&regex, "^ERROR [a-z]+$", 0, 0));
+        match = Regex_find (&regex, str, strlen (str));
+        mu_check (match.begin == str + 37 && match.end == str + 50);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "start.ERROR", 0, 0));
+        mu_assert_int_eq (-1, Regex_find (&regex, str, strlen (str)).pattern_id);
+        Regex_destroy (&regex);
+}
+
+MU_TEST (icase_class_test)
+{
+        // icase negated classes exclude both cases of their letters
+        const char* strs[4] = {"ab", "Ab", "aB", "cB"};
+        const int expected[4] = {-1, -1, -1, 0};
+        mu_assert_int_eq (0, Regex_compile (&regex, "[^a]b", 1, 0));
+        for (int idx = 0; idx < 4; ++idx)
+        {
+                char str[3];
+                memcpy (str, strs[idx], 3);
+                mu_assert_int_eq (expected[idx], Regex_find (&regex, str, 2).pattern_id);
+        }
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "[^A-Z]+", 1, 0));
+        char str[] = "Ab-cD";
+        Match match = Regex_find (&regex, str, strlen (str));
+        mu_check (match.begin == str + 2 && match.end == str + 3);
+        Regex_destroy (&regex);
+}
+
+MU_TEST (posix_test)
+{
+        // pattern, POSIX ERE equivalent
+        const char* patterns[][2] = {
+                {"ERROR .* timeout=\\d+", "ERROR .* timeout=[0-9]+"},
+                {"(ERROR|WARN) (user|retry) ", "(ERROR|WARN) (user|retry) "},
+                {"id=\\d*7", "id=[0-9]*7"},
+                {"x+ ?(42)+", "x+ ?(42)+"},
+                {"^WARN.*x$", "^WARN.*x$"},
+                {"[^ ]+=4?2?", "[^ ]+=4?2?"},
+                {"r{2}|y (us|re)", "r{2}|y (us|re)"},
+                {"e[a-z]{2,4}", "e[a-z]{2,4}"},
+                {"\\d{2,}", "[0-9]{2,}"},
+                {"u?s?e?r", "u?s?e?r"},
+                {"(x|7 )*id", "(x|7 )*id"},
+                {"[^r]ROR", "[^r]ROR"},
+                {"(id=|x)?\\d+$", "(id=|x)?[0-9]+$"},
+                {"x+7?|7", "x+7?|7"},
+                {"(R|ROR|O)R? ", "(R|ROR|O)R? "},
+        };
+        for (size_t p = 0; p < sizeof (patterns) / sizeof (patterns[0]); ++p)
+        {
+                size_t num_matches;
+                mu_check (check_posix (patterns[p][0], patterns[p][1], 0, 0, &num_matches));
+                mu_check (num_matches > 0);
+                mu_check (check_posix (patterns[p][0], patterns[p][1], 1, 0, &num_matches));
+        }
+}
+
+MU_TEST (long_line_test)
+{
+        // the leftmost start is not found by restarting the automaton at every byte (quadratic in the line size)
+        size_t size = 1000000;
+        char* str = malloc (size + 1);
+        memset (str, 'a', size);
+        str[size] = 'b';
+        mu_assert_int_eq (0, Regex_compile (&regex, "(a[a-y]*z|b)", 0, 0));
+        Match match = Regex_find (&regex, str, size + 1);
+        mu_check (match.begin == str + size && match.end == str + size + 1);
+        Regex_destroy (&regex);
+        mu_assert_int_eq (0, Regex_compile (&regex, "a*b$", 0, 0));
+        match = Regex_find (&regex, str, size + 1);
+        mu_check (match.begin == str && match.end == str + size + 1);
+        Regex_destroy (&regex);
+        free (str);
+}
+
+MU_TEST (cache_test)
+{
+        // a cache of the minimum size is flushed repeatedly and still gives the same results
+        size_t num_matches;
+        mu_check (check_posix ("[a-z]+ [a-z]*[0-9]", "[a-z]+ [a-z]*[0-9]", 0, 8, &num_matches));
+        mu_check (num_matches > 0);
+        mu_assert_int_eq (0, Regex_compile (&regex, "(a|b)*a(a|b){6}", 0, 8));
+        char str[200];
+        for (size_t idx = 0; idx < sizeof (str); ++idx)
+        {
+                str[idx] = "ab"[(idx * 7 + idx / 3) % 2];
+        }
+        memcpy (str + 150, "bbbbbbbb", 8);
+        Match match = Regex_find (&regex, str, sizeof (str));
+        mu_check (regex.num_flushes > 0);
+        mu_check (match.begin == str && match.end == str + 199);
+        Regex_destroy (&regex);
+}
+
+MU_TEST_SUITE (regex_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (literals_test);
+        MU_RUN_TEST (syntax_test);
+        MU_RUN_TEST (find_test);
+        MU_RUN_TEST (icase_class_test);
+        MU_RUN_TEST (posix_test);
+        MU_RUN_TEST (long_line_test);
+        MU_RUN_TEST (cache_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (regex_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
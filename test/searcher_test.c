@@ -0,0 +1,263 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/searcher.h>
+
+#define TEXT_SIZE 50000
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        static const char* words[] = {"error", "terrorism", "errors", "err", "ok", "error_code", "Error", "x"};
+        static const char separators[] = " \n-_.\n";
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 3;
+        size_t pos = 0;
+        while (pos < TEXT_SIZE)
+        {
+                const char* word = words[(test_random (&state) >> 16) % 8];
+                size_t size = strlen (word);
+                size = size < TEXT_SIZE - pos ? size : TEXT_SIZE - pos;
+                memcpy (text + pos, word, size);
+                pos += size;
+                if (pos < TEXT_SIZE)
+                {
+                        text[pos++] = separators[(state >> 24) % 6];
+                }
+        }
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+static int
+h_is_word (char c)
+{
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int
+naive_accept (uint32_t flags, const char* str, size_t str_size, size_t begin, size_t end)
+{
+        if ((flags & SEARCH_WORD) && ((begin > 0 && h_is_word (str[begin - 1])) || (end < str_size && h_is_word (str[end]))))
+        {
+                return 0;
+        }
+        if ((flags & SEARCH_LINE_START) && begin > 0 && str[begin - 1] != '\n')
+        {
+                return 0;
+        }
+        if ((flags & SEARCH_LINE_END) && end < str_size && str[end] != '\n')
+        {
+                return 0;
+        }
+        return (!(flags & SEARCH_BUFFER_START) || begin == 0) && (!(flags & SEARCH_BUFFER_END) || end == str_size);
+}
+
+/*
+ * Compare all matches reported by resuming Searcher_find_from behind every match with the naive match positions.
+ */
+static int
+check_flags (Searcher* searcher, const Pattern* patterns, uint16_t num_patterns, uint32_t flags, char* str,
+             size_t str_size, size_t* num_matches)
+{
+        Searcher_set_flags (searcher, flags);
+        size_t from = 0;
+        *num_matches = 0;
+        for (size_t begin = 0; begin < str_size; ++begin)
+        {
+                int expected = 0;
+                for (uint16_t pattern_id = 0; pattern_id < num_patterns && !expected; ++pattern_id)
+                {
+                        size_t size = patterns[pattern_id].size;
+                        expected = size <= str_size - begin && memcmp (str + begin, patterns[pattern_id].begin, size) == 0 &&
+                                   naive_accept (flags, str, str_size, begin, begin + size);
+                }
+                if (!expected)
+                {
+                        continue;
+                }
+                Match match = Searcher_find_from (searcher, str, str_size, from);
+                if (match.pattern_id < 0 || (size_t) (match.begin - str) != begin)
+                {
+                        return 0;
+                }
+                const Pattern* pattern = &patterns[match.pattern_id];
+                if ((size_t) (match.end - match.begin) != pattern->size || memcmp (match.begin, pattern->begin, pattern->size) != 0 ||
+                    !naive_accept (flags, str, str_size, begin, (size_t) (match.end - str)))
+                {
+                        return 0;
+                }
+                from = begin + 1;
+                (*num_matches)++;
+        }
+        return Searcher_find_from (searcher, str, str_size, from).pattern_id < 0;
+}
+
+static const uint32_t all_flags[] = {
+        0,
+        SEARCH_WORD,
+        SEARCH_LINE_START,
+        SEARCH_LINE_END,
+        SEARCH_LINE_START | SEARCH_LINE_END,
+        SEARCH_WORD | SEARCH_LINE_START,
+        SEARCH_BUFFER_START,
+        SEARCH_BUFFER_END,
+        SEARCH_WORD | SEARCH_BUFFER_END,
+};
+
+MU_TEST (needle_flags_test)
+{
+        Pattern pattern = {"error", 5};
+        Searcher searcher;
+        Searcher_init_needle (&searcher, pattern.begin, pattern.size);
+        size_t num_all = 0;
+        for (size_t i = 0; i < sizeof (all_flags) / sizeof (all_flags[0]); ++i)
+        {
+                size_t num_matches;
+                mu_check (check_flags (&searcher, &pattern, 1, all_flags[i], text, TEXT_SIZE, &num_matches));
+                num_all = all_flags[i] == 0 ? num_matches : num_all;
+                // every flag removes matches, e.g. "error" in "terrorism"
+                mu_check (all_flags[i] == 0 || num_matches < num_all);
+        }
+
+        char str[] = "error: terrorism";
+        Searcher_set_flags (&searcher, SEARCH_WORD);
+        mu_check (Searcher_find (&searcher, str, strlen (str)).begin == str);
+        // resuming keeps the left context: "rror" is preceded by 'e'
+        Searcher_init_needle (&searcher, "rror", 4);
+        Searcher_set_flags (&searcher, SEARCH_WORD | SEARCH_LINE_END);
+        mu_assert_int_eq (-1, Searcher_find_from (&searcher, str, strlen (str), 1).pattern_id);
+        mu_check (Searcher_find (&searcher, str + 1, 4).begin == str + 1);
+}
+
+MU_TEST (slim_teddy_flags_test)
+{
+        // "err" and "error" begin at the same positions: a rejected "err" must not hide "error"
+        Pattern patterns[4] = {{"err", 3}, {"error", 5}, {"ok", 2}, {"code", 4}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 4, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+        for (size_t i = 0; i < sizeof (all_flags) / sizeof (all_flags[0]); ++i)
+        {
+                size_t num_matches;
+                mu_check (check_flags (&searcher, patterns, 4, all_flags[i], text, TEXT_SIZE, &num_matches));
+                mu_check (num_matches > 0 || (all_flags[i] & (SEARCH_BUFFER_START | SEARCH_BUFFER_END)));
+                // haystacks shorter than a Teddy block
+                mu_check (check_flags (&searcher, patterns, 4, all_flags[i], text + 100, 13, &num_matches));
+        }
+}
+
+MU_TEST (fat_teddy_flags_test)
+{
+        char* strs[3] = {"errors", "ok", "Error"};
+        Pattern patterns[3] = {{"errors", 6}, {"ok", 2}, {"Error", 5}};
+        FatTeddy teddy;
+        fat_teddy_init (&teddy, strs, 3);
+        Searcher searcher;
+        Searcher_init_fat_teddy (&searcher, &teddy);
+        for (size_t i = 0; i < sizeof (all_flags) / sizeof (all_flags[0]); ++i)
+        {
+                size_t num_matches;
+                mu_check (check_flags (&searcher, patterns, 3, all_flags[i], text, TEXT_SIZE, &num_matches));
+        }
+}
+
+MU_TEST (buffer_anchor_test)
+{
+        char str[] = "ok error ok";
+        Pattern patterns[2] = {{"ok", 2}, {"k", 1}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 2, 1);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+
+        Searcher_set_flags (&searcher, SEARCH_BUFFER_START);
+        mu_check (Searcher_find (&searcher, str, strlen (str)).begin == str);
+        mu_assert_int_eq (-1, Searcher_find_from (&searcher, str, strlen (str), 1).pattern_id);
+
+        // the leftmost of the matches ending at the buffer end
+        Searcher_set_flags (&searcher, SEARCH_BUFFER_END);
+        Match match = Searcher_find (&searcher, str, strlen (str));
+        mu_assert_int_eq (0, match.pattern_id);
+        mu_check (match.begin == str + 9);
+        match = Searcher_find_from (&searcher, str, strlen (str), 10);
+        mu_assert_int_eq (1, match.pattern_id);
+}
+
+MU_TEST (window_test)
+{
+        // windows of the text: matches lie in the window, the flags see the text around it
+        Pattern patterns[3] = {{"error", 5}, {"err", 3}, {"ok", 2}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 3, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+        uint32_t state = 17;
+        int equal = 1;
+        for (size_t flags_id = 0; flags_id < sizeof (all_flags) / sizeof (all_flags[0]); ++flags_id)
+        {
+                Searcher_set_flags (&searcher, all_flags[flags_id]);
+                for (size_t round = 0; round < 200; ++round)
+                {
+                        test_random (&state);
+                        size_t begin = round == 0 ? 0 : (state >> 8) % 1000;
+                        size_t end = round == 1 ? TEXT_SIZE : begin + (state >> 20) % 64;
+                        int before = begin > 0 ? (unsigned char) text[begin - 1] : SEARCH_EDGE;
+                        int after = end < TEXT_SIZE ? (unsigned char) text[end] : SEARCH_EDGE;
+                        Match match = Searcher_find_window (&searcher, text + begin, end - begin, 0, before, after);
+
+                        Match expected = Match_empty ();
+                        for (size_t pos = begin; pos < end && expected.pattern_id < 0; ++pos)
+                        {
+                                for (uint16_t pattern_id = 0; pattern_id < 3; ++pattern_id)
+                                {
+                                        size_t size = patterns[pattern_id].size;
+                                        if (size <= end - pos && memcmp (text + pos, patterns[pattern_id].begin, size) == 0 &&
+                                            naive_accept (all_flags[flags_id], text, TEXT_SIZE, pos, pos + size))
+                                        {
+                                                expected.pattern_id = (int16_t) pattern_id;
+                                                expected.begin = text + pos;
+                                                break;
+                                        }
+                                }
+                        }
+                        equal &= match.pattern_id == expected.pattern_id && match.begin == expected.begin;
+                }
+        }
+        mu_check (equal);
+}
+
+MU_TEST_SUITE (searcher_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (needle_flags_test);
+        MU_RUN_TEST (slim_teddy_flags_test);
+        MU_RUN_TEST (fat_teddy_flags_test);
+        MU_RUN_TEST (buffer_anchor_test);
+        MU_RUN_TEST (window_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (searcher_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
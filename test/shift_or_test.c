@@ -0,0 +1,205 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <simdstr/shift_or.h>
+
+#define TEXT_SIZE 30000
+
+typedef Match (*ShiftOrFind) (const ShiftOr*, char*, size_t);
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 7;
+        test_random_text (text, TEXT_SIZE, "abcxyz0123456789-_ ,\n", 21, &state);
+        // planted occurrences, also across the 32 byte skip blocks
+        memcpy (text + 1000, "ID:555-1234;", 12);
+        memcpy (text + 2047, "KEY=Secret", 10);
+        memcpy (text + 29990, "key=SECRET", 10);
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+/*
+ * Leftmost (lowest pattern id on ties) match, checked position by position on the class masks of the matcher.
+ */
+static Match
+naive_find (const ShiftOr* matcher, char* str, size_t str_size)
+{
+        for (size_t start = 0; start < str_size; ++start)
+        {
+                for (uint8_t pattern_id = 0; pattern_id < matcher->num_patterns; ++pattern_id)
+                {
+                        size_t size = matcher->sizes[pattern_id];
+                        if (start + size > str_size)
+                        {
+                                continue;
+                        }
+                        size_t position = 0;
+                        while (position < size &&
+                               !((matcher->masks[(uint8_t) str[start + position]][pattern_id] >> position) & 1))
+                        {
+                                position++;
+                        }
+                        if (position == size)
+                        {
+                                return (Match) {pattern_id, str + start, str + start + size};
+                        }
+                }
+        }
+        return Match_empty ();
+}
+
+static int
+check_find (ShiftOrFind find, const ShiftOr* matcher, char* str, size_t str_size, size_t* num_matches)
+{
+        *num_matches = 0;
+        size_t from = 0;
+        for (;;)
+        {
+                Match expected = naive_find (matcher, str + from, str_size - from);
+                Match found = find (matcher, str + from, str_size - from);
+                if (found.pattern_id != expected.pattern_id || found.begin != expected.begin || found.end != expected.end)
+                {
+                        return 0;
+                }
+                if (found.pattern_id < 0)
+                {
+                        return 1;
+                }
+                (*num_matches)++;
+                from = (size_t) (found.begin - str) + 1;
+        }
+}
+
+static int
+matches (const char* pattern, const char* str, int icase)
+{
+        ShiftOr matcher;
+        if (ShiftOr_init (&matcher, &pattern, 1, icase) != 0)
+        {
+                return -1;
+        }
+        Match match = ShiftOr_find (&matcher, (char*) str, strlen (str));
+        return match.pattern_id == 0 && match.begin == str && match.end == str + strlen (str);
+}
+
+MU_TEST (syntax_test)
+{
+        mu_assert_int_eq (1, matches ("abc", "abc", 0));
+        mu_assert_int_eq (0, matches ("abc", "aBc", 0));
+        mu_assert_int_eq (1, matches ("abc", "aBc", 1));
+        // icase negated classes exclude both cases of their letters
+        mu_assert_int_eq (0, matches ("[^a]b", "Ab", 1));
+        mu_assert_int_eq (0, matches ("[^a]b", "aB", 1));
+        mu_assert_int_eq (1, matches ("[^a]b", "cB", 1));
+        mu_assert_int_eq (0, matches ("[^A-Z]", "q", 1));
+        mu_assert_int_eq (1, matches ("a.c", "a\nc", 0));
+        mu_assert_int_eq (1, matches ("[0-9]{3}-[0-9]{4}", "555-1234", 0));
+        mu_assert_int_eq (0, matches ("[0-9]{3}-[0-9]{4}", "555-12a4", 0));
+        mu_assert_int_eq (1, matches ("[^,]x", "-x", 0));
+        mu_assert_int_eq (0, matches ("[^,]x", ",x", 0));
+        mu_assert_int_eq (1, matches ("[a-c_\\d]{3}", "b_7", 0));
+        mu_assert_int_eq (1, matches ("\\w\\s\\d", "_\t9", 0));
+        mu_assert_int_eq (0, matches ("\\w\\s\\d", "-\t9", 0));
+        mu_assert_int_eq (1, matches ("\\W\\S\\D", "-xa", 0));
+        mu_assert_int_eq (0, matches ("\\W\\S\\D", "-x9", 0));
+        mu_assert_int_eq (0, matches ("a\\0b", "a0b", 0));
+        mu_assert_int_eq (1, matches ("\\x41\\.\\n", "A.\n", 0));
+        mu_assert_int_eq (1, matches ("[\\x00-\\x7f]\\xff", "a\xff", 0));
+        mu_assert_int_eq (1, matches ("x{64}", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 0));
+        // syntax errors and size limits
+        mu_assert_int_eq (-1, matches ("", "", 0));
+        mu_assert_int_eq (-1, matches ("[a-", "", 0));
+        mu_assert_int_eq (-1, matches ("[z-a]", "", 0));
+        mu_assert_int_eq (-1, matches ("{2}", "", 0));
+        mu_assert_int_eq (-1, matches ("a{0}", "", 0));
+        mu_assert_int_eq (-1, matches ("a{65}", "", 0));
+        mu_assert_int_eq (-1, matches ("\\xg1", "", 0));
+        mu_assert_int_eq (-1, matches ("ab\\", "", 0));
+        const char* patterns[SHIFT_OR_MAX_PATTERNS + 1] = {"a", "b", "c", "d", "e", "f", "g", "h", "i"};
+        ShiftOr matcher;
+        mu_assert_int_eq (-1, ShiftOr_init (&matcher, patterns, SHIFT_OR_MAX_PATTERNS + 1, 0));
+        mu_assert_int_eq (0, ShiftOr_init (&matcher, patterns, SHIFT_OR_MAX_PATTERNS, 0));
+}
+
+MU_TEST (kernel_test)
+{
+        ShiftOrFind finds[3] = {ShiftOr_find, ShiftOr_find_avx_32, ShiftOr_find_avx_64};
+        // one register, two registers (more than 4 patterns) and overlapping patterns of different sizes
+        const char* pattern_sets[][SHIFT_OR_MAX_PATTERNS] = {
+                {"[0-9]{3}-[0-9]{4}"},
+                {"key=secret", "[a-c]{2}\\d", "x[^0-9a-z]y"},
+                {"z,", "\\d\\d\\d\\d\\d", "a[b-z]{3}", "_ \\w", "[xyz]{4}", "9-9", ":\\d{3}", "key"},
+                {"abc", "ab", "b", "[a-c]{6}", "c.{40}c"},
+        };
+        uint8_t num_patterns[] = {1, 3, 8, 5};
+        for (size_t s = 0; s < 3; ++s)
+        {
+                for (size_t p = 0; p < sizeof (num_patterns); ++p)
+                {
+                        ShiftOr matcher;
+                        mu_assert_int_eq (0, ShiftOr_init (&matcher, pattern_sets[p], num_patterns[p], p == 1));
+                        size_t num_matches;
+                        mu_check (check_find (finds[s], &matcher, text, TEXT_SIZE, &num_matches));
+                        mu_check (num_matches > 0);
+                        // short haystacks: no skip blocks
+                        mu_check (check_find (finds[s], &matcher, text + 990, 20, &num_matches));
+                }
+        }
+}
+
+MU_TEST (leftmost_test)
+{
+        // a longer pattern starting first wins over a shorter one ending first
+        const char* patterns[] = {"cd", "abcde"};
+        ShiftOr matcher;
+        ShiftOr_init (&matcher, patterns, 2, 0);
+        char str[] = "xxabcdexx";
+        Match match = ShiftOr_find_avx_32 (&matcher, str, strlen (str));
+        mu_assert_int_eq (1, match.pattern_id);
+        mu_check (match.begin == str + 2 && match.end == str + 7);
+        match = ShiftOr_find_avx_64 (&matcher, str, strlen (str));
+        mu_assert_int_eq (1, match.pattern_id);
+        // same start: lowest pattern id
+        const char* same_start[] = {"ab[a-z]", "ab"};
+        ShiftOr_init (&matcher, same_start, 2, 0);
+        match = ShiftOr_find (&matcher, str, strlen (str));
+        mu_assert_int_eq (0, match.pattern_id);
+        mu_check (match.begin == str + 2 && match.end == str + 5);
+        mu_assert_int_eq (-1, ShiftOr_find (&matcher, str, 3).pattern_id);
+}
+
+MU_TEST_SUITE (shift_or_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (syntax_test);
+        MU_RUN_TEST (kernel_test);
+        MU_RUN_TEST (leftmost_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (shift_or_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,219 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdlib.h>
+
+#include <simdstr/signature.h>
+
+#define TEXT_SIZE 20000
+
+static char* text;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 11;
+        test_random_text (text, TEXT_SIZE, "MZPE=;iduser\x90\x00", 14, &state);
+        // longer signatures are too rare in random text
+        for (size_t pos = 100; pos + 64 < TEXT_SIZE; pos += 997)
+        {
+                memcpy (text + pos, "user=admin;id=", 14);
+                memcpy (text + pos + 20, "MZ\x90PE=;d", 9);
+                memcpy (text + pos + 40, "=iduser", 7);
+        }
+}
+
+static void
+test_teardown (void)
+{
+        free (text);
+}
+
+static int
+naive_position (const Signature* signature, size_t pos, unsigned char byte)
+{
+        if ((byte & signature->mask[pos]) != signature->value[pos])
+        {
+                return 0;
+        }
+        uint8_t class_id = signature->class_id[pos];
+        return class_id == 0 || (signature->classes[class_id - 1][byte / 8] >> (byte % 8)) & 1;
+}
+
+/*
+ * Naive backtracking: smallest end of a match of the segments [segment_id, ...) placed at str[offset].
+ */
+static size_t
+naive_end (const Signature* signature, uint8_t segment_id, const char* str, size_t str_size, size_t offset)
+{
+        const SignatureSegment* segment = &signature->segments[segment_id];
+        if (offset + segment->size > str_size)
+        {
+                return SIZE_MAX;
+        }
+        for (size_t i = 0; i < segment->size; ++i)
+        {
+                if (!naive_position (signature, segment->begin + i, (unsigned char) str[offset + i]))
+                {
+                        return SIZE_MAX;
+                }
+        }
+        size_t end = offset + segment->size;
+        if (segment_id + 1 == signature->num_segments)
+        {
+                return end;
+        }
+        const SignatureSegment* next = segment + 1;
+        size_t best = SIZE_MAX;
+        for (size_t gap = next->gap_min; gap <= next->gap_max; ++gap)
+        {
+                size_t next_end = naive_end (signature, segment_id + 1, str, str_size, end + gap);
+                best = next_end < best ? next_end : best;
+        }
+        return best;
+}
+
+static int
+check_signature (const Signature* signature, char* str, size_t str_size, size_t* num_matches)
+{
+        *num_matches = 0;
+        size_t from = 0;
+        for (size_t start = 0; start < str_size; ++start)
+        {
+                size_t end = naive_end (signature, 0, str, str_size, start);
+                if (end == SIZE_MAX)
+                {
+                        continue;
+                }
+                Match match = Signature_find (signature, str + from, str_size - from);
+                if (match.pattern_id != 0 || match.begin != str + start || match.end != str + end)
+                {
+                        return 0;
+                }
+                (*num_matches)++;
+                from = start + 1;
+        }
+        return Signature_find (signature, str + from, str_size - from).pattern_id < 0;
+}
+
+MU_TEST (parse_hex_test)
+{
+        Signature signature;
+        mu_assert_int_eq (0, Signature_parse_hex (&signature, "4D 5A ?? ?? 50 45"));
+        mu_assert_int_eq (6, signature.size);
+        mu_assert_int_eq (1, signature.num_segments);
+        mu_assert_int_eq (0, signature.mask[2]);
+        mu_assert_int_eq (0x4d, signature.value[0]);
+
+        mu_assert_int_eq (0, Signature_parse_hex (&signature, "4d5a 4? ?f [2-4] 00 [3] 01"));
+        mu_assert_int_eq (3, signature.num_segments);
+        mu_assert_int_eq (0xf0, signature.mask[2]);
+        mu_assert_int_eq (0x40, signature.value[2]);
+        mu_assert_int_eq (0x0f, signature.mask[3]);
+        mu_assert_int_eq (2, signature.segments[1].gap_min);
+        mu_assert_int_eq (4, signature.segments[1].gap_max);
+        mu_assert_int_eq (4 + 2 + 1 + 3 + 1, (int) signature.min_match_size);
+        mu_assert_int_eq (4 + 4 + 1 + 3 + 1, (int) signature.max_match_size);
+
+        const char* invalid[] = {"", "4", "4G", "[2] 4D", "4D [2]", "4D [3-2] 4D", "4D [2 4D", "4D [99999] 4D"};
+        for (size_t i = 0; i < sizeof (invalid) / sizeof (invalid[0]); ++i)
+        {
+                mu_assert_int_eq (-1, Signature_parse_hex (&signature, invalid[i]));
+        }
+}
+
+MU_TEST (parse_text_test)
+{
+        Signature signature;
+        mu_assert_int_eq (0, Signature_parse (&signature, "user=*;id="));
+        mu_assert_int_eq (2, signature.num_segments);
+        mu_assert_int_eq (SIGNATURE_STAR_GAP, signature.segments[1].gap_max);
+
+        // [0-1] and [02] are value/mask pairs, [a-z] needs the exact check, [^\n] too
+        mu_assert_int_eq (0, Signature_parse (&signature, "[0-1][02][a-z][^\\n]\\x41\\?\\[{1,2}x"));
+        mu_assert_int_eq (0, signature.class_id[0]);
+        mu_assert_int_eq (0xfe, signature.mask[0]);
+        mu_assert_int_eq (0, signature.class_id[1]);
+        mu_check (signature.class_id[2] != 0);
+        mu_check (signature.class_id[3] != 0);
+        mu_assert_int_eq ('A', signature.value[4]);
+        mu_assert_int_eq ('?', signature.value[5]);
+        mu_assert_int_eq (0xff, signature.mask[5]);
+        mu_assert_int_eq ('[', signature.value[6]);
+        mu_assert_int_eq (2, signature.num_segments);
+
+        // shorthand classes, also inside classes and negated; "\0" is the byte 0
+        mu_assert_int_eq (0, Signature_parse (&signature, "\\d[\\s,]\\W\\0"));
+        mu_check (naive_position (&signature, 0, '7') && !naive_position (&signature, 0, 'd'));
+        mu_check (naive_position (&signature, 1, ',') && naive_position (&signature, 1, '\t'));
+        mu_check (naive_position (&signature, 2, '-') && !naive_position (&signature, 2, '_'));
+        mu_check (naive_position (&signature, 3, '\0') && !naive_position (&signature, 3, '0'));
+
+        const char* invalid[] = {"", "*a", "a*", "a{2", "a{3,1}b", "[a", "[z-a]", "a\\", "\\x4", "[^\\x00-\\xff]"};
+        for (size_t i = 0; i < sizeof (invalid) / sizeof (invalid[0]); ++i)
+        {
+                mu_assert_int_eq (-1, Signature_parse (&signature, invalid[i]));
+        }
+}
+
+MU_TEST (find_test)
+{
+        // two anchors, one anchor, no anchor, classes, gaps with several placements
+        const char* patterns[] = {"MZ?P",       "user=*;id=",  "?Z",       "[PE]?[i-u]", "MZ{0,3}PE{2}d",
+                                  "\\x90{1,4}\\x90\\x00", "[^MZ]iduser", "e*r*s*=", "P??????????????????????????????????????[MZ]",
+                                  "\\w\\W\\S\\0", "[a-z]*user=", "[^=]{2,9}id=", "?{0,9};?{0,9}MZ[\\x00-\\x90]"};
+        for (size_t i = 0; i < sizeof (patterns) / sizeof (patterns[0]); ++i)
+        {
+                Signature signature;
+                mu_assert_int_eq (0, Signature_parse (&signature, patterns[i]));
+                size_t num_matches;
+                mu_check (check_signature (&signature, text, TEXT_SIZE, &num_matches));
+                mu_check (num_matches > 0);
+                // haystacks shorter than a block
+                mu_check (check_signature (&signature, text + 777, 40, &num_matches));
+        }
+
+        // anchored behind the first segment: starts are found backwards from the anchor hits
+        Signature signature;
+        size_t num_matches;
+        mu_assert_int_eq (0, Signature_parse (&signature, "[a-z]*user="));
+        mu_assert_int_eq (1, signature.anchor_segment);
+        mu_assert_int_eq (0, Signature_parse_hex (&signature, "?? ?? [2] 4D 5A"));
+        mu_assert_int_eq (1, signature.anchor_segment);
+        mu_check (check_signature (&signature, text, TEXT_SIZE, &num_matches));
+        mu_check (num_matches > 0);
+
+        mu_assert_int_eq (0, Signature_parse_hex (&signature, "4D 5A ?? ?? 50 45 [0-8] 00 00"));
+        char binary[] = "....MZ\x90\x00PE\x01\x02\x03\x00\x00....MZ\x90\x00PE\x00\x00";
+        Match match = Signature_find (&signature, binary, sizeof (binary) - 1);
+        mu_check (match.begin == binary + 4);
+        mu_check (match.end == binary + 15);
+        match = Signature_find (&signature, binary + 5, sizeof (binary) - 6);
+        mu_check (match.begin == binary + 19);
+        mu_check (match.end == binary + 27);
+}
+
+MU_TEST_SUITE (signature_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (parse_hex_test);
+        MU_RUN_TEST (parse_text_test);
+        MU_RUN_TEST (find_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (signature_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
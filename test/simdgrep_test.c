@@ -0,0 +1,128 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// SIMDGREP: path of the simdgrep executable (set by CMake)
+
+#define NUM_LINES 400
+
+static char path[64];
+
+static void
+test_setup (void)
+{
+        strcpy (path, "/tmp/simdgrep_testXXXXXX");
+        int fd = mkstemp (path);
+        FILE* file = fdopen (fd, "w");
+        // empty lines, lines of non-word bytes, words at line edges
+        fputs ("ab\n\nab cd\n x\nx \na  b\n_\n-\nAB\nabab ab\n", file);
+        const char* words[] = {"ab", "cd", "abcd", "x", "_ab", "-", " ", "  ", "AB", ""};
+        uint32_t state = 17;
+        for (int line = 0; line < NUM_LINES; ++line)
+        {
+                int num_words = (int) ((test_random (&state) >> 16) % 5);
+                for (int w = 0; w < num_words; ++w)
+                {
+                        fputs (words[(test_random (&state) >> 16) % 10], file);
+                }
+                fputc ('\n', file);
+        }
+        fputs ("no trailing line break ab", file);
+        fclose (file);
+}
+
+static void
+test_teardown (void)
+{
+        unlink (path);
+}
+
+/*
+ * Output of the shell command (malloc'ed, NUL terminated).
+ */
+static char*
+run (const char* command)
+{
+        FILE* pipe = popen (command, "r");
+        size_t size = 0;
+        size_t capacity = 1 << 16;
+        char* output = malloc (capacity);
+        size_t n;
+        while ((n = fread (output + size, 1, capacity - size - 1, pipe)) > 0)
+        {
+                size += n;
+                if (size + 1 == capacity)
+                {
+                        capacity *= 2;
+                        output = realloc (output, capacity);
+                }
+        }
+        output[size] = '\0';
+        pclose (pipe);
+        return output;
+}
+
+/*
+ * simdgrep and grep -F print the same for the arguments.
+ */
+static int
+same_as_grep (const char* args)
+{
+        char command[512];
+        snprintf (command, sizeof (command), "%s %s %s", SIMDGREP, args, path);
+        char* found = run (command);
+        snprintf (command, sizeof (command), "grep -F %s %s", args, path);
+        char* expected = run (command);
+        int equal = strcmp (found, expected) == 0;
+        if (!equal)
+        {
+                printf ("\nsimdgrep %s differs from grep -F\n", args);
+        }
+        free (found);
+        free (expected);
+        return equal;
+}
+
+MU_TEST (empty_pattern_test)
+{
+        const char* patterns[] = {"-e ''", "-e '' -e ab", "-e ab -e '' -e cd", "-e ab", "-e ab -e abcd -e x"};
+        const char* options[] = {"", "-w", "-x", "-w -x", "-c", "-c -w", "-c -x", "-n -w", "-o", "-o -w", "-o -x",
+                                 "-i -w", "-i -x", "-l -x"};
+        for (size_t p = 0; p < sizeof (patterns) / sizeof (patterns[0]); ++p)
+        {
+                for (size_t o = 0; o < sizeof (options) / sizeof (options[0]); ++o)
+                {
+                        char args[128];
+                        snprintf (args, sizeof (args), "%s %s", options[o], patterns[p]);
+                        mu_check (same_as_grep (args));
+                }
+        }
+}
+
+MU_TEST_SUITE (simdgrep_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (empty_pattern_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (simdgrep_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -9,7 +9,9 @@
 
 #include <assert.h>
 
+#include <simdstr/search.h>
 #include <simdstr/slim_teddy.h>
+#include <simdstr/teddy_buckets.h>
 
 char haystack[1024] = "The quick brown fox jumps over the lazy dog. Coding is a fascinating skill that requires dedication and practice. "
                       "Machine learning and artificial intelligence are revolutionizing the world. Cats and dogs make wonderful pets. The sun sets behind the mountains, "
@@ -82,12 +84,179 @@ MU_TEST (find_1_test)
 
         free_teddy (teddy);
 
-        mu_assert_int_eq (10, match.begin - haystack);
+        // none of "abcd", "efgh", "ijklm", "nopqr" occurs in haystack
+        mu_assert_int_eq (-1, match.pattern_id);
+}
+
+MU_TEST (find_1_match_test)
+{
+        SlimTeddy* teddy = get_teddy(64, 1);
+
+        Match match = SlimTeddy_find_1 (teddy, haystack, 1024);
+
+        free_teddy (teddy);
+
+        mu_assert_int_eq (50, match.pattern_id);
+        mu_assert_int_eq (45, match.begin - haystack);
+}
+
+MU_TEST (bucket_assignment_test)
+{
+        Pattern patterns[4] = {{"foo", 3}, {"bar", 3}, {"fox", 3}, {"baz", 3}};
+
+        uint8_t bucket_of[4];
+        double rate = teddy_assign_buckets (patterns, 4, 1, 0, 8, 8, NULL, bucket_of);
+
+        mu_assert_int_eq (bucket_of[0], bucket_of[2]);
+        mu_assert_int_eq (bucket_of[1], bucket_of[3]);
+        mu_check (bucket_of[0] != bucket_of[1]);
+
+        // sequential assignment puts all patterns into bucket 0
+        uint8_t sequential[4] = {0, 0, 0, 0};
+        mu_check (rate < teddy_false_positive_rate (patterns, 4, 1, 0, 8, sequential, NULL));
+
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 4, 1);
+
+        char str[] = "a fox jumps over a bar";
+        Match match = SlimTeddy_find (&teddy, str, strlen (str));
+        mu_assert_int_eq (2, match.pattern_id);
+        mu_assert_int_eq (2, match.begin - str);
+}
+
+MU_TEST (find_n_test)
+{
+        for (uint8_t num_masks = 2; num_masks <= 4; ++num_masks)
+        {
+                SlimTeddy* teddy = get_teddy(64, num_masks);
+
+                Match match = SlimTeddy_find (teddy, haystack, 1024);
+
+                free_teddy (teddy);
+
+                mu_assert_int_eq (50, match.pattern_id);
+                mu_assert_int_eq (45, match.begin - haystack);
+        }
+}
+
+MU_TEST (fingerprint_offset_test)
+{
+        Pattern patterns[4] = {{"user_id", 7}, {"user_name", 9}, {"user_mail", 9}, {"user_group", 10}};
+
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 4, 2);
+
+        // the shared prefix "user" does not discriminate the patterns
+        mu_check (teddy.offset >= 4);
+
+        char str[] = "users: user_group=admin, user_mail=root@localhost";
+        Match match = SlimTeddy_find (&teddy, str, strlen (str));
+        mu_assert_int_eq (3, match.pattern_id);
+        mu_assert_int_eq (7, match.begin - str);
+
+        match = SlimTeddy_find (&teddy, str + 8, strlen (str) - 8);
+        mu_assert_int_eq (2, match.pattern_id);
+        mu_assert_int_eq (25, match.begin - str);
+}
+
+MU_TEST (find_icase_test)
+{
+        char text[] = "The quick brown fox jumps over the LAZY dog, then the Quick Fox rests.";
+        Pattern patterns[3] = {{"lazy", 4}, {"QUICK FOX", 9}, {"cat", 3}};
+        for (uint8_t num_masks = 1; num_masks <= 3; ++num_masks)
+        {
+                SlimTeddy teddy;
+                SlimTeddy_init_icase (&teddy, patterns, 3, num_masks);
+                Match match = SlimTeddy_find (&teddy, text, sizeof (text) - 1);
+                mu_assert_int_eq (0, match.pattern_id);
+                mu_assert_int_eq (35, (int) (match.begin - text));
+
+                char* rest = text + 40;
+                match = SlimTeddy_find (&teddy, rest, sizeof (text) - 41);
+                mu_assert_int_eq (1, match.pattern_id);
+                mu_assert_int_eq (54, (int) (match.begin - text));
+
+                // case sensitive: no match
+                SlimTeddy_init (&teddy, patterns, 3, num_masks);
+                match = SlimTeddy_find (&teddy, text, sizeof (text) - 1);
+                mu_assert_int_eq (-1, match.pattern_id);
+        }
+}
+
+MU_TEST (retire_test)
+{
+        SlimTeddy* teddy = get_teddy (64, 2);
+
+        SlimTeddy_retire (teddy, 50);
+        Match match = SlimTeddy_find (teddy, haystack, 1024);
+        mu_check (match.pattern_id != 50);
+        mu_check (match.begin - haystack > 45);
+
+        free_teddy (teddy);
+}
+
+MU_TEST (find_each_test)
+{
+        for (uint8_t num_masks = 1; num_masks <= 3; ++num_masks)
+        {
+                SlimTeddy* teddy = get_teddy (64, num_masks);
+                Match firsts[64];
+                uint8_t num_found = SlimTeddy_find_each (teddy, haystack, strlen (haystack), firsts);
+
+                uint8_t num_expected = 0;
+                for (uint8_t pattern_id = 0; pattern_id < 64; ++pattern_id)
+                {
+                        Pattern* pattern = &teddy->patterns[pattern_id];
+                        const char* expected = simd_strstr (haystack, strlen (haystack), pattern->begin, pattern->size);
+                        if (expected == NULL)
+                        {
+                                mu_assert_int_eq (-1, firsts[pattern_id].pattern_id);
+                                continue;
+                        }
+                        num_expected++;
+                        mu_assert_int_eq (pattern_id, firsts[pattern_id].pattern_id);
+                        mu_assert_int_eq ((int) (expected - haystack), (int) (firsts[pattern_id].begin - haystack));
+                }
+                mu_assert_int_eq (num_expected, num_found);
+                // the original matcher is left untouched
+                mu_assert_int_eq (50, SlimTeddy_find (teddy, haystack, 1024).pattern_id);
+
+                free_teddy (teddy);
+        }
+
+        // patterns starting at the same position, matches in the short tail
+        char str[] = "key=value; keys=values; end";
+        Pattern patterns[4] = {{"key", 3}, {"key=", 4}, {"end", 3}, {"missing", 7}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 4, 1);
+        Match firsts[4];
+        mu_assert_int_eq (3, SlimTeddy_find_each (&teddy, str, strlen (str), firsts));
+        mu_assert_int_eq (0, (int) (firsts[0].begin - str));
+        mu_assert_int_eq (0, (int) (firsts[1].begin - str));
+        mu_assert_int_eq (24, (int) (firsts[2].begin - str));
+        mu_assert_int_eq (-1, firsts[3].pattern_id);
+
+        // shorter than a Teddy block
+        mu_assert_int_eq (1, SlimTeddy_find_each (&teddy, str + 11, 5, firsts));
+        mu_assert_int_eq (11, (int) (firsts[0].begin - str));
+        mu_assert_int_eq (-1, firsts[1].pattern_id);
+
+        SlimTeddy_init_icase (&teddy, patterns, 4, 1);
+        char upper[] = "KEYS: ... the END";
+        mu_assert_int_eq (2, SlimTeddy_find_each (&teddy, upper, strlen (upper), firsts));
+        mu_assert_int_eq (14, (int) (firsts[2].begin - upper));
 }
 
 MU_TEST_SUITE (SlimTeddy_test)
 {
         MU_RUN_TEST (find_1_test);
+        MU_RUN_TEST (find_1_match_test);
+        MU_RUN_TEST (bucket_assignment_test);
+        MU_RUN_TEST (find_n_test);
+        MU_RUN_TEST (fingerprint_offset_test);
+        MU_RUN_TEST (find_icase_test);
+        MU_RUN_TEST (retire_test);
+        MU_RUN_TEST (find_each_test);
 }
 
 int main(int argc, char *argv[]) {
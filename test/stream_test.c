@@ -0,0 +1,164 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#include "minunit.h"
+
+#include <simdstr/stream.h>
+
+static char data[] = "GET /api/users HTTP/1.1\r\nHost: example.org\r\nUser-Agent: curl/8.0\r\n"
+                     "Accept: */*\r\n\r\nGET /api/orders HTTP/1.1\r\nHost: example.org\r\nCookie: user_id=42; user_name=root\r\n"
+                     "\r\nPOST /api/users HTTP/1.1\r\nHost: example.com\r\nContent-Length: 0\r\n\r\n";
+
+typedef struct {
+        StreamMatch matches[64];
+        size_t num_matches;
+} Matches;
+
+static int
+collect (const StreamMatch* match, void* user_data)
+{
+        Matches* matches = user_data;
+        if (matches->num_matches < 64)
+        {
+                matches->matches[matches->num_matches] = *match;
+        }
+        matches->num_matches++;
+        return 0;
+}
+
+static void
+stream_chunked (const Searcher* searcher, size_t chunk_size, Matches* matches)
+{
+        matches->num_matches = 0;
+        SearchStream stream;
+        SearchStream_begin (&stream, searcher, collect, matches);
+        size_t size = strlen (data);
+        for (size_t pos = 0; pos < size; pos += chunk_size)
+        {
+                size_t remaining = size - pos;
+                SearchStream_feed (&stream, data + pos, remaining < chunk_size ? remaining : chunk_size);
+        }
+        SearchStream_end (&stream);
+}
+
+static void
+check_chunk_sizes (const Searcher* searcher)
+{
+        Matches expected;
+        stream_chunked (searcher, strlen (data), &expected);
+
+        for (size_t chunk_size = 1; chunk_size < 48; ++chunk_size)
+        {
+                Matches matches;
+                stream_chunked (searcher, chunk_size, &matches);
+                mu_assert_int_eq ((int) expected.num_matches, (int) matches.num_matches);
+                for (size_t i = 0; i < expected.num_matches; ++i)
+                {
+                        mu_assert_int_eq (expected.matches[i].pattern_id, matches.matches[i].pattern_id);
+                        mu_assert_int_eq ((int) expected.matches[i].begin, (int) matches.matches[i].begin);
+                        mu_assert_int_eq ((int) expected.matches[i].end, (int) matches.matches[i].end);
+                }
+        }
+}
+
+MU_TEST (needle_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "example.org", 11);
+
+        Matches matches;
+        stream_chunked (&searcher, strlen (data), &matches);
+        mu_assert_int_eq (2, (int) matches.num_matches);
+        mu_assert_int_eq ((int) (strstr (data, "example.org") - data), (int) matches.matches[0].begin);
+
+        check_chunk_sizes (&searcher);
+}
+
+MU_TEST (teddy_test)
+{
+        Pattern patterns[4] = {{"/api/users", 10}, {"/api/orders", 11}, {"user_name", 9}, {"example.com", 11}};
+        SlimTeddy teddy;
+        SlimTeddy_init (&teddy, patterns, 4, 2);
+        Searcher searcher;
+        Searcher_init_slim_teddy (&searcher, &teddy);
+
+        Matches matches;
+        stream_chunked (&searcher, strlen (data), &matches);
+        mu_assert_int_eq (5, (int) matches.num_matches);
+
+        check_chunk_sizes (&searcher);
+}
+
+static int
+stop_at_first (const StreamMatch* match, void* user_data)
+{
+        collect (match, user_data);
+        return 1;
+}
+
+MU_TEST (stop_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "HTTP/1.1", 8);
+
+        Matches matches;
+        matches.num_matches = 0;
+        SearchStream stream;
+        SearchStream_begin (&stream, &searcher, stop_at_first, &matches);
+        mu_assert_int_eq (0, SearchStream_feed (&stream, data, 10));
+        mu_assert_int_eq (0, SearchStream_feed (&stream, data + 10, 10));
+        mu_assert_int_eq (1, SearchStream_feed (&stream, data + 20, 100));
+        mu_assert_int_eq (1, SearchStream_feed (&stream, data + 120, 10));
+        mu_assert_int_eq (1, SearchStream_end (&stream));
+        mu_assert_int_eq (1, (int) matches.num_matches);
+        mu_assert_int_eq (15, (int) matches.matches[0].begin);
+}
+
+MU_TEST (flags_test)
+{
+        // chunk seams inside a word must not look like word boundaries
+        char text[] = "aaaaaaaaterror ism and more error\nerror? terrors error";
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "error", 5);
+        const uint32_t flags[3] = {SEARCH_WORD, SEARCH_LINE_START, SEARCH_WORD | SEARCH_LINE_END};
+        const int num_expected[3] = {3, 1, 2};
+        for (int idx = 0; idx < 3; ++idx)
+        {
+                Searcher_set_flags (&searcher, flags[idx]);
+                for (size_t chunk_size = 1; chunk_size <= sizeof (text); ++chunk_size)
+                {
+                        Matches matches;
+                        matches.num_matches = 0;
+                        SearchStream stream;
+                        SearchStream_begin (&stream, &searcher, collect, &matches);
+                        for (size_t pos = 0; pos < sizeof (text) - 1; pos += chunk_size)
+                        {
+                                size_t remaining = sizeof (text) - 1 - pos;
+                                SearchStream_feed (&stream, text + pos, remaining < chunk_size ? remaining : chunk_size);
+                        }
+                        SearchStream_end (&stream);
+                        mu_assert_int_eq (num_expected[idx], (int) matches.num_matches);
+                        mu_check (matches.matches[0].begin == (idx == 1 ? 34 : 28));
+                }
+        }
+}
+
+MU_TEST_SUITE (stream_test)
+{
+        MU_RUN_TEST (needle_test);
+        MU_RUN_TEST (teddy_test);
+        MU_RUN_TEST (stop_test);
+        MU_RUN_TEST (flags_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (stream_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
@@ -0,0 +1,41 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#ifndef SIMD_STRING_TEST_UTIL_H
+#define SIMD_STRING_TEST_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Deterministic random input shared by the tests (the same seed yields the same input on every platform).
+ */
+
+/**
+ * Advance the linear congruential generator state and return the new state. Its low bits are weak, callers use the
+ *  bits from 8 upwards.
+ */
+static inline uint32_t
+test_random (uint32_t* state)
+{
+        *state = *state * 1103515245u + 12345u;
+        return *state;
+}
+
+/**
+ * Fill str[0, size) with bytes drawn from alphabet[0, alphabet_size) (alphabet may contain NUL bytes).
+ */
+static inline void
+test_random_text (char* str, size_t size, const char* alphabet, size_t alphabet_size, uint32_t* state)
+{
+        for (size_t i = 0; i < size; ++i)
+        {
+                str[i] = alphabet[(test_random (state) >> 16) % alphabet_size];
+        }
+}
+
+#endif//SIMD_STRING_TEST_UTIL_H
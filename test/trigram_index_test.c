@@ -0,0 +1,216 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <simdstr/match_vector.h>
+#include <simdstr/trigram_index.h>
+
+#define TEXT_SIZE (1u << 20)
+#define BLOCK_SIZE 4096
+
+static char* text;
+static ThreadPool pool;
+static char long_pattern[400];
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 42;
+        test_random_text (text, TEXT_SIZE, "abcdefgh ", 9, &state);
+        // plant needles, some of them crossing block boundaries
+        size_t positions[] = {100, BLOCK_SIZE - 3, 7 * BLOCK_SIZE - 1, 100000, TEXT_SIZE - 9};
+        for (size_t i = 0; i < 5; ++i)
+        {
+                memcpy (text + positions[i], "needle42", 8);
+        }
+        memcpy (text + 50000, "pattern", 7);
+        // longer than the indexed prefix, starting right before a block boundary
+        memcpy (long_pattern, text + 3 * BLOCK_SIZE - 5, sizeof (long_pattern));
+        ThreadPool_init (&pool, 4, NULL, NULL);
+}
+
+static void
+test_teardown (void)
+{
+        ThreadPool_destroy (&pool);
+        free (text);
+}
+
+/*
+ * find_all of the index equals a scan of the whole corpus.
+ */
+static int
+check_find_all (const TrigramIndex* index, ThreadPool* scan_pool, const Pattern* patterns, size_t num_patterns)
+{
+        SlimTeddy teddy;
+        Searcher searcher;
+        if (num_patterns == 1)
+        {
+                Searcher_init_needle (&searcher, patterns[0].begin, patterns[0].size);
+        }
+        else
+        {
+                SlimTeddy_init (&teddy, (Pattern*) patterns, (uint8_t) num_patterns, 2);
+                Searcher_init_slim_teddy (&searcher, &teddy);
+        }
+        MatchVector expected;
+        MatchVector_init (&expected);
+        MatchVector_find_all (&expected, &searcher, text, TEXT_SIZE, TEXT_SIZE);
+
+        Match* matches;
+        size_t num_matches = TrigramIndex_find_all (index, scan_pool, patterns, num_patterns, &searcher, text, TEXT_SIZE, &matches);
+        int equal = num_matches == expected.size && num_matches > 0;
+        for (size_t i = 0; equal && i < num_matches; ++i)
+        {
+                equal = matches[i].begin == expected.matches[i].begin && matches[i].pattern_id == expected.matches[i].pattern_id;
+        }
+        free (matches);
+        MatchVector_free (&expected);
+        return equal;
+}
+
+MU_TEST (candidates_test)
+{
+        TrigramIndex index;
+        mu_assert_int_eq (0, TrigramIndex_build (&index, &pool, text, TEXT_SIZE, BLOCK_SIZE));
+        mu_assert_int_eq (TEXT_SIZE / BLOCK_SIZE, (int) index.header.num_blocks);
+        uint32_t blocks[TEXT_SIZE / BLOCK_SIZE];
+        size_t num_blocks = TrigramIndex_candidates (&index, "needle42", 8, blocks);
+        // the needles at 100 and BLOCK_SIZE - 3 both start in block 0
+        uint32_t expected[] = {0, 6, 100000 / BLOCK_SIZE, TEXT_SIZE / BLOCK_SIZE - 1};
+        mu_assert_int_eq (4, (int) num_blocks);
+        for (size_t i = 0; i < 4; ++i)
+        {
+                mu_assert_int_eq ((int) expected[i], (int) blocks[i]);
+        }
+        mu_assert_int_eq (0, (int) TrigramIndex_candidates (&index, "needle43", 8, blocks));
+        mu_assert_int_eq (0, (int) TrigramIndex_candidates (&index, "xyz", 3, blocks));
+        // short patterns: every block
+        mu_assert_int_eq (TEXT_SIZE / BLOCK_SIZE, (int) TrigramIndex_candidates (&index, "ab", 2, blocks));
+        num_blocks = TrigramIndex_candidates (&index, long_pattern, sizeof (long_pattern), blocks);
+        int has_start_block = 0;
+        for (size_t i = 0; i < num_blocks; ++i)
+        {
+                has_start_block |= blocks[i] == 2;
+        }
+        mu_check (has_start_block);
+        TrigramIndex_destroy (&index);
+}
+
+MU_TEST (find_all_test)
+{
+        TrigramIndex index;
+        // single threaded and parallel builds are equal
+        TrigramIndex parallel_index;
+        mu_assert_int_eq (0, TrigramIndex_build (&index, NULL, text, TEXT_SIZE, BLOCK_SIZE));
+        mu_assert_int_eq (0, TrigramIndex_build (&parallel_index, &pool, text, TEXT_SIZE, BLOCK_SIZE));
+        mu_check (index.memory_size == parallel_index.memory_size);
+        mu_check (memcmp (index.memory, parallel_index.memory, index.memory_size) == 0);
+        TrigramIndex_destroy (&parallel_index);
+
+        Pattern needle = {"needle42", 8};
+        mu_check (check_find_all (&index, NULL, &needle, 1));
+        mu_check (check_find_all (&index, &pool, &needle, 1));
+        Pattern patterns[3] = {{"needle42", 8}, {"pattern", 7}, {"hgfedc", 6}};
+        mu_check (check_find_all (&index, &pool, patterns, 3));
+        Pattern long_needle = {long_pattern, sizeof (long_pattern)};
+        mu_check (check_find_all (&index, &pool, &long_needle, 1));
+        // short patterns scan every block
+        Pattern short_needle = {"h ", 2};
+        mu_check (check_find_all (&index, &pool, &short_needle, 1));
+
+        Match* matches;
+        mu_check (TrigramIndex_find_all (&index, NULL, &needle, 1, NULL, text, TEXT_SIZE - 1, &matches) == SIZE_MAX);
+        TrigramIndex_destroy (&index);
+}
+
+/*
+ * Overwrite size bytes of the file at pos.
+ */
+static int
+patch_file (const char* path, size_t pos, const void* data, size_t size)
+{
+        FILE* file = fopen (path, "r+b");
+        int ok = file != NULL && fseek (file, (long) pos, SEEK_SET) == 0 && fwrite (data, 1, size, file) == size;
+        return file != NULL && fclose (file) == 0 && ok;
+}
+
+MU_TEST (file_test)
+{
+        TrigramIndex index;
+        mu_assert_int_eq (0, TrigramIndex_build (&index, &pool, text, TEXT_SIZE, 0));
+        char path[64];
+        strcpy (path, "/tmp/trigram_index_testXXXXXX");
+        close (mkstemp (path));
+        mu_assert_int_eq (0, TrigramIndex_save (&index, path));
+
+        TrigramIndex opened;
+        mu_assert_int_eq (0, TrigramIndex_open (&opened, path));
+        mu_check (opened.mapped);
+        mu_assert_int_eq (TRIGRAM_INDEX_BLOCK_SIZE, (int) opened.header.block_size);
+        mu_check (opened.memory_size == index.memory_size && memcmp (opened.memory, index.memory, index.memory_size) == 0);
+        Pattern patterns[2] = {{"needle42", 8}, {"pattern", 7}};
+        mu_check (check_find_all (&opened, &pool, patterns, 2));
+        TrigramIndex_destroy (&opened);
+
+        // out-of-range offsets and postings are rejected
+        const char* memory = index.memory;
+        size_t offset_pos = (size_t) ((const char*) &index.offsets[1] - memory);
+        size_t posting_pos = (size_t) ((const char*) &index.postings[0] - memory);
+        uint64_t bad_offset = index.header.num_postings + 1;
+        uint32_t bad_posting = (uint32_t) index.header.num_blocks;
+        mu_check (patch_file (path, offset_pos, &bad_offset, sizeof (bad_offset)));
+        mu_assert_int_eq (-1, TrigramIndex_open (&opened, path));
+        mu_check (patch_file (path, offset_pos, &index.offsets[1], sizeof (uint64_t)));
+        mu_check (patch_file (path, posting_pos, &bad_posting, sizeof (bad_posting)));
+        mu_assert_int_eq (-1, TrigramIndex_open (&opened, path));
+        mu_check (patch_file (path, posting_pos, &index.postings[0], sizeof (uint32_t)));
+        mu_assert_int_eq (0, TrigramIndex_open (&opened, path));
+        TrigramIndex_destroy (&opened);
+
+        // truncated and foreign files are rejected
+        mu_assert_int_eq (0, truncate (path, (off_t) index.memory_size - 4));
+        mu_assert_int_eq (-1, TrigramIndex_open (&opened, path));
+        FILE* file = fopen (path, "wb");
+        fwrite (text, 1, 4096, file);
+        fclose (file);
+        mu_assert_int_eq (-1, TrigramIndex_open (&opened, path));
+        unlink (path);
+        TrigramIndex_destroy (&index);
+
+        // empty corpus
+        mu_assert_int_eq (0, TrigramIndex_build (&index, NULL, text, 0, 0));
+        mu_assert_int_eq (0, (int) index.header.num_blocks);
+        mu_assert_int_eq (0, (int) TrigramIndex_candidates (&index, "abc", 3, NULL));
+        TrigramIndex_destroy (&index);
+}
+
+MU_TEST_SUITE (trigram_index_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (candidates_test);
+        MU_RUN_TEST (find_all_test);
+        MU_RUN_TEST (file_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (trigram_index_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}
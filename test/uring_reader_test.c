@@ -0,0 +1,161 @@
+/**
+ * Copyright 2024, Leon Freist (https://github.com/lfreist)
+ * Author: Leon Freist <freist.leon@gmail.com>
+ *
+ * This file is part of simd_string.
+ */
+
+#define _GNU_SOURCE
+
+#include "minunit.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <simdstr/uring_reader.h>
+
+#define TEXT_SIZE (3u << 20)
+#define BUFFER_SIZE (64u << 10)
+
+static char* text;
+static char path[64];
+static char empty_path[64];
+
+typedef struct {
+        uint64_t offset;
+        int content_ok;
+        size_t num_chunks;
+        size_t stop_after;
+} ChunkCollector;
+
+typedef struct {
+        uint64_t begins[64];
+        size_t num_matches;
+} MatchCollector;
+
+static void
+test_setup (void)
+{
+        text = malloc (TEXT_SIZE);
+        uint32_t state = 11;
+        test_random_text (text, TEXT_SIZE, "abcdefgh ", 9, &state);
+        // needles across buffer boundaries and at the end of the file
+        for (size_t pos = BUFFER_SIZE - 4; pos + 8 <= TEXT_SIZE; pos += 5 * BUFFER_SIZE)
+        {
+                memcpy (text + pos, "needle42", 8);
+        }
+        memcpy (text + TEXT_SIZE - 8, "needle42", 8);
+
+        strcpy (path, "/tmp/uring_reader_testXXXXXX");
+        int fd = mkstemp (path);
+        write (fd, text, TEXT_SIZE);
+        close (fd);
+        strcpy (empty_path, "/tmp/uring_reader_emptyXXXXXX");
+        close (mkstemp (empty_path));
+}
+
+static void
+test_teardown (void)
+{
+        unlink (path);
+        unlink (empty_path);
+        free (text);
+}
+
+static int
+collect_chunk (const char* chunk, size_t chunk_size, uint64_t offset, void* user_data)
+{
+        ChunkCollector* collector = user_data;
+        collector->content_ok &= offset == collector->offset && offset + chunk_size <= TEXT_SIZE &&
+                                 memcmp (chunk, text + offset, chunk_size) == 0;
+        collector->offset += chunk_size;
+        return ++collector->num_chunks == collector->stop_after;
+}
+
+static int
+collect_match (const StreamMatch* match, void* user_data)
+{
+        MatchCollector* collector = user_data;
+        if (collector->num_matches < 64)
+        {
+                collector->begins[collector->num_matches] = match->begin;
+        }
+        collector->num_matches++;
+        return 0;
+}
+
+MU_TEST (read_test)
+{
+        int flags[] = {0, URING_READER_DIRECT};
+        for (int f = 0; f < 2; ++f)
+        {
+                UringReader reader;
+                mu_assert_int_eq (0, UringReader_init (&reader, 4, BUFFER_SIZE, flags[f]));
+
+                ChunkCollector collector = {0, 1, 0, 0};
+                mu_assert_int_eq (0, UringReader_read_file (&reader, path, collect_chunk, &collector));
+                mu_check (collector.content_ok);
+                mu_assert_int_eq (TEXT_SIZE, (int) collector.offset);
+
+                // stopped by the callback
+                ChunkCollector stopped = {0, 1, 0, 3};
+                mu_assert_int_eq (1, UringReader_read_file (&reader, path, collect_chunk, &stopped));
+                mu_assert_int_eq (3, (int) stopped.num_chunks);
+
+                ChunkCollector empty = {0, 1, 0, 0};
+                mu_assert_int_eq (0, UringReader_read_file (&reader, empty_path, collect_chunk, &empty));
+                mu_assert_int_eq (0, (int) empty.num_chunks);
+
+                mu_assert_int_eq (-1, UringReader_read_file (&reader, "/nonexistent/file", collect_chunk, &empty));
+                UringReader_destroy (&reader);
+        }
+}
+
+MU_TEST (search_test)
+{
+        Searcher searcher;
+        Searcher_init_needle (&searcher, "needle42", 8);
+
+        MatchCollector expected = {{0}, 0};
+        size_t pos = 0;
+        for (;;)
+        {
+                Match match = Searcher_find (&searcher, text + pos, TEXT_SIZE - pos);
+                if (match.pattern_id < 0)
+                {
+                        break;
+                }
+                expected.begins[expected.num_matches++] = (uint64_t) (match.begin - text);
+                pos = (size_t) (match.begin - text) + 1;
+        }
+        mu_check (expected.num_matches >= 9);
+
+        UringReader reader;
+        UringReader_init (&reader, 3, BUFFER_SIZE, 0);
+        MatchCollector collector = {{0}, 0};
+        mu_assert_int_eq (0, UringReader_search_file (&reader, path, &searcher, collect_match, &collector));
+        mu_assert_int_eq ((int) expected.num_matches, (int) collector.num_matches);
+        for (size_t i = 0; i < expected.num_matches && i < collector.num_matches; ++i)
+        {
+                mu_assert_int_eq ((int) expected.begins[i], (int) collector.begins[i]);
+        }
+        UringReader_destroy (&reader);
+}
+
+MU_TEST_SUITE (uring_reader_test)
+{
+        MU_SUITE_CONFIGURE (&test_setup, &test_teardown);
+
+        MU_RUN_TEST (read_test);
+        MU_RUN_TEST (search_test);
+}
+
+int
+main (int argc, char* argv[])
+{
+        MU_RUN_SUITE (uring_reader_test);
+        MU_REPORT ();
+        return MU_EXIT_CODE;
+}